@@ -21,7 +21,7 @@ top_level_results_dir=${results_root_directory}${sequence_file_base_name}/${conf
 ltm_opt_jacobian_info_directory=${top_level_results_dir}jacobian_debugging_out/
 
 
-jacobian_residual_info_file=${ltm_opt_jacobian_info_directory}ordered_jacobian_residual_info.json
+jacobian_residual_info_file=${ltm_opt_jacobian_info_directory}ordered_jacobian_residual_info.bin
 hessian_diag_entries_file=${ltm_opt_jacobian_info_directory}hessian_diag.csv
 data_association_file=${top_level_results_dir}ut_vslam_out/data_association_results.json
 
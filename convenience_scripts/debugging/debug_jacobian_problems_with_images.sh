@@ -25,7 +25,7 @@ nodes_by_timestamp_file=${ut_vslam_in_dir}timestamps/node_ids_and_timestamps.txt
 rosbag_file=${orig_data_dir}${rosbag_base_name}${bag_suffix}
 low_level_feats_dir=${ut_vslam_in_dir}
 
-jacobian_residual_info_file=${ltm_opt_jacobian_info_directory}ordered_jacobian_residual_info.json
+jacobian_residual_info_file=${ltm_opt_jacobian_info_directory}ordered_jacobian_residual_info.bin
 problem_feats_matlab_file=${ltm_opt_jacobian_info_directory}${problem_feature_file_base_name}
 jacobian_debugging_images_out_dir=${ltm_opt_jacobian_info_directory}debug_images/
 
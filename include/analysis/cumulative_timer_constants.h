@@ -11,6 +11,7 @@ namespace vslam_types_refactor {
 const std::string kTimerNameFullTrajectoryExecution =
     "full_trajectory_execution";
 const std::string kTimerNameVisFunction = "visualization_top_level";
+const std::string kTimerNameVisSnapshot = "visualization_snapshot";
 const std::string kTimerNameVisualFrontendFunction =
     "visual_frontend_top_level";
 const std::string kTimerNameResidualCreator = "residual_creator_top";
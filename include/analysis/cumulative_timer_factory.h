@@ -8,6 +8,7 @@
 #include <util/timer.h>
 
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 namespace vslam_types_refactor {
@@ -26,6 +27,8 @@ class CumulativeTimerFactory {
 
   std::shared_ptr<CumulativeFunctionTimer> getOrCreateFunctionTimer(
       const std::string& timer_name) {
+    // Timed stages may run on different threads (e.g. the front ends)
+    std::lock_guard<std::mutex> lock(timers_map_mutex_);
     if (timers_map_.find(timer_name) == timers_map_.end()) {
       timers_map_[timer_name] =
           std::make_shared<CumulativeFunctionTimer>(timer_name.c_str());
@@ -34,6 +37,7 @@ class CumulativeTimerFactory {
   }
 
  private:
+  std::mutex timers_map_mutex_;
   std::unordered_map<std::string, std::shared_ptr<CumulativeFunctionTimer>>
       timers_map_;
 };
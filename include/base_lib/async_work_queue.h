@@ -0,0 +1,187 @@
+//
+// Created by amanda on 3/2/23.
+//
+
+#ifndef UT_VSLAM_ASYNC_WORK_QUEUE_H
+#define UT_VSLAM_ASYNC_WORK_QUEUE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace util {
+
+/**
+ * Behavior when an item is added to a work queue that is already full.
+ */
+enum QueueFullPolicy {
+  /**
+   * Block the producer until there is space in the queue.
+   */
+  BLOCK_PRODUCER,
+  /**
+   * Discard the oldest queued (not yet started) item to make room.
+   */
+  DROP_OLDEST,
+  /**
+   * Discard the item that is being added.
+   */
+  DROP_NEWEST
+};
+
+/**
+ * Bounded queue of work items that are processed in order by a single
+ * background thread.
+ *
+ * Items are moved into the queue, so the producer should hand over data that
+ * it will not modify afterwards (i.e. a snapshot). The processor is only ever
+ * called from the background thread.
+ *
+ * @tparam ItemType Type of the work item. Must be default constructible and
+ *                  movable.
+ */
+template <typename ItemType>
+class AsyncWorkQueue {
+ public:
+  /**
+   * Create the queue and start the background thread.
+   *
+   * @param max_queue_size    Maximum number of items waiting to be processed
+   *                          (not including the one being processed). Must be
+   *                          positive.
+   * @param queue_full_policy What to do when an item is added to a full queue.
+   * @param item_processor    Function to process each item.
+   */
+  AsyncWorkQueue(const size_t &max_queue_size,
+                 const QueueFullPolicy &queue_full_policy,
+                 const std::function<void(ItemType &)> &item_processor)
+      : max_queue_size_(std::max(max_queue_size, (size_t)1)),
+        queue_full_policy_(queue_full_policy),
+        item_processor_(item_processor),
+        stop_requested_(false),
+        processing_item_(false),
+        num_dropped_items_(0) {
+    worker_thread_ = std::thread(&AsyncWorkQueue::processItems, this);
+  }
+
+  /**
+   * Process all remaining items and then stop the background thread.
+   */
+  ~AsyncWorkQueue() {
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      stop_requested_ = true;
+    }
+    item_available_cv_.notify_all();
+    worker_thread_.join();
+  }
+
+  AsyncWorkQueue(const AsyncWorkQueue &) = delete;
+  AsyncWorkQueue &operator=(const AsyncWorkQueue &) = delete;
+
+  /**
+   * Add an item to the queue.
+   *
+   * @param item Item to add. Moved into the queue.
+   *
+   * @return True if the item was added, false if it was dropped because the
+   * queue was full.
+   */
+  bool push(ItemType &&item) {
+    bool dropped_item = false;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      if (queue_.size() >= max_queue_size_) {
+        switch (queue_full_policy_) {
+          case BLOCK_PRODUCER:
+            space_available_cv_.wait(
+                lock, [&]() { return queue_.size() < max_queue_size_; });
+            break;
+          case DROP_OLDEST:
+            queue_.pop_front();
+            num_dropped_items_++;
+            break;
+          case DROP_NEWEST:
+          default:
+            num_dropped_items_++;
+            dropped_item = true;
+            break;
+        }
+      }
+      if (!dropped_item) {
+        queue_.emplace_back(std::move(item));
+      }
+    }
+    if (!dropped_item) {
+      item_available_cv_.notify_one();
+    }
+    return !dropped_item;
+  }
+
+  /**
+   * Block until all items added so far have been processed.
+   */
+  void waitUntilEmpty() {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    queue_drained_cv_.wait(
+        lock, [&]() { return queue_.empty() && !processing_item_; });
+  }
+
+  /**
+   * Get the number of items that were dropped because the queue was full.
+   *
+   * @return Number of dropped items.
+   */
+  size_t getNumDroppedItems() {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    return num_dropped_items_;
+  }
+
+ private:
+  size_t max_queue_size_;
+  QueueFullPolicy queue_full_policy_;
+  std::function<void(ItemType &)> item_processor_;
+
+  std::mutex queue_mutex_;
+  std::condition_variable item_available_cv_;
+  std::condition_variable space_available_cv_;
+  std::condition_variable queue_drained_cv_;
+  std::deque<ItemType> queue_;
+  bool stop_requested_;
+  bool processing_item_;
+  size_t num_dropped_items_;
+
+  std::thread worker_thread_;
+
+  void processItems() {
+    while (true) {
+      ItemType item;
+      {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        item_available_cv_.wait(
+            lock, [&]() { return stop_requested_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          // Only get here if a stop was requested and everything was processed
+          return;
+        }
+        item = std::move(queue_.front());
+        queue_.pop_front();
+        processing_item_ = true;
+      }
+      space_available_cv_.notify_one();
+      item_processor_(item);
+      {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        processing_item_ = false;
+      }
+      queue_drained_cv_.notify_all();
+    }
+  }
+};
+
+}  // namespace util
+
+#endif  // UT_VSLAM_ASYNC_WORK_QUEUE_H
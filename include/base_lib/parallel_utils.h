@@ -0,0 +1,78 @@
+//
+// Created by amanda on 3/2/23.
+//
+
+#ifndef UT_VSLAM_PARALLEL_UTILS_H
+#define UT_VSLAM_PARALLEL_UTILS_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * Get the number of worker threads to use, given a requested number.
+ *
+ * @param requested_num_threads Requested number of threads. If this is not
+ *                              positive, the hardware concurrency is used.
+ * @param num_items             Number of work items. No more threads than
+ *                              items will be used.
+ *
+ * @return Number of threads to use (at least 1).
+ */
+inline size_t getNumWorkerThreads(const int &requested_num_threads,
+                                  const size_t &num_items) {
+  size_t num_threads = (requested_num_threads > 0)
+                           ? (size_t)requested_num_threads
+                           : (size_t)std::thread::hardware_concurrency();
+  num_threads = std::min(num_threads, num_items);
+  return std::max(num_threads, (size_t)1);
+}
+
+/**
+ * Execute the given function for each index in [0, num_items), distributing
+ * the indices across worker threads. Each index is processed exactly once.
+ * The function must be safe to call concurrently for different indices.
+ *
+ * @param num_items             Number of items to process.
+ * @param requested_num_threads Number of threads to use. If not positive, the
+ *                              hardware concurrency is used. If 1, items are
+ *                              processed serially on the calling thread.
+ * @param item_processor        Function to run for each item index.
+ */
+inline void parallelFor(
+    const size_t &num_items,
+    const int &requested_num_threads,
+    const std::function<void(const size_t &)> &item_processor) {
+  size_t num_threads = getNumWorkerThreads(requested_num_threads, num_items);
+  if (num_threads <= 1) {
+    for (size_t item_idx = 0; item_idx < num_items; item_idx++) {
+      item_processor(item_idx);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next_item_idx(0);
+  std::function<void()> worker = [&]() {
+    size_t item_idx;
+    while ((item_idx = next_item_idx.fetch_add(1)) < num_items) {
+      item_processor(item_idx);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t thread_num = 1; thread_num < num_threads; thread_num++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (std::thread &worker_thread : workers) {
+    worker_thread.join();
+  }
+}
+
+}  // namespace util
+
+#endif  // UT_VSLAM_PARALLEL_UTILS_H
@@ -0,0 +1,256 @@
+//
+// Created by amanda on 3/12/23.
+//
+
+#ifndef UT_VSLAM_FRAME_TELEMETRY_LOGGER_H
+#define UT_VSLAM_FRAME_TELEMETRY_LOGGER_H
+
+#include <glog/logging.h>
+#include <refactoring/types/vslam_basic_types_refactor.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace vslam_types_refactor {
+
+/**
+ * Stages of processing a frame that are timed separately.
+ */
+enum FrameTelemetryStage {
+  FRONT_END,
+  BUILD_OPTIMIZATION,
+  SOLVE_OPTIMIZATION,
+  OUTLIER_IDENTIFICATION,
+  PGO_PLUS_OBJECTS,
+  VISUALIZATION,
+  NUM_FRAME_TELEMETRY_STAGES
+};
+
+const std::array<std::string, NUM_FRAME_TELEMETRY_STAGES>
+    kFrameTelemetryStageNames = {"front_end",
+                                 "build",
+                                 "solve",
+                                 "outlier",
+                                 "pgo_plus_objects",
+                                 "visualization"};
+
+/**
+ * Flush the buffered records to the file once they reach this size.
+ */
+const size_t kDefaultFrameTelemetryBufferBytes = 1 << 16;
+
+struct FrameTelemetryRecord {
+  FrameId frame_id_ = 0;
+  double total_time_ = 0;
+  std::array<double, NUM_FRAME_TELEMETRY_STAGES> stage_times_ = {};
+  size_t num_solves_ = 0;
+  size_t num_ceres_iterations_ = 0;
+  // Keyed by factor type id
+  std::map<int, size_t> num_residuals_by_factor_type_;
+  size_t rss_bytes_ = 0;
+  size_t peak_rss_bytes_ = 0;
+};
+
+/**
+ * Get the resident set size of this process.
+ *
+ * @param rss_bytes[out]      Current resident set size.
+ * @param peak_rss_bytes[out] Largest resident set size so far.
+ */
+inline void getProcessRss(size_t &rss_bytes, size_t &peak_rss_bytes) {
+  rss_bytes = 0;
+  FILE *statm_file = fopen("/proc/self/statm", "r");
+  if (statm_file != nullptr) {
+    unsigned long total_pages;
+    unsigned long resident_pages;
+    if (fscanf(statm_file, "%lu %lu", &total_pages, &resident_pages) == 2) {
+      rss_bytes = resident_pages * (size_t)sysconf(_SC_PAGESIZE);
+    }
+    fclose(statm_file);
+  }
+  struct rusage usage;
+  peak_rss_bytes = 0;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    // Reported in kilobytes on Linux
+    peak_rss_bytes = (size_t)usage.ru_maxrss * 1024;
+  }
+}
+
+/**
+ * Writes one telemetry record per processed frame as newline-delimited JSON.
+ * Records are buffered in memory and written in large blocks, so logging a
+ * frame doesn't touch the file system.
+ *
+ * Only stage times reported between startFrame and finishFrame are recorded.
+ * Not thread safe.
+ */
+class FrameTelemetryLogger {
+ public:
+  FrameTelemetryLogger(
+      const std::string &output_file_path,
+      const size_t &buffer_bytes = kDefaultFrameTelemetryBufferBytes)
+      : output_file_(output_file_path, std::ios::trunc),
+        buffer_bytes_(buffer_bytes) {
+    if (!output_file_.is_open()) {
+      LOG(WARNING) << "Could not open frame telemetry file "
+                   << output_file_path << "; telemetry will not be written";
+    }
+    buffer_.reserve(buffer_bytes_ + kMaxRecordBytes);
+  }
+
+  ~FrameTelemetryLogger() { flush(); }
+
+  FrameTelemetryLogger(const FrameTelemetryLogger &) = delete;
+  FrameTelemetryLogger &operator=(const FrameTelemetryLogger &) = delete;
+
+  void startFrame(const FrameId &frame_id) {
+    current_record_ = FrameTelemetryRecord();
+    current_record_.frame_id_ = frame_id;
+    frame_start_time_ = std::chrono::steady_clock::now();
+    frame_in_progress_ = true;
+  }
+
+  bool frameInProgress() const { return frame_in_progress_; }
+
+  void addStageTime(const FrameTelemetryStage &stage, const double &seconds) {
+    if (frame_in_progress_) {
+      current_record_.stage_times_[stage] += seconds;
+    }
+  }
+
+  void addSolve(const size_t &num_ceres_iterations) {
+    if (frame_in_progress_) {
+      current_record_.num_solves_++;
+      current_record_.num_ceres_iterations_ += num_ceres_iterations;
+    }
+  }
+
+  /**
+   * Set the number of residuals in the most recently built optimization.
+   */
+  void setResidualCounts(
+      const std::map<int, size_t> &num_residuals_by_factor_type) {
+    if (frame_in_progress_) {
+      current_record_.num_residuals_by_factor_type_ =
+          num_residuals_by_factor_type;
+    }
+  }
+
+  void finishFrame() {
+    if (!frame_in_progress_) {
+      return;
+    }
+    frame_in_progress_ = false;
+    current_record_.total_time_ =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                      frame_start_time_)
+            .count();
+    getProcessRss(current_record_.rss_bytes_,
+                  current_record_.peak_rss_bytes_);
+    appendRecord(current_record_);
+    if (buffer_.size() >= buffer_bytes_) {
+      flush();
+    }
+  }
+
+  void flush() {
+    if ((!buffer_.empty()) && output_file_.is_open()) {
+      output_file_.write(buffer_.data(), buffer_.size());
+      output_file_.flush();
+    }
+    buffer_.clear();
+  }
+
+ private:
+  // Generous upper bound on the size of one serialized record
+  static const size_t kMaxRecordBytes = 1024;
+
+  std::ofstream output_file_;
+  size_t buffer_bytes_;
+  std::string buffer_;
+
+  bool frame_in_progress_ = false;
+  FrameTelemetryRecord current_record_;
+  std::chrono::steady_clock::time_point frame_start_time_;
+
+  void appendRecord(const FrameTelemetryRecord &record) {
+    char number_buffer[64];
+    buffer_ += "{\"frame_id\":" + std::to_string(record.frame_id_);
+    snprintf(number_buffer,
+             sizeof(number_buffer),
+             ",\"total_time\":%.9g",
+             record.total_time_);
+    buffer_ += number_buffer;
+    buffer_ += ",\"stage_times\":{";
+    for (size_t stage = 0; stage < NUM_FRAME_TELEMETRY_STAGES; stage++) {
+      snprintf(number_buffer,
+               sizeof(number_buffer),
+               "%s\"%s\":%.9g",
+               (stage == 0) ? "" : ",",
+               kFrameTelemetryStageNames[stage].c_str(),
+               record.stage_times_[stage]);
+      buffer_ += number_buffer;
+    }
+    buffer_ += "},\"num_solves\":" + std::to_string(record.num_solves_);
+    buffer_ += ",\"num_ceres_iterations\":" +
+               std::to_string(record.num_ceres_iterations_);
+    buffer_ += ",\"num_residuals_by_factor_type\":{";
+    bool first_factor_type = true;
+    for (const auto &factor_type_and_count :
+         record.num_residuals_by_factor_type_) {
+      if (!first_factor_type) {
+        buffer_ += ",";
+      }
+      first_factor_type = false;
+      buffer_ += "\"" + std::to_string(factor_type_and_count.first) +
+                 "\":" + std::to_string(factor_type_and_count.second);
+    }
+    buffer_ += "},\"rss_bytes\":" + std::to_string(record.rss_bytes_);
+    buffer_ +=
+        ",\"peak_rss_bytes\":" + std::to_string(record.peak_rss_bytes_) + "}\n";
+  }
+};
+
+/**
+ * Adds the time from its creation to its destruction to a stage of the
+ * current frame's telemetry record. Does nothing if there is no logger.
+ */
+class FrameTelemetryStageTimer {
+ public:
+  FrameTelemetryStageTimer(FrameTelemetryLogger *telemetry_logger,
+                           const FrameTelemetryStage &stage)
+      : telemetry_logger_(telemetry_logger), stage_(stage) {
+    if (telemetry_logger_ != nullptr) {
+      start_time_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~FrameTelemetryStageTimer() {
+    if (telemetry_logger_ != nullptr) {
+      telemetry_logger_->addStageTime(
+          stage_,
+          std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                        start_time_)
+              .count());
+    }
+  }
+
+  FrameTelemetryStageTimer(const FrameTelemetryStageTimer &) = delete;
+  FrameTelemetryStageTimer &operator=(const FrameTelemetryStageTimer &) =
+      delete;
+
+ private:
+  FrameTelemetryLogger *telemetry_logger_;
+  FrameTelemetryStage stage_;
+  std::chrono::steady_clock::time_point start_time_;
+};
+
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_FRAME_TELEMETRY_LOGGER_H
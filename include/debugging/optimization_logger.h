@@ -6,9 +6,12 @@
 #define UT_VSLAM_OPTIMIZATION_LOGGER_H
 
 #include <ceres/solver.h>
+#include <debugging/frame_telemetry_logger.h>
 #include <file_io/file_io_utils.h>
 #include <refactoring/types/vslam_obj_opt_types_refactor.h>
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_set>
 
@@ -28,12 +31,37 @@ struct CurrentOptimizationInfo {
   double jacobian_time_;
   double residual_time_;
   size_t num_ceres_iterations_;
+  // Not written to the CSV file
+  double initial_cost_;
+  double final_cost_;
 };
 
 class OptimizationLogger {
  public:
-  OptimizationLogger(const std::string &output_file_path)
-      : output_file_path_(output_file_path) {}
+  /**
+   * Create the logger.
+   *
+   * @param output_file_path            CSV file to write one line per
+   *                                    optimization to.
+   * @param frame_telemetry_file_path   File to write per-frame telemetry to
+   *                                    (newline-delimited JSON). If empty, no
+   *                                    telemetry is recorded.
+   */
+  OptimizationLogger(const std::string &output_file_path,
+                     const std::string &frame_telemetry_file_path = "")
+      : output_file_path_(output_file_path) {
+    if (!frame_telemetry_file_path.empty()) {
+      frame_telemetry_ =
+          std::make_shared<FrameTelemetryLogger>(frame_telemetry_file_path);
+    }
+  }
+
+  /**
+   * Get the per-frame telemetry logger (nullptr if telemetry is disabled).
+   */
+  FrameTelemetryLogger *getFrameTelemetryLogger() const {
+    return frame_telemetry_.get();
+  }
 
   void setOptimizationTypeParams(const FrameId &max_frame_id,
                                  const bool &global_ba,
@@ -55,6 +83,13 @@ class OptimizationLogger {
     current_opt_info_.num_poses_ = optimized_frames.size();
   }
 
+  void setResidualCountsByFactorType(
+      const std::map<int, size_t> &num_residuals_by_factor_type) {
+    if (frame_telemetry_ != nullptr) {
+      frame_telemetry_->setResidualCounts(num_residuals_by_factor_type);
+    }
+  }
+
   void extractOptimizationTimingResults(
       const ceres::Solver::Summary &ceres_solver_summary) {
     current_opt_info_.total_ceres_time_ =
@@ -67,6 +102,15 @@ class OptimizationLogger {
         ceres_solver_summary.residual_evaluation_time_in_seconds;
     current_opt_info_.num_ceres_iterations_ =
         ceres_solver_summary.iterations.size();
+    current_opt_info_.initial_cost_ = ceres_solver_summary.initial_cost;
+    current_opt_info_.final_cost_ = ceres_solver_summary.final_cost;
+    if (frame_telemetry_ != nullptr) {
+      frame_telemetry_->addSolve(ceres_solver_summary.iterations.size());
+    }
+  }
+
+  const CurrentOptimizationInfo &getCurrentOptInfo() const {
+    return current_opt_info_;
   }
 
   void writeCurrentOptInfo() {
@@ -112,8 +156,23 @@ class OptimizationLogger {
  private:
   std::string output_file_path_;
   CurrentOptimizationInfo current_opt_info_;
+
+  // Shared so that the logger can still be copied
+  std::shared_ptr<FrameTelemetryLogger> frame_telemetry_;
 };
 
+/**
+ * Get the per-frame telemetry logger of an optional optimization logger
+ * (nullptr if there is no logger or it doesn't record telemetry).
+ */
+inline FrameTelemetryLogger *getFrameTelemetryLogger(
+    const std::optional<OptimizationLogger> &opt_logger) {
+  if (!opt_logger.has_value()) {
+    return nullptr;
+  }
+  return opt_logger->getFrameTelemetryLogger();
+}
+
 }  // namespace vslam_types_refactor
 
 #endif  // UT_VSLAM_OPTIMIZATION_LOGGER_H
@@ -0,0 +1,177 @@
+//
+// Created by amanda on 3/19/23.
+//
+
+#ifndef UT_VSLAM_POSITION_KD_TREE_H
+#define UT_VSLAM_POSITION_KD_TREE_H
+
+#include <refactoring/types/vslam_basic_types_refactor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+/**
+ * Static KD-tree over 3D positions, each with an identifier. The tree is
+ * stored implicitly: the median of each range of the point array is the node
+ * splitting that range, so no node structure is allocated.
+ */
+class PositionKdTree {
+ public:
+  PositionKdTree() = default;
+
+  /**
+   * Build the tree.
+   *
+   * @param points_with_ids Identifier and position of each point.
+   */
+  explicit PositionKdTree(
+      const std::vector<std::pair<ObjectId, Position3d<double>>>
+          &points_with_ids)
+      : points_with_ids_(points_with_ids),
+        split_dims_(points_with_ids.size(), 0) {
+    build(0, points_with_ids_.size());
+  }
+
+  size_t size() const { return points_with_ids_.size(); }
+
+  /**
+   * Find all points within the radius of the query.
+   *
+   * @param query                 Query position.
+   * @param radius                Maximum distance (inclusive).
+   * @param ids_and_dists[out]    Identifier of and distance to each point in
+   *                              the radius (appended, in no particular
+   *                              order).
+   */
+  void radiusSearch(
+      const Position3d<double> &query,
+      const double &radius,
+      std::vector<std::pair<ObjectId, double>> &ids_and_dists) const {
+    radiusSearch(0, points_with_ids_.size(), query, radius, ids_and_dists);
+  }
+
+  /**
+   * Find the point closest to the query. Ties are broken by the smaller
+   * identifier.
+   *
+   * @param query     Query position.
+   * @param max_dist  Maximum distance (inclusive) of the point to return.
+   *
+   * @return Identifier of and distance to the closest point, or nullopt if
+   * there is no point within max_dist.
+   */
+  std::optional<std::pair<ObjectId, double>> nearest(
+      const Position3d<double> &query,
+      const double &max_dist =
+          std::numeric_limits<double>::infinity()) const {
+    std::optional<std::pair<ObjectId, double>> closest;
+    nearest(0, points_with_ids_.size(), query, max_dist, closest);
+    return closest;
+  }
+
+ private:
+  std::vector<std::pair<ObjectId, Position3d<double>>> points_with_ids_;
+
+  /**
+   * Dimension that the node at each index splits on.
+   */
+  std::vector<int> split_dims_;
+
+  void build(const size_t &begin, const size_t &end) {
+    if (end - begin <= 1) {
+      return;
+    }
+    // Split on the dimension with the largest extent
+    Position3d<double> min_corner = points_with_ids_[begin].second;
+    Position3d<double> max_corner = min_corner;
+    for (size_t idx = begin + 1; idx < end; idx++) {
+      min_corner = min_corner.cwiseMin(points_with_ids_[idx].second);
+      max_corner = max_corner.cwiseMax(points_with_ids_[idx].second);
+    }
+    int split_dim;
+    (max_corner - min_corner).maxCoeff(&split_dim);
+
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(points_with_ids_.begin() + begin,
+                     points_with_ids_.begin() + mid,
+                     points_with_ids_.begin() + end,
+                     [&](const std::pair<ObjectId, Position3d<double>> &lhs,
+                         const std::pair<ObjectId, Position3d<double>> &rhs) {
+                       return lhs.second(split_dim) < rhs.second(split_dim);
+                     });
+    split_dims_[mid] = split_dim;
+    build(begin, mid);
+    build(mid + 1, end);
+  }
+
+  void radiusSearch(
+      const size_t &begin,
+      const size_t &end,
+      const Position3d<double> &query,
+      const double &radius,
+      std::vector<std::pair<ObjectId, double>> &ids_and_dists) const {
+    if (begin >= end) {
+      return;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    const std::pair<ObjectId, Position3d<double>> &node =
+        points_with_ids_[mid];
+    double dist = (node.second - query).norm();
+    if (dist <= radius) {
+      ids_and_dists.emplace_back(std::make_pair(node.first, dist));
+    }
+    double offset_from_split =
+        query(split_dims_[mid]) - node.second(split_dims_[mid]);
+    if (offset_from_split <= radius) {
+      radiusSearch(begin, mid, query, radius, ids_and_dists);
+    }
+    if (-offset_from_split <= radius) {
+      radiusSearch(mid + 1, end, query, radius, ids_and_dists);
+    }
+  }
+
+  void nearest(const size_t &begin,
+               const size_t &end,
+               const Position3d<double> &query,
+               const double &max_dist,
+               std::optional<std::pair<ObjectId, double>> &closest) const {
+    if (begin >= end) {
+      return;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    const std::pair<ObjectId, Position3d<double>> &node =
+        points_with_ids_[mid];
+    double dist = (node.second - query).norm();
+    if (dist <= max_dist) {
+      if ((!closest.has_value()) || (dist < closest->second) ||
+          ((dist == closest->second) && (node.first < closest->first))) {
+        closest = std::make_pair(node.first, dist);
+      }
+    }
+
+    // Search the side of the split containing the query first, so the other
+    // side can usually be pruned
+    double offset_from_split =
+        query(split_dims_[mid]) - node.second(split_dims_[mid]);
+    std::pair<size_t, size_t> near_range = std::make_pair(begin, mid);
+    std::pair<size_t, size_t> far_range = std::make_pair(mid + 1, end);
+    if (offset_from_split > 0) {
+      std::swap(near_range, far_range);
+    }
+    nearest(near_range.first, near_range.second, query, max_dist, closest);
+    double far_bound =
+        closest.has_value() ? std::min(closest->second, max_dist) : max_dist;
+    if (std::abs(offset_from_split) <= far_bound) {
+      nearest(far_range.first, far_range.second, query, max_dist, closest);
+    }
+  }
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_POSITION_KD_TREE_H
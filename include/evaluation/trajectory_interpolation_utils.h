@@ -17,6 +17,64 @@ const double kTranslErrorMultForRotError = 0.05;
 const double kRotErrorMultForTranslError = 0.05;
 const double kRotErrorMultForRotError = 0.05;
 
+const double kClosedFormInterpMaxTranslDiscrepancy = 0.25;
+const double kClosedFormInterpMaxRotDiscrepancy = 0.05;
+const double kClosedFormInterpMaxFactorTranslError = 0.02;
+const double kClosedFormInterpMaxFactorRotError = 0.01;
+
+/**
+ * Parameters controlling how the interpolation problem is split up and solved.
+ *
+ * The fixed (coarse trajectory) poses split the trajectory into independent
+ * segments, each of which is solved separately (and in parallel). If the
+ * odometry within a segment is consistent with the fixed poses bounding it,
+ * the segment is solved in closed form by distributing the discrepancy between
+ * the dead-reckoned and fixed end pose along the segment (SE(3) geodesic
+ * interpolation), instead of running an optimization.
+ *
+ * Both are opt-in: by default, the whole trajectory is solved in a single
+ * optimization.
+ */
+struct SegmentedInterpolationParams {
+  /**
+   * True if the problem should be split into segments. If false, the whole
+   * trajectory is solved in a single optimization (and the remaining
+   * parameters are unused).
+   */
+  bool solve_in_segments_ = false;
+
+  /**
+   * Number of threads to use for solving segments. If not positive, the
+   * hardware concurrency is used.
+   */
+  int num_threads_ = -1;
+
+  /**
+   * True if the closed form solution should be used for segments whose
+   * odometry is consistent with the bounding fixed poses.
+   */
+  bool use_closed_form_when_consistent_ = false;
+
+  /**
+   * Maximum translation (m) and rotation (rad) discrepancy between the fixed
+   * pose at the end of a segment and the dead-reckoned pose at that timestamp
+   * for the closed form solution to be attempted.
+   */
+  double closed_form_max_transl_discrepancy_ =
+      kClosedFormInterpMaxTranslDiscrepancy;
+  double closed_form_max_rot_discrepancy_ = kClosedFormInterpMaxRotDiscrepancy;
+
+  /**
+   * Maximum translation (m) and rotation (rad) error of any factor in the
+   * segment after applying the closed form solution for it to be accepted.
+   * Segments that exceed this are optimized, using the closed form solution
+   * as the initial estimate.
+   */
+  double closed_form_max_factor_transl_error_ =
+      kClosedFormInterpMaxFactorTranslError;
+  double closed_form_max_factor_rot_error_ = kClosedFormInterpMaxFactorRotError;
+};
+
 struct RelativePoseFactorInfo {
   Pose3D<double> measured_pose_deviation_;
   Covariance<double, 6> pose_deviation_cov_;
@@ -45,8 +103,9 @@ void interpolate3dPosesUsingOdom(
         void(const util::BoostHashMap<pose::Timestamp, Pose3D<double>> &,
              const std::vector<RelativePoseFactorInfo> &)> &vis_function,
     util::BoostHashMap<pose::Timestamp, Pose3D<double>> &interpolated_poses,
-    util::BoostHashMap<pose::Timestamp, Pose3D<double>>
-        &odom_poses_adjusted_3d);
+    util::BoostHashMap<pose::Timestamp, Pose3D<double>> &odom_poses_adjusted_3d,
+    const SegmentedInterpolationParams &segment_params =
+        SegmentedInterpolationParams());
 
 }  // namespace vslam_types_refactor
 
@@ -0,0 +1,86 @@
+//
+// Created by amanda on 3/3/23.
+//
+
+#ifndef UT_VSLAM_ASYNC_CHECKPOINT_WRITER_H
+#define UT_VSLAM_ASYNC_CHECKPOINT_WRITER_H
+
+#include <base_lib/async_work_queue.h>
+#include <glog/logging.h>
+
+#include <functional>
+#include <string>
+
+namespace file_io {
+
+/**
+ * State to write and the file to write it to.
+ *
+ * @tparam StateType Type of the checkpointed state.
+ */
+template <typename StateType>
+struct Checkpoint {
+  StateType state_;
+  std::string out_file_;
+};
+
+/**
+ * Writes checkpoints on a background thread.
+ *
+ * The caller only has to snapshot the state; the (much slower) serialization
+ * happens on the writer thread. At most one checkpoint is written while one
+ * more waits, so memory use stays bounded; if both slots are in use, the
+ * caller blocks until the write finishes. Checkpoints are never dropped. The
+ * state writer is expected to replace each file atomically.
+ *
+ * @tparam StateType Type of the checkpointed state.
+ */
+template <typename StateType>
+class AsyncCheckpointWriter {
+ public:
+  /**
+   * Create the writer.
+   *
+   * @param state_writer Function that writes a state to the given file.
+   */
+  AsyncCheckpointWriter(
+      const std::function<void(const StateType &, const std::string &)>
+          &state_writer)
+      : checkpoint_queue_(kMaxPendingCheckpoints,
+                          util::BLOCK_PRODUCER,
+                          [state_writer](Checkpoint<StateType> &checkpoint) {
+                            state_writer(checkpoint.state_,
+                                         checkpoint.out_file_);
+                            VLOG(2) << "Wrote checkpoint "
+                                    << checkpoint.out_file_;
+                          }) {}
+
+  /**
+   * Queue a state snapshot to be written.
+   *
+   * @param state     State to write. Moved into the queue.
+   * @param out_file  File to write the checkpoint to.
+   */
+  void writeCheckpoint(StateType &&state, const std::string &out_file) {
+    Checkpoint<StateType> checkpoint;
+    checkpoint.state_ = std::move(state);
+    checkpoint.out_file_ = out_file;
+    checkpoint_queue_.push(std::move(checkpoint));
+  }
+
+  /**
+   * Block until all queued checkpoints have been written.
+   */
+  void flush() { checkpoint_queue_.waitUntilEmpty(); }
+
+ private:
+  /**
+   * Number of checkpoints that can wait while another one is being written.
+   */
+  static const size_t kMaxPendingCheckpoints = 1;
+
+  util::AsyncWorkQueue<Checkpoint<StateType>> checkpoint_queue_;
+};
+}  // namespace file_io
+
+#endif  // UT_VSLAM_ASYNC_CHECKPOINT_WRITER_H
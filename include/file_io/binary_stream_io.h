@@ -0,0 +1,334 @@
+//
+// Created by amanda on 3/5/23.
+//
+
+#ifndef UT_VSLAM_BINARY_STREAM_IO_H
+#define UT_VSLAM_BINARY_STREAM_IO_H
+
+#include <file_io/file_access_utils.h>
+#include <glog/logging.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace file_io {
+
+#if !defined(__BYTE_ORDER__) || (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+// Binary stream files are written with the host byte order.
+#error "Binary stream files require a little endian host"
+#endif
+
+const static std::string kBinaryExtension = ".bin";
+
+/**
+ * Bytes at the start of every binary stream file.
+ */
+const static char kBinaryStreamMagic[] = {'U', 'T', 'V', 'S', 'B', 'I', 'N', 0};
+
+/**
+ * Version of the layout of the binary stream file header. Increment if the
+ * header (not the content) changes.
+ */
+const static uint32_t kBinaryStreamFormatVersion = 1;
+
+/**
+ * Check if a file should be read/written with the binary stream format (based
+ * on its extension).
+ *
+ * @param file_name File name.
+ *
+ * @return True if the file has the binary extension.
+ */
+inline bool isBinaryStreamFile(const std::string &file_name) {
+  return (file_name.size() >= kBinaryExtension.size()) &&
+         (file_name.compare(file_name.size() - kBinaryExtension.size(),
+                            kBinaryExtension.size(),
+                            kBinaryExtension) == 0);
+}
+
+/**
+ * Writes flat little-endian binary data to a file.
+ *
+ * Layout: magic bytes, format version (uint32), content type string, content
+ * version (uint32), followed by the content. Strings and arrays are stored as
+ * a uint64 length followed by the raw elements, so large arrays (i.e. the
+ * values of a sparse matrix) are written with a single call and can be read
+ * directly into memory (i.e. with MATLAB's fread).
+ *
+ * The data is written to a temporary file that replaces the output file when
+ * the writer is closed, so readers never see a partially written file.
+ */
+class BinaryStreamWriter {
+ public:
+  /**
+   * Open the file and write the header.
+   *
+   * @param out_file          File to write.
+   * @param content_type      Identifier for the content of the file (checked
+   *                          by the reader).
+   * @param content_version   Version of the content layout (checked by the
+   *                          reader).
+   */
+  BinaryStreamWriter(const std::string &out_file,
+                     const std::string &content_type,
+                     const uint32_t &content_version)
+      : out_file_(out_file),
+        temp_file_(getTempFileForAtomicWrite(out_file)),
+        stream_buffer_(new char[kStreamBufferSize]),
+        closed_(false) {
+    stream_.rdbuf()->pubsetbuf(stream_buffer_.get(), kStreamBufferSize);
+    stream_.open(temp_file_, std::ios::binary | std::ios::trunc);
+    if (!stream_.is_open()) {
+      LOG(ERROR) << "Could not open " << temp_file_ << " for writing";
+    }
+    stream_.write(kBinaryStreamMagic, sizeof(kBinaryStreamMagic));
+    writeScalar(kBinaryStreamFormatVersion);
+    writeString(content_type);
+    writeScalar(content_version);
+  }
+
+  ~BinaryStreamWriter() { close(); }
+
+  BinaryStreamWriter(const BinaryStreamWriter &) = delete;
+  BinaryStreamWriter &operator=(const BinaryStreamWriter &) = delete;
+
+  template <typename ScalarType>
+  void writeScalar(const ScalarType &value) {
+    static_assert(std::is_arithmetic<ScalarType>::value,
+                  "Only arithmetic types can be written as scalars");
+    stream_.write(reinterpret_cast<const char *>(&value), sizeof(ScalarType));
+  }
+
+  void writeBool(const bool &value) { writeScalar((uint8_t)(value ? 1 : 0)); }
+
+  void writeString(const std::string &value) {
+    writeScalar((uint64_t)value.size());
+    stream_.write(value.data(), value.size());
+  }
+
+  template <typename ScalarType>
+  void writeArray(const std::vector<ScalarType> &values) {
+    writeArray(values.data(), values.size());
+  }
+
+  template <typename ScalarType>
+  void writeArray(const ScalarType *values, const size_t &num_values) {
+    static_assert(std::is_arithmetic<ScalarType>::value,
+                  "Only arrays of arithmetic types can be written directly");
+    writeScalar((uint64_t)num_values);
+    stream_.write(reinterpret_cast<const char *>(values),
+                  num_values * sizeof(ScalarType));
+  }
+
+  template <typename ScalarType>
+  void writeOptionalScalar(const std::optional<ScalarType> &value) {
+    writeBool(value.has_value());
+    if (value.has_value()) {
+      writeScalar(value.value());
+    }
+  }
+
+  /**
+   * Finish writing and move the file to its final location. Called by the
+   * destructor if not called explicitly.
+   *
+   * @return True if everything was written successfully.
+   */
+  bool close() {
+    if (closed_) {
+      return true;
+    }
+    closed_ = true;
+    stream_.close();
+    if (stream_.fail()) {
+      LOG(ERROR) << "Failed writing binary file " << temp_file_;
+      return false;
+    }
+    return commitAtomicallyWrittenFile(temp_file_, out_file_);
+  }
+
+ private:
+  /**
+   * Size of the buffer used for the file stream. Much larger than the default
+   * so that large dumps are written with few system calls.
+   */
+  static const size_t kStreamBufferSize = 1 << 20;
+
+  std::string out_file_;
+  std::string temp_file_;
+  std::unique_ptr<char[]> stream_buffer_;
+  std::ofstream stream_;
+  bool closed_;
+};
+
+/**
+ * Reads files written by BinaryStreamWriter.
+ *
+ * Reads fail (return false) instead of reading past the end of the file or
+ * allocating more than the file could contain, so truncated or mismatched
+ * files are reported rather than crashing the reader.
+ */
+class BinaryStreamReader {
+ public:
+  /**
+   * Open the file and validate the header.
+   *
+   * @param in_file           File to read.
+   * @param content_type      Expected content type.
+   * @param content_version   Expected content version.
+   */
+  BinaryStreamReader(const std::string &in_file,
+                     const std::string &content_type,
+                     const uint32_t &content_version)
+      : in_file_(in_file),
+        stream_(in_file, std::ios::binary | std::ios::ate),
+        valid_(false) {
+    if (!stream_.is_open()) {
+      LOG(ERROR) << "Could not open " << in_file << " for reading";
+      return;
+    }
+    remaining_bytes_ = stream_.tellg();
+    stream_.seekg(0);
+    valid_ = true;
+
+    char magic[sizeof(kBinaryStreamMagic)];
+    if (!readBytes(magic, sizeof(magic)) ||
+        (std::memcmp(magic, kBinaryStreamMagic, sizeof(magic)) != 0)) {
+      LOG(ERROR) << in_file << " is not a binary stream file";
+      valid_ = false;
+      return;
+    }
+    uint32_t format_version;
+    std::string file_content_type;
+    uint32_t file_content_version;
+    if (!readScalar(format_version) || !readString(file_content_type) ||
+        !readScalar(file_content_version)) {
+      LOG(ERROR) << "Could not read header of " << in_file;
+      valid_ = false;
+      return;
+    }
+    if ((format_version != kBinaryStreamFormatVersion) ||
+        (file_content_type != content_type) ||
+        (file_content_version != content_version)) {
+      LOG(ERROR) << in_file << " has format version " << format_version
+                 << ", content " << file_content_type << " version "
+                 << file_content_version << ", but expected version "
+                 << kBinaryStreamFormatVersion << ", content " << content_type
+                 << " version " << content_version;
+      valid_ = false;
+    }
+  }
+
+  BinaryStreamReader(const BinaryStreamReader &) = delete;
+  BinaryStreamReader &operator=(const BinaryStreamReader &) = delete;
+
+  /**
+   * Check if the header was valid and all reads so far succeeded.
+   *
+   * @return True if the reader is in a valid state.
+   */
+  bool isValid() const { return valid_; }
+
+  template <typename ScalarType>
+  bool readScalar(ScalarType &value) {
+    static_assert(std::is_arithmetic<ScalarType>::value,
+                  "Only arithmetic types can be read as scalars");
+    return readBytes(reinterpret_cast<char *>(&value), sizeof(ScalarType));
+  }
+
+  bool readBool(bool &value) {
+    uint8_t raw_value;
+    if (!readScalar(raw_value)) {
+      return false;
+    }
+    value = (raw_value != 0);
+    return true;
+  }
+
+  bool readString(std::string &value) {
+    uint64_t size;
+    if (!readSize(size, sizeof(char))) {
+      return false;
+    }
+    value.resize(size);
+    return readBytes(value.data(), size);
+  }
+
+  template <typename ScalarType>
+  bool readArray(std::vector<ScalarType> &values) {
+    static_assert(std::is_arithmetic<ScalarType>::value,
+                  "Only arrays of arithmetic types can be read directly");
+    uint64_t size;
+    if (!readSize(size, sizeof(ScalarType))) {
+      return false;
+    }
+    values.resize(size);
+    return readBytes(reinterpret_cast<char *>(values.data()),
+                     size * sizeof(ScalarType));
+  }
+
+  template <typename ScalarType>
+  bool readOptionalScalar(std::optional<ScalarType> &value) {
+    bool has_value;
+    if (!readBool(has_value)) {
+      return false;
+    }
+    if (!has_value) {
+      value = std::nullopt;
+      return true;
+    }
+    ScalarType raw_value;
+    if (!readScalar(raw_value)) {
+      return false;
+    }
+    value = raw_value;
+    return true;
+  }
+
+ private:
+  std::string in_file_;
+  std::ifstream stream_;
+  uint64_t remaining_bytes_;
+  bool valid_;
+
+  bool readBytes(char *dest, const uint64_t &num_bytes) {
+    if (!valid_) {
+      return false;
+    }
+    if (num_bytes > remaining_bytes_) {
+      LOG(ERROR) << "Unexpected end of file " << in_file_;
+      valid_ = false;
+      return false;
+    }
+    stream_.read(dest, num_bytes);
+    if (!stream_) {
+      LOG(ERROR) << "Failed reading from " << in_file_;
+      valid_ = false;
+      return false;
+    }
+    remaining_bytes_ -= num_bytes;
+    return true;
+  }
+
+  bool readSize(uint64_t &size, const size_t &element_size) {
+    if (!readScalar(size)) {
+      return false;
+    }
+    if (size > (remaining_bytes_ / element_size)) {
+      LOG(ERROR) << "Array of " << size << " entries is larger than the rest "
+                 << "of " << in_file_;
+      valid_ = false;
+      return false;
+    }
+    return true;
+  }
+};
+}  // namespace file_io
+
+#endif  // UT_VSLAM_BINARY_STREAM_IO_H
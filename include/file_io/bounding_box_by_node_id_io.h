@@ -72,27 +72,29 @@ void writeBoundingBoxesWithNodeIdToFile(
 }
 
 void readBoundingBoxWithNodeIdLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     BoundingBoxWithNodeId &bounding_box) {
   size_t list_idx = 0;
 
-  bounding_box.min_pixel_x = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.min_pixel_y = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.max_pixel_x = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.max_pixel_y = std::stod(entries_in_file_line[list_idx++]);
+  bounding_box.min_pixel_x =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.min_pixel_y =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.max_pixel_x =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.max_pixel_y =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
 
   bounding_box.semantic_class = entries_in_file_line[list_idx++];
   boost::algorithm::trim(bounding_box.semantic_class);
 
-  std::istringstream node_id_stream(entries_in_file_line[list_idx++]);
-  node_id_stream >> bounding_box.node_id;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.node_id);
 
-  std::istringstream cam_id_stream(entries_in_file_line[list_idx++]);
-  cam_id_stream >> bounding_box.camera_id;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.camera_id);
 
   if (entries_in_file_line.size() > list_idx) {
     bounding_box.detection_confidence =
-        std::stod(entries_in_file_line[list_idx++]);
+        parseCsvField<double>(entries_in_file_line[list_idx++]);
   } else {
     bounding_box.detection_confidence = kDefaultBbWithNodeIdConfidence;
   }
@@ -101,7 +103,7 @@ void readBoundingBoxWithNodeIdLine(
 void readBoundingBoxesWithNodeIdFromFile(
     const std::string &file_name,
     std::vector<BoundingBoxWithNodeId> &bounding_boxes) {
-  std::function<void(const std::vector<std::string> &, BoundingBoxWithNodeId &)>
+  CsvLineReader<BoundingBoxWithNodeId>
       object_from_line_reader = readBoundingBoxWithNodeIdLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, bounding_boxes);
@@ -168,29 +170,30 @@ void writeBoundingBoxWithNodeIdAndIdsToFile(
 }
 
 void readBoundingBoxWithNodeIdAndIdLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     BoundingBoxWithNodeIdAndId &bounding_box) {
   size_t list_idx = 0;
-  std::istringstream ellipsoid_idx_stream(entries_in_file_line[list_idx++]);
-  ellipsoid_idx_stream >> bounding_box.ellipsoid_idx;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.ellipsoid_idx);
 
-  bounding_box.min_pixel_x = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.min_pixel_y = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.max_pixel_x = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.max_pixel_y = std::stod(entries_in_file_line[list_idx++]);
+  bounding_box.min_pixel_x =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.min_pixel_y =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.max_pixel_x =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.max_pixel_y =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
 
   bounding_box.semantic_class = entries_in_file_line[list_idx++];
   boost::algorithm::trim(bounding_box.semantic_class);
 
-  std::istringstream node_id_stream(entries_in_file_line[list_idx++]);
-  node_id_stream >> bounding_box.node_id;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.node_id);
 
-  std::istringstream cam_id_stream(entries_in_file_line[list_idx++]);
-  cam_id_stream >> bounding_box.camera_id;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.camera_id);
 
   if (entries_in_file_line.size() > list_idx) {
     bounding_box.detection_confidence =
-        std::stod(entries_in_file_line[list_idx++]);
+        parseCsvField<double>(entries_in_file_line[list_idx++]);
   } else {
     bounding_box.detection_confidence = kDefaultBbWithNodeIdConfidence;
   }
@@ -199,8 +202,7 @@ void readBoundingBoxWithNodeIdAndIdLine(
 void readBoundingBoxWithNodeIdAndIdsFromFile(
     const std::string &file_name,
     std::vector<BoundingBoxWithNodeIdAndId> &bounding_boxes) {
-  std::function<void(const std::vector<std::string> &,
-                     BoundingBoxWithNodeIdAndId &)>
+  CsvLineReader<BoundingBoxWithNodeIdAndId>
       object_from_line_reader = readBoundingBoxWithNodeIdAndIdLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, bounding_boxes);
@@ -141,66 +141,67 @@ void writeBoundingBoxWithTimestampsToFile(
 }
 
 void readBoundingBoxWithTimestampAndIdLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     BoundingBoxWithTimestampAndId &bounding_box) {
   size_t list_idx = 0;
-  std::istringstream ellipsoid_idx_stream(entries_in_file_line[list_idx++]);
-  ellipsoid_idx_stream >> bounding_box.ellipsoid_idx;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.ellipsoid_idx);
 
-  bounding_box.min_pixel_x = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.min_pixel_y = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.max_pixel_x = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.max_pixel_y = std::stod(entries_in_file_line[list_idx++]);
+  bounding_box.min_pixel_x =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.min_pixel_y =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.max_pixel_x =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.max_pixel_y =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
 
   bounding_box.semantic_class = entries_in_file_line[list_idx++];
   boost::algorithm::trim(bounding_box.semantic_class);
 
-  std::istringstream seconds_stream(entries_in_file_line[list_idx++]);
-  seconds_stream >> bounding_box.seconds;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.seconds);
 
-  std::istringstream nano_seconds_stream(entries_in_file_line[list_idx++]);
-  nano_seconds_stream >> bounding_box.nano_seconds;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.nano_seconds);
 
-  std::istringstream cam_id_stream(entries_in_file_line[list_idx++]);
-  cam_id_stream >> bounding_box.camera_id;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.camera_id);
 
   if (entries_in_file_line.size() < list_idx) {
     bounding_box.detection_confidence =
-        std::stod(entries_in_file_line[list_idx++]);
+        parseCsvField<double>(entries_in_file_line[list_idx++]);
   } else {
     bounding_box.detection_confidence = kDefaultBbWithNodeTimestampConfidence;
   }
 }
 
 void readBoundingBoxWithTimestampLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     BoundingBoxWithTimestamp &bounding_box) {
   std::string substr;
 
   size_t list_idx = 0;
 
-  bounding_box.min_pixel_x = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.min_pixel_y = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.max_pixel_x = std::stod(entries_in_file_line[list_idx++]);
-  bounding_box.max_pixel_y = std::stod(entries_in_file_line[list_idx++]);
+  bounding_box.min_pixel_x =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.min_pixel_y =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.max_pixel_x =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  bounding_box.max_pixel_y =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
 
   bounding_box.semantic_class = entries_in_file_line[list_idx++];
   boost::algorithm::trim(bounding_box.semantic_class);
 
-  std::istringstream seconds_stream(entries_in_file_line[list_idx++]);
-  seconds_stream >> bounding_box.seconds;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.seconds);
 
-  std::istringstream nano_seconds_stream(entries_in_file_line[list_idx++]);
-  nano_seconds_stream >> bounding_box.nano_seconds;
+  parseCsvField(entries_in_file_line[list_idx++], bounding_box.nano_seconds);
 
   bounding_box.camera_id = kDefaultCameraId;
   if (list_idx < entries_in_file_line.size()) {
-    std::istringstream cam_id_stream(entries_in_file_line[list_idx++]);
-    cam_id_stream >> bounding_box.camera_id;
+    parseCsvField(entries_in_file_line[list_idx++], bounding_box.camera_id);
   }
   if (list_idx < entries_in_file_line.size()) {
     bounding_box.detection_confidence =
-        std::stod(entries_in_file_line[list_idx++]);
+        parseCsvField<double>(entries_in_file_line[list_idx++]);
   } else {
     bounding_box.detection_confidence = kDefaultBbWithNodeTimestampConfidence;
   }
@@ -209,8 +210,7 @@ void readBoundingBoxWithTimestampLine(
 void readBoundingBoxWithTimestampAndIdsFromFile(
     const std::string &file_name,
     std::vector<BoundingBoxWithTimestampAndId> &bounding_boxes) {
-  std::function<void(const std::vector<std::string> &,
-                     BoundingBoxWithTimestampAndId &)>
+  CsvLineReader<BoundingBoxWithTimestampAndId>
       object_from_line_reader = readBoundingBoxWithTimestampAndIdLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, bounding_boxes);
@@ -219,8 +219,7 @@ void readBoundingBoxWithTimestampAndIdsFromFile(
 void readBoundingBoxWithTimestampsFromFile(
     const std::string &file_name,
     std::vector<BoundingBoxWithTimestamp> &bounding_boxes) {
-  std::function<void(const std::vector<std::string> &,
-                     BoundingBoxWithTimestamp &)>
+  CsvLineReader<BoundingBoxWithTimestamp>
       object_from_line_reader = readBoundingBoxWithTimestampLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, bounding_boxes);
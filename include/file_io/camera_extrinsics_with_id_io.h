@@ -26,33 +26,32 @@ struct CameraExtrinsicsWithId {
 };
 
 void readCameraExtrinsicsWithIdLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     CameraExtrinsicsWithId &camera_extrinsics_with_id) {
   size_t list_idx = 0;
-  std::istringstream stream_cam_id(entries_in_file_line[list_idx++]);
-  stream_cam_id >> camera_extrinsics_with_id.camera_id;
+  parseCsvField(entries_in_file_line[list_idx++],
+                camera_extrinsics_with_id.camera_id);
 
   camera_extrinsics_with_id.transl_x =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_extrinsics_with_id.transl_y =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_extrinsics_with_id.transl_z =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_extrinsics_with_id.quat_x =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_extrinsics_with_id.quat_y =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_extrinsics_with_id.quat_z =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_extrinsics_with_id.quat_w =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
 }
 
 void readCameraExtrinsicsWithIdsFromFile(
     const std::string &file_name,
     std::vector<CameraExtrinsicsWithId> &camera_extrinsics_with_ids) {
-  std::function<void(const std::vector<std::string> &,
-                     CameraExtrinsicsWithId &)>
+  CsvLineReader<CameraExtrinsicsWithId>
       object_from_line_reader = readCameraExtrinsicsWithIdLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, camera_extrinsics_with_ids);
@@ -30,43 +30,42 @@ struct CameraIntrinsicsWithId {
 };
 
 void readCameraIntrinsicsWithIdLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     CameraIntrinsicsWithId &camera_intrinsics_with_id) {
   size_t list_idx = 0;
-  std::istringstream stream_cam_id(entries_in_file_line[list_idx++]);
-  stream_cam_id >> camera_intrinsics_with_id.camera_id;
+  parseCsvField(entries_in_file_line[list_idx++],
+                camera_intrinsics_with_id.camera_id);
 
-  std::istringstream stream_img_width(entries_in_file_line[list_idx++]);
-  stream_img_width >> camera_intrinsics_with_id.img_width;
+  parseCsvField(entries_in_file_line[list_idx++],
+                camera_intrinsics_with_id.img_width);
 
-  std::istringstream stream_img_height(entries_in_file_line[list_idx++]);
-  stream_img_height >> camera_intrinsics_with_id.img_height;
+  parseCsvField(entries_in_file_line[list_idx++],
+                camera_intrinsics_with_id.img_height);
 
   camera_intrinsics_with_id.mat_00 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_intrinsics_with_id.mat_01 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_intrinsics_with_id.mat_02 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_intrinsics_with_id.mat_10 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_intrinsics_with_id.mat_11 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_intrinsics_with_id.mat_12 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_intrinsics_with_id.mat_20 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_intrinsics_with_id.mat_21 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
   camera_intrinsics_with_id.mat_22 =
-      std::stod(entries_in_file_line[list_idx++]);
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
 }
 
 void readCameraIntrinsicsWithIdsFromFile(
     const std::string &file_name,
     std::vector<CameraIntrinsicsWithId> &camera_intrinsics_with_ids) {
-  std::function<void(const std::vector<std::string> &,
-                     CameraIntrinsicsWithId &)>
+  CsvLineReader<CameraIntrinsicsWithId>
       object_from_line_reader = readCameraIntrinsicsWithIdLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, camera_intrinsics_with_ids);
@@ -0,0 +1,352 @@
+//
+// Created by amanda on 3/10/23.
+//
+
+#ifndef UT_VSLAM_CSV_TOKENIZER_H
+#define UT_VSLAM_CSV_TOKENIZER_H
+
+#include <base_lib/parallel_utils.h>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace file_io {
+
+/**
+ * Files smaller than this (per thread) are parsed on fewer threads, since
+ * starting a thread costs more than parsing a small chunk.
+ */
+const size_t kMinCsvBytesPerParseThread = 1 << 22;
+
+/**
+ * Read-only memory mapping of a whole text file.
+ */
+class MappedTextFile {
+ public:
+  MappedTextFile() = default;
+
+  ~MappedTextFile() { close(); }
+
+  MappedTextFile(const MappedTextFile &) = delete;
+  MappedTextFile &operator=(const MappedTextFile &) = delete;
+
+  /**
+   * Map the file.
+   *
+   * @param file_name Name of the file to map.
+   *
+   * @return True if the file could be opened. An empty file is mapped to
+   * empty contents.
+   */
+  bool open(const std::string &file_name) {
+    close();
+    int file_descriptor = ::open(file_name.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+      return false;
+    }
+    struct stat file_stat;
+    if (fstat(file_descriptor, &file_stat) != 0) {
+      ::close(file_descriptor);
+      return false;
+    }
+    size_t file_size = (size_t)file_stat.st_size;
+    if (file_size > 0) {
+      void *mapped =
+          mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+      if (mapped == MAP_FAILED) {
+        ::close(file_descriptor);
+        return false;
+      }
+      madvise(mapped, file_size, MADV_SEQUENTIAL);
+      data_ = static_cast<const char *>(mapped);
+      size_ = file_size;
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(file_descriptor);
+    return true;
+  }
+
+  void close() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char *>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  std::string_view contents() const { return std::string_view(data_, size_); }
+
+ private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/**
+ * Remove leading and trailing whitespace (including carriage returns) from a
+ * field.
+ */
+inline std::string_view trimCsvField(std::string_view field) {
+  const char *kWhitespace = " \t\r\n";
+  size_t start = field.find_first_not_of(kWhitespace);
+  if (start == std::string_view::npos) {
+    return std::string_view();
+  }
+  size_t end = field.find_last_not_of(kWhitespace);
+  return field.substr(start, end - start + 1);
+}
+
+/**
+ * Split a line into delimited fields without copying. Like splitting with
+ * getline, a trailing empty field (after a final delimiter) is not included
+ * and an empty line has no fields.
+ *
+ * @param line          Line to split. Must outlive the fields.
+ * @param fields[out]   Fields in the line (cleared first).
+ * @param delimiter     Character separating fields.
+ */
+inline void splitCsvLine(std::string_view line,
+                         std::vector<std::string_view> &fields,
+                         const char &delimiter = ',') {
+  fields.clear();
+  size_t field_start = 0;
+  while (field_start < line.size()) {
+    size_t field_end = line.find(delimiter, field_start);
+    if (field_end == std::string_view::npos) {
+      fields.emplace_back(line.substr(field_start));
+      return;
+    }
+    fields.emplace_back(line.substr(field_start, field_end - field_start));
+    field_start = field_end + 1;
+  }
+}
+
+inline std::vector<std::string_view> splitCsvLine(
+    std::string_view line, const char &delimiter = ',') {
+  std::vector<std::string_view> fields;
+  splitCsvLine(line, fields, delimiter);
+  return fields;
+}
+
+/**
+ * Parse a numeric field. Surrounding whitespace is ignored and, like
+ * stod/stream extraction, parsing stops at the first character that isn't
+ * part of the number.
+ *
+ * @param field       Field to parse.
+ * @param value[out]  Parsed value.
+ *
+ * @return True if the field started with a valid number.
+ */
+template <typename NumType>
+bool tryParseCsvField(std::string_view field, NumType &value) {
+  static_assert(std::is_arithmetic_v<NumType>,
+                "CSV fields can only be parsed as numbers");
+  field = trimCsvField(field);
+  if ((!field.empty()) && (field.front() == '+')) {
+    field.remove_prefix(1);
+  }
+  if (field.empty()) {
+    return false;
+  }
+  if constexpr (std::is_floating_point_v<NumType>) {
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+    std::from_chars_result result =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc();
+#else
+    // No floating point from_chars in this standard library. The field isn't
+    // null terminated, so copy it to a small buffer for strtod
+    char buffer[64];
+    if (field.size() >= sizeof(buffer)) {
+      return false;
+    }
+    memcpy(buffer, field.data(), field.size());
+    buffer[field.size()] = '\0';
+    char *parse_end;
+    value = (NumType)strtod(buffer, &parse_end);
+    return parse_end != buffer;
+#endif
+  } else {
+    std::from_chars_result result =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc();
+  }
+}
+
+/**
+ * Parse a numeric field, exiting with an error if it isn't a number.
+ */
+template <typename NumType>
+void parseCsvField(std::string_view field, NumType &value) {
+  if (!tryParseCsvField(field, value)) {
+    LOG(FATAL) << "Could not parse CSV field '" << field << "' as a number";
+  }
+}
+
+template <typename NumType>
+NumType parseCsvField(std::string_view field) {
+  NumType value;
+  parseCsvField(field, value);
+  return value;
+}
+
+/**
+ * Reads an object from the fields of one line of a CSV file.
+ */
+template <typename T>
+using CsvLineReader =
+    std::function<void(const std::vector<std::string_view> &, T &)>;
+
+namespace csv_internal {
+
+/**
+ * Parse the (non-empty) lines in the given text into objects.
+ */
+template <typename T>
+void parseCsvLines(std::string_view text,
+                   const CsvLineReader<T> &object_from_line_reader,
+                   const char &delimiter,
+                   std::vector<T> &objects) {
+  objects.reserve(objects.size() + std::count(text.begin(), text.end(), '\n') +
+                  1);
+  std::vector<std::string_view> fields;
+  size_t line_start = 0;
+  while (line_start < text.size()) {
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == std::string_view::npos) {
+      line_end = text.size();
+    }
+    std::string_view line = text.substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+    if (trimCsvField(line).empty()) {
+      continue;
+    }
+    splitCsvLine(line, fields, delimiter);
+    objects.emplace_back();
+    object_from_line_reader(fields, objects.back());
+  }
+}
+}  // namespace csv_internal
+
+/**
+ * Parse the lines of CSV text into objects, optionally splitting the text
+ * into chunks (at line boundaries) that are parsed on separate threads.
+ * Objects are output in the same order as the lines. Blank lines are skipped.
+ *
+ * @param text                    CSV text (without a header).
+ * @param object_from_line_reader Reads one object from a line's fields. Must
+ *                                be safe to call concurrently.
+ * @param num_parse_threads       Number of threads to parse with. If 0, this
+ *                                is chosen from the text size.
+ * @param objects[out]            Objects read from the text (appended).
+ * @param delimiter               Character separating fields in a line.
+ */
+template <typename T>
+void parseCsvText(std::string_view text,
+                  const CsvLineReader<T> &object_from_line_reader,
+                  const size_t &num_parse_threads,
+                  std::vector<T> &objects,
+                  const char &delimiter = ',') {
+  size_t num_chunks = num_parse_threads;
+  if (num_chunks == 0) {
+    num_chunks = util::getNumWorkerThreads(
+        0, text.size() / kMinCsvBytesPerParseThread);
+  }
+  if (num_chunks <= 1) {
+    csv_internal::parseCsvLines(
+        text, object_from_line_reader, delimiter, objects);
+    return;
+  }
+
+  // Split into roughly equal chunks, extending each to the end of its line
+  std::vector<std::string_view> chunks;
+  size_t chunk_start = 0;
+  size_t target_chunk_size = text.size() / num_chunks + 1;
+  while (chunk_start < text.size()) {
+    size_t chunk_end =
+        std::min(chunk_start + target_chunk_size, text.size()) - 1;
+    chunk_end = text.find('\n', chunk_end);
+    if (chunk_end == std::string_view::npos) {
+      chunk_end = text.size() - 1;
+    }
+    chunks.emplace_back(text.substr(chunk_start, chunk_end - chunk_start + 1));
+    chunk_start = chunk_end + 1;
+  }
+
+  std::vector<std::vector<T>> objects_by_chunk(chunks.size());
+  util::parallelFor(
+      chunks.size(), (int)num_chunks, [&](const size_t &chunk_num) {
+        csv_internal::parseCsvLines(chunks[chunk_num],
+                                    object_from_line_reader,
+                                    delimiter,
+                                    objects_by_chunk[chunk_num]);
+      });
+
+  size_t total_objects = objects.size();
+  for (const std::vector<T> &chunk_objects : objects_by_chunk) {
+    total_objects += chunk_objects.size();
+  }
+  objects.reserve(total_objects);
+  for (std::vector<T> &chunk_objects : objects_by_chunk) {
+    std::move(chunk_objects.begin(),
+              chunk_objects.end(),
+              std::back_inserter(objects));
+  }
+}
+
+/**
+ * Memory map a CSV file with a header line and parse the rest of its lines
+ * into objects.
+ *
+ * @param file_name               Name of the file.
+ * @param object_from_line_reader Reads one object from a line's fields. Must
+ *                                be safe to call concurrently.
+ * @param num_parse_threads       Number of threads to parse with. If 0, this
+ *                                is chosen from the file size.
+ * @param objects[out]            Objects read from the file (appended).
+ * @param delimiter               Character separating fields in a line.
+ *
+ * @return False if the file couldn't be read or was empty.
+ */
+template <typename T>
+bool parseCsvFileWithHeader(const std::string &file_name,
+                            const CsvLineReader<T> &object_from_line_reader,
+                            const size_t &num_parse_threads,
+                            std::vector<T> &objects,
+                            const char &delimiter = ',') {
+  MappedTextFile mapped_file;
+  if (!mapped_file.open(file_name)) {
+    return false;
+  }
+  std::string_view contents = mapped_file.contents();
+  if (contents.empty()) {
+    return false;
+  }
+  size_t header_end = contents.find('\n');
+  if (header_end == std::string_view::npos) {
+    return true;
+  }
+  parseCsvText(contents.substr(header_end + 1),
+               object_from_line_reader,
+               num_parse_threads,
+               objects,
+               delimiter);
+  return true;
+}
+
+}  // namespace file_io
+
+#endif  // UT_VSLAM_CSV_TOKENIZER_H
@@ -52,6 +52,13 @@ class SerializableIndependentEllipsoidsLongTermObjectMap
                           SerializableObjectId,
                           FrontEndObjMapData,
                           SerializableFrontEndObjMapData>(front_end_data);
+    std::unordered_map<ObjectId, uint64_t> unobserved_session_counts;
+    data_.getUnobservedSessionCounts(unobserved_session_counts);
+    fs << kUnobservedSessionCountsLabel
+       << SerializableMap<ObjectId,
+                          SerializableObjectId,
+                          uint64_t,
+                          SerializableUint64>(unobserved_session_counts);
     fs << "}";
   }
 
@@ -91,6 +98,17 @@ class SerializableIndependentEllipsoidsLongTermObjectMap
         ser_front_end_data;
     node[kFrontEndMapDataLabel] >> ser_front_end_data;
     data_.setFrontEndObjMapData(ser_front_end_data.getEntry());
+
+    // Maps written before session counts were tracked don't have this entry,
+    // which reads as every object having been observed in the last session
+    SerializableMap<ObjectId,
+                    SerializableObjectId,
+                    uint64_t,
+                    SerializableUint64>
+        ser_unobserved_session_counts;
+    node[kUnobservedSessionCountsLabel] >> ser_unobserved_session_counts;
+    data_.setUnobservedSessionCounts(
+        ser_unobserved_session_counts.getEntry());
   }
 
  protected:
@@ -112,6 +130,8 @@ class SerializableIndependentEllipsoidsLongTermObjectMap
   inline static const std::string kEllipsoidCovariancesLabel =
       "obj_id_covariance_map";
   inline static const std::string kFrontEndMapDataLabel = "front_end_map_data";
+  inline static const std::string kUnobservedSessionCountsLabel =
+      "unobserved_session_counts";
 };
 
 template <typename FrontEndObjMapData, typename SerializableFrontEndObjMapData>
@@ -8,6 +8,7 @@
 #include <file_io/cv_file_storage/file_storage_io_utils.h>
 #include <file_io/cv_file_storage/vslam_basic_types_file_storage_io.h>
 #include <file_io/cv_file_storage/vslam_obj_types_file_storage_io.h>
+#include <file_io/file_access_utils.h>
 #include <refactoring/optimization/object_pose_graph.h>
 
 #include <filesystem>
@@ -22,6 +23,8 @@ const std::string kPostFrameAddCheckpointOutputFileBaseName =
     "pose_graph_state_checkpoint_post_frame_add";
 const std::string kPostPostprocessingCheckpointOutputFileBaseName =
     "pose_graph_state_checkpoint_post_postprocessing";
+const std::string kPeriodicCheckpointOutputFileBaseName =
+    "pose_graph_state_checkpoint_after_frame_";
 const std::string kPoseGraphStateKey = "pose_graph";
 
 using SerializableFeatureFactorId = SerializableUint64;
@@ -1018,18 +1021,22 @@ static void read(
   }
 }
 
-void outputPoseGraphStateToFile(
+inline void outputPoseGraphStateToFile(
     const ObjectAndReprojectionFeaturePoseGraphState &pose_graph_state,
     const std::string &out_file) {
-  cv::FileStorage pose_graph_state_fs(out_file, cv::FileStorage::WRITE);
+  // Write to a temp file first so a crash mid-write never leaves a truncated
+  // checkpoint in place of the previous one
+  std::string temp_file = file_io::getTempFileForAtomicWrite(out_file);
+  cv::FileStorage pose_graph_state_fs(temp_file, cv::FileStorage::WRITE);
 
   pose_graph_state_fs << kPoseGraphStateKey
                       << SerializableObjectAndReprojectionFeaturePoseGraphState(
                              pose_graph_state);
   pose_graph_state_fs.release();
+  file_io::commitAtomicallyWrittenFile(temp_file, out_file);
 }
 
-void readPoseGraphStateFromFile(
+inline void readPoseGraphStateFromFile(
     const std::string &in_file,
     ObjectAndReprojectionFeaturePoseGraphState &pose_graph_state) {
   if (!std::filesystem::exists(in_file)) {
@@ -1044,7 +1051,7 @@ void readPoseGraphStateFromFile(
   pose_graph_state = ser_pose_graph_state.getEntry();
 }
 
-void outputPoseGraphToFile(
+inline void outputPoseGraphToFile(
     const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> &pose_graph,
     const std::string &out_file) {
   ObjectAndReprojectionFeaturePoseGraphState pose_graph_state;
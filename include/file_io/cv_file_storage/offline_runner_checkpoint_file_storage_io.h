@@ -0,0 +1,763 @@
+//
+// Created by amanda on 3/4/23.
+//
+
+#ifndef UT_VSLAM_OFFLINE_RUNNER_CHECKPOINT_FILE_STORAGE_IO_H
+#define UT_VSLAM_OFFLINE_RUNNER_CHECKPOINT_FILE_STORAGE_IO_H
+
+#include <file_io/cv_file_storage/file_storage_io_utils.h>
+#include <file_io/cv_file_storage/object_and_reprojection_feature_pose_graph_file_storage_io.h>
+#include <file_io/cv_file_storage/vslam_basic_types_file_storage_io.h>
+#include <file_io/cv_file_storage/vslam_obj_types_file_storage_io.h>
+#include <file_io/file_access_utils.h>
+#include <refactoring/bounding_box_frontend/feature_based_bounding_box_front_end.h>
+#include <refactoring/visual_feature_frontend/visual_feature_front_end.h>
+
+#include <filesystem>
+
+namespace vslam_types_refactor {
+
+const std::string kRunnerCheckpointOutputFileBaseName =
+    "runner_state_checkpoint_after_frame_";
+const std::string kRunnerCheckpointKey = "runner_checkpoint";
+
+/**
+ * Everything needed to resume the offline problem runner after the last frame
+ * processed, as though the run was never interrupted.
+ *
+ * Only the feature-based bounding box front end (the one the optimization
+ * runner uses) can be restored. The optimization logger, per-frame telemetry
+ * and cumulative timers aren't checkpointed and restart at the resumed frame.
+ * The solver problems are rebuilt rather than restored, so the estimates match
+ * an uninterrupted run up to solver round-off.
+ */
+struct OfflineRunnerCheckpointState {
+  FrameId last_frame_processed_;
+  ObjectAndReprojectionFeaturePoseGraphState pose_graph_state_;
+  VisualFeatureFrontEndState visual_feature_front_end_state_;
+  /**
+   * Empty if the bounding box front end had not been created yet (no bounding
+   * boxes had been processed).
+   */
+  std::optional<FeatureBasedBoundingBoxFrontEndState>
+      bounding_box_front_end_state_;
+};
+
+class SerializableUninitializedObjectFactor
+    : public FileStorageSerializable<UninitializedObjectFactor> {
+ public:
+  SerializableUninitializedObjectFactor()
+      : FileStorageSerializable<UninitializedObjectFactor>() {}
+  SerializableUninitializedObjectFactor(const UninitializedObjectFactor &data)
+      : FileStorageSerializable<UninitializedObjectFactor>(data) {}
+
+  virtual void write(cv::FileStorage &fs) const override {
+    fs << "{";
+    fs << kFrameIdLabel << SerializableFrameId(data_.frame_id_);
+    fs << kCameraIdLabel << SerializableCameraId(data_.camera_id_);
+    fs << kBoundingBoxCornersLabel
+       << SerializableBbCorners<double>(data_.bounding_box_corners_);
+    fs << kDetectionConfidenceLabel << data_.detection_confidence_;
+    fs << kBoundingBoxCornersCovarianceLabel
+       << SerializableCovariance<double, 4>(
+              data_.bounding_box_corners_covariance_);
+    fs << "}";
+  }
+
+  virtual void read(const cv::FileNode &node) override {
+    SerializableFrameId ser_frame_id;
+    node[kFrameIdLabel] >> ser_frame_id;
+    data_.frame_id_ = ser_frame_id.getEntry();
+    SerializableCameraId ser_camera_id;
+    node[kCameraIdLabel] >> ser_camera_id;
+    data_.camera_id_ = ser_camera_id.getEntry();
+    SerializableBbCorners<double> ser_corners;
+    node[kBoundingBoxCornersLabel] >> ser_corners;
+    data_.bounding_box_corners_ = ser_corners.getEntry();
+    data_.detection_confidence_ = node[kDetectionConfidenceLabel];
+    SerializableCovariance<double, 4> ser_cov;
+    node[kBoundingBoxCornersCovarianceLabel] >> ser_cov;
+    data_.bounding_box_corners_covariance_ = ser_cov.getEntry();
+  }
+
+ protected:
+  using FileStorageSerializable<UninitializedObjectFactor>::data_;
+
+ private:
+  inline static const std::string kFrameIdLabel = "frame_id";
+  inline static const std::string kCameraIdLabel = "camera_id";
+  inline static const std::string kBoundingBoxCornersLabel = "bb_corners";
+  inline static const std::string kDetectionConfidenceLabel = "det_conf";
+  inline static const std::string kBoundingBoxCornersCovarianceLabel =
+      "bb_corners_cov";
+};
+
+static void write(cv::FileStorage &fs,
+                  const std::string &,
+                  const SerializableUninitializedObjectFactor &data) {
+  data.write(fs);
+}
+
+static void read(const cv::FileNode &node,
+                 SerializableUninitializedObjectFactor &data,
+                 const SerializableUninitializedObjectFactor &default_data =
+                     SerializableUninitializedObjectFactor()) {
+  if (node.empty()) {
+    data = default_data;
+  } else {
+    data.read(node);
+  }
+}
+
+class SerializableFeatureBasedFrontEndPendingObjInfo
+    : public FileStorageSerializable<FeatureBasedFrontEndPendingObjInfo> {
+ public:
+  SerializableFeatureBasedFrontEndPendingObjInfo()
+      : FileStorageSerializable<FeatureBasedFrontEndPendingObjInfo>() {}
+  SerializableFeatureBasedFrontEndPendingObjInfo(
+      const FeatureBasedFrontEndPendingObjInfo &data)
+      : FileStorageSerializable<FeatureBasedFrontEndPendingObjInfo>(data) {}
+
+  virtual void write(cv::FileStorage &fs) const override {
+    fs << "{";
+    fs << kObjectEstimateLabel
+       << SerializableOptional<EllipsoidState<double>,
+                               SerializableEllipsoidState<double>>(
+              data_.object_estimate_);
+    fs << kMaxConfidenceLabel << data_.max_confidence_;
+    int ready_for_merge = data_.ready_for_merge ? 1 : 0;
+    fs << kReadyForMergeLabel << ready_for_merge;
+    fs << "}";
+  }
+
+  virtual void read(const cv::FileNode &node) override {
+    SerializableOptional<EllipsoidState<double>,
+                         SerializableEllipsoidState<double>>
+        ser_object_estimate;
+    node[kObjectEstimateLabel] >> ser_object_estimate;
+    data_.object_estimate_ = ser_object_estimate.getEntry();
+    data_.max_confidence_ = node[kMaxConfidenceLabel];
+    int ready_for_merge = node[kReadyForMergeLabel];
+    data_.ready_for_merge = ready_for_merge != 0;
+  }
+
+ protected:
+  using FileStorageSerializable<FeatureBasedFrontEndPendingObjInfo>::data_;
+
+ private:
+  inline static const std::string kObjectEstimateLabel = "obj_est";
+  inline static const std::string kMaxConfidenceLabel = "max_conf";
+  inline static const std::string kReadyForMergeLabel = "ready_for_merge";
+};
+
+static void write(cv::FileStorage &fs,
+                  const std::string &,
+                  const SerializableFeatureBasedFrontEndPendingObjInfo &data) {
+  data.write(fs);
+}
+
+static void read(
+    const cv::FileNode &node,
+    SerializableFeatureBasedFrontEndPendingObjInfo &data,
+    const SerializableFeatureBasedFrontEndPendingObjInfo &default_data =
+        SerializableFeatureBasedFrontEndPendingObjInfo()) {
+  if (node.empty()) {
+    data = default_data;
+  } else {
+    data.read(node);
+  }
+}
+
+class SerializableFeatureBasedFrontEndObjAssociationInfo
+    : public FileStorageSerializable<FeatureBasedFrontEndObjAssociationInfo> {
+ public:
+  SerializableFeatureBasedFrontEndObjAssociationInfo()
+      : FileStorageSerializable<FeatureBasedFrontEndObjAssociationInfo>() {}
+  SerializableFeatureBasedFrontEndObjAssociationInfo(
+      const FeatureBasedFrontEndObjAssociationInfo &data)
+      : FileStorageSerializable<FeatureBasedFrontEndObjAssociationInfo>(data) {
+  }
+
+  virtual void write(cv::FileStorage &fs) const override {
+    fs << "{";
+    fs << kObservedFeatsLabel
+       << SerializableObservedFeatsByFrame(data_.observed_feats_);
+    fs << "}";
+  }
+
+  virtual void read(const cv::FileNode &node) override {
+    SerializableObservedFeatsByFrame ser_observed_feats;
+    node[kObservedFeatsLabel] >> ser_observed_feats;
+    data_.observed_feats_ = ser_observed_feats.getEntry();
+  }
+
+ protected:
+  using FileStorageSerializable<FeatureBasedFrontEndObjAssociationInfo>::data_;
+
+ private:
+  inline static const std::string kObservedFeatsLabel = "observed_feats";
+
+  using SerializableFeatureSet =
+      SerializableUnorderedSet<FeatureId, SerializableFeatureId>;
+  using ObservedFeatsByCamera =
+      std::unordered_map<CameraId, std::unordered_set<FeatureId>>;
+  using SerializableObservedFeatsByCamera =
+      SerializableMap<CameraId,
+                      SerializableCameraId,
+                      std::unordered_set<FeatureId>,
+                      SerializableFeatureSet>;
+  using SerializableObservedFeatsByFrame =
+      SerializableMap<FrameId,
+                      SerializableFrameId,
+                      ObservedFeatsByCamera,
+                      SerializableObservedFeatsByCamera>;
+};
+
+static void write(
+    cv::FileStorage &fs,
+    const std::string &,
+    const SerializableFeatureBasedFrontEndObjAssociationInfo &data) {
+  data.write(fs);
+}
+
+static void read(
+    const cv::FileNode &node,
+    SerializableFeatureBasedFrontEndObjAssociationInfo &data,
+    const SerializableFeatureBasedFrontEndObjAssociationInfo &default_data =
+        SerializableFeatureBasedFrontEndObjAssociationInfo()) {
+  if (node.empty()) {
+    data = default_data;
+  } else {
+    data.read(node);
+  }
+}
+
+using FeatureBasedUninitializedEllipsoidInfo =
+    UninitializedEllispoidInfo<FeatureBasedFrontEndObjAssociationInfo,
+                               FeatureBasedFrontEndPendingObjInfo>;
+
+class SerializableFeatureBasedUninitializedEllipsoidInfo
+    : public FileStorageSerializable<FeatureBasedUninitializedEllipsoidInfo> {
+ public:
+  SerializableFeatureBasedUninitializedEllipsoidInfo()
+      : FileStorageSerializable<FeatureBasedUninitializedEllipsoidInfo>() {}
+  SerializableFeatureBasedUninitializedEllipsoidInfo(
+      const FeatureBasedUninitializedEllipsoidInfo &data)
+      : FileStorageSerializable<FeatureBasedUninitializedEllipsoidInfo>(data) {
+  }
+
+  virtual void write(cv::FileStorage &fs) const override {
+    fs << "{";
+    fs << kAppearanceInfoLabel
+       << SerializableFeatureBasedFrontEndObjAssociationInfo(
+              data_.appearance_info_);
+    fs << kPendingInfoLabel
+       << SerializableFeatureBasedFrontEndPendingObjInfo(data_.pending_info_);
+    fs << kSemanticClassLabel << data_.semantic_class_;
+    fs << kObservationFactorsLabel
+       << SerializableVector<UninitializedObjectFactor,
+                             SerializableUninitializedObjectFactor>(
+              data_.observation_factors_);
+    fs << kMinFrameIdLabel << SerializableFrameId(data_.min_frame_id_);
+    fs << kMaxFrameIdLabel << SerializableFrameId(data_.max_frame_id_);
+    fs << "}";
+  }
+
+  virtual void read(const cv::FileNode &node) override {
+    SerializableFeatureBasedFrontEndObjAssociationInfo ser_appearance_info;
+    node[kAppearanceInfoLabel] >> ser_appearance_info;
+    data_.appearance_info_ = ser_appearance_info.getEntry();
+    SerializableFeatureBasedFrontEndPendingObjInfo ser_pending_info;
+    node[kPendingInfoLabel] >> ser_pending_info;
+    data_.pending_info_ = ser_pending_info.getEntry();
+    node[kSemanticClassLabel] >> data_.semantic_class_;
+    SerializableVector<UninitializedObjectFactor,
+                       SerializableUninitializedObjectFactor>
+        ser_observation_factors;
+    node[kObservationFactorsLabel] >> ser_observation_factors;
+    data_.observation_factors_ = ser_observation_factors.getEntry();
+    SerializableFrameId ser_min_frame_id;
+    node[kMinFrameIdLabel] >> ser_min_frame_id;
+    data_.min_frame_id_ = ser_min_frame_id.getEntry();
+    SerializableFrameId ser_max_frame_id;
+    node[kMaxFrameIdLabel] >> ser_max_frame_id;
+    data_.max_frame_id_ = ser_max_frame_id.getEntry();
+  }
+
+ protected:
+  using FileStorageSerializable<FeatureBasedUninitializedEllipsoidInfo>::data_;
+
+ private:
+  inline static const std::string kAppearanceInfoLabel = "appearance_info";
+  inline static const std::string kPendingInfoLabel = "pending_info";
+  inline static const std::string kSemanticClassLabel = "semantic_class";
+  inline static const std::string kObservationFactorsLabel = "obs_factors";
+  inline static const std::string kMinFrameIdLabel = "min_frame_id";
+  inline static const std::string kMaxFrameIdLabel = "max_frame_id";
+};
+
+static void write(
+    cv::FileStorage &fs,
+    const std::string &,
+    const SerializableFeatureBasedUninitializedEllipsoidInfo &data) {
+  data.write(fs);
+}
+
+static void read(
+    const cv::FileNode &node,
+    SerializableFeatureBasedUninitializedEllipsoidInfo &data,
+    const SerializableFeatureBasedUninitializedEllipsoidInfo &default_data =
+        SerializableFeatureBasedUninitializedEllipsoidInfo()) {
+  if (node.empty()) {
+    data = default_data;
+  } else {
+    data.read(node);
+  }
+}
+
+class SerializableFeatureBasedBoundingBoxFrontEndState
+    : public FileStorageSerializable<FeatureBasedBoundingBoxFrontEndState> {
+ public:
+  SerializableFeatureBasedBoundingBoxFrontEndState()
+      : FileStorageSerializable<FeatureBasedBoundingBoxFrontEndState>() {}
+  SerializableFeatureBasedBoundingBoxFrontEndState(
+      const FeatureBasedBoundingBoxFrontEndState &data)
+      : FileStorageSerializable<FeatureBasedBoundingBoxFrontEndState>(data) {}
+
+  virtual void write(cv::FileStorage &fs) const override {
+    fs << "{";
+    fs << kUninitializedObjectInfoLabel
+       << SerializableUninitializedObjectInfo(
+              data_.association_state_.uninitialized_object_info_);
+    fs << kObjectAppearanceInfoLabel
+       << SerializableObjectAppearanceInfo(
+              data_.association_state_.object_appearance_info_);
+    fs << kAllFilteredCornerLocationsLabel
+       << SerializableAllCornersByFrame(data_.all_filtered_corner_locations_);
+    fs << kObservedCornerLocationsLabel
+       << SerializableAssociatedCornersByFrame(
+              data_.observed_corner_locations_);
+    fs << kBoundingBoxesForPendingObjectLabel
+       << SerializablePendingObjectBoundingBoxes(
+              data_.bounding_boxes_for_pending_object_);
+    fs << kPendingObjectsLabel
+       << SerializablePendingObjects(data_.pending_objects_);
+    fs << "}";
+  }
+
+  virtual void read(const cv::FileNode &node) override {
+    SerializableUninitializedObjectInfo ser_uninitialized_object_info;
+    node[kUninitializedObjectInfoLabel] >> ser_uninitialized_object_info;
+    data_.association_state_.uninitialized_object_info_ =
+        ser_uninitialized_object_info.getEntry();
+    SerializableObjectAppearanceInfo ser_object_appearance_info;
+    node[kObjectAppearanceInfoLabel] >> ser_object_appearance_info;
+    data_.association_state_.object_appearance_info_ =
+        ser_object_appearance_info.getEntry();
+    SerializableAllCornersByFrame ser_all_corners;
+    node[kAllFilteredCornerLocationsLabel] >> ser_all_corners;
+    data_.all_filtered_corner_locations_ = ser_all_corners.getEntry();
+    SerializableAssociatedCornersByFrame ser_associated_corners;
+    node[kObservedCornerLocationsLabel] >> ser_associated_corners;
+    data_.observed_corner_locations_ = ser_associated_corners.getEntry();
+    SerializablePendingObjectBoundingBoxes ser_pending_obj_bbs;
+    node[kBoundingBoxesForPendingObjectLabel] >> ser_pending_obj_bbs;
+    data_.bounding_boxes_for_pending_object_ = ser_pending_obj_bbs.getEntry();
+    SerializablePendingObjects ser_pending_objects;
+    node[kPendingObjectsLabel] >> ser_pending_objects;
+    data_.pending_objects_ = ser_pending_objects.getEntry();
+  }
+
+ protected:
+  using FileStorageSerializable<FeatureBasedBoundingBoxFrontEndState>::data_;
+
+ private:
+  inline static const std::string kUninitializedObjectInfoLabel =
+      "uninitialized_object_info";
+  inline static const std::string kObjectAppearanceInfoLabel =
+      "object_appearance_info";
+  inline static const std::string kAllFilteredCornerLocationsLabel =
+      "all_filtered_corner_locations";
+  inline static const std::string kObservedCornerLocationsLabel =
+      "observed_corner_locations";
+  inline static const std::string kBoundingBoxesForPendingObjectLabel =
+      "bounding_boxes_for_pending_object";
+  inline static const std::string kPendingObjectsLabel = "pending_objects";
+
+  using SerializableUninitializedObjectInfo =
+      SerializableVector<FeatureBasedUninitializedEllipsoidInfo,
+                         SerializableFeatureBasedUninitializedEllipsoidInfo>;
+  using SerializableObjectAppearanceInfo =
+      SerializableMap<ObjectId,
+                      SerializableObjectId,
+                      FeatureBasedFrontEndObjAssociationInfo,
+                      SerializableFeatureBasedFrontEndObjAssociationInfo>;
+
+  using CornersWithUncertainty =
+      std::pair<BbCornerPair<double>, std::optional<double>>;
+  using SerializableCornersWithUncertainty =
+      SerializablePair<BbCornerPair<double>,
+                       SerializableBbCornerPair,
+                       std::optional<double>,
+                       SerializableOptional<double, SerializableDouble>>;
+
+  using SerializableCornersList =
+      SerializableVector<CornersWithUncertainty,
+                         SerializableCornersWithUncertainty>;
+  using AllCornersByCamera =
+      std::unordered_map<CameraId, std::vector<CornersWithUncertainty>>;
+  using SerializableAllCornersByCamera =
+      SerializableMap<CameraId,
+                      SerializableCameraId,
+                      std::vector<CornersWithUncertainty>,
+                      SerializableCornersList>;
+  using SerializableAllCornersByFrame =
+      SerializableMap<FrameId,
+                      SerializableFrameId,
+                      AllCornersByCamera,
+                      SerializableAllCornersByCamera>;
+
+  using AssociatedCornersByObject =
+      std::unordered_map<ObjectId, CornersWithUncertainty>;
+  using SerializableAssociatedCornersByObject =
+      SerializableMap<ObjectId,
+                      SerializableObjectId,
+                      CornersWithUncertainty,
+                      SerializableCornersWithUncertainty>;
+  using AssociatedCornersByCamera =
+      std::unordered_map<CameraId, AssociatedCornersByObject>;
+  using SerializableAssociatedCornersByCamera =
+      SerializableMap<CameraId,
+                      SerializableCameraId,
+                      AssociatedCornersByObject,
+                      SerializableAssociatedCornersByObject>;
+  using SerializableAssociatedCornersByFrame =
+      SerializableMap<FrameId,
+                      SerializableFrameId,
+                      AssociatedCornersByCamera,
+                      SerializableAssociatedCornersByCamera>;
+
+  using CornersWithConfidence = std::pair<BbCornerPair<double>, double>;
+  using SerializableCornersWithConfidence =
+      SerializablePair<BbCornerPair<double>,
+                       SerializableBbCornerPair,
+                       double,
+                       SerializableDouble>;
+  using PendingCornersByCamera =
+      std::unordered_map<CameraId, CornersWithConfidence>;
+  using SerializablePendingCornersByCamera =
+      SerializableMap<CameraId,
+                      SerializableCameraId,
+                      CornersWithConfidence,
+                      SerializableCornersWithConfidence>;
+  using PendingCornersByFrame =
+      std::unordered_map<FrameId, PendingCornersByCamera>;
+  using SerializablePendingCornersByFrame =
+      SerializableMap<FrameId,
+                      SerializableFrameId,
+                      PendingCornersByCamera,
+                      SerializablePendingCornersByCamera>;
+  using SerializablePendingObjectBoundingBoxes =
+      SerializableVector<PendingCornersByFrame,
+                         SerializablePendingCornersByFrame>;
+
+  using SerializableOptionalEllipsoid =
+      SerializableOptional<EllipsoidState<double>,
+                           SerializableEllipsoidState<double>>;
+  using PendingObject =
+      std::pair<std::string, std::optional<EllipsoidState<double>>>;
+  using SerializablePendingObject =
+      SerializablePair<std::string,
+                       SerializableString,
+                       std::optional<EllipsoidState<double>>,
+                       SerializableOptionalEllipsoid>;
+  using SerializablePendingObjects =
+      SerializableVector<PendingObject, SerializablePendingObject>;
+};
+
+static void write(
+    cv::FileStorage &fs,
+    const std::string &,
+    const SerializableFeatureBasedBoundingBoxFrontEndState &data) {
+  data.write(fs);
+}
+
+static void read(
+    const cv::FileNode &node,
+    SerializableFeatureBasedBoundingBoxFrontEndState &data,
+    const SerializableFeatureBasedBoundingBoxFrontEndState &default_data =
+        SerializableFeatureBasedBoundingBoxFrontEndState()) {
+  if (node.empty()) {
+    data = default_data;
+  } else {
+    data.read(node);
+  }
+}
+
+class SerializableVisualFeatureCachedInfo
+    : public FileStorageSerializable<VisualFeatureCachedInfo> {
+ public:
+  SerializableVisualFeatureCachedInfo()
+      : FileStorageSerializable<VisualFeatureCachedInfo>() {}
+  SerializableVisualFeatureCachedInfo(const VisualFeatureCachedInfo &data)
+      : FileStorageSerializable<VisualFeatureCachedInfo>(data) {}
+
+  virtual void write(cv::FileStorage &fs) const override {
+    fs << "{";
+    int is_cache_cleaned = data_.is_cache_cleaned_ ? 1 : 0;
+    fs << kIsCacheCleanedLabel << is_cache_cleaned;
+    // Frames are keyed by ordered maps in the cache, but entries are written
+    // in order and the map reorders them on read, so the unordered map
+    // serializer works here
+    fs << kFactorsByFrameLabel
+       << SerializableFactorsByFrame(
+              std::unordered_map<FrameId, std::vector<ReprojectionErrorFactor>>(
+                  data_.frame_ids_and_reprojection_err_factors_.begin(),
+                  data_.frame_ids_and_reprojection_err_factors_.end()));
+    fs << kPosesByFrameLabel
+       << SerializablePosesByFrame(
+              std::unordered_map<FrameId, std::optional<Pose3D<double>>>(
+                  data_.frame_ids_and_poses_.begin(),
+                  data_.frame_ids_and_poses_.end()));
+    fs << "}";
+  }
+
+  virtual void read(const cv::FileNode &node) override {
+    int is_cache_cleaned = node[kIsCacheCleanedLabel];
+    data_.is_cache_cleaned_ = is_cache_cleaned != 0;
+    SerializableFactorsByFrame ser_factors_by_frame;
+    node[kFactorsByFrameLabel] >> ser_factors_by_frame;
+    for (const auto &frame_and_factors : ser_factors_by_frame.getEntry()) {
+      data_.frame_ids_and_reprojection_err_factors_[frame_and_factors.first] =
+          frame_and_factors.second;
+    }
+    SerializablePosesByFrame ser_poses_by_frame;
+    node[kPosesByFrameLabel] >> ser_poses_by_frame;
+    for (const auto &frame_and_pose : ser_poses_by_frame.getEntry()) {
+      data_.frame_ids_and_poses_[frame_and_pose.first] = frame_and_pose.second;
+    }
+  }
+
+ protected:
+  using FileStorageSerializable<VisualFeatureCachedInfo>::data_;
+
+ private:
+  inline static const std::string kIsCacheCleanedLabel = "is_cache_cleaned";
+  inline static const std::string kFactorsByFrameLabel = "factors_by_frame";
+  inline static const std::string kPosesByFrameLabel = "poses_by_frame";
+
+  using SerializableFactorsByFrame =
+      SerializableMap<FrameId,
+                      SerializableFrameId,
+                      std::vector<ReprojectionErrorFactor>,
+                      SerializableVector<ReprojectionErrorFactor,
+                                         SerializableReprojectionErrorFactor>>;
+  using SerializablePosesByFrame =
+      SerializableMap<FrameId,
+                      SerializableFrameId,
+                      std::optional<Pose3D<double>>,
+                      SerializableOptional<Pose3D<double>,
+                                           SerializablePose3D<double>>>;
+};
+
+static void write(cv::FileStorage &fs,
+                  const std::string &,
+                  const SerializableVisualFeatureCachedInfo &data) {
+  data.write(fs);
+}
+
+static void read(const cv::FileNode &node,
+                 SerializableVisualFeatureCachedInfo &data,
+                 const SerializableVisualFeatureCachedInfo &default_data =
+                     SerializableVisualFeatureCachedInfo()) {
+  if (node.empty()) {
+    data = default_data;
+  } else {
+    data.read(node);
+  }
+}
+
+class SerializableVisualFeatureFrontEndState
+    : public FileStorageSerializable<VisualFeatureFrontEndState> {
+ public:
+  SerializableVisualFeatureFrontEndState()
+      : FileStorageSerializable<VisualFeatureFrontEndState>() {}
+  SerializableVisualFeatureFrontEndState(const VisualFeatureFrontEndState &data)
+      : FileStorageSerializable<VisualFeatureFrontEndState>(data) {}
+
+  virtual void write(cv::FileStorage &fs) const override {
+    fs << "{";
+    fs << kFirstObservedFrameLabel
+       << SerializableFirstObservedFrames(
+              data_.first_observed_frame_by_feature_);
+    fs << kAddedFeatureIdsLabel
+       << SerializableFeatureSet(data_.added_feature_ids_);
+    fs << kPendingFeatureFactorsLabel
+       << SerializableCachesByFeature(data_.pending_feature_factors_);
+    fs << kPendingFactorsForInitializedLabel
+       << SerializableCachesByFeature(
+              data_.pending_feature_factors_for_initialized_features_);
+    fs << "}";
+  }
+
+  virtual void read(const cv::FileNode &node) override {
+    SerializableFirstObservedFrames ser_first_observed;
+    node[kFirstObservedFrameLabel] >> ser_first_observed;
+    data_.first_observed_frame_by_feature_ = ser_first_observed.getEntry();
+    SerializableFeatureSet ser_added_feature_ids;
+    node[kAddedFeatureIdsLabel] >> ser_added_feature_ids;
+    data_.added_feature_ids_ = ser_added_feature_ids.getEntry();
+    SerializableCachesByFeature ser_pending;
+    node[kPendingFeatureFactorsLabel] >> ser_pending;
+    data_.pending_feature_factors_ = ser_pending.getEntry();
+    SerializableCachesByFeature ser_pending_for_initialized;
+    node[kPendingFactorsForInitializedLabel] >> ser_pending_for_initialized;
+    data_.pending_feature_factors_for_initialized_features_ =
+        ser_pending_for_initialized.getEntry();
+  }
+
+ protected:
+  using FileStorageSerializable<VisualFeatureFrontEndState>::data_;
+
+ private:
+  inline static const std::string kFirstObservedFrameLabel =
+      "first_observed_frame_by_feature";
+  inline static const std::string kAddedFeatureIdsLabel = "added_feature_ids";
+  inline static const std::string kPendingFeatureFactorsLabel =
+      "pending_feature_factors";
+  inline static const std::string kPendingFactorsForInitializedLabel =
+      "pending_feature_factors_for_initialized_features";
+
+  using SerializableFirstObservedFrames = SerializableMap<FeatureId,
+                                                         SerializableFeatureId,
+                                                         FrameId,
+                                                         SerializableFrameId>;
+  using SerializableFeatureSet =
+      SerializableUnorderedSet<FeatureId, SerializableFeatureId>;
+  using SerializableCachesByFeature =
+      SerializableMap<FeatureId,
+                      SerializableFeatureId,
+                      VisualFeatureCachedInfo,
+                      SerializableVisualFeatureCachedInfo>;
+};
+
+static void write(cv::FileStorage &fs,
+                  const std::string &,
+                  const SerializableVisualFeatureFrontEndState &data) {
+  data.write(fs);
+}
+
+static void read(const cv::FileNode &node,
+                 SerializableVisualFeatureFrontEndState &data,
+                 const SerializableVisualFeatureFrontEndState &default_data =
+                     SerializableVisualFeatureFrontEndState()) {
+  if (node.empty()) {
+    data = default_data;
+  } else {
+    data.read(node);
+  }
+}
+
+class SerializableOfflineRunnerCheckpointState
+    : public FileStorageSerializable<OfflineRunnerCheckpointState> {
+ public:
+  SerializableOfflineRunnerCheckpointState()
+      : FileStorageSerializable<OfflineRunnerCheckpointState>() {}
+  SerializableOfflineRunnerCheckpointState(
+      const OfflineRunnerCheckpointState &data)
+      : FileStorageSerializable<OfflineRunnerCheckpointState>(data) {}
+
+  virtual void write(cv::FileStorage &fs) const override {
+    fs << "{";
+    fs << kLastFrameProcessedLabel
+       << SerializableFrameId(data_.last_frame_processed_);
+    fs << kPoseGraphStateLabel
+       << SerializableObjectAndReprojectionFeaturePoseGraphState(
+              data_.pose_graph_state_);
+    fs << kVisualFeatureFrontEndStateLabel
+       << SerializableVisualFeatureFrontEndState(
+              data_.visual_feature_front_end_state_);
+    fs << kBoundingBoxFrontEndStateLabel
+       << SerializableOptionalBbFrontEndState(
+              data_.bounding_box_front_end_state_);
+    fs << "}";
+  }
+
+  virtual void read(const cv::FileNode &node) override {
+    SerializableFrameId ser_last_frame;
+    node[kLastFrameProcessedLabel] >> ser_last_frame;
+    data_.last_frame_processed_ = ser_last_frame.getEntry();
+    SerializableObjectAndReprojectionFeaturePoseGraphState ser_pg_state;
+    node[kPoseGraphStateLabel] >> ser_pg_state;
+    data_.pose_graph_state_ = ser_pg_state.getEntry();
+    SerializableVisualFeatureFrontEndState ser_vf_state;
+    node[kVisualFeatureFrontEndStateLabel] >> ser_vf_state;
+    data_.visual_feature_front_end_state_ = ser_vf_state.getEntry();
+    SerializableOptionalBbFrontEndState ser_bb_state;
+    node[kBoundingBoxFrontEndStateLabel] >> ser_bb_state;
+    data_.bounding_box_front_end_state_ = ser_bb_state.getEntry();
+  }
+
+ protected:
+  using FileStorageSerializable<OfflineRunnerCheckpointState>::data_;
+
+ private:
+  inline static const std::string kLastFrameProcessedLabel =
+      "last_frame_processed";
+  inline static const std::string kPoseGraphStateLabel = "pose_graph_state";
+  inline static const std::string kVisualFeatureFrontEndStateLabel =
+      "visual_feature_front_end_state";
+  inline static const std::string kBoundingBoxFrontEndStateLabel =
+      "bounding_box_front_end_state";
+
+  using SerializableOptionalBbFrontEndState =
+      SerializableOptional<FeatureBasedBoundingBoxFrontEndState,
+                           SerializableFeatureBasedBoundingBoxFrontEndState>;
+};
+
+static void write(cv::FileStorage &fs,
+                  const std::string &,
+                  const SerializableOfflineRunnerCheckpointState &data) {
+  data.write(fs);
+}
+
+static void read(const cv::FileNode &node,
+                 SerializableOfflineRunnerCheckpointState &data,
+                 const SerializableOfflineRunnerCheckpointState &default_data =
+                     SerializableOfflineRunnerCheckpointState()) {
+  if (node.empty()) {
+    data = default_data;
+  } else {
+    data.read(node);
+  }
+}
+
+inline void outputRunnerCheckpointToFile(
+    const OfflineRunnerCheckpointState &runner_checkpoint,
+    const std::string &out_file) {
+  std::string temp_file = file_io::getTempFileForAtomicWrite(out_file);
+  cv::FileStorage checkpoint_fs(temp_file, cv::FileStorage::WRITE);
+  checkpoint_fs << kRunnerCheckpointKey
+                << SerializableOfflineRunnerCheckpointState(runner_checkpoint);
+  checkpoint_fs.release();
+  file_io::commitAtomicallyWrittenFile(temp_file, out_file);
+}
+
+inline bool readRunnerCheckpointFromFile(
+    const std::string &in_file,
+    OfflineRunnerCheckpointState &runner_checkpoint) {
+  if (!std::filesystem::exists(in_file)) {
+    LOG(ERROR) << "Trying to read file " << in_file << " that does not exist";
+    return false;
+  }
+  cv::FileStorage checkpoint_fs(in_file, cv::FileStorage::READ);
+  SerializableOfflineRunnerCheckpointState ser_runner_checkpoint;
+  checkpoint_fs[kRunnerCheckpointKey] >> ser_runner_checkpoint;
+  checkpoint_fs.release();
+  runner_checkpoint = ser_runner_checkpoint.getEntry();
+  return true;
+}
+
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_OFFLINE_RUNNER_CHECKPOINT_FILE_STORAGE_IO_H
@@ -286,8 +286,8 @@ static void read(const cv::FileNode &node,
   }
 }
 
-void writeRobotPoseResults(const std::string &robot_pose_file,
-                           const RobotPoseResults &robot_pose_results) {
+inline void writeRobotPoseResults(const std::string &robot_pose_file,
+                                  const RobotPoseResults &robot_pose_results) {
   cv::FileStorage robot_poses_results_out(robot_pose_file,
                                           cv::FileStorage::WRITE);
   robot_poses_results_out << kRobotPosesKey
@@ -295,8 +295,8 @@ void writeRobotPoseResults(const std::string &robot_pose_file,
   robot_poses_results_out.release();
 }
 
-void readRobotPoseResults(const std::string &robot_pose_file,
-                          RobotPoseResults &robot_pose_results) {
+inline void readRobotPoseResults(const std::string &robot_pose_file,
+                                 RobotPoseResults &robot_pose_results) {
   if (!std::filesystem::exists(robot_pose_file)) {
     LOG(ERROR) << "Trying to read file " << robot_pose_file
                << " that does not exist";
@@ -309,8 +309,8 @@ void readRobotPoseResults(const std::string &robot_pose_file,
   robot_pose_results = serializable_robot_pose_results.getEntry();
 }
 
-void writeEllipsoidResults(const std::string &ellipsoid_results_file,
-                           const EllipsoidResults &ellipsoid_results) {
+inline void writeEllipsoidResults(const std::string &ellipsoid_results_file,
+                                  const EllipsoidResults &ellipsoid_results) {
   cv::FileStorage ellipsoids_results_out(ellipsoid_results_file,
                                          cv::FileStorage::WRITE);
 
@@ -319,8 +319,8 @@ void writeEllipsoidResults(const std::string &ellipsoid_results_file,
   ellipsoids_results_out.release();
 }
 
-void readEllipsoidResults(const std::string &ellipsoid_results_file,
-                          EllipsoidResults &ellipsoid_results) {
+inline void readEllipsoidResults(const std::string &ellipsoid_results_file,
+                                 EllipsoidResults &ellipsoid_results) {
   if (!std::filesystem::exists(ellipsoid_results_file)) {
     LOG(ERROR) << "Trying to read file " << ellipsoid_results_file
                << " that does not exist";
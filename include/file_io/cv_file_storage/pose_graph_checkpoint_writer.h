@@ -0,0 +1,50 @@
+//
+// Created by amanda on 3/3/23.
+//
+
+#ifndef UT_VSLAM_POSE_GRAPH_CHECKPOINT_WRITER_H
+#define UT_VSLAM_POSE_GRAPH_CHECKPOINT_WRITER_H
+
+#include <file_io/async_checkpoint_writer.h>
+#include <file_io/cv_file_storage/object_and_reprojection_feature_pose_graph_file_storage_io.h>
+
+namespace vslam_types_refactor {
+
+/**
+ * Writes pose graph checkpoints on a background thread.
+ *
+ * Checkpointing only copies the pose graph state on the caller's thread; the
+ * (much slower) serialization happens on the writer thread. See
+ * file_io::AsyncCheckpointWriter for how pending checkpoints are bounded.
+ */
+class PoseGraphCheckpointWriter {
+ public:
+  PoseGraphCheckpointWriter()
+      : checkpoint_writer_(outputPoseGraphStateToFile) {}
+
+  /**
+   * Snapshot the pose graph state and queue it to be written.
+   *
+   * @param pose_graph  Pose graph to checkpoint.
+   * @param out_file    File to write the checkpoint to.
+   */
+  void writeCheckpoint(
+      const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> &pose_graph,
+      const std::string &out_file) {
+    ObjectAndReprojectionFeaturePoseGraphState pose_graph_state;
+    pose_graph->getState(pose_graph_state);
+    checkpoint_writer_.writeCheckpoint(std::move(pose_graph_state), out_file);
+  }
+
+  /**
+   * Block until all queued checkpoints have been written.
+   */
+  void flush() { checkpoint_writer_.flush(); }
+
+ private:
+  file_io::AsyncCheckpointWriter<ObjectAndReprojectionFeaturePoseGraphState>
+      checkpoint_writer_;
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_POSE_GRAPH_CHECKPOINT_WRITER_H
@@ -0,0 +1,367 @@
+//
+// Created by amanda on 3/5/23.
+//
+
+#ifndef UT_VSLAM_DEBUG_DUMP_IO_H
+#define UT_VSLAM_DEBUG_DUMP_IO_H
+
+#include <ceres/crs_matrix.h>
+#include <file_io/binary_stream_io.h>
+#include <file_io/cv_file_storage/generic_factor_info_file_storage_io.h>
+#include <file_io/cv_file_storage/output_problem_data_file_storage_io.h>
+#include <refactoring/factors/generic_factor_info.h>
+#include <refactoring/output_problem_data.h>
+
+namespace vslam_types_refactor {
+
+const std::string kCrsMatrixBinaryContentType = "crs_matrix";
+const uint32_t kCrsMatrixBinaryContentVersion = 1;
+const std::string kJacobianResidualInfoBinaryContentType =
+    "jacobian_residual_info";
+const uint32_t kJacobianResidualInfoBinaryContentVersion = 1;
+const std::string kObjectDataAssociationBinaryContentType =
+    "object_data_association_results";
+const uint32_t kObjectDataAssociationBinaryContentVersion = 1;
+
+const std::string kJacobianParamBlockInfoKey = "jacobian_param_block_info";
+const std::string kJacobianResidualInfoKey = "jacobian_residual_info";
+const std::string kBoundingBoxAssociationsKey = "bounding_box_associations";
+
+/**
+ * Write a sparse matrix (i.e. a jacobian) in the binary stream format.
+ *
+ * Content (after the binary stream header): num_rows (int32), num_cols
+ * (int32), rows array (int32), cols array (int32), values array (double),
+ * where the arrays have the same meaning as in ceres::CRSMatrix. MATLAB's
+ * sparse(...) triplets can be recovered from these without any text parsing.
+ *
+ * @param crs_matrix  Matrix to write.
+ * @param out_file    File to write to.
+ *
+ * @return True if the file was written successfully.
+ */
+inline bool writeCrsMatrixToBinaryFile(const ceres::CRSMatrix &crs_matrix,
+                                       const std::string &out_file) {
+  file_io::BinaryStreamWriter writer(
+      out_file, kCrsMatrixBinaryContentType, kCrsMatrixBinaryContentVersion);
+  writer.writeScalar((int32_t)crs_matrix.num_rows);
+  writer.writeScalar((int32_t)crs_matrix.num_cols);
+  writer.writeArray(crs_matrix.rows);
+  writer.writeArray(crs_matrix.cols);
+  writer.writeArray(crs_matrix.values);
+  return writer.close();
+}
+
+/**
+ * Read a sparse matrix written by writeCrsMatrixToBinaryFile.
+ *
+ * @param in_file         File to read.
+ * @param crs_matrix[out] Matrix read from the file.
+ *
+ * @return True if the file was read successfully.
+ */
+inline bool readCrsMatrixFromBinaryFile(const std::string &in_file,
+                                        ceres::CRSMatrix &crs_matrix) {
+  file_io::BinaryStreamReader reader(
+      in_file, kCrsMatrixBinaryContentType, kCrsMatrixBinaryContentVersion);
+  int32_t num_rows;
+  int32_t num_cols;
+  if (!reader.isValid() || !reader.readScalar(num_rows) ||
+      !reader.readScalar(num_cols) || !reader.readArray(crs_matrix.rows) ||
+      !reader.readArray(crs_matrix.cols) ||
+      !reader.readArray(crs_matrix.values)) {
+    LOG(ERROR) << "Could not read sparse matrix from " << in_file;
+    return false;
+  }
+  crs_matrix.num_rows = num_rows;
+  crs_matrix.num_cols = num_cols;
+  return true;
+}
+
+/**
+ * Write the parameter block and residual info for a jacobian. Uses the binary
+ * stream format if the file has the binary extension and JSON (through
+ * cv::FileStorage) otherwise.
+ *
+ * @param parameter_block_infos Info for the parameter blocks (jacobian
+ *                              columns).
+ * @param generic_factor_infos  Info for the residuals (jacobian rows).
+ * @param out_file              File to write to.
+ */
+inline void writeJacobianResidualInfoToFile(
+    const std::vector<ParameterBlockInfo> &parameter_block_infos,
+    const std::vector<GenericFactorInfo> &generic_factor_infos,
+    const std::string &out_file) {
+  if (!file_io::isBinaryStreamFile(out_file)) {
+    cv::FileStorage jacobian_residual_info_out(out_file,
+                                               cv::FileStorage::WRITE);
+    jacobian_residual_info_out
+        << kJacobianParamBlockInfoKey
+        << SerializableVector<ParameterBlockInfo,
+                              SerializableParameterBlockInfo>(
+               parameter_block_infos);
+    jacobian_residual_info_out
+        << kJacobianResidualInfoKey
+        << SerializableVector<GenericFactorInfo, SerializableGenericFactorInfo>(
+               generic_factor_infos);
+    jacobian_residual_info_out.release();
+    return;
+  }
+
+  file_io::BinaryStreamWriter writer(out_file,
+                                     kJacobianResidualInfoBinaryContentType,
+                                     kJacobianResidualInfoBinaryContentVersion);
+  writer.writeScalar((uint64_t)parameter_block_infos.size());
+  for (const ParameterBlockInfo &param_block_info : parameter_block_infos) {
+    writer.writeOptionalScalar(param_block_info.frame_id_);
+    writer.writeOptionalScalar(param_block_info.obj_id_);
+    writer.writeOptionalScalar(param_block_info.feature_id_);
+  }
+  writer.writeScalar((uint64_t)generic_factor_infos.size());
+  for (const GenericFactorInfo &factor_info : generic_factor_infos) {
+    writer.writeScalar(factor_info.factor_type_);
+    writer.writeBool(factor_info.frame_ids_.has_value());
+    if (factor_info.frame_ids_.has_value()) {
+      writer.writeArray(
+          std::vector<FrameId>(factor_info.frame_ids_.value().begin(),
+                               factor_info.frame_ids_.value().end()));
+    }
+    writer.writeOptionalScalar(factor_info.camera_id_);
+    writer.writeOptionalScalar(factor_info.obj_id_);
+    writer.writeOptionalScalar(factor_info.feature_id_);
+    writer.writeOptionalScalar(factor_info.final_residual_val_);
+  }
+  writer.close();
+}
+
+/**
+ * Read the parameter block and residual info for a jacobian written by
+ * writeJacobianResidualInfoToFile (format determined by the extension).
+ *
+ * @param in_file                     File to read.
+ * @param parameter_block_infos[out]  Info for the parameter blocks.
+ * @param generic_factor_infos[out]   Info for the residuals.
+ *
+ * @return True if the file was read successfully.
+ */
+inline bool readJacobianResidualInfoFromFile(
+    const std::string &in_file,
+    std::vector<ParameterBlockInfo> &parameter_block_infos,
+    std::vector<GenericFactorInfo> &generic_factor_infos) {
+  if (!file_io::isBinaryStreamFile(in_file)) {
+    SerializableVector<ParameterBlockInfo, SerializableParameterBlockInfo>
+        serializable_param_info;
+    SerializableVector<GenericFactorInfo, SerializableGenericFactorInfo>
+        serializable_factors;
+    cv::FileStorage jacobian_info_fs(in_file, cv::FileStorage::READ);
+    jacobian_info_fs[kJacobianParamBlockInfoKey] >> serializable_param_info;
+    jacobian_info_fs[kJacobianResidualInfoKey] >> serializable_factors;
+    jacobian_info_fs.release();
+    parameter_block_infos = serializable_param_info.getEntry();
+    generic_factor_infos = serializable_factors.getEntry();
+    return true;
+  }
+
+  file_io::BinaryStreamReader reader(in_file,
+                                     kJacobianResidualInfoBinaryContentType,
+                                     kJacobianResidualInfoBinaryContentVersion);
+  uint64_t num_param_blocks;
+  if (!reader.readScalar(num_param_blocks)) {
+    return false;
+  }
+  parameter_block_infos.clear();
+  for (uint64_t block_num = 0; block_num < num_param_blocks; block_num++) {
+    ParameterBlockInfo param_block_info;
+    if (!reader.readOptionalScalar(param_block_info.frame_id_) ||
+        !reader.readOptionalScalar(param_block_info.obj_id_) ||
+        !reader.readOptionalScalar(param_block_info.feature_id_)) {
+      return false;
+    }
+    parameter_block_infos.emplace_back(param_block_info);
+  }
+
+  uint64_t num_factors;
+  if (!reader.readScalar(num_factors)) {
+    return false;
+  }
+  generic_factor_infos.clear();
+  for (uint64_t factor_num = 0; factor_num < num_factors; factor_num++) {
+    GenericFactorInfo factor_info;
+    bool has_frame_ids;
+    if (!reader.readScalar(factor_info.factor_type_) ||
+        !reader.readBool(has_frame_ids)) {
+      return false;
+    }
+    if (has_frame_ids) {
+      std::vector<FrameId> frame_ids;
+      if (!reader.readArray(frame_ids)) {
+        return false;
+      }
+      factor_info.frame_ids_ =
+          std::unordered_set<FrameId>(frame_ids.begin(), frame_ids.end());
+    }
+    if (!reader.readOptionalScalar(factor_info.camera_id_) ||
+        !reader.readOptionalScalar(factor_info.obj_id_) ||
+        !reader.readOptionalScalar(factor_info.feature_id_) ||
+        !reader.readOptionalScalar(factor_info.final_residual_val_)) {
+      return false;
+    }
+    generic_factor_infos.emplace_back(factor_info);
+  }
+  return true;
+}
+
+/**
+ * Write bounding box associations and the associated ellipsoids. Uses the
+ * binary stream format if the file has the binary extension and JSON
+ * (through cv::FileStorage) otherwise.
+ *
+ * @param data_assoc_results  Results to write.
+ * @param out_file            File to write to.
+ */
+inline void writeObjectDataAssociationResultsToFile(
+    const ObjectDataAssociationResults &data_assoc_results,
+    const std::string &out_file) {
+  if (!file_io::isBinaryStreamFile(out_file)) {
+    cv::FileStorage bb_associations_out(out_file, cv::FileStorage::WRITE);
+    bb_associations_out << kBoundingBoxAssociationsKey
+                        << SerializableObjectDataAssociationResults(
+                               data_assoc_results);
+    bb_associations_out.release();
+    return;
+  }
+
+  file_io::BinaryStreamWriter writer(
+      out_file,
+      kObjectDataAssociationBinaryContentType,
+      kObjectDataAssociationBinaryContentVersion);
+  const auto &ellipsoids =
+      data_assoc_results.ellipsoid_pose_results_.ellipsoids_;
+  writer.writeScalar((uint64_t)ellipsoids.size());
+  for (const auto &obj_and_ellipsoid : ellipsoids) {
+    writer.writeScalar(obj_and_ellipsoid.first);
+    writer.writeString(obj_and_ellipsoid.second.first);
+    RawEllipsoid<double> raw_ellipsoid =
+        convertToRawEllipsoid(obj_and_ellipsoid.second.second);
+    writer.writeArray(raw_ellipsoid.data(), raw_ellipsoid.size());
+  }
+
+  // Flatten the nested maps into one record per association
+  std::vector<uint64_t> frame_cam_obj_ids;
+  std::vector<double> corners;
+  std::vector<uint8_t> has_confidence;
+  std::vector<double> confidences;
+  for (const auto &frame_entry :
+       data_assoc_results.associated_bounding_boxes_) {
+    for (const auto &cam_entry : frame_entry.second) {
+      for (const auto &obj_entry : cam_entry.second) {
+        frame_cam_obj_ids.insert(frame_cam_obj_ids.end(),
+                                 {frame_entry.first,
+                                  cam_entry.first,
+                                  obj_entry.first});
+        const BbCornerPair<double> &corner_pair = obj_entry.second.first;
+        corners.insert(corners.end(),
+                       {corner_pair.first.x(),
+                        corner_pair.first.y(),
+                        corner_pair.second.x(),
+                        corner_pair.second.y()});
+        has_confidence.emplace_back(obj_entry.second.second.has_value());
+        confidences.emplace_back(obj_entry.second.second.value_or(0));
+      }
+    }
+  }
+  writer.writeArray(frame_cam_obj_ids);
+  writer.writeArray(corners);
+  writer.writeArray(has_confidence);
+  writer.writeArray(confidences);
+  writer.close();
+}
+
+/**
+ * Read bounding box associations written by
+ * writeObjectDataAssociationResultsToFile (format determined by the
+ * extension).
+ *
+ * @param in_file                 File to read.
+ * @param data_assoc_results[out] Results read from the file.
+ *
+ * @return True if the file was read successfully.
+ */
+inline bool readObjectDataAssociationResultsFromFile(
+    const std::string &in_file,
+    ObjectDataAssociationResults &data_assoc_results) {
+  if (!file_io::isBinaryStreamFile(in_file)) {
+    SerializableObjectDataAssociationResults ser_data_assoc_results;
+    cv::FileStorage data_assoc_results_in(in_file, cv::FileStorage::READ);
+    data_assoc_results_in[kBoundingBoxAssociationsKey] >>
+        ser_data_assoc_results;
+    data_assoc_results_in.release();
+    data_assoc_results = ser_data_assoc_results.getEntry();
+    return true;
+  }
+
+  file_io::BinaryStreamReader reader(
+      in_file,
+      kObjectDataAssociationBinaryContentType,
+      kObjectDataAssociationBinaryContentVersion);
+  uint64_t num_ellipsoids;
+  if (!reader.readScalar(num_ellipsoids)) {
+    return false;
+  }
+  data_assoc_results = ObjectDataAssociationResults();
+  for (uint64_t ellipsoid_num = 0; ellipsoid_num < num_ellipsoids;
+       ellipsoid_num++) {
+    ObjectId obj_id;
+    std::string semantic_class;
+    std::vector<double> raw_ellipsoid;
+    if (!reader.readScalar(obj_id) || !reader.readString(semantic_class) ||
+        !reader.readArray(raw_ellipsoid)) {
+      return false;
+    }
+    if (raw_ellipsoid.size() != kEllipsoidParamterizationSize) {
+      LOG(ERROR) << "Ellipsoid in " << in_file << " has "
+                 << raw_ellipsoid.size() << " parameters, but expected "
+                 << kEllipsoidParamterizationSize
+                 << "; was it written with a different ellipsoid "
+                    "parameterization?";
+      return false;
+    }
+    RawEllipsoid<double> raw_ellipsoid_state =
+        Eigen::Map<RawEllipsoid<double>>(raw_ellipsoid.data());
+    data_assoc_results.ellipsoid_pose_results_.ellipsoids_[obj_id] =
+        std::make_pair(semantic_class,
+                       convertToEllipsoidState(raw_ellipsoid_state));
+  }
+
+  std::vector<uint64_t> frame_cam_obj_ids;
+  std::vector<double> corners;
+  std::vector<uint8_t> has_confidence;
+  std::vector<double> confidences;
+  if (!reader.readArray(frame_cam_obj_ids) || !reader.readArray(corners) ||
+      !reader.readArray(has_confidence) || !reader.readArray(confidences)) {
+    return false;
+  }
+  size_t num_associations = has_confidence.size();
+  if ((frame_cam_obj_ids.size() != 3 * num_associations) ||
+      (corners.size() != 4 * num_associations) ||
+      (confidences.size() != num_associations)) {
+    LOG(ERROR) << "Inconsistent number of associations in " << in_file;
+    return false;
+  }
+  for (size_t assoc_num = 0; assoc_num < num_associations; assoc_num++) {
+    const uint64_t *ids = &(frame_cam_obj_ids[3 * assoc_num]);
+    const double *bb = &(corners[4 * assoc_num]);
+    std::optional<double> confidence;
+    if (has_confidence[assoc_num] != 0) {
+      confidence = confidences[assoc_num];
+    }
+    data_assoc_results.associated_bounding_boxes_[ids[0]][ids[1]][ids[2]] =
+        std::make_pair(std::make_pair(PixelCoord<double>(bb[0], bb[1]),
+                                      PixelCoord<double>(bb[2], bb[3])),
+                       confidence);
+  }
+  return true;
+}
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_DEBUG_DUMP_IO_H
@@ -19,15 +19,15 @@ struct FeatureEstWithId {
 };
 
 void readFeatureEstWithIdLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     FeatureEstWithId &feature_est_with_id) {
   size_t list_idx = 0;
-  std::istringstream stream_feature_id(entries_in_file_line[list_idx++]);
-  stream_feature_id >> feature_est_with_id.feature_id;
+  parseCsvField(entries_in_file_line[list_idx++],
+                feature_est_with_id.feature_id);
 
   std::vector<double> data;
   for (size_t i = 0; i < 3; i++) {
-    data.emplace_back(std::stod(entries_in_file_line[list_idx++]));
+    data.emplace_back(parseCsvField<double>(entries_in_file_line[list_idx++]));
   }
   feature_est_with_id.x = data[0];
   feature_est_with_id.y = data[1];
@@ -37,7 +37,7 @@ void readFeatureEstWithIdLine(
 void readFeatureEstsWithIdFromFile(
     const std::string &file_name,
     std::vector<FeatureEstWithId> &feature_ests_with_node_id) {
-  std::function<void(const std::vector<std::string> &, FeatureEstWithId &)>
+  CsvLineReader<FeatureEstWithId>
       feature_est_from_line_reader = readFeatureEstWithIdLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, feature_est_from_line_reader, feature_ests_with_node_id);
@@ -15,6 +15,7 @@ namespace file_io {
 const static std::string kJsonExtension = ".json";
 const static std::string kCsvExtension = ".csv";
 const static std::string kBagExtension = ".bag";
+const static std::string kTempFileSuffix = "_tmp";
 
 inline std::string ensureDirectoryPathEndsWithSlash(
     const std::string &unvalidated_dir_path) {
@@ -32,6 +33,46 @@ inline std::string ensureDirectoryPathEndsWithSlash(
 inline void makeDirectoryIfDoesNotExist(const std::string &dir_name) {
   boost::filesystem::create_directories(dir_name);
 }
+
+/**
+ * Get the file to write to when the contents of out_file should be replaced
+ * atomically. The temporary file is in the same directory (so the rename is
+ * atomic) and keeps the extension (so writers that infer the format from the
+ * extension, i.e. cv::FileStorage, still work).
+ *
+ * @param out_file File that will eventually contain the output.
+ *
+ * @return Temporary file to write to before calling
+ * commitAtomicallyWrittenFile.
+ */
+inline std::string getTempFileForAtomicWrite(const std::string &out_file) {
+  boost::filesystem::path out_path(out_file);
+  return (out_path.parent_path() /
+          (out_path.stem().string() + kTempFileSuffix +
+           out_path.extension().string()))
+      .string();
+}
+
+/**
+ * Move a fully written temporary file to its final location, so that readers
+ * of out_file never see a partially written file.
+ *
+ * @param temp_file Temporary file (from getTempFileForAtomicWrite).
+ * @param out_file  Final file name.
+ *
+ * @return True if the file was moved, false otherwise.
+ */
+inline bool commitAtomicallyWrittenFile(const std::string &temp_file,
+                                        const std::string &out_file) {
+  boost::system::error_code rename_error;
+  boost::filesystem::rename(temp_file, out_file, rename_error);
+  if (rename_error) {
+    LOG(ERROR) << "Could not move " << temp_file << " to " << out_file << ": "
+               << rename_error.message();
+    return false;
+  }
+  return true;
+}
 }  // namespace file_io
 
 #endif  // UT_VSLAM_FILE_ACCESS_UTILS_H
@@ -5,10 +5,12 @@
 #ifndef UT_VSLAM_FILE_IO_UTILS_H
 #define UT_VSLAM_FILE_IO_UTILS_H
 
+#include <file_io/csv_tokenizer.h>
 #include <glog/logging.h>
 
 #include <fstream>
 #include <functional>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -29,34 +31,30 @@ inline void writeCommaSeparatedStringsLineToFile(
 inline std::vector<std::string> parseCommaSeparatedStrings(
     const std::string &str) {
   std::vector<std::string> strs;
-  std::stringstream ss(str);
-
-  std::string substr;
-  while (getline(ss, substr, ',')) {
-    strs.emplace_back(substr);
+  for (const std::string_view &field : splitCsvLine(str)) {
+    strs.emplace_back(field);
   }
   return strs;
 }
 
+/**
+ * Read a CSV file with a header line, with one object per remaining line.
+ *
+ * @param file_name               Name of the file.
+ * @param object_from_line_reader Reads one object from a line's fields. Must
+ *                                be safe to call concurrently.
+ * @param objects[out]            Objects read from the file (appended).
+ * @param num_parse_threads       Number of threads to parse with. If 0, this
+ *                                is chosen from the file size.
+ */
 template <typename T>
 void readObjectListFromFileWithHeader(
     const std::string &file_name,
-    std::function<void(const std::vector<std::string> &, T &)>
-        object_from_line_reader,
-    std::vector<T> &objects) {
-  std::ifstream file_obj(file_name);
-  std::string line;
-  bool first_line = true;
-  while (std::getline(file_obj, line)) {
-    if (first_line) {
-      first_line = false;
-      continue;
-    }
-    T object;
-    object_from_line_reader(parseCommaSeparatedStrings(line), object);
-    objects.emplace_back(object);
-  }
-  if (first_line) {
+    const CsvLineReader<T> &object_from_line_reader,
+    std::vector<T> &objects,
+    const size_t &num_parse_threads = 0) {
+  if (!parseCsvFileWithHeader(
+          file_name, object_from_line_reader, num_parse_threads, objects)) {
     LOG(ERROR)
         << "The file was completely empty (and likely doesn't exist). File "
         << file_name;
@@ -64,13 +62,25 @@ void readObjectListFromFileWithHeader(
   }
 }
 
+/**
+ * Size of the stream buffer used when writing object lists. Much larger than
+ * the default so that large files (i.e. feature estimates for a whole
+ * dataset) are written with few system calls.
+ */
+const size_t kCsvWriteBufferSize = 1 << 20;
+
 template <typename T>
 void writeObjectsToFile(const std::string &file_name,
                         const std::vector<std::string> &entry_names,
                         const std::vector<T> &objects,
                         std::function<std::vector<std::string>(const T &)>
                             object_to_str_list_converter) {
-  std::ofstream csv_file(file_name, std::ios::trunc);
+  // Declared before the stream so that it outlives it
+  std::unique_ptr<char[]> write_buffer(new char[kCsvWriteBufferSize]);
+  std::ofstream csv_file;
+  // Must be set before opening to take effect
+  csv_file.rdbuf()->pubsetbuf(write_buffer.get(), kCsvWriteBufferSize);
+  csv_file.open(file_name, std::ios::trunc);
   writeCommaSeparatedStringsLineToFile(entry_names, csv_file);
   for (const T &obj : objects) {
     writeCommaSeparatedStringsLineToFile(object_to_str_list_converter(obj),
@@ -90,7 +100,7 @@ bool readNumObjectsIndicatedByFirstLine(
     return false;
   }
   // Read the number
-  int num_entries = std::stoi(line);
+  int num_entries = parseCsvField<int>(line);
   for (int i = 0; i < num_entries; i++) {
     if (!std::getline(file_stream, line)) {
       LOG(ERROR) << "File ended unexpectedly";
@@ -31,27 +31,30 @@ struct ObjectEst {
   double d_z_;
 };
 
-void readObjectEstLine(const std::vector<std::string> &entries_in_file_line,
-                       ObjectEst &object_est) {
+void readObjectEstLine(
+    const std::vector<std::string_view> &entries_in_file_line,
+    ObjectEst &object_est) {
   size_t list_idx = 0;
   object_est.semantic_class_ = entries_in_file_line[list_idx++];
 
-  object_est.transl_x_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.transl_y_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.transl_z_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.quat_x_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.quat_y_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.quat_z_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.quat_w_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.d_x_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.d_y_ = std::stod(entries_in_file_line[list_idx++]);
-  object_est.d_z_ = std::stod(entries_in_file_line[list_idx++]);
+  object_est.transl_x_ =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.transl_y_ =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.transl_z_ =
+      parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.quat_x_ = parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.quat_y_ = parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.quat_z_ = parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.quat_w_ = parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.d_x_ = parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.d_y_ = parseCsvField<double>(entries_in_file_line[list_idx++]);
+  object_est.d_z_ = parseCsvField<double>(entries_in_file_line[list_idx++]);
 }
 
 void readObjectEstsFromFile(const std::string &file_name,
                             std::vector<ObjectEst> &object_ests) {
-  std::function<void(const std::vector<std::string> &, ObjectEst &)>
-      object_from_line_reader = readObjectEstLine;
+  CsvLineReader<ObjectEst> object_from_line_reader = readObjectEstLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, object_ests);
 }
@@ -21,23 +21,21 @@ struct NodeIdAndTimestamp {
 };
 
 void readNodeIdAndTimestampLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     NodeIdAndTimestamp &node_and_timestamp) {
   size_t list_idx = 0;
-  std::istringstream stream_identifier(entries_in_file_line[list_idx++]);
-  stream_identifier >> node_and_timestamp.node_id_;
+  parseCsvField(entries_in_file_line[list_idx++], node_and_timestamp.node_id_);
 
-  std::istringstream stream_seconds(entries_in_file_line[list_idx++]);
-  stream_seconds >> node_and_timestamp.seconds_;
+  parseCsvField(entries_in_file_line[list_idx++], node_and_timestamp.seconds_);
 
-  std::istringstream stream_nanoseconds(entries_in_file_line[list_idx++]);
-  stream_nanoseconds >> node_and_timestamp.nano_seconds_;
+  parseCsvField(entries_in_file_line[list_idx++],
+                node_and_timestamp.nano_seconds_);
 }
 
 void readNodeIdsAndTimestampsFromFile(
     const std::string &file_name,
     std::vector<NodeIdAndTimestamp> &nodes_and_timestamps) {
-  std::function<void(const std::vector<std::string> &, NodeIdAndTimestamp &)>
+  CsvLineReader<NodeIdAndTimestamp>
       object_from_line_reader = readNodeIdAndTimestampLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, nodes_and_timestamps);
@@ -93,8 +93,7 @@ bool readRoshanFrontEndDataFromFile(
     return false;
   }
 
-  std::istringstream stream_num_ellipsoids(line);
-  stream_num_ellipsoids >> num_ellipsoids;
+  parseCsvField(line, num_ellipsoids);
 
   for (size_t i = 0; i < num_ellipsoids; i++) {
     // Read object id
@@ -105,8 +104,7 @@ bool readRoshanFrontEndDataFromFile(
     }
 
     vslam_types_refactor::ObjectId obj_id;
-    std::istringstream stream_obj_id(line);
-    stream_obj_id >> obj_id;
+    parseCsvField(line, obj_id);
 
     if (!std::getline(file_stream, line)) {
       LOG(ERROR) << "File ended unexpectedly";
@@ -114,8 +112,7 @@ bool readRoshanFrontEndDataFromFile(
     }
 
     size_t num_entries_per_ellipsoid;
-    std::istringstream stream_num_entries_per_ellipsoid(line);
-    stream_num_entries_per_ellipsoid >> num_entries_per_ellipsoid;
+    parseCsvField(line, num_entries_per_ellipsoid);
 
     for (size_t ellipsoid_entry_num = 0;
          ellipsoid_entry_num < num_entries_per_ellipsoid;
@@ -125,29 +122,33 @@ bool readRoshanFrontEndDataFromFile(
         return false;
       }
 
-      std::vector<std::string> comma_separated_strings =
-          parseCommaSeparatedStrings(line);
+      std::vector<std::string_view> comma_separated_strings =
+          splitCsvLine(line);
       vslam_types_refactor::RoshanBbInfo bb_info;
       size_t list_idx = 0;
       bb_info.est_generated_ = comma_separated_strings[list_idx++] == "1";
 
-      double transl_x = std::stod(comma_separated_strings[list_idx++]);
-      double transl_y = std::stod(comma_separated_strings[list_idx++]);
-      double transl_z = std::stod(comma_separated_strings[list_idx++]);
+      double transl_x =
+          parseCsvField<double>(comma_separated_strings[list_idx++]);
+      double transl_y =
+          parseCsvField<double>(comma_separated_strings[list_idx++]);
+      double transl_z =
+          parseCsvField<double>(comma_separated_strings[list_idx++]);
 #ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
-      double yaw = std::stod(comma_separated_strings[list_idx++]);
+      double yaw = parseCsvField<double>(comma_separated_strings[list_idx++]);
 #else
-      double orientation_angle = std::stod(comma_separated_strings[list_idx++]);
+      double orientation_angle =
+          parseCsvField<double>(comma_separated_strings[list_idx++]);
       double orientation_axis_x =
-          std::stod(comma_separated_strings[list_idx++]);
+          parseCsvField<double>(comma_separated_strings[list_idx++]);
       double orientation_axis_y =
-          std::stod(comma_separated_strings[list_idx++]);
+          parseCsvField<double>(comma_separated_strings[list_idx++]);
       double orientation_axis_z =
-          std::stod(comma_separated_strings[list_idx++]);
+          parseCsvField<double>(comma_separated_strings[list_idx++]);
 #endif
-      double dim_x = std::stod(comma_separated_strings[list_idx++]);
-      double dim_y = std::stod(comma_separated_strings[list_idx++]);
-      double dim_z = std::stod(comma_separated_strings[list_idx++]);
+      double dim_x = parseCsvField<double>(comma_separated_strings[list_idx++]);
+      double dim_y = parseCsvField<double>(comma_separated_strings[list_idx++]);
+      double dim_z = parseCsvField<double>(comma_separated_strings[list_idx++]);
 
       bb_info.single_bb_init_est_ =
           vslam_types_refactor::EllipsoidState<double>(
@@ -213,31 +214,33 @@ bool readEllipsoidResultEntryFromFile(
         vslam_types_refactor::ObjectId,
         std::pair<std::string, vslam_types_refactor::EllipsoidState<double>>>
         &ellipsoid_entry) {
-  std::vector<std::string> comma_separated_strings =
-      parseCommaSeparatedStrings(line);
+  std::vector<std::string_view> comma_separated_strings = splitCsvLine(line);
   size_t list_idx = 0;
 
-  std::istringstream obj_id_stream(comma_separated_strings[list_idx++]);
   vslam_types_refactor::ObjectId obj_id;
-  obj_id_stream >> obj_id;
+  parseCsvField(comma_separated_strings[list_idx++], obj_id);
 
-  std::string semantic_class = comma_separated_strings[list_idx++];
+  std::string semantic_class(comma_separated_strings[list_idx++]);
 
-  double transl_x = std::stod(comma_separated_strings[list_idx++]);
-  double transl_y = std::stod(comma_separated_strings[list_idx++]);
-  double transl_z = std::stod(comma_separated_strings[list_idx++]);
+  double transl_x = parseCsvField<double>(comma_separated_strings[list_idx++]);
+  double transl_y = parseCsvField<double>(comma_separated_strings[list_idx++]);
+  double transl_z = parseCsvField<double>(comma_separated_strings[list_idx++]);
 #ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
-  double yaw = std::stod(comma_separated_strings[list_idx++]);
+  double yaw = parseCsvField<double>(comma_separated_strings[list_idx++]);
 #else
-  double orientation_angle = std::stod(comma_separated_strings[list_idx++]);
-  double orientation_axis_x = std::stod(comma_separated_strings[list_idx++]);
-  double orientation_axis_y = std::stod(comma_separated_strings[list_idx++]);
-  double orientation_axis_z = std::stod(comma_separated_strings[list_idx++]);
+  double orientation_angle =
+      parseCsvField<double>(comma_separated_strings[list_idx++]);
+  double orientation_axis_x =
+      parseCsvField<double>(comma_separated_strings[list_idx++]);
+  double orientation_axis_y =
+      parseCsvField<double>(comma_separated_strings[list_idx++]);
+  double orientation_axis_z =
+      parseCsvField<double>(comma_separated_strings[list_idx++]);
 #endif
 
-  double dim_x = std::stod(comma_separated_strings[list_idx++]);
-  double dim_y = std::stod(comma_separated_strings[list_idx++]);
-  double dim_z = std::stod(comma_separated_strings[list_idx++]);
+  double dim_x = parseCsvField<double>(comma_separated_strings[list_idx++]);
+  double dim_y = parseCsvField<double>(comma_separated_strings[list_idx++]);
+  double dim_z = parseCsvField<double>(comma_separated_strings[list_idx++]);
 
   ellipsoid_entry = std::make_pair(
       obj_id,
@@ -393,119 +396,117 @@ bool readPairwiseEllipsoidCovarianceEntryFromFile(
 #else
               Eigen::Matrix<double, 9, 9>> &ellipsoid_covariance_entry) {
 #endif
-  std::vector<std::string> com_sep_str = parseCommaSeparatedStrings(line);
+  std::vector<std::string_view> com_sep_str = splitCsvLine(line);
   size_t list_idx = 0;
 
-  std::istringstream obj_id_1_stream(com_sep_str[list_idx++]);
   vslam_types_refactor::ObjectId obj_id_1;
-  obj_id_1_stream >> obj_id_1;
+  parseCsvField(com_sep_str[list_idx++], obj_id_1);
 
-  std::istringstream obj_id_2_stream(com_sep_str[list_idx++]);
   vslam_types_refactor::ObjectId obj_id_2;
-  obj_id_2_stream >> obj_id_2;
-
-  double cov_00 = std::stod(com_sep_str[list_idx++]);
-  double cov_01 = std::stod(com_sep_str[list_idx++]);
-  double cov_02 = std::stod(com_sep_str[list_idx++]);
-  double cov_03 = std::stod(com_sep_str[list_idx++]);
-  double cov_04 = std::stod(com_sep_str[list_idx++]);
-  double cov_05 = std::stod(com_sep_str[list_idx++]);
-  double cov_06 = std::stod(com_sep_str[list_idx++]);
+  parseCsvField(com_sep_str[list_idx++], obj_id_2);
+
+  double cov_00 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_01 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_02 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_03 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_04 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_05 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_06 = parseCsvField<double>(com_sep_str[list_idx++]);
 #ifndef CONSTRAIN_ELLIPSOID_ORIENTATION
-  double cov_07 = std::stod(com_sep_str[list_idx++]);
-  double cov_08 = std::stod(com_sep_str[list_idx++]);
+  double cov_07 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_08 = parseCsvField<double>(com_sep_str[list_idx++]);
 #endif
 
-  double cov_10 = std::stod(com_sep_str[list_idx++]);
-  double cov_11 = std::stod(com_sep_str[list_idx++]);
-  double cov_12 = std::stod(com_sep_str[list_idx++]);
-  double cov_13 = std::stod(com_sep_str[list_idx++]);
-  double cov_14 = std::stod(com_sep_str[list_idx++]);
-  double cov_15 = std::stod(com_sep_str[list_idx++]);
-  double cov_16 = std::stod(com_sep_str[list_idx++]);
+  double cov_10 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_11 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_12 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_13 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_14 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_15 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_16 = parseCsvField<double>(com_sep_str[list_idx++]);
 #ifndef CONSTRAIN_ELLIPSOID_ORIENTATION
-  double cov_17 = std::stod(com_sep_str[list_idx++]);
-  double cov_18 = std::stod(com_sep_str[list_idx++]);
+  double cov_17 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_18 = parseCsvField<double>(com_sep_str[list_idx++]);
 #endif
 
-  double cov_20 = std::stod(com_sep_str[list_idx++]);
-  double cov_21 = std::stod(com_sep_str[list_idx++]);
-  double cov_22 = std::stod(com_sep_str[list_idx++]);
-  double cov_23 = std::stod(com_sep_str[list_idx++]);
-  double cov_24 = std::stod(com_sep_str[list_idx++]);
-  double cov_25 = std::stod(com_sep_str[list_idx++]);
-  double cov_26 = std::stod(com_sep_str[list_idx++]);
+  double cov_20 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_21 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_22 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_23 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_24 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_25 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_26 = parseCsvField<double>(com_sep_str[list_idx++]);
 #ifndef CONSTRAIN_ELLIPSOID_ORIENTATION
-  double cov_27 = std::stod(com_sep_str[list_idx++]);
-  double cov_28 = std::stod(com_sep_str[list_idx++]);
+  double cov_27 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_28 = parseCsvField<double>(com_sep_str[list_idx++]);
 #endif
 
-  double cov_30 = std::stod(com_sep_str[list_idx++]);
-  double cov_31 = std::stod(com_sep_str[list_idx++]);
-  double cov_32 = std::stod(com_sep_str[list_idx++]);
-  double cov_33 = std::stod(com_sep_str[list_idx++]);
-  double cov_34 = std::stod(com_sep_str[list_idx++]);
-  double cov_35 = std::stod(com_sep_str[list_idx++]);
-  double cov_36 = std::stod(com_sep_str[list_idx++]);
+  double cov_30 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_31 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_32 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_33 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_34 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_35 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_36 = parseCsvField<double>(com_sep_str[list_idx++]);
 #ifndef CONSTRAIN_ELLIPSOID_ORIENTATION
-  double cov_37 = std::stod(com_sep_str[list_idx++]);
-  double cov_38 = std::stod(com_sep_str[list_idx++]);
+  double cov_37 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_38 = parseCsvField<double>(com_sep_str[list_idx++]);
 #endif
 
-  double cov_40 = std::stod(com_sep_str[list_idx++]);
-  double cov_41 = std::stod(com_sep_str[list_idx++]);
-  double cov_42 = std::stod(com_sep_str[list_idx++]);
-  double cov_43 = std::stod(com_sep_str[list_idx++]);
-  double cov_44 = std::stod(com_sep_str[list_idx++]);
-  double cov_45 = std::stod(com_sep_str[list_idx++]);
-  double cov_46 = std::stod(com_sep_str[list_idx++]);
+  double cov_40 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_41 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_42 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_43 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_44 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_45 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_46 = parseCsvField<double>(com_sep_str[list_idx++]);
 #ifndef CONSTRAIN_ELLIPSOID_ORIENTATION
-  double cov_47 = std::stod(com_sep_str[list_idx++]);
-  double cov_48 = std::stod(com_sep_str[list_idx++]);
+  double cov_47 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_48 = parseCsvField<double>(com_sep_str[list_idx++]);
 #endif
 
-  double cov_50 = std::stod(com_sep_str[list_idx++]);
-  double cov_51 = std::stod(com_sep_str[list_idx++]);
-  double cov_52 = std::stod(com_sep_str[list_idx++]);
-  double cov_53 = std::stod(com_sep_str[list_idx++]);
-  double cov_54 = std::stod(com_sep_str[list_idx++]);
-  double cov_55 = std::stod(com_sep_str[list_idx++]);
-  double cov_56 = std::stod(com_sep_str[list_idx++]);
+  double cov_50 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_51 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_52 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_53 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_54 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_55 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_56 = parseCsvField<double>(com_sep_str[list_idx++]);
 #ifndef CONSTRAIN_ELLIPSOID_ORIENTATION
-  double cov_57 = std::stod(com_sep_str[list_idx++]);
-  double cov_58 = std::stod(com_sep_str[list_idx++]);
+  double cov_57 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_58 = parseCsvField<double>(com_sep_str[list_idx++]);
 #endif
 
-  double cov_60 = std::stod(com_sep_str[list_idx++]);
-  double cov_61 = std::stod(com_sep_str[list_idx++]);
-  double cov_62 = std::stod(com_sep_str[list_idx++]);
-  double cov_63 = std::stod(com_sep_str[list_idx++]);
-  double cov_64 = std::stod(com_sep_str[list_idx++]);
-  double cov_65 = std::stod(com_sep_str[list_idx++]);
-  double cov_66 = std::stod(com_sep_str[list_idx++]);
+  double cov_60 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_61 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_62 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_63 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_64 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_65 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_66 = parseCsvField<double>(com_sep_str[list_idx++]);
 #ifndef CONSTRAIN_ELLIPSOID_ORIENTATION
-  double cov_67 = std::stod(com_sep_str[list_idx++]);
-  double cov_68 = std::stod(com_sep_str[list_idx++]);
-
-  double cov_70 = std::stod(com_sep_str[list_idx++]);
-  double cov_71 = std::stod(com_sep_str[list_idx++]);
-  double cov_72 = std::stod(com_sep_str[list_idx++]);
-  double cov_73 = std::stod(com_sep_str[list_idx++]);
-  double cov_74 = std::stod(com_sep_str[list_idx++]);
-  double cov_75 = std::stod(com_sep_str[list_idx++]);
-  double cov_76 = std::stod(com_sep_str[list_idx++]);
-  double cov_77 = std::stod(com_sep_str[list_idx++]);
-  double cov_78 = std::stod(com_sep_str[list_idx++]);
-
-  double cov_80 = std::stod(com_sep_str[list_idx++]);
-  double cov_81 = std::stod(com_sep_str[list_idx++]);
-  double cov_82 = std::stod(com_sep_str[list_idx++]);
-  double cov_83 = std::stod(com_sep_str[list_idx++]);
-  double cov_84 = std::stod(com_sep_str[list_idx++]);
-  double cov_85 = std::stod(com_sep_str[list_idx++]);
-  double cov_86 = std::stod(com_sep_str[list_idx++]);
-  double cov_87 = std::stod(com_sep_str[list_idx++]);
-  double cov_88 = std::stod(com_sep_str[list_idx++]);
+  double cov_67 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_68 = parseCsvField<double>(com_sep_str[list_idx++]);
+
+  double cov_70 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_71 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_72 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_73 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_74 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_75 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_76 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_77 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_78 = parseCsvField<double>(com_sep_str[list_idx++]);
+
+  double cov_80 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_81 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_82 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_83 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_84 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_85 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_86 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_87 = parseCsvField<double>(com_sep_str[list_idx++]);
+  double cov_88 = parseCsvField<double>(com_sep_str[list_idx++]);
 #endif
 
 #ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
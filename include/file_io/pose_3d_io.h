@@ -13,13 +13,14 @@
 
 namespace file_io {
 
-void readPose3dLine(const std::vector<std::string> &entries_in_file_line,
-                    vslam_types_refactor::Pose3D<double> &pose3d) {
+void readPose3dLine(
+    const std::vector<std::string_view> &entries_in_file_line,
+    vslam_types_refactor::Pose3D<double> &pose3d) {
   size_t list_idx = 0;
 
   std::vector<double> data;
   for (size_t i = 0; i < 7; i++) {
-    data.emplace_back(std::stod(entries_in_file_line[list_idx++]));
+    data.emplace_back(parseCsvField<double>(entries_in_file_line[list_idx++]));
   }
 
   pose3d = vslam_types_refactor::Pose3D<double>(
@@ -31,8 +32,7 @@ void readPose3dLine(const std::vector<std::string> &entries_in_file_line,
 void readPose3dsFromFile(const std::string &file_name,
                          std::vector<vslam_types_refactor::Pose3D<double>>
                              &pose_3ds_with_timestamp) {
-  std::function<void(const std::vector<std::string> &,
-                     vslam_types_refactor::Pose3D<double> &)>
+  CsvLineReader<vslam_types_refactor::Pose3D<double>>
       object_from_line_reader = readPose3dLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, pose_3ds_with_timestamp);
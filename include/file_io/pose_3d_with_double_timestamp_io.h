@@ -6,6 +6,7 @@
 #define UT_VSLAM_POSE_3D_WITH_DOUBLE_TIMESTAMP_IO_H
 
 #include <base_lib/pose_reps.h>
+#include <file_io/csv_tokenizer.h>
 
 #include <eigen3/Eigen/Dense>
 #include <fstream>
@@ -25,14 +26,11 @@ struct Pose3DWithDoubleTimestamp {
 };
 
 void readPose3DWithDoubleTimestampLine(
-    const std::string &line_in_file,
+    const std::vector<std::string_view> &entries_in_file_line,
     Pose3DWithDoubleTimestamp &lidar_odom_est_data) {
-  std::stringstream ss(line_in_file);
   std::vector<double> data;
-  while (ss.good()) {
-    std::string substr;
-    getline(ss, substr, ' ');
-    data.push_back(std::stod(substr));
+  for (const std::string_view &entry : entries_in_file_line) {
+    data.push_back(parseCsvField<double>(entry));
   }
   lidar_odom_est_data.timestamp_ = data[0];
   lidar_odom_est_data.transl_x_ = data[1];
@@ -47,20 +45,14 @@ void readPose3DWithDoubleTimestampLine(
 void readPose3DWithDoubleTimestampFromFile(
     const std::string &file_name,
     std::vector<Pose3DWithDoubleTimestamp> &odom_ests_in_abs_frame) {
-  std::ifstream file_obj(file_name);
-  std::string line;
-  bool first_line = true;
-  while (std::getline(file_obj, line)) {
-    if (first_line) {
-      first_line = false;
-      continue;
-    }
-
-    Pose3DWithDoubleTimestamp lidar_odom_est_data;
-    readPose3DWithDoubleTimestampLine(line, lidar_odom_est_data);
-    odom_ests_in_abs_frame.emplace_back(lidar_odom_est_data);
-  }
-  if (first_line) {
+  CsvLineReader<Pose3DWithDoubleTimestamp> object_from_line_reader =
+      readPose3DWithDoubleTimestampLine;
+  // Entries in these files are space separated
+  if (!parseCsvFileWithHeader(file_name,
+                              object_from_line_reader,
+                              0,
+                              odom_ests_in_abs_frame,
+                              ' ')) {
     throw std::invalid_argument("Pose3d with double file was empty");
   }
 }
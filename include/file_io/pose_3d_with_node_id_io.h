@@ -13,16 +13,15 @@
 namespace file_io {
 
 void readPose3dWithNodeIdLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     std::pair<uint64_t, pose::Pose3d> &pose3d_with_node_id) {
   uint64_t node_id;
   size_t list_idx = 0;
-  std::istringstream stream_node_id(entries_in_file_line[list_idx++]);
-  stream_node_id >> node_id;
+  parseCsvField(entries_in_file_line[list_idx++], node_id);
 
   std::vector<double> data;
   for (size_t i = 0; i < 7; i++) {
-    data.emplace_back(std::stod(entries_in_file_line[list_idx++]));
+    data.emplace_back(parseCsvField<double>(entries_in_file_line[list_idx++]));
   }
 
   pose::Pose3d pose_3d =
@@ -35,8 +34,7 @@ void readPose3dWithNodeIdLine(
 void readPose3dsAndNodeIdFromFile(
     const std::string &file_name,
     std::vector<std::pair<uint64_t, pose::Pose3d>> &pose_3ds_with_node_id) {
-  std::function<void(const std::vector<std::string> &,
-                     std::pair<uint64_t, pose::Pose3d> &)>
+  CsvLineReader<std::pair<uint64_t, pose::Pose3d>>
       object_from_line_reader = readPose3dWithNodeIdLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, pose_3ds_with_node_id);
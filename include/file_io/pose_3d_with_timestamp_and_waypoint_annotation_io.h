@@ -20,7 +20,7 @@ static const size_t kWaypointIdIdx = 10;
 }
 
 void readPose3dWithWaypointInfoLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     std::pair<pose::Timestamp, vslam_types_refactor::PoseAndWaypointInfoForNode>
         &stamp_and_pose_info) {
   size_t list_idx = 0;
@@ -28,19 +28,18 @@ void readPose3dWithWaypointInfoLine(
   uint32_t seconds;
   uint32_t nano_seconds;
 
-  std::istringstream stream_seconds(entries_in_file_line[list_idx++]);
-  stream_seconds >> seconds;
+  parseCsvField(entries_in_file_line[list_idx++], seconds);
 
-  std::istringstream stream_nseconds(entries_in_file_line[list_idx++]);
-  stream_nseconds >> nano_seconds;
+  parseCsvField(entries_in_file_line[list_idx++], nano_seconds);
 
   vslam_types_refactor::PoseAndWaypointInfoForNode pose_info;
 
-  bool lost = std::stoi(entries_in_file_line[list_idx++]) != 0;
+  bool lost = parseCsvField<int>(entries_in_file_line[list_idx++]) != 0;
   if (!lost) {
     std::vector<double> data;
     for (size_t i = 0; i < 7; i++) {
-      data.emplace_back(std::stod(entries_in_file_line[list_idx++]));
+      data.emplace_back(
+          parseCsvField<double>(entries_in_file_line[list_idx++]));
     }
 
     vslam_types_refactor::Pose3D<double> pose_3d(
@@ -52,12 +51,12 @@ void readPose3dWithWaypointInfoLine(
     pose_info.pose_ = std::nullopt;
   }
 
-  int waypoint_id = std::stoi(entries_in_file_line[kWaypointIdIdx]);
+  int waypoint_id = parseCsvField<int>(entries_in_file_line[kWaypointIdIdx]);
   if (waypoint_id < 0) {
     pose_info.waypoint_id_and_reversal_ = std::nullopt;
   } else {
     bool waypoint_reversed =
-        std::stoi(entries_in_file_line[kWaypointIdIdx + 1]) != 0;
+        parseCsvField<int>(entries_in_file_line[kWaypointIdIdx + 1]) != 0;
     pose_info.waypoint_id_and_reversal_ =
         std::make_pair(waypoint_id, waypoint_reversed);
   }
@@ -71,10 +70,8 @@ void readPose3dsWithWaypointInfoFromFile(
     std::vector<std::pair<pose::Timestamp,
                           vslam_types_refactor::PoseAndWaypointInfoForNode>>
         &stamp_and_pose_infos) {
-  std::function<void(
-      const std::vector<std::string> &,
-      std::pair<pose::Timestamp,
-                vslam_types_refactor::PoseAndWaypointInfoForNode> &)>
+  CsvLineReader<std::pair<pose::Timestamp,
+                          vslam_types_refactor::PoseAndWaypointInfoForNode>>
       object_from_line_reader = readPose3dWithWaypointInfoLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, stamp_and_pose_infos);
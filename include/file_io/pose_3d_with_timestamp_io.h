@@ -15,22 +15,20 @@
 namespace file_io {
 
 void readPose3dWithTimestampLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     std::pair<pose::Timestamp, pose::Pose3d> &pose3d_with_timestamp) {
   size_t list_idx = 0;
 
   uint32_t seconds;
   uint32_t nano_seconds;
 
-  std::istringstream stream_seconds(entries_in_file_line[list_idx++]);
-  stream_seconds >> seconds;
+  parseCsvField(entries_in_file_line[list_idx++], seconds);
 
-  std::istringstream stream_nseconds(entries_in_file_line[list_idx++]);
-  stream_nseconds >> nano_seconds;
+  parseCsvField(entries_in_file_line[list_idx++], nano_seconds);
 
   std::vector<double> data;
   for (size_t i = 0; i < 7; i++) {
-    data.emplace_back(std::stod(entries_in_file_line[list_idx++]));
+    data.emplace_back(parseCsvField<double>(entries_in_file_line[list_idx++]));
   }
 
   pose::Pose3d pose_3d =
@@ -42,7 +40,7 @@ void readPose3dWithTimestampLine(
 }
 
 void readOptionalPose3dWithTimestampLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     std::pair<pose::Timestamp,
               std::optional<vslam_types_refactor::Pose3D<double>>>
         &pose3d_with_timestamp) {
@@ -51,17 +49,16 @@ void readOptionalPose3dWithTimestampLine(
   uint32_t seconds;
   uint32_t nano_seconds;
 
-  std::istringstream stream_seconds(entries_in_file_line[list_idx++]);
-  stream_seconds >> seconds;
+  parseCsvField(entries_in_file_line[list_idx++], seconds);
 
-  std::istringstream stream_nseconds(entries_in_file_line[list_idx++]);
-  stream_nseconds >> nano_seconds;
+  parseCsvField(entries_in_file_line[list_idx++], nano_seconds);
 
-  bool lost = std::stoi(entries_in_file_line[list_idx++]) != 0;
+  bool lost = parseCsvField<int>(entries_in_file_line[list_idx++]) != 0;
   if (!lost) {
     std::vector<double> data;
     for (size_t i = 0; i < 7; i++) {
-      data.emplace_back(std::stod(entries_in_file_line[list_idx++]));
+      data.emplace_back(
+          parseCsvField<double>(entries_in_file_line[list_idx++]));
     }
 
     vslam_types_refactor::Pose3D<double> pose_3d(
@@ -81,8 +78,7 @@ void readPose3dsAndTimestampsFromFile(
     const std::string &file_name,
     std::vector<std::pair<pose::Timestamp, pose::Pose3d>>
         &pose_3ds_with_timestamp) {
-  std::function<void(const std::vector<std::string> &,
-                     std::pair<pose::Timestamp, pose::Pose3d> &)>
+  CsvLineReader<std::pair<pose::Timestamp, pose::Pose3d>>
       object_from_line_reader = readPose3dWithTimestampLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, pose_3ds_with_timestamp);
@@ -191,10 +187,9 @@ void readOptionalPose3dsWithTimestampFromFile(
     std::vector<std::pair<pose::Timestamp,
                           std::optional<vslam_types_refactor::Pose3D<double>>>>
         &optional_pose_3ds_with_timestamp) {
-  std::function<void(
-      const std::vector<std::string> &,
+  CsvLineReader<
       std::pair<pose::Timestamp,
-                std::optional<vslam_types_refactor::Pose3D<double>>> &)>
+                std::optional<vslam_types_refactor::Pose3D<double>>>>
       object_from_line_reader = readOptionalPose3dWithTimestampLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, optional_pose_3ds_with_timestamp);
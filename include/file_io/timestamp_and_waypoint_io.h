@@ -23,27 +23,26 @@ struct TimestampAndWaypointInfo {
 };
 
 void readTimestampAndWaypointInfoLine(
-    const std::vector<std::string> &entries_in_file_line,
+    const std::vector<std::string_view> &entries_in_file_line,
     TimestampAndWaypointInfo &timestamp_and_waypoint_info) {
   size_t list_idx = 0;
 
-  std::istringstream stream_seconds(entries_in_file_line[list_idx++]);
-  stream_seconds >> timestamp_and_waypoint_info.seconds_;
+  parseCsvField(entries_in_file_line[list_idx++],
+                timestamp_and_waypoint_info.seconds_);
 
-  std::istringstream stream_nanoseconds(entries_in_file_line[list_idx++]);
-  stream_nanoseconds >> timestamp_and_waypoint_info.nano_seconds_;
+  parseCsvField(entries_in_file_line[list_idx++],
+                timestamp_and_waypoint_info.nano_seconds_);
 
   timestamp_and_waypoint_info.waypoint_id_ =
-      std::stoi(entries_in_file_line[list_idx++]);
-  int reversed_int = std::stoi(entries_in_file_line[list_idx++]);
+      parseCsvField<int>(entries_in_file_line[list_idx++]);
+  int reversed_int = parseCsvField<int>(entries_in_file_line[list_idx++]);
   timestamp_and_waypoint_info.reversed_ = reversed_int != 0;
 }
 
 void readTimestampAndWaypointInfosFromFile(
     const std::string &file_name,
     std::vector<TimestampAndWaypointInfo> &nodes_and_timestamps) {
-  std::function<void(const std::vector<std::string> &,
-                     TimestampAndWaypointInfo &)>
+  CsvLineReader<TimestampAndWaypointInfo>
       object_from_line_reader = readTimestampAndWaypointInfoLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, nodes_and_timestamps);
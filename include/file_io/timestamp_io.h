@@ -16,25 +16,23 @@
 
 namespace file_io {
 
-void readTimestampLine(const std::vector<std::string> &entries_in_file_line,
-                       pose::Timestamp &timestamp) {
+void readTimestampLine(
+    const std::vector<std::string_view> &entries_in_file_line,
+    pose::Timestamp &timestamp) {
   size_t list_idx = 0;
 
   uint32_t seconds;
-  std::istringstream stream_seconds(entries_in_file_line[list_idx++]);
-  stream_seconds >> seconds;
+  parseCsvField(entries_in_file_line[list_idx++], seconds);
 
   uint32_t nano_seconds;
-  std::istringstream stream_nanoseconds(entries_in_file_line[list_idx++]);
-  stream_nanoseconds >> nano_seconds;
+  parseCsvField(entries_in_file_line[list_idx++], nano_seconds);
 
   timestamp = std::make_pair(seconds, nano_seconds);
 }
 
 void readTimestampsFromFile(const std::string &file_name,
                             std::vector<pose::Timestamp> &timestamps) {
-  std::function<void(const std::vector<std::string> &, pose::Timestamp &)>
-      object_from_line_reader = readTimestampLine;
+  CsvLineReader<pose::Timestamp> object_from_line_reader = readTimestampLine;
   file_io::readObjectListFromFileWithHeader(
       file_name, object_from_line_reader, timestamps);
 }
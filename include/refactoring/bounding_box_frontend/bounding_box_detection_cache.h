@@ -0,0 +1,185 @@
+//
+// Created by amanda on 3/6/23.
+//
+
+#ifndef UT_VSLAM_BOUNDING_BOX_DETECTION_CACHE_H
+#define UT_VSLAM_BOUNDING_BOX_DETECTION_CACHE_H
+
+#include <file_io/binary_stream_io.h>
+#include <file_io/file_access_utils.h>
+#include <glog/logging.h>
+#include <refactoring/types/vslam_obj_opt_types_refactor.h>
+#include <sensor_msgs/Image.h>
+
+#include <boost/filesystem.hpp>
+#include <cctype>
+#include <iomanip>
+#include <sstream>
+
+namespace vslam_types_refactor {
+
+const std::string kBoundingBoxDetectionCacheContentType = "bb_detections";
+const uint32_t kBoundingBoxDetectionCacheContentVersion = 1;
+
+/**
+ * Compute a hash of the contents (pixels, dimensions, and encoding) of an
+ * image. Uses 64-bit FNV-1a, which is cheap compared to running a detector
+ * and stable across runs and machines (unlike std::hash).
+ *
+ * @param image Image to hash.
+ *
+ * @return Hash of the image contents.
+ */
+inline uint64_t hashImageContents(const sensor_msgs::Image &image) {
+  const uint64_t kFnvPrime = 1099511628211ULL;
+  uint64_t hash = 14695981039346656037ULL;
+  auto add_bytes = [&](const uint8_t *bytes, const size_t &num_bytes) {
+    for (size_t byte_num = 0; byte_num < num_bytes; byte_num++) {
+      hash = (hash ^ bytes[byte_num]) * kFnvPrime;
+    }
+  };
+  uint32_t dims[] = {image.height, image.width, image.step};
+  add_bytes(reinterpret_cast<const uint8_t *>(dims), sizeof(dims));
+  add_bytes(reinterpret_cast<const uint8_t *>(image.encoding.data()),
+            image.encoding.size());
+  add_bytes(image.data.data(), image.data.size());
+  return hash;
+}
+
+/**
+ * On-disk cache of the bounding boxes detected in images.
+ *
+ * Entries are addressed by the hash of the image contents and the name and
+ * model of the detector, so reruns of a sequence (or different sequences
+ * sharing images) can reuse detections without querying the detector. Each
+ * entry is a separate file that is written atomically, so an interrupted run
+ * never leaves a partial entry behind.
+ */
+class BoundingBoxDetectionCache {
+ public:
+  /**
+   * Create the cache.
+   *
+   * @param cache_directory Directory containing the cache entries. Created if
+   *                        it doesn't exist.
+   * @param detector_name   Name identifying the detector (ex. the service
+   *                        it is queried through).
+   * @param detector_model  Identifies the model (and configuration) that the
+   *                        detector runs. Detections from different detectors
+   *                        or models are cached separately.
+   */
+  BoundingBoxDetectionCache(const std::string &cache_directory,
+                            const std::string &detector_name,
+                            const std::string &detector_model)
+      : detector_directory_(
+            file_io::ensureDirectoryPathEndsWithSlash(cache_directory) +
+            sanitizeDetectorName(detector_name) + "/" +
+            sanitizeDetectorName(detector_model) + "/") {
+    boost::system::error_code error_code;
+    boost::filesystem::create_directories(detector_directory_, error_code);
+    if (error_code) {
+      LOG(WARNING) << "Could not create bounding box cache directory "
+                   << detector_directory_ << ": " << error_code.message();
+    }
+  }
+
+  /**
+   * Get the detections for an image from the cache.
+   *
+   * @param image                 Image to get detections for.
+   * @param bounding_boxes[out]   Cached detections for the image.
+   *
+   * @return True if the image had a cache entry, false otherwise.
+   */
+  bool getCachedDetections(const sensor_msgs::Image &image,
+                           std::vector<RawBoundingBox> &bounding_boxes) const {
+    std::string entry_file = getEntryFile(image);
+    if (!boost::filesystem::exists(entry_file)) {
+      return false;
+    }
+    file_io::BinaryStreamReader reader(
+        entry_file,
+        kBoundingBoxDetectionCacheContentType,
+        kBoundingBoxDetectionCacheContentVersion);
+    uint32_t height;
+    uint32_t width;
+    uint64_t num_bbs;
+    if (!reader.readScalar(height) || !reader.readScalar(width) ||
+        !reader.readScalar(num_bbs)) {
+      return false;
+    }
+    if ((height != image.height) || (width != image.width)) {
+      // Hash collision; treat as a miss so the entry gets replaced
+      return false;
+    }
+    std::vector<RawBoundingBox> read_bbs;
+    for (uint64_t bb_num = 0; bb_num < num_bbs; bb_num++) {
+      RawBoundingBox bb;
+      std::vector<double> corners;
+      if (!reader.readArray(corners) || (corners.size() != 4) ||
+          !reader.readString(bb.semantic_class_) ||
+          !reader.readScalar(bb.detection_confidence_)) {
+        return false;
+      }
+      bb.pixel_corner_locations_ =
+          std::make_pair(PixelCoord<double>(corners[0], corners[1]),
+                         PixelCoord<double>(corners[2], corners[3]));
+      read_bbs.emplace_back(bb);
+    }
+    bounding_boxes = read_bbs;
+    return true;
+  }
+
+  /**
+   * Add the detections for an image to the cache.
+   *
+   * @param image           Image the detections are for.
+   * @param bounding_boxes  Detections for the image.
+   */
+  void cacheDetections(const sensor_msgs::Image &image,
+                       const std::vector<RawBoundingBox> &bounding_boxes) {
+    file_io::BinaryStreamWriter writer(
+        getEntryFile(image),
+        kBoundingBoxDetectionCacheContentType,
+        kBoundingBoxDetectionCacheContentVersion);
+    writer.writeScalar(image.height);
+    writer.writeScalar(image.width);
+    writer.writeScalar((uint64_t)bounding_boxes.size());
+    for (const RawBoundingBox &bb : bounding_boxes) {
+      const BbCornerPair<double> &corners = bb.pixel_corner_locations_;
+      writer.writeArray(std::vector<double>({corners.first.x(),
+                                             corners.first.y(),
+                                             corners.second.x(),
+                                             corners.second.y()}));
+      writer.writeString(bb.semantic_class_);
+      writer.writeScalar(bb.detection_confidence_);
+    }
+    if (!writer.close()) {
+      LOG(WARNING) << "Failed to cache bounding boxes for image";
+    }
+  }
+
+ private:
+  std::string detector_directory_;
+
+  static std::string sanitizeDetectorName(const std::string &detector_name) {
+    std::string sanitized;
+    for (const char &name_char : detector_name) {
+      sanitized += (std::isalnum(name_char) || (name_char == '-') ||
+                    (name_char == '_'))
+                       ? name_char
+                       : '_';
+    }
+    return sanitized;
+  }
+
+  std::string getEntryFile(const sensor_msgs::Image &image) const {
+    std::stringstream entry_name;
+    entry_name << std::hex << std::setw(16) << std::setfill('0')
+               << hashImageContents(image);
+    return detector_directory_ + entry_name.str() + file_io::kBinaryExtension;
+  }
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_BOUNDING_BOX_DETECTION_CACHE_H
@@ -34,6 +34,18 @@ struct UninitializedEllispoidInfo {
   FrameId max_frame_id_;
 };
 
+/**
+ * Association state of a bounding box front end (everything that changes as
+ * bounding boxes are added). Used to checkpoint and restore the front end.
+ */
+template <typename ObjectAppearanceInfo, typename PendingObjectInfo>
+struct BoundingBoxFrontEndState {
+  std::vector<
+      UninitializedEllispoidInfo<ObjectAppearanceInfo, PendingObjectInfo>>
+      uninitialized_object_info_;
+  std::unordered_map<ObjectId, ObjectAppearanceInfo> object_appearance_info_;
+};
+
 struct AssociatedObjectIdentifier {
   bool initialized_ellipsoid_;
 
@@ -43,13 +55,13 @@ struct AssociatedObjectIdentifier {
   ObjectId object_id_;
 };
 
-bool operator==(const AssociatedObjectIdentifier &assoc_1,
-                const AssociatedObjectIdentifier &assoc_2) {
+inline bool operator==(const AssociatedObjectIdentifier &assoc_1,
+                       const AssociatedObjectIdentifier &assoc_2) {
   return std::make_pair(assoc_1.initialized_ellipsoid_, assoc_1.object_id_) ==
          std::make_pair(assoc_2.initialized_ellipsoid_, assoc_2.object_id_);
 }
 
-std::size_t hash_value(const AssociatedObjectIdentifier &assoc) {
+inline std::size_t hash_value(const AssociatedObjectIdentifier &assoc) {
   boost::hash<std::pair<bool, ObjectId>> hasher;
   return hasher(std::make_pair(assoc.initialized_ellipsoid_, assoc.object_id_));
 }
@@ -355,6 +367,27 @@ class AbstractBoundingBoxFrontEnd {
     return true;
   }
 
+  void getState(
+      BoundingBoxFrontEndState<ObjectAssociationInfo, PendingObjectInfo> &state)
+      const {
+    state.uninitialized_object_info_ = uninitialized_object_info_;
+    state.object_appearance_info_ = object_appearance_info_;
+  }
+
+  /**
+   * Replace the association state with a previously retrieved state. The
+   * front end should already be initialized and the pose graph should have
+   * been restored to the state it had when the front end state was retrieved.
+   *
+   * @param state State to restore.
+   */
+  void setState(
+      const BoundingBoxFrontEndState<ObjectAssociationInfo, PendingObjectInfo>
+          &state) {
+    uninitialized_object_info_ = state.uninitialized_object_info_;
+    object_appearance_info_ = state.object_appearance_info_;
+  }
+
   /**
    * Merge objects.
    *
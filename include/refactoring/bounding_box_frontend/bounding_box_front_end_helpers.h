@@ -5,11 +5,12 @@
 #ifndef UT_VSLAM_BOUNDING_BOX_FRONT_END_HELPERS_H
 #define UT_VSLAM_BOUNDING_BOX_FRONT_END_HELPERS_H
 
+#include <refactoring/bounding_box_frontend/optimal_assignment.h>
 #include <refactoring/types/vslam_obj_opt_types_refactor.h>
 #include <refactoring/types/vslam_types_math_util.h>
 
 namespace vslam_types_refactor {
-std::vector<RawBoundingBox> filterBoundingBoxesWithMinConfidence(
+inline std::vector<RawBoundingBox> filterBoundingBoxesWithMinConfidence(
     const FrameId &frame_id,
     const CameraId &camera_id,
     const std::vector<RawBoundingBox> &original_bounding_boxes,
@@ -122,7 +123,7 @@ void identifyMergeCandidates(
   }
 }
 
-std::vector<AssociatedObjectIdentifier> greedilyAssignBoundingBoxes(
+inline std::vector<AssociatedObjectIdentifier> greedilyAssignBoundingBoxes(
     const std::vector<
         std::vector<std::pair<AssociatedObjectIdentifier, double>>>
         &match_candidates_with_scores,
@@ -183,6 +184,72 @@ std::vector<AssociatedObjectIdentifier> greedilyAssignBoundingBoxes(
   return final_assignments;
 }
 
+/**
+ * Assign bounding boxes to objects so that as many bounding boxes as possible
+ * are matched to a candidate and, given that, the total score is maximized
+ * (unlike greedilyAssignBoundingBoxes, a high-scoring match can't take an
+ * object that another bounding box needs). Bounding boxes without a match are
+ * assigned to new uninitialized objects.
+ *
+ * @param match_candidates_with_scores  Candidates and their scores for each
+ *                                      bounding box.
+ * @param next_free_obj                 Index to use for the first new
+ *                                      uninitialized object.
+ * @param min_score                     Candidates with scores below this are
+ *                                      not considered.
+ *
+ * @return Assignment for each bounding box.
+ */
+inline std::vector<AssociatedObjectIdentifier> optimallyAssignBoundingBoxes(
+    const std::vector<
+        std::vector<std::pair<AssociatedObjectIdentifier, double>>>
+        &match_candidates_with_scores,
+    const ObjectId &next_free_obj,
+    const double &min_score = -std::numeric_limits<double>::infinity()) {
+  // Convert the candidates to flat column indices
+  SparseAssignmentProblem assignment_problem;
+  assignment_problem.num_rows_ = match_candidates_with_scores.size();
+  std::vector<AssociatedObjectIdentifier> candidates_by_col;
+  util::BoostHashMap<AssociatedObjectIdentifier, size_t> col_for_candidate;
+  for (size_t bb_idx = 0; bb_idx < match_candidates_with_scores.size();
+       bb_idx++) {
+    for (const std::pair<AssociatedObjectIdentifier, double> &candidate_for_bb :
+         match_candidates_with_scores[bb_idx]) {
+      auto col_it = col_for_candidate.find(candidate_for_bb.first);
+      size_t col;
+      if (col_it == col_for_candidate.end()) {
+        col = candidates_by_col.size();
+        col_for_candidate[candidate_for_bb.first] = col;
+        candidates_by_col.emplace_back(candidate_for_bb.first);
+      } else {
+        col = col_it->second;
+      }
+      assignment_problem.entry_rows_.emplace_back(bb_idx);
+      assignment_problem.entry_cols_.emplace_back(col);
+      assignment_problem.entry_scores_.emplace_back(candidate_for_bb.second);
+    }
+  }
+  assignment_problem.num_cols_ = candidates_by_col.size();
+
+  std::vector<std::optional<size_t>> assigned_cols =
+      solveSparseAssignment(assignment_problem, min_score);
+
+  ObjectId next_free_assignment = next_free_obj;
+  std::vector<AssociatedObjectIdentifier> final_assignments;
+  for (const std::optional<size_t> &assigned_col : assigned_cols) {
+    if (assigned_col.has_value()) {
+      final_assignments.emplace_back(candidates_by_col[assigned_col.value()]);
+    } else {
+      AssociatedObjectIdentifier new_ellipsoid_assoc;
+      new_ellipsoid_assoc.initialized_ellipsoid_ = false;
+      new_ellipsoid_assoc.object_id_ = next_free_assignment;
+      final_assignments.emplace_back(new_ellipsoid_assoc);
+      next_free_assignment++;
+    }
+  }
+  return final_assignments;
+}
+
 template <typename AssociationInfo, typename PendingObjInfo>
 void removeStalePendingObjects(
     const std::vector<
@@ -201,9 +268,9 @@ void removeStalePendingObjects(
   }
 }
 
-double getObjectDepthGivenHeight(const BbCornerPair<double> &bb,
-                                 const double &height,
-                                 const double &fy) {
+inline double getObjectDepthGivenHeight(const BbCornerPair<double> &bb,
+                                        const double &height,
+                                        const double &fy) {
   double y_diff = bb.second.y() - bb.first.y();
   // TODO this isn't a valid way to do it, because this assumes the points
   // corresponding to the top and bottom of the bounding box correspond to the
@@ -10,6 +10,8 @@
 #include <refactoring/types/vslam_basic_types_refactor.h>
 #include <ros/ros.h>
 
+#include <atomic>
+
 namespace vslam_types_refactor {
 
 template <typename InputProblemData>
@@ -32,15 +34,41 @@ bool retrievePrecomputedBoundingBoxes(
 
 class YoloBoundingBoxQuerier {
  public:
+  /**
+   * Create the querier.
+   *
+   * @param node_handle                       Node handle.
+   * @param query_service_name                Name of the detection service.
+   * @param require_service_on_construction   True if the service must be
+   *                                          available when this is created
+   *                                          (exits otherwise). If false, the
+   *                                          client is created on the first
+   *                                          query (i.e. so that runs served
+   *                                          entirely by a detection cache
+   *                                          don't need the service).
+   */
   YoloBoundingBoxQuerier(
       ros::NodeHandle &node_handle,
-      const std::string &query_service_name = "/yolov5_detect_objs")
+      const std::string &query_service_name = "/yolov5_detect_objs",
+      const bool &require_service_on_construction = true)
       : node_handle_(node_handle), service_name_(query_service_name) {
-    if (!regenerateClient()) {
+    if (require_service_on_construction && !regenerateClient()) {
       exit(1);
     }
   }
 
+  std::string getServiceName() const { return service_name_; }
+
+  /**
+   * Check if a query failed because the detection service couldn't be
+   * reached. Queries may run on a background thread, so rather than exiting
+   * there, the failure is recorded for the thread consuming the detections to
+   * check.
+   *
+   * @return True if the service was unavailable for a query.
+   */
+  bool isServiceUnavailable() const { return service_unavailable_; }
+
   bool retrieveBoundingBoxesFromCamIdsAndImages(
       const FrameId &frame_to_query_for,
       const std::unordered_map<CameraId, sensor_msgs::Image::ConstPtr>
@@ -72,8 +100,9 @@ class YoloBoundingBoxQuerier {
     if (!bounding_box_client_.isValid()) {
       if (!regenerateClient()) {
         LOG(ERROR) << "Tried to regenerate bounding box query client, but "
-                      "failed. Exiting. ";
-        exit(1);
+                      "failed.";
+        service_unavailable_ = true;
+        return false;
       }
     }
     if (bounding_box_client_.call(obj_det_srv_call)) {
@@ -123,6 +152,7 @@ class YoloBoundingBoxQuerier {
   ros::NodeHandle node_handle_;
   std::string service_name_;
   ros::ServiceClient bounding_box_client_;
+  std::atomic<bool> service_unavailable_ = false;
 
   bool regenerateClient() {
     if (!ros::service::waitForService(
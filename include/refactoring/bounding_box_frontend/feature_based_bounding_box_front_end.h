@@ -84,6 +84,36 @@ struct FeatureBasedBbAssociationParams {
   }
 };
 
+/**
+ * State of the feature based bounding box front end, including the bounding
+ * box data that is shared with the visualization/output.
+ */
+struct FeatureBasedBoundingBoxFrontEndState {
+  BoundingBoxFrontEndState<FeatureBasedFrontEndObjAssociationInfo,
+                           FeatureBasedFrontEndPendingObjInfo>
+      association_state_;
+
+  std::unordered_map<
+      FrameId,
+      std::unordered_map<
+          CameraId,
+          std::vector<std::pair<BbCornerPair<double>, std::optional<double>>>>>
+      all_filtered_corner_locations_;
+  std::unordered_map<
+      FrameId,
+      std::unordered_map<CameraId,
+                         std::unordered_map<ObjectId,
+                                            std::pair<BbCornerPair<double>,
+                                                      std::optional<double>>>>>
+      observed_corner_locations_;
+  std::vector<std::unordered_map<
+      FrameId,
+      std::unordered_map<CameraId, std::pair<BbCornerPair<double>, double>>>>
+      bounding_boxes_for_pending_object_;
+  std::vector<std::pair<std::string, std::optional<EllipsoidState<double>>>>
+      pending_objects_;
+};
+
 template <typename VisualFeatureFactorType>
 class FeatureBasedBoundingBoxFrontEnd
     : public AbstractUnknownDataAssociationBbFrontEnd<
@@ -149,6 +179,47 @@ class FeatureBasedBoundingBoxFrontEnd
         bounding_boxes_for_pending_object_(bounding_boxes_for_pending_object),
         pending_objects_(pending_objects) {}
 
+  void getState(FeatureBasedBoundingBoxFrontEndState &state) const {
+    AbstractUnknownDataAssociationBbFrontEnd<
+        VisualFeatureFactorType,
+        FeatureBasedFrontEndObjAssociationInfo,
+        FeatureBasedFrontEndPendingObjInfo,
+        FeatureBasedContextInfo,
+        FeatureBasedContextInfo,
+        FeatureBasedSingleBbContextInfo,
+        util::EmptyStruct,
+        FeatureBasedBbCandidateMatchInfo>::getState(state.association_state_);
+    state.all_filtered_corner_locations_ = *all_filtered_corner_locations_;
+    state.observed_corner_locations_ = *observed_corner_locations_;
+    state.bounding_boxes_for_pending_object_ =
+        *bounding_boxes_for_pending_object_;
+    state.pending_objects_ = *pending_objects_;
+  }
+
+  /**
+   * Restore a previously retrieved state. The shared bounding box data is
+   * overwritten in place, so other holders of those pointers see the restored
+   * data.
+   *
+   * @param state State to restore.
+   */
+  void setState(const FeatureBasedBoundingBoxFrontEndState &state) {
+    AbstractUnknownDataAssociationBbFrontEnd<
+        VisualFeatureFactorType,
+        FeatureBasedFrontEndObjAssociationInfo,
+        FeatureBasedFrontEndPendingObjInfo,
+        FeatureBasedContextInfo,
+        FeatureBasedContextInfo,
+        FeatureBasedSingleBbContextInfo,
+        util::EmptyStruct,
+        FeatureBasedBbCandidateMatchInfo>::setState(state.association_state_);
+    *all_filtered_corner_locations_ = state.all_filtered_corner_locations_;
+    *observed_corner_locations_ = state.observed_corner_locations_;
+    *bounding_boxes_for_pending_object_ =
+        state.bounding_boxes_for_pending_object_;
+    *pending_objects_ = state.pending_objects_;
+  }
+
  protected:
   virtual FeatureBasedFrontEndObjAssociationInfo objAssocInfoFromMapData(
       const ObjectId &obj_id,
@@ -482,9 +553,7 @@ class FeatureBasedBoundingBoxFrontEnd
       const std::vector<
           std::vector<std::pair<AssociatedObjectIdentifier, double>>>
           &match_candidates_with_scores) override {
-    // TODO for now we're just doing this more or less greedily. Should change
-    //  to find best overall matching
-    return greedilyAssignBoundingBoxes(
+    return optimallyAssignBoundingBoxes(
         match_candidates_with_scores,
         FeatureBasedBoundingBoxFrontEnd::uninitialized_object_info_.size());
   }
@@ -1008,11 +1077,46 @@ class FeatureBasedBoundingBoxFrontEndCreator {
           pending_objects_);
       feature_based_front_end_->initializeWithLongTermMapFrontEndData(
           front_end_data_);
+      if (state_to_restore_.has_value()) {
+        feature_based_front_end_->setState(state_to_restore_.value());
+        state_to_restore_ = std::nullopt;
+      }
       initialized_ = true;
     }
     return feature_based_front_end_;
   }
 
+  /**
+   * Set the state that the front end should have when it is created (i.e.
+   * when resuming from a checkpoint). Has no effect if the front end was
+   * already created.
+   *
+   * @param state State to restore on creation.
+   */
+  void setStateToRestore(const FeatureBasedBoundingBoxFrontEndState &state) {
+    if (initialized_) {
+      LOG(WARNING) << "Front end already created; not restoring state";
+      return;
+    }
+    state_to_restore_ = state;
+  }
+
+  /**
+   * Get the state of the front end.
+   *
+   * @param state[out] State of the front end.
+   *
+   * @return True if the front end has been created and the state was
+   * retrieved, false otherwise.
+   */
+  bool getFrontEndState(FeatureBasedBoundingBoxFrontEndState &state) const {
+    if (!initialized_) {
+      return false;
+    }
+    feature_based_front_end_->getState(state);
+    return true;
+  }
+
  private:
   FeatureBasedBbAssociationParams association_params_;
 
@@ -1060,16 +1164,10 @@ class FeatureBasedBoundingBoxFrontEndCreator {
 
   std::unordered_map<ObjectId, util::EmptyStruct> front_end_data_;
 
+  std::optional<FeatureBasedBoundingBoxFrontEndState> state_to_restore_;
+
   bool initialized_;
-  std::shared_ptr<AbstractUnknownDataAssociationBbFrontEnd<
-      VisualFeatureFactorType,
-      FeatureBasedFrontEndObjAssociationInfo,
-      FeatureBasedFrontEndPendingObjInfo,
-      FeatureBasedContextInfo,
-      FeatureBasedContextInfo,
-      FeatureBasedSingleBbContextInfo,
-      util::EmptyStruct,
-      FeatureBasedBbCandidateMatchInfo>>
+  std::shared_ptr<FeatureBasedBoundingBoxFrontEnd<VisualFeatureFactorType>>
       feature_based_front_end_;
 };
 
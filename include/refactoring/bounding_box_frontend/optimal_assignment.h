@@ -0,0 +1,257 @@
+//
+// Created by amanda on 3/7/23.
+//
+
+#ifndef UT_VSLAM_OPTIMAL_ASSIGNMENT_H
+#define UT_VSLAM_OPTIMAL_ASSIGNMENT_H
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+/**
+ * Assignment problem with sparse scores, stored as flat arrays. Entry i says
+ * that row entry_rows_[i] can be assigned to column entry_cols_[i] with score
+ * entry_scores_[i]. Row/column pairs without an entry can't be assigned to
+ * each other.
+ */
+struct SparseAssignmentProblem {
+  size_t num_rows_ = 0;
+  size_t num_cols_ = 0;
+  std::vector<size_t> entry_rows_;
+  std::vector<size_t> entry_cols_;
+  std::vector<double> entry_scores_;
+};
+
+namespace assignment_internal {
+
+/**
+ * Find the minimum cost assignment of every row to a distinct column for a
+ * dense cost matrix with at least as many columns as rows, using shortest
+ * augmenting paths with potentials (Jonker-Volgenant/Hungarian, O(n^2 m)).
+ *
+ * Infinite costs mark forbidden pairs. There must be a feasible assignment.
+ *
+ * @param costs     Row-major cost matrix.
+ * @param num_rows  Number of rows.
+ * @param num_cols  Number of columns (>= num_rows).
+ *
+ * @return Column assigned to each row.
+ */
+inline std::vector<size_t> solveDenseMinCostAssignment(
+    const std::vector<double> &costs,
+    const size_t &num_rows,
+    const size_t &num_cols) {
+  const double kInf = std::numeric_limits<double>::infinity();
+  // Indices are 1-based here; row/column 0 is a sentinel for the augmenting
+  // path search
+  std::vector<double> row_potentials(num_rows + 1, 0);
+  std::vector<double> col_potentials(num_cols + 1, 0);
+  std::vector<size_t> row_for_col(num_cols + 1, 0);
+  std::vector<size_t> prev_col_in_path(num_cols + 1, 0);
+  std::vector<double> min_reduced_cost(num_cols + 1);
+  std::vector<bool> col_used(num_cols + 1);
+
+  for (size_t row = 1; row <= num_rows; row++) {
+    row_for_col[0] = row;
+    size_t curr_col = 0;
+    std::fill(min_reduced_cost.begin(), min_reduced_cost.end(), kInf);
+    std::fill(col_used.begin(), col_used.end(), false);
+    do {
+      col_used[curr_col] = true;
+      size_t curr_row = row_for_col[curr_col];
+      double delta = kInf;
+      size_t next_col = 0;
+      for (size_t col = 1; col <= num_cols; col++) {
+        if (col_used[col]) {
+          continue;
+        }
+        double cost = costs[(curr_row - 1) * num_cols + (col - 1)];
+        if (cost != kInf) {
+          double reduced_cost =
+              cost - row_potentials[curr_row] - col_potentials[col];
+          if (reduced_cost < min_reduced_cost[col]) {
+            min_reduced_cost[col] = reduced_cost;
+            prev_col_in_path[col] = curr_col;
+          }
+        }
+        if (min_reduced_cost[col] < delta) {
+          delta = min_reduced_cost[col];
+          next_col = col;
+        }
+      }
+      CHECK_NE(next_col, 0) << "Assignment problem has no feasible solution";
+      for (size_t col = 0; col <= num_cols; col++) {
+        if (col_used[col]) {
+          row_potentials[row_for_col[col]] += delta;
+          col_potentials[col] -= delta;
+        } else {
+          min_reduced_cost[col] -= delta;
+        }
+      }
+      curr_col = next_col;
+    } while (row_for_col[curr_col] != 0);
+
+    // Flip the assignments along the augmenting path
+    do {
+      size_t prev_col = prev_col_in_path[curr_col];
+      row_for_col[curr_col] = row_for_col[prev_col];
+      curr_col = prev_col;
+    } while (curr_col != 0);
+  }
+
+  std::vector<size_t> col_for_row(num_rows);
+  for (size_t col = 1; col <= num_cols; col++) {
+    if (row_for_col[col] != 0) {
+      col_for_row[row_for_col[col] - 1] = col - 1;
+    }
+  }
+  return col_for_row;
+}
+
+inline size_t findRoot(std::vector<size_t> &parents, size_t node) {
+  while (parents[node] != node) {
+    parents[node] = parents[parents[node]];
+    node = parents[node];
+  }
+  return node;
+}
+}  // namespace assignment_internal
+
+/**
+ * Assign rows to distinct columns to maximize the number of assigned rows and,
+ * among assignments with the most rows assigned, the total score. Rows can be
+ * left unassigned (i.e. if all of their columns are taken by other rows).
+ *
+ * The problem is split into independent connected components (rows and
+ * columns linked by entries), which are solved separately, so the cost
+ * depends on the size of the largest group of competing rows rather than on
+ * the total number of rows and columns.
+ *
+ * @param problem   Assignment problem.
+ * @param min_score Entries with scores below this are not considered (gating
+ *                  threshold).
+ *
+ * @return Column assigned to each row, or nullopt if the row is unassigned.
+ */
+inline std::vector<std::optional<size_t>> solveSparseAssignment(
+    const SparseAssignmentProblem &problem,
+    const double &min_score = -std::numeric_limits<double>::infinity()) {
+  std::vector<std::optional<size_t>> assignments(problem.num_rows_);
+
+  std::vector<size_t> valid_entries;
+  for (size_t entry = 0; entry < problem.entry_scores_.size(); entry++) {
+    if ((problem.entry_scores_[entry] >= min_score) &&
+        std::isfinite(problem.entry_scores_[entry])) {
+      valid_entries.emplace_back(entry);
+    }
+  }
+  if (valid_entries.empty()) {
+    return assignments;
+  }
+
+  // Group rows and columns into connected components. Nodes are rows followed
+  // by columns
+  std::vector<size_t> parents(problem.num_rows_ + problem.num_cols_);
+  std::iota(parents.begin(), parents.end(), 0);
+  for (const size_t &entry : valid_entries) {
+    size_t row_root =
+        assignment_internal::findRoot(parents, problem.entry_rows_[entry]);
+    size_t col_root = assignment_internal::findRoot(
+        parents, problem.num_rows_ + problem.entry_cols_[entry]);
+    parents[row_root] = col_root;
+  }
+  std::vector<std::vector<size_t>> entries_by_component(parents.size());
+  for (const size_t &entry : valid_entries) {
+    entries_by_component[assignment_internal::findRoot(
+                             parents, problem.entry_rows_[entry])]
+        .emplace_back(entry);
+  }
+
+  const size_t kUnset = std::numeric_limits<size_t>::max();
+  std::vector<size_t> local_row_idx(problem.num_rows_, kUnset);
+  std::vector<size_t> local_col_idx(problem.num_cols_, kUnset);
+  for (const std::vector<size_t> &component_entries : entries_by_component) {
+    if (component_entries.empty()) {
+      continue;
+    }
+    std::vector<size_t> component_rows;
+    std::vector<size_t> component_cols;
+    double max_score = -std::numeric_limits<double>::infinity();
+    double min_component_score = std::numeric_limits<double>::infinity();
+    for (const size_t &entry : component_entries) {
+      size_t row = problem.entry_rows_[entry];
+      size_t col = problem.entry_cols_[entry];
+      if (local_row_idx[row] == kUnset) {
+        local_row_idx[row] = component_rows.size();
+        component_rows.emplace_back(row);
+      }
+      if (local_col_idx[col] == kUnset) {
+        local_col_idx[col] = component_cols.size();
+        component_cols.emplace_back(col);
+      }
+      max_score = std::max(max_score, problem.entry_scores_[entry]);
+      min_component_score =
+          std::min(min_component_score, problem.entry_scores_[entry]);
+    }
+
+    if (component_rows.size() == 1) {
+      // Only one row, so it gets its best column
+      size_t best_entry = *std::max_element(
+          component_entries.begin(),
+          component_entries.end(),
+          [&](const size_t &lhs, const size_t &rhs) {
+            return problem.entry_scores_[lhs] < problem.entry_scores_[rhs];
+          });
+      assignments[problem.entry_rows_[best_entry]] =
+          problem.entry_cols_[best_entry];
+    } else {
+      // Costs are (max_score - score) for entries. Each row also has its own
+      // "unassigned" column with a cost larger than any sum of entry costs,
+      // so assigning more rows is always preferred
+      size_t num_local_rows = component_rows.size();
+      size_t num_local_cols = component_cols.size() + num_local_rows;
+      double unassigned_cost =
+          (max_score - min_component_score + 1) * num_local_rows;
+      std::vector<double> costs(num_local_rows * num_local_cols,
+                                std::numeric_limits<double>::infinity());
+      for (const size_t &entry : component_entries) {
+        double &cost =
+            costs[local_row_idx[problem.entry_rows_[entry]] * num_local_cols +
+                  local_col_idx[problem.entry_cols_[entry]]];
+        cost = std::min(cost, max_score - problem.entry_scores_[entry]);
+      }
+      for (size_t local_row = 0; local_row < num_local_rows; local_row++) {
+        costs[local_row * num_local_cols + component_cols.size() +
+              local_row] = unassigned_cost;
+      }
+      std::vector<size_t> local_assignments =
+          assignment_internal::solveDenseMinCostAssignment(
+              costs, num_local_rows, num_local_cols);
+      for (size_t local_row = 0; local_row < num_local_rows; local_row++) {
+        if (local_assignments[local_row] < component_cols.size()) {
+          assignments[component_rows[local_row]] =
+              component_cols[local_assignments[local_row]];
+        }
+      }
+    }
+
+    for (const size_t &row : component_rows) {
+      local_row_idx[row] = kUnset;
+    }
+    for (const size_t &col : component_cols) {
+      local_col_idx[col] = kUnset;
+    }
+  }
+  return assignments;
+}
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_OPTIMAL_ASSIGNMENT_H
@@ -0,0 +1,260 @@
+//
+// Created by amanda on 3/6/23.
+//
+
+#ifndef UT_VSLAM_PIPELINED_BOUNDING_BOX_QUERIER_H
+#define UT_VSLAM_PIPELINED_BOUNDING_BOX_QUERIER_H
+
+#include <base_lib/async_work_queue.h>
+#include <glog/logging.h>
+#include <refactoring/bounding_box_frontend/bounding_box_detection_cache.h>
+#include <refactoring/types/vslam_basic_types_refactor.h>
+#include <refactoring/types/vslam_obj_opt_types_refactor.h>
+#include <sensor_msgs/Image.h>
+
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace vslam_types_refactor {
+
+/**
+ * Runs the bounding box detector for frames ahead of when the frames are
+ * processed, so the detector and the rest of the pipeline (optimization, etc.)
+ * can run concurrently.
+ *
+ * Detection requests for a frame (all cameras) are handled as a single work
+ * item by a background thread. At most max_frames_in_flight frames are
+ * detected ahead of the frame being retrieved. Detections are looked up in /
+ * added to the (optional) detection cache before the detector is queried.
+ *
+ * The detector is only called by one thread at a time, so it can wrap a
+ * single (non-thread-safe) service client.
+ */
+class PipelinedBoundingBoxQuerier {
+ public:
+  /**
+   * Function that detects the bounding boxes in a single image. Returns false
+   * if the detection failed.
+   */
+  using ImageDetector =
+      std::function<bool(const sensor_msgs::Image::ConstPtr &,
+                         std::vector<RawBoundingBox> &)>;
+
+  /**
+   * Create the querier.
+   *
+   * @param detector              Detector to run on images that aren't
+   *                              cached.
+   * @param max_frames_in_flight  Maximum number of frames for which detection
+   *                              can be pending at once. If 0, detection is
+   *                              only run when a frame is retrieved.
+   * @param detection_cache       Cache for detections. Not used if null.
+   */
+  PipelinedBoundingBoxQuerier(
+      const ImageDetector &detector,
+      const size_t &max_frames_in_flight,
+      const std::shared_ptr<BoundingBoxDetectionCache> &detection_cache =
+          nullptr)
+      : detector_(detector),
+        max_frames_in_flight_(max_frames_in_flight),
+        detection_cache_(detection_cache) {
+    if (max_frames_in_flight_ > 0) {
+      detection_queue_ =
+          std::make_unique<util::AsyncWorkQueue<DetectionRequest>>(
+              max_frames_in_flight_,
+              util::DROP_NEWEST,
+              [&](DetectionRequest &request) {
+                request.result_promise_->set_value(detectBoundingBoxesForFrame(
+                    request.frame_id_, request.cam_ids_and_images_));
+              });
+    }
+  }
+
+  /**
+   * Start detecting bounding boxes for a frame in the background.
+   *
+   * @param frame_to_query_for  Frame to detect bounding boxes for.
+   * @param cam_ids_and_images  Images for the frame by camera.
+   *
+   * @return True if detection was started (or already started) for the frame,
+   * false if the maximum number of frames are already in flight.
+   */
+  bool prefetchBoundingBoxes(
+      const FrameId &frame_to_query_for,
+      const std::unordered_map<CameraId, sensor_msgs::Image::ConstPtr>
+          &cam_ids_and_images) {
+    if (detection_queue_ == nullptr) {
+      return false;
+    }
+    if (pending_results_.find(frame_to_query_for) != pending_results_.end()) {
+      return true;
+    }
+    if (pending_results_.size() >= max_frames_in_flight_) {
+      return false;
+    }
+    DetectionRequest request;
+    request.frame_id_ = frame_to_query_for;
+    request.cam_ids_and_images_ = cam_ids_and_images;
+    request.result_promise_ = std::make_shared<std::promise<DetectionResult>>();
+    std::shared_future<DetectionResult> result_future =
+        request.result_promise_->get_future().share();
+    if (!detection_queue_->push(std::move(request))) {
+      return false;
+    }
+    pending_results_[frame_to_query_for] = result_future;
+    return true;
+  }
+
+  /**
+   * Get the bounding boxes for a frame, waiting for the detection if it was
+   * prefetched and running it now otherwise.
+   *
+   * @param frame_to_query_for            Frame to get bounding boxes for.
+   * @param cam_ids_and_images            Images for the frame by camera.
+   * @param bounding_boxes_for_frame[out] Bounding boxes by camera.
+   *
+   * @return True if the bounding boxes were retrieved for all cameras.
+   */
+  bool retrieveBoundingBoxesFromCamIdsAndImages(
+      const FrameId &frame_to_query_for,
+      const std::unordered_map<CameraId, sensor_msgs::Image::ConstPtr>
+          &cam_ids_and_images,
+      std::unordered_map<CameraId, std::vector<RawBoundingBox>>
+          &bounding_boxes_for_frame) {
+    DetectionResult result;
+    auto pending_result = pending_results_.find(frame_to_query_for);
+    if (pending_result != pending_results_.end()) {
+      result = pending_result->second.get();
+      pending_results_.erase(pending_result);
+    } else {
+      result =
+          detectBoundingBoxesForFrame(frame_to_query_for, cam_ids_and_images);
+    }
+
+    // Frames before this one won't be retrieved, so stop tracking them
+    pending_results_.erase(pending_results_.begin(),
+                           pending_results_.lower_bound(frame_to_query_for));
+
+    if (!result.has_value()) {
+      return false;
+    }
+    bounding_boxes_for_frame = result.value();
+    return true;
+  }
+
+  /**
+   * Get the bounding boxes for a frame and start detection for the frames
+   * after it.
+   *
+   * @tparam InputProblemData Type of the input problem data.
+   *
+   * @param frame_to_query_for            Frame to get bounding boxes for.
+   * @param input_problem_data            Input problem data containing the
+   *                                      images for each frame.
+   * @param bounding_boxes_for_frame[out] Bounding boxes by camera.
+   *
+   * @return True if the bounding boxes were retrieved for all cameras.
+   */
+  template <typename InputProblemData>
+  bool retrieveBoundingBoxes(
+      const FrameId &frame_to_query_for,
+      const InputProblemData &input_problem_data,
+      std::unordered_map<CameraId, std::vector<RawBoundingBox>>
+          &bounding_boxes_for_frame) {
+    bool retrieved = retrieveBoundingBoxesFromCamIdsAndImages(
+        frame_to_query_for,
+        input_problem_data.getImagesByCameraForFrame(frame_to_query_for),
+        bounding_boxes_for_frame);
+
+    FrameId max_frame_id = input_problem_data.getMaxFrameId();
+    for (FrameId next_frame = frame_to_query_for + 1;
+         (next_frame <= max_frame_id) &&
+         (next_frame <= frame_to_query_for + max_frames_in_flight_);
+         next_frame++) {
+      std::unordered_map<CameraId, sensor_msgs::Image::ConstPtr>
+          next_frame_images =
+              input_problem_data.getImagesByCameraForFrame(next_frame);
+      if (next_frame_images.empty()) {
+        continue;
+      }
+      if (!prefetchBoundingBoxes(next_frame, next_frame_images)) {
+        break;
+      }
+    }
+    return retrieved;
+  }
+
+ private:
+  using DetectionResult = std::optional<
+      std::unordered_map<CameraId, std::vector<RawBoundingBox>>>;
+
+  struct DetectionRequest {
+    FrameId frame_id_;
+    std::unordered_map<CameraId, sensor_msgs::Image::ConstPtr>
+        cam_ids_and_images_;
+    std::shared_ptr<std::promise<DetectionResult>> result_promise_;
+  };
+
+  ImageDetector detector_;
+  size_t max_frames_in_flight_;
+  std::shared_ptr<BoundingBoxDetectionCache> detection_cache_;
+
+  std::mutex detector_mutex_;
+
+  /**
+   * Results for frames that were prefetched but not yet retrieved. Only
+   * accessed by the thread retrieving bounding boxes.
+   */
+  std::map<FrameId, std::shared_future<DetectionResult>> pending_results_;
+
+  /**
+   * Declared last so that the background thread is stopped before the other
+   * members are destroyed.
+   */
+  std::unique_ptr<util::AsyncWorkQueue<DetectionRequest>> detection_queue_;
+
+  DetectionResult detectBoundingBoxesForFrame(
+      const FrameId &frame_to_query_for,
+      const std::unordered_map<CameraId, sensor_msgs::Image::ConstPtr>
+          &cam_ids_and_images) {
+    std::unordered_map<CameraId, std::vector<RawBoundingBox>>
+        bounding_boxes_for_frame;
+    for (const auto &cam_id_and_img : cam_ids_and_images) {
+      std::vector<RawBoundingBox> bounding_boxes_for_camera;
+      if (!detectBoundingBoxesForImage(cam_id_and_img.second,
+                                       bounding_boxes_for_camera)) {
+        LOG(WARNING) << "Couldn't get bounding boxes for frame id "
+                     << frame_to_query_for << " and camera "
+                     << cam_id_and_img.first;
+        return std::nullopt;
+      }
+      bounding_boxes_for_frame[cam_id_and_img.first] =
+          bounding_boxes_for_camera;
+    }
+    return bounding_boxes_for_frame;
+  }
+
+  bool detectBoundingBoxesForImage(
+      const sensor_msgs::Image::ConstPtr &image,
+      std::vector<RawBoundingBox> &bounding_boxes_for_image) {
+    if ((detection_cache_ != nullptr) &&
+        detection_cache_->getCachedDetections(*image,
+                                              bounding_boxes_for_image)) {
+      return true;
+    }
+    std::unique_lock<std::mutex> detector_lock(detector_mutex_);
+    if (!detector_(image, bounding_boxes_for_image)) {
+      return false;
+    }
+    if (detection_cache_ != nullptr) {
+      detection_cache_->cacheDetections(*image, bounding_boxes_for_image);
+    }
+    return true;
+  }
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_PIPELINED_BOUNDING_BOX_QUERIER_H
@@ -8,6 +8,7 @@
 #include <cv_bridge/cv_bridge.h>
 #include <refactoring/bounding_box_frontend/bounding_box_front_end.h>
 #include <refactoring/bounding_box_frontend/bounding_box_front_end_helpers.h>
+#include <refactoring/image_processing/decoded_image_cache.h>
 #include <refactoring/types/vslam_types_math_util.h>
 #include <sensor_msgs/Image.h>
 
@@ -375,9 +376,7 @@ class RoshanBbFrontEnd
       const std::vector<
           std::vector<std::pair<AssociatedObjectIdentifier, double>>>
           &match_candidates_with_scores) override {
-    // TODO for now we're just doing this more or less greedily. Should change
-    //  to find best overall matching
-    return greedilyAssignBoundingBoxes(
+    return optimallyAssignBoundingBoxes(
         match_candidates_with_scores,
         RoshanBbFrontEnd::uninitialized_object_info_.size());
   }
@@ -388,12 +387,10 @@ class RoshanBbFrontEnd
       const CameraId &camera_id) override {
     RoshanImageSummaryInfo summary_info;
     if (bb_context.has_value()) {
-      // TODO is this the right way to specify encoding?
-      cv_bridge::CvImageConstPtr cv_img =
-          cv_bridge::toCvShare(bb_context.value(), "bgr8");
-      summary_info.hsv_img_ = std::make_optional(cv::Mat());
-      // TODO is this the right code to switch to HSV?
-      cv::cvtColor(cv_img->image, *(summary_info.hsv_img_), cv::COLOR_BGR2HSV);
+      // Shares the data with the cache, so the image must not be modified
+      summary_info.hsv_img_ = DecodedImageCache::getInstance()
+                                  .getDecodedImage(bb_context.value())
+                                  ->getHsv();
     }
     return summary_info;
   }
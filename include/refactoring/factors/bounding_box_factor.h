@@ -2,7 +2,9 @@
 #define UT_VSLAM_REFACTORING_BOUNDING_BOX_FACTOR_H
 
 #include <ceres/autodiff_cost_function.h>
+#include <ceres/sized_cost_function.h>
 #include <glog/logging.h>
+#include <refactoring/types/ellipsoid_projection_kernel.h>
 #include <refactoring/types/ellipsoid_utils.h>
 #include <refactoring/types/vslam_basic_types_refactor.h>
 #include <refactoring/types/vslam_obj_opt_types_refactor.h>
@@ -135,6 +137,30 @@ class BoundingBoxFactor {
     return true;
   }
 
+  /**
+   * Compute the residual for the bounding box observation and (optionally) its
+   * Jacobians, using the closed-form projection kernel instead of automatic
+   * differentiation. Gives the same residuals as operator().
+   *
+   * @param ellipsoid[in]               Estimate of the ellipsoid parameters.
+   * @param robot_pose[in]              Robot's pose in the world frame.
+   * @param residuals_ptr[out]          Residual giving the error. Contains 4
+   *                                    entries.
+   * @param ellipsoid_jacobian[out]     Row-major Jacobian of the residuals
+   *                                    with respect to the ellipsoid. Not
+   *                                    computed if null.
+   * @param robot_pose_jacobian[out]    Row-major Jacobian of the residuals
+   *                                    with respect to the robot pose. Not
+   *                                    computed if null.
+   *
+   * @return True if the residual was computed successfully, false otherwise.
+   */
+  bool evaluateWithAnalyticJacobian(const double *ellipsoid,
+                                    const double *robot_pose,
+                                    double *residuals_ptr,
+                                    double *ellipsoid_jacobian,
+                                    double *robot_pose_jacobian) const;
+
   /**
    * Create the autodiff cost function with this cost functor.
    *
@@ -205,6 +231,63 @@ class BoundingBoxFactor {
 
   bool debug_;
 };
+
+/**
+ * Cost function for the bounding box factor that computes its Jacobians in
+ * closed form (see projectEllipsoidRectified) rather than evaluating the
+ * projection with 15-dimensional autodiff jets.
+ */
+class BoundingBoxCostFunctionAnalyticJacobian
+    : public ceres::SizedCostFunction<4, kEllipsoidParamterizationSize, 6> {
+ public:
+  explicit BoundingBoxCostFunctionAnalyticJacobian(
+      const BoundingBoxFactor &factor)
+      : factor_(factor) {}
+
+  virtual ~BoundingBoxCostFunctionAnalyticJacobian() = default;
+
+  virtual bool Evaluate(double const *const *parameters,
+                        double *residuals,
+                        double **jacobians) const {
+    return factor_.evaluateWithAnalyticJacobian(
+        parameters[0],
+        parameters[1],
+        residuals,
+        (jacobians == nullptr) ? nullptr : jacobians[0],
+        (jacobians == nullptr) ? nullptr : jacobians[1]);
+  }
+
+  /**
+   * Create the cost function. Takes the same arguments as
+   * BoundingBoxFactor::createBoundingBoxFactor.
+   */
+  static BoundingBoxCostFunctionAnalyticJacobian *createBoundingBoxFactor(
+      const double &invalid_ellipse_error,
+      const vslam_types_refactor::BbCorners<double> &object_detection,
+      const vslam_types_refactor::CameraIntrinsicsMat<double>
+          &camera_intrinsics,
+      const vslam_types_refactor::CameraExtrinsics<double> &camera_extrinsics,
+      const vslam_types_refactor::Covariance<double, 4>
+          &bounding_box_covariance,
+      const std::optional<ObjectId> &obj_id,
+      const std::optional<FrameId> &frame_id,
+      const std::optional<CameraId> &cam_id,
+      const bool &debug = false) {
+    return new BoundingBoxCostFunctionAnalyticJacobian(
+        BoundingBoxFactor(invalid_ellipse_error,
+                          camera_intrinsics,
+                          camera_extrinsics,
+                          object_detection,
+                          bounding_box_covariance,
+                          obj_id,
+                          frame_id,
+                          cam_id,
+                          debug));
+  }
+
+ private:
+  BoundingBoxFactor factor_;
+};
 }  // namespace vslam_types_refactor
 
 #endif  // UT_VSLAM_REFACTORING_BOUNDING_BOX_FACTOR_H
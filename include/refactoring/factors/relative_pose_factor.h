@@ -16,6 +16,17 @@ class RelativePoseFactor {
   RelativePoseFactor(const Pose3D<double> &measured_pose_deviation,
                      const Covariance<double, 6> &pose_deviation_cov);
 
+  /**
+   * Replace the measurement for this factor. Used to update a factor that is
+   * already in an optimization problem instead of recreating it.
+   *
+   * @param measured_pose_deviation Measured pose of the robot after moving
+   *                                relative to the pose before moving.
+   * @param pose_deviation_cov      Covariance of the measured pose deviation.
+   */
+  void setMeasurement(const Pose3D<double> &measured_pose_deviation,
+                      const Covariance<double, 6> &pose_deviation_cov);
+
   /**
    * Compute the residual for the bounding box observation.
    *
@@ -69,13 +80,21 @@ class RelativePoseFactor {
    *                                    relative to robot base link).
    * @param bounding_box_covariance     Covariance of bounding box measurements.
    *
+   * @param factor_out[out]             Cost functor owned by the returned
+   *                                    cost function, for updating the
+   *                                    measurement later. Not set if null.
+   *
    * @return Ceres cost function.
    */
   static ceres::AutoDiffCostFunction<RelativePoseFactor, 6, 6, 6> *
   createRelativePoseFactor(const Pose3D<double> &measured_pose_deviation,
-                           const Covariance<double, 6> &pose_deviation_cov) {
+                           const Covariance<double, 6> &pose_deviation_cov,
+                           RelativePoseFactor **factor_out = nullptr) {
     RelativePoseFactor *factor =
         new RelativePoseFactor(measured_pose_deviation, pose_deviation_cov);
+    if (factor_out != nullptr) {
+      *factor_out = factor;
+    }
     return new ceres::AutoDiffCostFunction<RelativePoseFactor, 6, 6, 6>(factor);
   }
 
@@ -14,7 +14,7 @@ namespace {
 const double kMinStdDev = 1e-3;
 }
 
-Covariance<double, 6> generateOdomCov(
+inline Covariance<double, 6> generateOdomCov(
     const Pose3D<double> &relative_pose,
     const double &transl_error_mult_for_transl_error,
     const double &transl_error_mult_for_rot_error,
@@ -0,0 +1,159 @@
+#ifndef UT_VSLAM_REFACTORING_REPROJECTION_COST_FUNCTOR_CACHED_POSE_H
+#define UT_VSLAM_REFACTORING_REPROJECTION_COST_FUNCTOR_CACHED_POSE_H
+
+#include <ceres/sized_cost_function.h>
+#include <refactoring/factors/robot_pose_transform_cache.h>
+#include <refactoring/types/vslam_basic_types_refactor.h>
+
+#include <eigen3/Eigen/Dense>
+
+namespace vslam_types_refactor {
+
+/**
+ * Cost function that adds a residual for Gaussian-distributed reprojection
+ * error, with analytic Jacobians.
+ *
+ * Computes the same residual as ReprojectionCostFunctor, but reads the
+ * rotation of the robot pose (and its derivative) from a RobotPoseTransform
+ * that is shared by all residuals for the pose, so the axis-angle conversion
+ * is done once per pose per evaluation rather than once per residual.
+ */
+class ReprojectionCostFunctorCachedPose
+    : public ceres::SizedCostFunction<2, 6, 3> {
+ public:
+  /**
+   * Constructor.
+   *
+   * @param image_feature               Pixel location of the feature in image
+   * @param intrinsics                  Camera intrinsics.
+   * @param extrinsics                  Camera extrinsics (pose of the camera
+   *                                    relative to the robot).
+   * @param reprojection_error_std_dev  Standard deviation of the reprojection
+   *                                    error
+   * @param robot_pose_transform        Cached transform for the robot pose
+   *                                    block this residual is added with.
+   */
+  ReprojectionCostFunctorCachedPose(
+      const vslam_types_refactor::PixelCoord<double> &image_feature,
+      const vslam_types_refactor::CameraIntrinsicsMat<double> &intrinsics,
+      const vslam_types_refactor::CameraExtrinsics<double> &extrinsics,
+      const double &reprojection_error_std_dev,
+      const std::shared_ptr<const RobotPoseTransform> &robot_pose_transform);
+
+  virtual ~ReprojectionCostFunctorCachedPose() = default;
+
+  virtual bool Evaluate(double const *const *parameters,
+                        double *residuals,
+                        double **jacobians) const {
+    const double *robot_pose_block = parameters[0];
+    const double *point_block = parameters[1];
+
+    // The cache is only current if it was refreshed for this evaluation point
+    const RobotPoseTransform *robot_pose_transform =
+        robot_pose_transform_.get();
+    RobotPoseTransform local_robot_pose_transform;
+    if (!robot_pose_transform->matches(robot_pose_block)) {
+      local_robot_pose_transform.update(robot_pose_block);
+      robot_pose_transform = &local_robot_pose_transform;
+    }
+
+    const Eigen::Vector3d point_world(
+        point_block[0], point_block[1], point_block[2]);
+    const Eigen::Vector3d point_robot =
+        robot_pose_transform->world_to_robot_rot_ *
+        (point_world - robot_pose_transform->robot_transl_);
+    const Eigen::Vector3d point_cam =
+        robot_to_cam_rot_ * point_robot + robot_to_cam_transl_;
+
+    const double inv_depth = 1.0 / point_cam.z();
+    residuals[0] = rectified_error_multiplier_x_ *
+                   (point_cam.x() * inv_depth - rect_feature_x_);
+    residuals[1] = rectified_error_multiplier_y_ *
+                   (point_cam.y() * inv_depth - rect_feature_y_);
+
+    if (jacobians == nullptr) {
+      return true;
+    }
+
+    // Derivative of the residual with respect to the point in the camera
+    // frame
+    Eigen::Matrix<double, 2, 3> residual_jacobian_cam;
+    residual_jacobian_cam << rectified_error_multiplier_x_ * inv_depth, 0,
+        -rectified_error_multiplier_x_ * point_cam.x() * inv_depth * inv_depth,
+        0, rectified_error_multiplier_y_ * inv_depth,
+        -rectified_error_multiplier_y_ * point_cam.y() * inv_depth * inv_depth;
+
+    const Eigen::Matrix<double, 2, 3> residual_jacobian_point =
+        residual_jacobian_cam * robot_to_cam_rot_ *
+        robot_pose_transform->world_to_robot_rot_;
+
+    double *robot_pose_jacobian = jacobians[0];
+    double *point_jacobian = jacobians[1];
+
+    if (robot_pose_jacobian != nullptr) {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>>
+          robot_pose_jacobian_mat(robot_pose_jacobian);
+      robot_pose_jacobian_mat.leftCols<3>() = -residual_jacobian_point;
+      robot_pose_jacobian_mat.rightCols<3>() =
+          residual_jacobian_cam * robot_to_cam_rot_ *
+          skewSymmetric(point_robot) * robot_pose_transform->rot_jacobian_;
+    }
+
+    if (point_jacobian != nullptr) {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>>
+          point_jacobian_mat(point_jacobian);
+      point_jacobian_mat = residual_jacobian_point;
+    }
+
+    return true;
+  }
+
+  /**
+   * Create the cost function.
+   *
+   * @param intrinsics                  Camera intrinsics.
+   * @param extrinsics                  Camera extrinsics (provide camera pose
+   *                                    relative to robot).
+   * @param feature_pixel               Pixel location of the feature.
+   * @param reprojection_error_std_dev  Standard deviation of the reprojection
+   *                                    error (assuming this is normally
+   *                                    distributed).
+   * @param robot_pose_transform        Cached transform for the robot pose
+   *                                    block this residual is added with.
+   *
+   * @return Ceres cost function.
+   */
+  static ReprojectionCostFunctorCachedPose *create(
+      const vslam_types_refactor::CameraIntrinsicsMat<double> &intrinsics,
+      const vslam_types_refactor::CameraExtrinsics<double> &extrinsics,
+      const vslam_types_refactor::PixelCoord<double> &feature_pixel,
+      const double &reprojection_error_std_dev,
+      const std::shared_ptr<const RobotPoseTransform> &robot_pose_transform) {
+    return new ReprojectionCostFunctorCachedPose(feature_pixel,
+                                                 intrinsics,
+                                                 extrinsics,
+                                                 reprojection_error_std_dev,
+                                                 robot_pose_transform);
+  }
+
+ private:
+  double rect_feature_x_;
+
+  double rect_feature_y_;
+
+  double rectified_error_multiplier_x_;
+
+  double rectified_error_multiplier_y_;
+
+  /**
+   * Rotation and translation that take points from the robot frame to the
+   * camera frame.
+   */
+  Eigen::Matrix3d robot_to_cam_rot_;
+  Eigen::Vector3d robot_to_cam_transl_;
+
+  std::shared_ptr<const RobotPoseTransform> robot_pose_transform_;
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_REFACTORING_REPROJECTION_COST_FUNCTOR_CACHED_POSE_H
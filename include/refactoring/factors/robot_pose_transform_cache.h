@@ -0,0 +1,159 @@
+//
+// Created by amanda on 3/14/23.
+//
+
+#ifndef UT_VSLAM_ROBOT_POSE_TRANSFORM_CACHE_H
+#define UT_VSLAM_ROBOT_POSE_TRANSFORM_CACHE_H
+
+#include <ceres/evaluation_callback.h>
+#include <refactoring/types/vslam_math_util.h>
+
+#include <array>
+#include <eigen3/Eigen/Dense>
+#include <memory>
+#include <unordered_map>
+
+namespace vslam_types_refactor {
+
+/**
+ * Below this angle, the closed form of the rotation Jacobian loses precision,
+ * so a series expansion is used instead.
+ */
+const double kRotationJacobianSeriesAngleThreshold = 1e-4;
+
+/**
+ * Skew symmetric matrix such that skew(v) * w = v x w.
+ */
+inline Eigen::Matrix3d skewSymmetric(const Eigen::Vector3d &vec) {
+  Eigen::Matrix3d skew;
+  skew << 0, -vec.z(), vec.y(), vec.z(), 0, -vec.x(), -vec.y(), vec.x(), 0;
+  return skew;
+}
+
+/**
+ * Terms that depend only on a robot pose block (translation then axis-angle
+ * rotation), shared by all residuals that observe from that pose.
+ */
+struct RobotPoseTransform {
+  /**
+   * Pose block values that the rest of the fields were computed from.
+   */
+  std::array<double, 6> pose_;
+
+  /**
+   * Rotation from the world frame to the robot frame (R^T).
+   */
+  Eigen::Matrix3d world_to_robot_rot_;
+
+  /**
+   * Position of the robot in the world frame.
+   */
+  Eigen::Vector3d robot_transl_;
+
+  /**
+   * Derivative of R^T v with respect to the axis-angle rotation is
+   * skewSymmetric(R^T v) * rot_jacobian_ (rot_jacobian_ is the right Jacobian
+   * of SO(3)).
+   */
+  Eigen::Matrix3d rot_jacobian_;
+
+  bool valid_ = false;
+
+  void update(const double *pose_block) {
+    std::copy(pose_block, pose_block + 6, pose_.begin());
+    const Eigen::Vector3d axis_angle(
+        pose_block[3], pose_block[4], pose_block[5]);
+    const double angle = axis_angle.norm();
+
+    // Rotation matches PoseArrayToAffine
+    if (angle < kSmallAngleThreshold) {
+      world_to_robot_rot_.setIdentity();
+    } else {
+      world_to_robot_rot_ = Eigen::AngleAxisd(angle, axis_angle / angle)
+                                .toRotationMatrix()
+                                .transpose();
+    }
+    robot_transl_ =
+        Eigen::Vector3d(pose_block[0], pose_block[1], pose_block[2]);
+
+    const Eigen::Matrix3d axis_angle_skew = skewSymmetric(axis_angle);
+    if (angle < kRotationJacobianSeriesAngleThreshold) {
+      rot_jacobian_ = Eigen::Matrix3d::Identity() - 0.5 * axis_angle_skew +
+                      (1.0 / 6.0) * axis_angle_skew * axis_angle_skew;
+    } else {
+      const double angle_sq = angle * angle;
+      rot_jacobian_ =
+          Eigen::Matrix3d::Identity() -
+          ((1 - cos(angle)) / angle_sq) * axis_angle_skew +
+          ((angle - sin(angle)) / (angle_sq * angle)) * axis_angle_skew *
+              axis_angle_skew;
+    }
+    valid_ = true;
+  }
+
+  /**
+   * Check if the transform was computed from exactly these pose values.
+   */
+  bool matches(const double *pose_block) const {
+    return valid_ && std::equal(pose_.begin(), pose_.end(), pose_block);
+  }
+};
+
+/**
+ * Recomputes the transform for each registered robot pose block once per
+ * Ceres evaluation point, instead of once per residual.
+ *
+ * Register this as the problem's evaluation callback. Residuals still check
+ * that the cached values match their parameters (and compute them locally if
+ * not), so they stay correct in problems without this callback.
+ *
+ * Entries are only written in PrepareForEvaluation, which Ceres calls before
+ * (not during) the multi-threaded residual evaluation. Entries that are no
+ * longer referenced by any residual are dropped there.
+ */
+class RobotPoseTransformCache : public ceres::EvaluationCallback {
+ public:
+  RobotPoseTransformCache() = default;
+
+  virtual ~RobotPoseTransformCache() = default;
+
+  /**
+   * Get the cache entry for a robot pose block, creating it if needed. Must not
+   * be called while a problem using this cache is being solved.
+   */
+  std::shared_ptr<const RobotPoseTransform> getOrAddRobotPose(
+      const double *robot_pose_block) {
+    std::shared_ptr<RobotPoseTransform> &transform =
+        transforms_by_pose_block_[robot_pose_block];
+    if (transform == nullptr) {
+      transform = std::make_shared<RobotPoseTransform>();
+      transform->update(robot_pose_block);
+    }
+    return transform;
+  }
+
+  virtual void PrepareForEvaluation(bool evaluate_jacobians,
+                                    bool new_evaluation_point) override {
+    if (!new_evaluation_point) {
+      return;
+    }
+    for (auto transform_it = transforms_by_pose_block_.begin();
+         transform_it != transforms_by_pose_block_.end();) {
+      if (transform_it->second.use_count() == 1) {
+        transform_it = transforms_by_pose_block_.erase(transform_it);
+      } else {
+        transform_it->second->update(transform_it->first);
+        transform_it++;
+      }
+    }
+  }
+
+  size_t size() const { return transforms_by_pose_block_.size(); }
+
+ private:
+  std::unordered_map<const double *, std::shared_ptr<RobotPoseTransform>>
+      transforms_by_pose_block_;
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_ROBOT_POSE_TRANSFORM_CACHE_H
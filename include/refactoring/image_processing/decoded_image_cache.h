@@ -0,0 +1,165 @@
+//
+// Created by amanda on 3/18/23.
+//
+
+#ifndef UT_VSLAM_DECODED_IMAGE_CACHE_H
+#define UT_VSLAM_DECODED_IMAGE_CACHE_H
+
+#include <cv_bridge/cv_bridge.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/image_encodings.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <unordered_map>
+
+namespace vslam_types_refactor {
+
+const static size_t kDefaultDecodedImageCacheCapacity = 32;
+
+/**
+ * BGR version of an image message, plus color conversions of it that are
+ * computed the first time they're requested. The returned matrices share
+ * their data with the cache and must not be modified (clone them first).
+ */
+class DecodedImage {
+ public:
+  explicit DecodedImage(const sensor_msgs::Image::ConstPtr &image)
+      : image_(image) {}
+
+  /**
+   * Get the BGR image. Doesn't copy the image data if the message is already
+   * BGR.
+   *
+   * Throws cv_bridge::Exception if the message can't be converted.
+   */
+  const cv::Mat &getBgr() const {
+    std::call_once(bgr_once_, [&]() {
+      bgr_image_ = cv_bridge::toCvShare(image_,
+                                        sensor_msgs::image_encodings::BGR8);
+    });
+    return bgr_image_->image;
+  }
+
+  const cv::Mat &getHsv() const {
+    std::call_once(hsv_once_, [&]() {
+      cv::cvtColor(getBgr(), hsv_image_, cv::COLOR_BGR2HSV);
+    });
+    return hsv_image_;
+  }
+
+  const cv::Mat &getGray() const {
+    std::call_once(gray_once_, [&]() {
+      cv::cvtColor(getBgr(), gray_image_, cv::COLOR_BGR2GRAY);
+    });
+    return gray_image_;
+  }
+
+  /**
+   * Get a copy of the BGR image that can be drawn on, with the header of the
+   * image message (same result as cv_bridge::toCvCopy).
+   */
+  cv_bridge::CvImagePtr copyBgr() const {
+    return boost::make_shared<cv_bridge::CvImage>(
+        image_->header, sensor_msgs::image_encodings::BGR8, getBgr().clone());
+  }
+
+ private:
+  sensor_msgs::Image::ConstPtr image_;
+
+  mutable std::once_flag bgr_once_;
+  mutable cv_bridge::CvImageConstPtr bgr_image_;
+
+  mutable std::once_flag hsv_once_;
+  mutable cv::Mat hsv_image_;
+
+  mutable std::once_flag gray_once_;
+  mutable cv::Mat gray_image_;
+};
+
+/**
+ * Decoded images shared by all consumers of the same image message (front
+ * ends, visualizers, evaluation tools), so that each image is converted to BGR
+ * (and HSV, grayscale) once no matter how many of them use it. Each frame and
+ * camera has one image message, so entries are keyed by the message.
+ *
+ * The most recently used images are kept, up to the capacity. Entries that
+ * are evicted stay valid for consumers that still hold them.
+ */
+class DecodedImageCache {
+ protected:
+  DecodedImageCache() = default;
+
+ public:
+  // NOTE: Make sure to keep variables returned by this function passed by
+  // reference so that the singleton pattern holds.
+  static DecodedImageCache &getInstance() {
+    static DecodedImageCache cache_instance;
+    return cache_instance;
+  }
+
+  /**
+   * Get the decoded image for the message, adding it to the cache if needed.
+   * Conversion happens when a variant is first requested from the returned
+   * object, outside of the cache lock.
+   */
+  std::shared_ptr<const DecodedImage> getDecodedImage(
+      const sensor_msgs::Image::ConstPtr &image) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto entry_it = entries_by_image_.find(image.get());
+    if (entry_it != entries_by_image_.end()) {
+      recently_used_images_.splice(recently_used_images_.begin(),
+                                   recently_used_images_,
+                                   entry_it->second.second);
+      return entry_it->second.first;
+    }
+
+    // The entry holds the message, so its address isn't reused while cached
+    std::shared_ptr<const DecodedImage> decoded_image =
+        std::make_shared<DecodedImage>(image);
+    recently_used_images_.push_front(image.get());
+    entries_by_image_[image.get()] =
+        std::make_pair(decoded_image, recently_used_images_.begin());
+    evictToCapacity();
+    return decoded_image;
+  }
+
+  void setCapacity(const size_t &capacity) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    capacity_ = capacity;
+    evictToCapacity();
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return entries_by_image_.size();
+  }
+
+ private:
+  std::mutex cache_mutex_;
+
+  size_t capacity_ = kDefaultDecodedImageCacheCapacity;
+
+  /**
+   * Images in the cache, most recently used first.
+   */
+  std::list<const sensor_msgs::Image *> recently_used_images_;
+
+  std::unordered_map<
+      const sensor_msgs::Image *,
+      std::pair<std::shared_ptr<const DecodedImage>,
+                std::list<const sensor_msgs::Image *>::iterator>>
+      entries_by_image_;
+
+  void evictToCapacity() {
+    while (entries_by_image_.size() > capacity_) {
+      entries_by_image_.erase(recently_used_images_.back());
+      recently_used_images_.pop_back();
+    }
+  }
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_DECODED_IMAGE_CACHE_H
@@ -0,0 +1,447 @@
+//
+// Created by amanda on 3/17/23.
+//
+
+#ifndef UT_VSLAM_LONG_TERM_MAP_COMPACTION_H
+#define UT_VSLAM_LONG_TERM_MAP_COMPACTION_H
+
+#include <base_lib/basic_utils.h>
+#include <glog/logging.h>
+#include <refactoring/long_term_map/long_term_object_map.h>
+#include <refactoring/output_problem_data.h>
+#include <refactoring/types/vslam_obj_opt_types_refactor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+struct LongTermMapCompactionParams {
+  /**
+   * Objects of the same semantic class whose centers are within this distance
+   * are considered duplicates and merged. Non-positive disables merging.
+   */
+  double max_merge_distance_ = 0.5;
+
+  /**
+   * If true, only the x-y distance between object centers is considered when
+   * finding duplicates.
+   */
+  bool x_y_only_merge_ = true;
+
+  /**
+   * Objects that have not been observed in this many consecutive sessions are
+   * removed from the map. 0 disables removal.
+   */
+  uint64_t max_unobserved_sessions_ = 0;
+
+  bool operator==(const LongTermMapCompactionParams &rhs) const {
+    return (max_merge_distance_ == rhs.max_merge_distance_) &&
+           (x_y_only_merge_ == rhs.x_y_only_merge_) &&
+           (max_unobserved_sessions_ == rhs.max_unobserved_sessions_);
+  }
+
+  bool operator!=(const LongTermMapCompactionParams &rhs) const {
+    return !operator==(rhs);
+  }
+};
+
+struct LongTermMapCompactionStats {
+  size_t num_objects_before_ = 0;
+  size_t num_objects_after_ = 0;
+  size_t num_merged_ = 0;
+  size_t num_removed_unobserved_ = 0;
+};
+
+/**
+ * Fuse two estimates of the same object, weighting each by its information
+ * (inverse covariance).
+ *
+ * Estimates and covariances are fused in the raw parameterization, so
+ * orientations are averaged as parameters, which is only accurate when they
+ * are close (as they are for duplicates of the same object). For yaw-only
+ * ellipsoids, the second yaw is first wrapped to within pi of the first, and
+ * the fused yaw is wrapped back to [-pi, pi].
+ *
+ * @param first_est       First estimate.
+ * @param first_cov       Covariance of the first estimate.
+ * @param second_est      Second estimate.
+ * @param second_cov      Covariance of the second estimate.
+ * @param fused_est[out]  Fused estimate.
+ * @param fused_cov[out]  Covariance of the fused estimate.
+ *
+ * @return True if the estimates were fused, false if either covariance isn't
+ * invertible.
+ */
+inline bool fuseEllipsoidEstimates(
+    const RawEllipsoid<double> &first_est,
+    const Covariance<double, kEllipsoidParamterizationSize> &first_cov,
+    const RawEllipsoid<double> &second_est,
+    const Covariance<double, kEllipsoidParamterizationSize> &second_cov,
+    RawEllipsoid<double> &fused_est,
+    Covariance<double, kEllipsoidParamterizationSize> &fused_cov) {
+  Eigen::FullPivLU<Covariance<double, kEllipsoidParamterizationSize>>
+      first_cov_lu(first_cov);
+  Eigen::FullPivLU<Covariance<double, kEllipsoidParamterizationSize>>
+      second_cov_lu(second_cov);
+  if ((!first_cov_lu.isInvertible()) || (!second_cov_lu.isInvertible())) {
+    return false;
+  }
+  Covariance<double, kEllipsoidParamterizationSize> first_info =
+      first_cov_lu.inverse();
+  Covariance<double, kEllipsoidParamterizationSize> second_info =
+      second_cov_lu.inverse();
+  Eigen::FullPivLU<Covariance<double, kEllipsoidParamterizationSize>>
+      fused_info_lu(first_info + second_info);
+  if (!fused_info_lu.isInvertible()) {
+    return false;
+  }
+
+  RawEllipsoid<double> adjusted_second_est = second_est;
+#ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
+  const int kYawIdx = 3;
+  adjusted_second_est(kYawIdx) =
+      first_est(kYawIdx) +
+      std::remainder(second_est(kYawIdx) - first_est(kYawIdx), 2 * M_PI);
+#endif
+  fused_cov = fused_info_lu.inverse();
+  fused_cov = 0.5 * (fused_cov + fused_cov.transpose());
+  fused_est = fused_cov *
+              (first_info * first_est + second_info * adjusted_second_est);
+#ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
+  fused_est(kYawIdx) = std::remainder(fused_est(kYawIdx), 2 * M_PI);
+#endif
+  return true;
+}
+
+/**
+ * Update the unobserved session counts for a newly extracted long-term map.
+ * Objects observed in the session get no entry (a count of 0). Objects that
+ * carried over from the previous map without being observed get their previous
+ * count plus 1.
+ *
+ * @param prev_long_term_map  Long-term map that the session started from.
+ *                            Null if the session started from scratch.
+ * @param observed_objects    Objects that were observed in the session.
+ * @param long_term_map[out]  Long-term map extracted from the session.
+ */
+template <typename LongTermObjectMapType>
+void updateUnobservedSessionCounts(
+    const std::shared_ptr<LongTermObjectMapType> &prev_long_term_map,
+    const std::unordered_set<ObjectId> &observed_objects,
+    LongTermObjectMapType &long_term_map) {
+  EllipsoidResults prev_ellipsoids;
+  std::unordered_map<ObjectId, uint64_t> prev_unobserved_session_counts;
+  if (prev_long_term_map != nullptr) {
+    prev_long_term_map->getLtmEllipsoidResults(prev_ellipsoids);
+    prev_long_term_map->getUnobservedSessionCounts(
+        prev_unobserved_session_counts);
+  }
+
+  EllipsoidResults ltm_ellipsoids;
+  long_term_map.getLtmEllipsoidResults(ltm_ellipsoids);
+  std::unordered_map<ObjectId, uint64_t> unobserved_session_counts;
+  for (const auto &ltm_ellipsoid : ltm_ellipsoids.ellipsoids_) {
+    const ObjectId &obj_id = ltm_ellipsoid.first;
+    if ((observed_objects.find(obj_id) != observed_objects.end()) ||
+        (prev_ellipsoids.ellipsoids_.find(obj_id) ==
+         prev_ellipsoids.ellipsoids_.end())) {
+      continue;
+    }
+    auto prev_count_it = prev_unobserved_session_counts.find(obj_id);
+    unobserved_session_counts[obj_id] =
+        ((prev_count_it == prev_unobserved_session_counts.end())
+             ? 0
+             : prev_count_it->second) +
+        1;
+  }
+  long_term_map.setUnobservedSessionCounts(unobserved_session_counts);
+}
+
+/**
+ * Keeps the long-term map from growing across sessions in a static
+ * environment by merging duplicate objects and removing objects that haven't
+ * been observed in a long time.
+ *
+ * Duplicates are same-class objects with nearby centers, found with a grid
+ * over the object centers (cell size is the merge distance, so only
+ * neighboring cells need to be checked). Like the end-of-session merge, the
+ * closest pairs are merged first and each object is merged at most once per
+ * pass; passes repeat until nothing is merged. The object with the smaller id
+ * is kept. Only merged objects get new estimates and covariances; all other
+ * entries are left as they are.
+ *
+ * Like the end-of-session merge in the bounding box front end, the front-end
+ * map data of a merged-away object is merged into that of the kept object, or
+ * used for the kept object if it has none.
+ */
+class LongTermMapCompactor {
+ public:
+  explicit LongTermMapCompactor(const LongTermMapCompactionParams &params)
+      : params_(params) {}
+
+  /**
+   * Compact the long-term map.
+   *
+   * @param long_term_map[in/out]       Long-term map to compact.
+   * @param front_end_map_data_merger   Merges the front-end map data of a
+   *                                    merged-away object (first argument)
+   *                                    into the data of the object it was
+   *                                    merged into (second argument). If
+   *                                    empty, the kept object's data is left
+   *                                    as is, which is only correct when the
+   *                                    front-end map data has no per-object
+   *                                    content (as with util::EmptyStruct).
+   *
+   * @return Object counts before and after compaction.
+   */
+  template <typename FrontEndObjMapData>
+  LongTermMapCompactionStats compact(
+      IndependentEllipsoidsLongTermObjectMap<FrontEndObjMapData>
+          &long_term_map,
+      const std::function<void(const FrontEndObjMapData &,
+                               FrontEndObjMapData &)>
+          &front_end_map_data_merger = nullptr) const {
+    LongTermMapCompactionStats stats;
+    EllipsoidResults ltm_ellipsoids;
+    long_term_map.getLtmEllipsoidResults(ltm_ellipsoids);
+    stats.num_objects_before_ = ltm_ellipsoids.ellipsoids_.size();
+
+    std::unordered_map<ObjectId,
+                       Covariance<double, kEllipsoidParamterizationSize>>
+        ellipsoid_covariances = long_term_map.getEllipsoidCovariances();
+    std::unordered_map<ObjectId, uint64_t> unobserved_session_counts;
+    long_term_map.getUnobservedSessionCounts(unobserved_session_counts);
+
+    std::unordered_set<ObjectId> objects_to_remove;
+    // Kept and merged-away object for each merge, in the order performed
+    std::vector<std::pair<ObjectId, ObjectId>> merges;
+    if (params_.max_unobserved_sessions_ > 0) {
+      for (const auto &unobserved_count : unobserved_session_counts) {
+        if ((unobserved_count.second >= params_.max_unobserved_sessions_) &&
+            (ltm_ellipsoids.ellipsoids_.erase(unobserved_count.first) > 0)) {
+          objects_to_remove.insert(unobserved_count.first);
+          stats.num_removed_unobserved_++;
+        }
+      }
+    }
+
+    if (params_.max_merge_distance_ > 0) {
+      std::unordered_map<ObjectId, std::pair<std::string, RawEllipsoid<double>>>
+          raw_ellipsoids;
+      for (const auto &ltm_ellipsoid : ltm_ellipsoids.ellipsoids_) {
+        raw_ellipsoids[ltm_ellipsoid.first] =
+            std::make_pair(ltm_ellipsoid.second.first,
+                           convertToRawEllipsoid(ltm_ellipsoid.second.second));
+      }
+      std::unordered_set<ObjectId> merged_objects;
+      size_t num_merged_in_pass;
+      do {
+        num_merged_in_pass = runMergePass(raw_ellipsoids,
+                                          ellipsoid_covariances,
+                                          unobserved_session_counts,
+                                          merged_objects,
+                                          objects_to_remove,
+                                          merges);
+        stats.num_merged_ += num_merged_in_pass;
+      } while (num_merged_in_pass > 0);
+
+      for (const ObjectId &merged_obj : merged_objects) {
+        if (raw_ellipsoids.find(merged_obj) != raw_ellipsoids.end()) {
+          ltm_ellipsoids.ellipsoids_[merged_obj].second =
+              convertToEllipsoidState(raw_ellipsoids.at(merged_obj).second);
+        }
+      }
+      for (const ObjectId &removed_obj : objects_to_remove) {
+        ltm_ellipsoids.ellipsoids_.erase(removed_obj);
+      }
+    }
+
+    if (objects_to_remove.empty()) {
+      stats.num_objects_after_ = stats.num_objects_before_;
+      return stats;
+    }
+
+    std::unordered_map<ObjectId, FrontEndObjMapData> front_end_map_data;
+    long_term_map.getFrontEndObjMapData(front_end_map_data);
+    for (const std::pair<ObjectId, ObjectId> &merge : merges) {
+      auto removed_data_it = front_end_map_data.find(merge.second);
+      if (removed_data_it == front_end_map_data.end()) {
+        continue;
+      }
+      auto kept_data_it = front_end_map_data.find(merge.first);
+      if (kept_data_it == front_end_map_data.end()) {
+        FrontEndObjMapData removed_data = removed_data_it->second;
+        front_end_map_data[merge.first] = removed_data;
+      } else if (front_end_map_data_merger) {
+        front_end_map_data_merger(removed_data_it->second,
+                                  kept_data_it->second);
+      }
+    }
+    EllipsoidResults prev_traj_ellipsoids;
+    long_term_map.getEllipsoidResults(prev_traj_ellipsoids);
+    for (const ObjectId &removed_obj : objects_to_remove) {
+      ellipsoid_covariances.erase(removed_obj);
+      unobserved_session_counts.erase(removed_obj);
+      front_end_map_data.erase(removed_obj);
+    }
+
+    // The previous trajectory estimates are filtered to the objects in the
+    // long-term map, so the long-term map ellipsoids have to be set first
+    long_term_map.setLtmEllipsoidResults(ltm_ellipsoids);
+    long_term_map.setEllipsoidResults(prev_traj_ellipsoids);
+    long_term_map.setEllipsoidCovariances(ellipsoid_covariances);
+    long_term_map.setFrontEndObjMapData(front_end_map_data);
+    long_term_map.setUnobservedSessionCounts(unobserved_session_counts);
+    stats.num_objects_after_ = ltm_ellipsoids.ellipsoids_.size();
+    return stats;
+  }
+
+ private:
+  using GridCell = std::pair<int64_t, int64_t>;
+
+  LongTermMapCompactionParams params_;
+
+  GridCell getCellForPosition(const Position3d<double> &position) const {
+    return std::make_pair(
+        (int64_t)std::floor(position.x() / params_.max_merge_distance_),
+        (int64_t)std::floor(position.y() / params_.max_merge_distance_));
+  }
+
+  double getCenterDistance(const Position3d<double> &first_center,
+                           const Position3d<double> &second_center) const {
+    if (params_.x_y_only_merge_) {
+      return (first_center.topRows(2) - second_center.topRows(2)).norm();
+    }
+    return (first_center - second_center).norm();
+  }
+
+  /**
+   * Merge the closest same-class pairs of objects once.
+   *
+   * @param merges[out] Kept and merged-away object for each merge performed
+   *                    (appended).
+   *
+   * @return Number of merges performed.
+   */
+  size_t runMergePass(
+      std::unordered_map<ObjectId, std::pair<std::string, RawEllipsoid<double>>>
+          &raw_ellipsoids,
+      std::unordered_map<ObjectId,
+                         Covariance<double, kEllipsoidParamterizationSize>>
+          &ellipsoid_covariances,
+      std::unordered_map<ObjectId, uint64_t> &unobserved_session_counts,
+      std::unordered_set<ObjectId> &merged_objects,
+      std::unordered_set<ObjectId> &objects_to_remove,
+      std::vector<std::pair<ObjectId, ObjectId>> &merges) const {
+    util::BoostHashMap<GridCell, std::vector<ObjectId>> objects_by_cell;
+    for (const auto &raw_ellipsoid : raw_ellipsoids) {
+      objects_by_cell[getCellForPosition(
+                          extractPosition(raw_ellipsoid.second.second))]
+          .emplace_back(raw_ellipsoid.first);
+    }
+
+    std::vector<std::pair<double, std::pair<ObjectId, ObjectId>>>
+        possible_merge_objs_with_dist;
+    for (const auto &raw_ellipsoid : raw_ellipsoids) {
+      const ObjectId &obj_id = raw_ellipsoid.first;
+      Position3d<double> center = extractPosition(raw_ellipsoid.second.second);
+      GridCell cell = getCellForPosition(center);
+      for (int64_t cell_x = cell.first - 1; cell_x <= cell.first + 1;
+           cell_x++) {
+        for (int64_t cell_y = cell.second - 1; cell_y <= cell.second + 1;
+             cell_y++) {
+          auto cell_it = objects_by_cell.find(std::make_pair(cell_x, cell_y));
+          if (cell_it == objects_by_cell.end()) {
+            continue;
+          }
+          for (const ObjectId &other_obj_id : cell_it->second) {
+            // Consider each pair once, with the smaller id first
+            if (other_obj_id <= obj_id) {
+              continue;
+            }
+            const std::pair<std::string, RawEllipsoid<double>> &other_obj =
+                raw_ellipsoids.at(other_obj_id);
+            if (other_obj.first != raw_ellipsoid.second.first) {
+              continue;
+            }
+            double center_dist =
+                getCenterDistance(center, extractPosition(other_obj.second));
+            if (center_dist <= params_.max_merge_distance_) {
+              possible_merge_objs_with_dist.emplace_back(std::make_pair(
+                  center_dist, std::make_pair(obj_id, other_obj_id)));
+            }
+          }
+        }
+      }
+    }
+
+    std::sort(
+        possible_merge_objs_with_dist.begin(),
+        possible_merge_objs_with_dist.end(),
+        util::sort_pair_by_first<double, std::pair<ObjectId, ObjectId>>());
+
+    std::unordered_set<ObjectId> involved_in_merge;
+    size_t num_merged = 0;
+    for (const std::pair<double, std::pair<ObjectId, ObjectId>>
+             &merge_candidate : possible_merge_objs_with_dist) {
+      const ObjectId &kept_obj = merge_candidate.second.first;
+      const ObjectId &removed_obj = merge_candidate.second.second;
+      if ((involved_in_merge.find(kept_obj) != involved_in_merge.end()) ||
+          (involved_in_merge.find(removed_obj) != involved_in_merge.end())) {
+        continue;
+      }
+      RawEllipsoid<double> &kept_est = raw_ellipsoids.at(kept_obj).second;
+      auto kept_cov_it = ellipsoid_covariances.find(kept_obj);
+      auto removed_cov_it = ellipsoid_covariances.find(removed_obj);
+      if ((kept_cov_it != ellipsoid_covariances.end()) &&
+          (removed_cov_it != ellipsoid_covariances.end())) {
+        RawEllipsoid<double> fused_est;
+        Covariance<double, kEllipsoidParamterizationSize> fused_cov;
+        if (fuseEllipsoidEstimates(kept_est,
+                                   kept_cov_it->second,
+                                   raw_ellipsoids.at(removed_obj).second,
+                                   removed_cov_it->second,
+                                   fused_est,
+                                   fused_cov)) {
+          kept_est = fused_est;
+          kept_cov_it->second = fused_cov;
+        } else {
+          LOG(WARNING) << "Could not fuse the estimates of long-term map "
+                          "objects "
+                       << kept_obj << " and " << removed_obj
+                       << "; keeping the estimate of " << kept_obj;
+        }
+      }
+
+      // The merged object was last observed when either of them was
+      auto removed_count_it = unobserved_session_counts.find(removed_obj);
+      if (removed_count_it == unobserved_session_counts.end()) {
+        unobserved_session_counts.erase(kept_obj);
+      } else {
+        auto kept_count_it = unobserved_session_counts.find(kept_obj);
+        if (kept_count_it != unobserved_session_counts.end()) {
+          kept_count_it->second =
+              std::min(kept_count_it->second, removed_count_it->second);
+        }
+      }
+
+      involved_in_merge.insert(kept_obj);
+      involved_in_merge.insert(removed_obj);
+      raw_ellipsoids.erase(removed_obj);
+      merged_objects.insert(kept_obj);
+      merged_objects.erase(removed_obj);
+      objects_to_remove.insert(removed_obj);
+      merges.emplace_back(std::make_pair(kept_obj, removed_obj));
+      num_merged++;
+    }
+    return num_merged;
+  }
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_LONG_TERM_MAP_COMPACTION_H
@@ -10,6 +10,7 @@
 #include <refactoring/factors/independent_object_map_factor.h>
 #include <refactoring/factors/pairwise_object_map_factor.h>
 #include <refactoring/long_term_map/long_term_object_map.h>
+#include <refactoring/optimization/loss_function_pool.h>
 #include <refactoring/optimization/object_pose_graph.h>
 #include <refactoring/optimization/optimization_solver_params.h>
 
@@ -178,7 +179,7 @@ class PairwiseCovarianceLongTermObjectMapFactorCreator
             factor_entry.obj_2_map_est_,
             factor_entry
                 .cross_covariance_),  // TODO probably will need to change this
-        new ceres::HuberLoss(
+        LossFunctionPool::getInstance().getHuberLoss(
             residual_params.long_term_map_params_.pair_huber_loss_param_),
         ellipsoid_1_param_block,
         ellipsoid_2_param_block);
@@ -238,6 +239,8 @@ class IndependentEllipsoidsLongTermObjectMapFactorCreator
       factor_entry.covariance_ = ltm_entry.second;
       factor_entry.obj_map_est_ =
           map_ellipsoid_ests.ellipsoids_[factor_entry.obj_id_].second;
+      factors_by_object_[factor_entry.obj_id_].emplace_back(
+          kLongTermMapFactorTypeId, next_feature_factor_id);
       factor_data_[kLongTermMapFactorTypeId][next_feature_factor_id++] =
           factor_entry;
     }
@@ -248,15 +251,16 @@ class IndependentEllipsoidsLongTermObjectMapFactorCreator
       util::BoostHashMap<std::pair<FactorType, FeatureFactorId>,
                          std::unordered_set<ObjectId>> &ltm_factors)
       const override {
-    for (const auto &factor_entry : factor_data_) {
-      FactorType factor_type = factor_entry.first;
-      for (const auto &feature_entry : factor_entry.second) {
-        if (objects_to_include.find(feature_entry.second.obj_id_) !=
-            objects_to_include.end()) {
-          FeatureFactorId feature_id = feature_entry.first;
-          ltm_factors[std::make_pair(factor_type, feature_id)] = {
-              feature_entry.second.obj_id_};
-        }
+    // Look up by object, since the map can have many more objects than are
+    // being optimized
+    for (const ObjectId &object_id : objects_to_include) {
+      auto factors_for_obj_it = factors_by_object_.find(object_id);
+      if (factors_for_obj_it == factors_by_object_.end()) {
+        continue;
+      }
+      for (const std::pair<FactorType, FeatureFactorId> &factor :
+           factors_for_obj_it->second) {
+        ltm_factors[factor] = {object_id};
       }
     }
     return true;
@@ -284,9 +288,9 @@ class IndependentEllipsoidsLongTermObjectMapFactorCreator
                  << " when creating residual.";
       return false;
     }
-    std::unordered_map<FeatureFactorId,
-                       IndependentEllipsoidsLongTermMapFactorData>
-        features_for_factor_type = factor_data_.at(factor_info.first);
+    const std::unordered_map<FeatureFactorId,
+                             IndependentEllipsoidsLongTermMapFactorData>
+        &features_for_factor_type = factor_data_.at(factor_info.first);
     if (features_for_factor_type.find(factor_info.second) ==
         features_for_factor_type.end()) {
       LOG(ERROR) << "Could not find feature id " << factor_info.second
@@ -294,7 +298,7 @@ class IndependentEllipsoidsLongTermObjectMapFactorCreator
                  << " when creating residual.";
       return false;
     }
-    IndependentEllipsoidsLongTermMapFactorData factor_entry =
+    const IndependentEllipsoidsLongTermMapFactorData &factor_entry =
         features_for_factor_type.at(factor_info.second);
 
     if (!cached_info_creator(factor_info, pose_graph, cached_info)) {
@@ -315,7 +319,7 @@ class IndependentEllipsoidsLongTermObjectMapFactorCreator
     residual_id = problem->AddResidualBlock(
         IndependentObjectMapFactor::createIndependentObjectMapFactor(
             factor_entry.obj_map_est_, factor_entry.covariance_),
-        new ceres::HuberLoss(
+        LossFunctionPool::getInstance().getHuberLoss(
             residual_params.long_term_map_params_.pair_huber_loss_param_),
         ellipsoid_param_block);
     return true;
@@ -330,9 +334,9 @@ class IndependentEllipsoidsLongTermObjectMapFactorCreator
                  << " when creating residual.";
       return false;
     }
-    std::unordered_map<FeatureFactorId,
-                       IndependentEllipsoidsLongTermMapFactorData>
-        features_for_factor_type = factor_data_.at(factor_type);
+    const std::unordered_map<FeatureFactorId,
+                             IndependentEllipsoidsLongTermMapFactorData>
+        &features_for_factor_type = factor_data_.at(factor_type);
     if (features_for_factor_type.find(factor_id) ==
         features_for_factor_type.end()) {
       LOG(ERROR) << "Could not find feature id " << factor_id
@@ -340,9 +344,7 @@ class IndependentEllipsoidsLongTermObjectMapFactorCreator
                  << " when creating residual.";
       return false;
     }
-    IndependentEllipsoidsLongTermMapFactorData factor_entry =
-        features_for_factor_type.at(factor_id);
-    object_ids.insert(factor_entry.obj_id_);
+    object_ids.insert(features_for_factor_type.at(factor_id).obj_id_);
     return true;
   }
 
@@ -352,6 +354,13 @@ class IndependentEllipsoidsLongTermObjectMapFactorCreator
       std::unordered_map<FeatureFactorId,
                          IndependentEllipsoidsLongTermMapFactorData>>
       factor_data_;
+
+  /**
+   * Factors in factor_data_ for each object.
+   */
+  std::unordered_map<ObjectId,
+                     std::vector<std::pair<FactorType, FeatureFactorId>>>
+      factors_by_object_;
 };
 
 }  // namespace vslam_types_refactor
@@ -0,0 +1,220 @@
+//
+// Created by amanda on 3/16/23.
+//
+
+#ifndef UT_VSLAM_LONG_TERM_MAP_TILES_H
+#define UT_VSLAM_LONG_TERM_MAP_TILES_H
+
+#include <base_lib/basic_utils.h>
+#include <glog/logging.h>
+#include <refactoring/output_problem_data.h>
+#include <refactoring/types/vslam_obj_opt_types_refactor.h>
+
+#include <cmath>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+/**
+ * Controls which long-term map objects are kept in the pose graph when the
+ * long-term map is split into tiles.
+ */
+struct LongTermMapTilingParams {
+  /**
+   * Side length (in the x-y plane) of the square tiles.
+   */
+  double tile_size_ = 25.0;
+
+  /**
+   * Objects in tiles that come within this distance of the robot are added to
+   * the pose graph.
+   */
+  double load_radius_ = 50.0;
+
+  /**
+   * Objects that haven't been observed this session are removed from the pose
+   * graph once no tile within this distance of the robot contains them. Should
+   * be larger than the load radius so that objects don't get added and removed
+   * repeatedly near the boundary.
+   */
+  double unload_radius_ = 75.0;
+
+  bool operator==(const LongTermMapTilingParams &rhs) const {
+    return (tile_size_ == rhs.tile_size_) &&
+           (load_radius_ == rhs.load_radius_) &&
+           (unload_radius_ == rhs.unload_radius_);
+  }
+
+  bool operator!=(const LongTermMapTilingParams &rhs) const {
+    return !operator==(rhs);
+  }
+};
+
+/**
+ * Long-term map objects grouped into square tiles in the x-y plane, so that
+ * only the objects near the robot need to be in the pose graph. Objects from
+ * the long-term map that are far from the trajectory are then not considered
+ * by the front end or the optimizer.
+ *
+ * Objects that have been observed in the current session are never removed
+ * from the pose graph, since their observation factors refer to them. Merges
+ * always keep the long-term map object, so a long-term map object is only
+ * missing from the pose graph if it was never added or was removed here.
+ */
+class TiledLongTermMapObjects {
+ public:
+  using TileKey = std::pair<int64_t, int64_t>;
+
+  /**
+   * Constructor.
+   *
+   * @param map_objects Estimates (and semantic classes) of the long-term map
+   *                    objects.
+   * @param params      Tile size and load/unload radii.
+   */
+  TiledLongTermMapObjects(const EllipsoidResults &map_objects,
+                          const LongTermMapTilingParams &params)
+      : params_(params), max_map_object_id_(0) {
+    CHECK_GT(params_.tile_size_, 0);
+    for (const auto &map_object : map_objects.ellipsoids_) {
+      const ObjectId &object_id = map_object.first;
+      const Position3d<double> &object_position =
+          map_object.second.second.pose_.transl_;
+      map_objects_[object_id] =
+          std::make_pair(map_object.second.first,
+                         convertToRawEllipsoid(map_object.second.second));
+      objects_by_tile_[getTileForPosition(object_position)].emplace_back(
+          object_id);
+      max_map_object_id_ = std::max(max_map_object_id_, object_id);
+    }
+  }
+
+  TileKey getTileForPosition(const Position3d<double> &position) const {
+    return std::make_pair(
+        (int64_t)std::floor(position.x() / params_.tile_size_),
+        (int64_t)std::floor(position.y() / params_.tile_size_));
+  }
+
+  /**
+   * Get the long-term map objects in all tiles that come within the given
+   * distance (in the x-y plane) of the position.
+   *
+   * @param position        Position to find objects near.
+   * @param radius          Distance from the position that a tile must come
+   *                        within for its objects to be included.
+   * @param nearby_objects  Ids of the objects in the tiles near the position.
+   */
+  void getObjectsInTilesNear(
+      const Position3d<double> &position,
+      const double &radius,
+      std::unordered_set<ObjectId> &nearby_objects) const {
+    TileKey min_tile = getTileForPosition(
+        position - Position3d<double>(radius, radius, 0));
+    TileKey max_tile = getTileForPosition(
+        position + Position3d<double>(radius, radius, 0));
+    for (int64_t tile_x = min_tile.first; tile_x <= max_tile.first; tile_x++) {
+      for (int64_t tile_y = min_tile.second; tile_y <= max_tile.second;
+           tile_y++) {
+        auto tile_it = objects_by_tile_.find(std::make_pair(tile_x, tile_y));
+        if (tile_it == objects_by_tile_.end()) {
+          continue;
+        }
+        // Distance from the position to the closest point in the tile
+        double dist_x = std::max({tile_x * params_.tile_size_ - position.x(),
+                                  0.0,
+                                  position.x() - (tile_x + 1) *
+                                                     params_.tile_size_});
+        double dist_y = std::max({tile_y * params_.tile_size_ - position.y(),
+                                  0.0,
+                                  position.y() - (tile_y + 1) *
+                                                     params_.tile_size_});
+        if ((dist_x * dist_x + dist_y * dist_y) <= (radius * radius)) {
+          nearby_objects.insert(tile_it->second.begin(), tile_it->second.end());
+        }
+      }
+    }
+  }
+
+  /**
+   * Add the long-term map objects near the robot to the pose graph and remove
+   * the unobserved ones that are no longer near it.
+   *
+   * @param robot_position  Current position of the robot.
+   * @param pose_graph      Pose graph to update.
+   */
+  template <typename PoseGraphType>
+  void updateWorkingSet(
+      const Position3d<double> &robot_position,
+      const std::shared_ptr<PoseGraphType> &pose_graph) const {
+    // New objects must not take the ids of map objects that aren't loaded yet.
+    // This is repeated for every update so that it also holds for pose graphs
+    // restored from a checkpoint.
+    pose_graph->reserveObjectIdsThrough(max_map_object_id_);
+
+    std::unordered_set<ObjectId> objects_to_keep;
+    getObjectsInTilesNear(
+        robot_position, params_.unload_radius_, objects_to_keep);
+    std::unordered_set<ObjectId> loaded_objects;
+    pose_graph->getLongTermMapObjects(loaded_objects);
+    size_t num_removed = 0;
+    for (const ObjectId &loaded_object : loaded_objects) {
+      if ((map_objects_.find(loaded_object) != map_objects_.end()) &&
+          (objects_to_keep.find(loaded_object) == objects_to_keep.end())) {
+        if (pose_graph->removeUnobservedLongTermMapObject(loaded_object)) {
+          num_removed++;
+        }
+      }
+    }
+
+    std::unordered_set<ObjectId> objects_to_load;
+    getObjectsInTilesNear(
+        robot_position, params_.load_radius_, objects_to_load);
+    size_t num_added = 0;
+    for (const ObjectId &object_to_load : objects_to_load) {
+      const std::pair<std::string, RawEllipsoid<double>> &map_object =
+          map_objects_.at(object_to_load);
+      if (pose_graph->addLongTermMapObject(
+              object_to_load, map_object.first, map_object.second)) {
+        num_added++;
+      }
+    }
+    if ((num_added > 0) || (num_removed > 0)) {
+      LOG(INFO) << "Added " << num_added << " and removed " << num_removed
+                << " long-term map objects from the pose graph";
+    }
+  }
+
+  /**
+   * Add all long-term map objects that aren't in the pose graph (e.g. before
+   * extracting the next long-term map, which should contain all of them).
+   *
+   * @param pose_graph  Pose graph to add the objects to.
+   */
+  template <typename PoseGraphType>
+  void loadAllObjects(const std::shared_ptr<PoseGraphType> &pose_graph) const {
+    pose_graph->reserveObjectIdsThrough(max_map_object_id_);
+    for (const auto &map_object : map_objects_) {
+      pose_graph->addLongTermMapObject(
+          map_object.first, map_object.second.first, map_object.second.second);
+    }
+  }
+
+  size_t getNumTiles() const { return objects_by_tile_.size(); }
+
+  ObjectId getMaxMapObjectId() const { return max_map_object_id_; }
+
+ private:
+  LongTermMapTilingParams params_;
+
+  ObjectId max_map_object_id_;
+
+  std::unordered_map<ObjectId, std::pair<std::string, RawEllipsoid<double>>>
+      map_objects_;
+
+  util::BoostHashMap<TileKey, std::vector<ObjectId>> objects_by_tile_;
+};
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_LONG_TERM_MAP_TILES_H
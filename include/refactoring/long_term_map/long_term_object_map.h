@@ -65,6 +65,24 @@ class AbsLongTermObjectMap {
     front_end_data = front_end_map_data_;
   }
 
+  /**
+   * Set the number of consecutive sessions (ending with the one that produced
+   * this map) in which each object was not observed. Objects without an entry
+   * were observed in the most recent session.
+   *
+   * @param unobserved_session_counts Unobserved session count by object id.
+   */
+  virtual void setUnobservedSessionCounts(
+      const std::unordered_map<ObjectId, uint64_t> &unobserved_session_counts) {
+    unobserved_session_counts_ = unobserved_session_counts;
+  }
+
+  virtual void getUnobservedSessionCounts(
+      std::unordered_map<ObjectId, uint64_t> &unobserved_session_counts)
+      const {
+    unobserved_session_counts = unobserved_session_counts_;
+  }
+
  private:
   // Long term map has
   // -- Set of ellipsoids (ids, semantic class, pose, dimensions)
@@ -76,6 +94,8 @@ class AbsLongTermObjectMap {
   EllipsoidResults prev_traj_est_ellipsoids_;
 
   std::unordered_map<ObjectId, FrontEndObjMapData> front_end_map_data_;
+
+  std::unordered_map<ObjectId, uint64_t> unobserved_session_counts_;
 };
 
 template <typename FrontEndObjMapData>
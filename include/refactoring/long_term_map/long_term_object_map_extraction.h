@@ -10,6 +10,7 @@
 #include <refactoring/long_term_map/long_term_map_extraction_tunable_params.h>
 #include <refactoring/long_term_map/long_term_object_map.h>
 #include <refactoring/optimization/jacobian_extraction.h>
+#include <refactoring/optimization/loss_function_pool.h>
 #include <refactoring/optimization/object_pose_graph.h>
 #include <refactoring/optimization/object_pose_graph_optimizer.h>
 #include <refactoring/output_problem_data_extraction.h>
@@ -255,7 +256,11 @@ class PairwiseCovarianceLongTermObjectMapExtractor {
 
     std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> pose_graph_copy =
         pose_graph->makeDeepCopy();
-    ceres::Problem problem_for_ltm;
+    ceres::Problem::Options ltm_problem_options =
+        createProblemOptionsForPooledLossFunctions();
+    ltm_problem_options.evaluation_callback =
+        pose_graph_copy->getRobotPoseTransformCache().get();
+    ceres::Problem problem_for_ltm(ltm_problem_options);
 
     std::vector<ObjectId> object_ids;
     for (const auto &object_id_est_pair :
@@ -450,7 +455,11 @@ class IndependentEllipsoidsLongTermObjectMapExtractor {
     extractEllipsoidEstimates(pose_graph, prev_run_ellipsoid_results);
     std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> pose_graph_copy =
         pose_graph->makeDeepCopy();
-    ceres::Problem problem_for_ltm;
+    ceres::Problem::Options ltm_problem_options =
+        createProblemOptionsForPooledLossFunctions();
+    ltm_problem_options.evaluation_callback =
+        pose_graph_copy->getRobotPoseTransformCache().get();
+    ceres::Problem problem_for_ltm(ltm_problem_options);
     std::vector<ObjectId> object_ids;
     for (const auto &object_id_est_pair :
          prev_run_ellipsoid_results.ellipsoids_) {
@@ -0,0 +1,346 @@
+//
+// Created by amanda on 3/19/23.
+//
+
+#ifndef UT_VSLAM_KEYFRAME_SELECTION_H
+#define UT_VSLAM_KEYFRAME_SELECTION_H
+
+#include <glog/logging.h>
+#include <refactoring/offline/offline_problem_data.h>
+#include <refactoring/offline/pipelined_frame_feature_loader.h>
+#include <refactoring/types/vslam_types_math_util.h>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+struct KeyframeSelectionParams {
+  /**
+   * A frame becomes a keyframe if it has moved more than this (m) since the
+   * last keyframe.
+   */
+  double max_pose_inc_threshold_transl_ = 0.2;
+
+  /**
+   * A frame becomes a keyframe if it has rotated more than this (rad) since
+   * the last keyframe.
+   */
+  double max_pose_inc_threshold_rot_ = 0.1;
+
+  /**
+   * A frame becomes a keyframe if the median pixel displacement of the
+   * features it shares with the last keyframe (in the same camera) exceeds
+   * this. Non-positive disables this check.
+   */
+  double max_median_feature_parallax_ = 0;
+
+  /**
+   * A frame becomes a keyframe if it observes less than this fraction of the
+   * features observed in the last keyframe, so that feature tracks aren't cut
+   * off by skipped frames. Non-positive disables this check.
+   */
+  double min_tracked_feature_fraction_ = 0;
+
+  /**
+   * If true, a frame becomes a keyframe if it has more detections of any
+   * semantic class than the last keyframe (likely a newly visible object).
+   */
+  bool keyframe_on_new_detections_ = false;
+
+  bool operator==(const KeyframeSelectionParams &rhs) const {
+    return (max_pose_inc_threshold_transl_ ==
+            rhs.max_pose_inc_threshold_transl_) &&
+           (max_pose_inc_threshold_rot_ == rhs.max_pose_inc_threshold_rot_) &&
+           (max_median_feature_parallax_ ==
+            rhs.max_median_feature_parallax_) &&
+           (min_tracked_feature_fraction_ ==
+            rhs.min_tracked_feature_fraction_) &&
+           (keyframe_on_new_detections_ == rhs.keyframe_on_new_detections_);
+  }
+
+  bool operator!=(const KeyframeSelectionParams &rhs) const {
+    return !operator==(rhs);
+  }
+};
+
+/**
+ * Decides, one frame at a time and in order, whether each frame adds enough
+ * to be a node in the pose graph. Uses the same pose increment thresholds as
+ * the trajectory sparsifier, plus feature parallax and detection novelty.
+ */
+class KeyframeSelector {
+ public:
+  explicit KeyframeSelector(const KeyframeSelectionParams &params)
+      : params_(params) {}
+
+  /**
+   * Decide if the frame should be a keyframe. If it is, it becomes the frame
+   * that later frames are compared to. The first frame is always a keyframe.
+   *
+   * @param robot_pose          Initial estimate of the robot pose at the
+   *                            frame.
+   * @param feature_obs         Low level feature observations in the frame.
+   * @param detection_classes   Semantic classes of the bounding boxes
+   *                            detected in the frame (if known before the
+   *                            frame is processed).
+   *
+   * @return True if the frame is a keyframe.
+   */
+  bool considerFrame(
+      const Pose3D<double> &robot_pose,
+      const FrameFeatureObservations &feature_obs,
+      const std::optional<std::vector<std::string>> &detection_classes) {
+    std::unordered_map<std::string, size_t> detection_counts;
+    if (detection_classes.has_value()) {
+      for (const std::string &detection_class : detection_classes.value()) {
+        detection_counts[detection_class]++;
+      }
+    }
+
+    if (last_keyframe_pose_.has_value() &&
+        !isKeyframe(robot_pose, feature_obs, detection_counts)) {
+      return false;
+    }
+    last_keyframe_pose_ = robot_pose;
+    last_keyframe_feature_obs_ = feature_obs;
+    last_keyframe_detection_counts_ = detection_counts;
+    return true;
+  }
+
+ private:
+  KeyframeSelectionParams params_;
+
+  std::optional<Pose3D<double>> last_keyframe_pose_;
+
+  FrameFeatureObservations last_keyframe_feature_obs_;
+
+  std::unordered_map<std::string, size_t> last_keyframe_detection_counts_;
+
+  bool isKeyframe(
+      const Pose3D<double> &robot_pose,
+      const FrameFeatureObservations &feature_obs,
+      const std::unordered_map<std::string, size_t> &detection_counts) const {
+    Pose3D<double> relative_since_last_keyframe =
+        getPose2RelativeToPose1(last_keyframe_pose_.value(), robot_pose);
+    if ((relative_since_last_keyframe.transl_.norm() >
+         params_.max_pose_inc_threshold_transl_) ||
+        (relative_since_last_keyframe.orientation_.angle() >
+         params_.max_pose_inc_threshold_rot_)) {
+      return true;
+    }
+
+    if (params_.keyframe_on_new_detections_) {
+      for (const auto &class_and_count : detection_counts) {
+        auto last_count_it =
+            last_keyframe_detection_counts_.find(class_and_count.first);
+        if ((last_count_it == last_keyframe_detection_counts_.end()) ||
+            (last_count_it->second < class_and_count.second)) {
+          return true;
+        }
+      }
+    }
+
+    std::unordered_set<FeatureId> last_keyframe_features;
+    std::unordered_set<FeatureId> tracked_features;
+    std::vector<double> parallaxes;
+    for (const auto &cam_and_last_obs : last_keyframe_feature_obs_) {
+      auto cam_obs_it = feature_obs.find(cam_and_last_obs.first);
+      for (const auto &last_obs : cam_and_last_obs.second) {
+        last_keyframe_features.insert(last_obs.first);
+        if (cam_obs_it == feature_obs.end()) {
+          continue;
+        }
+        auto obs_it = cam_obs_it->second.find(last_obs.first);
+        if (obs_it != cam_obs_it->second.end()) {
+          tracked_features.insert(last_obs.first);
+          parallaxes.emplace_back((obs_it->second - last_obs.second).norm());
+        }
+      }
+    }
+
+    if ((params_.min_tracked_feature_fraction_ > 0) &&
+        (!last_keyframe_features.empty()) &&
+        (tracked_features.size() <
+         params_.min_tracked_feature_fraction_ *
+             last_keyframe_features.size())) {
+      return true;
+    }
+    if ((params_.max_median_feature_parallax_ > 0) && (!parallaxes.empty())) {
+      std::nth_element(parallaxes.begin(),
+                       parallaxes.begin() + parallaxes.size() / 2,
+                       parallaxes.end());
+      if (parallaxes[parallaxes.size() / 2] >
+          params_.max_median_feature_parallax_) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+/**
+ * Mapping between the frames of the input data and the (contiguous) frame ids
+ * of the keyframes.
+ */
+struct KeyframeMapping {
+  /**
+   * Keyframe id by the input frame id, only for frames that are keyframes.
+   */
+  std::unordered_map<FrameId, FrameId> keyframe_for_input_frame_;
+
+  /**
+   * Input frame id of each keyframe, indexed by keyframe id.
+   */
+  std::vector<FrameId> input_frame_for_keyframe_;
+};
+
+/**
+ * Run the keyframe selector over all frames with pose estimates, in order.
+ * The first and last frames are always keyframes.
+ *
+ * @param params          Keyframe selection parameters.
+ * @param robot_poses     Initial robot pose estimates by input frame id.
+ * @param visual_features Feature tracks (by input frame id).
+ * @param bounding_boxes  Precomputed bounding boxes by input frame id. Only
+ *                        used for detection novelty; may be empty.
+ *
+ * @return Mapping between the input frames and the keyframes. Empty if there
+ * are no robot poses.
+ */
+inline KeyframeMapping selectKeyframes(
+    const KeyframeSelectionParams &params,
+    const std::unordered_map<FrameId, Pose3D<double>> &robot_poses,
+    const std::unordered_map<FeatureId, StructuredVisionFeatureTrack>
+        &visual_features,
+    const std::unordered_map<
+        FrameId,
+        std::unordered_map<CameraId, std::vector<RawBoundingBox>>>
+        &bounding_boxes) {
+  if (robot_poses.empty()) {
+    return KeyframeMapping();
+  }
+
+  std::unordered_map<FrameId, FrameFeatureObservations> feature_obs_by_frame;
+  for (const auto &feature_and_track : visual_features) {
+    for (const auto &frame_and_obs :
+         feature_and_track.second.feature_track.feature_observations_) {
+      for (const auto &cam_and_pixel :
+           frame_and_obs.second.pixel_by_camera_id) {
+        feature_obs_by_frame[frame_and_obs.first][cam_and_pixel.first]
+                            [feature_and_track.first] = cam_and_pixel.second;
+      }
+    }
+  }
+
+  std::map<FrameId, Pose3D<double>> ordered_robot_poses(robot_poses.begin(),
+                                                        robot_poses.end());
+  KeyframeSelector selector(params);
+  KeyframeMapping mapping;
+  const FrameId last_frame = ordered_robot_poses.rbegin()->first;
+  for (const auto &frame_and_pose : ordered_robot_poses) {
+    const FrameId &frame_id = frame_and_pose.first;
+    std::optional<std::vector<std::string>> detection_classes;
+    auto bbs_it = bounding_boxes.find(frame_id);
+    if (bbs_it != bounding_boxes.end()) {
+      detection_classes = std::vector<std::string>();
+      for (const auto &cam_and_bbs : bbs_it->second) {
+        for (const RawBoundingBox &bb : cam_and_bbs.second) {
+          detection_classes->emplace_back(bb.semantic_class_);
+        }
+      }
+    }
+    auto feature_obs_it = feature_obs_by_frame.find(frame_id);
+    bool is_keyframe = selector.considerFrame(
+        frame_and_pose.second,
+        (feature_obs_it == feature_obs_by_frame.end())
+            ? FrameFeatureObservations()
+            : feature_obs_it->second,
+        detection_classes);
+    if (is_keyframe || (frame_id == last_frame)) {
+      mapping.keyframe_for_input_frame_[frame_id] =
+          mapping.input_frame_for_keyframe_.size();
+      mapping.input_frame_for_keyframe_.emplace_back(frame_id);
+    }
+  }
+  LOG(INFO) << "Selected " << mapping.input_frame_for_keyframe_.size()
+            << " keyframes out of " << robot_poses.size() << " frames";
+  return mapping;
+}
+
+/**
+ * Keep only the keyframe entries of data keyed by input frame id, keyed by
+ * keyframe id instead.
+ */
+template <typename DataType>
+std::unordered_map<FrameId, DataType> remapToKeyframes(
+    const std::unordered_map<FrameId, DataType> &data_by_input_frame,
+    const KeyframeMapping &mapping) {
+  std::unordered_map<FrameId, DataType> data_by_keyframe;
+  for (const auto &frame_and_data : data_by_input_frame) {
+    auto keyframe_it =
+        mapping.keyframe_for_input_frame_.find(frame_and_data.first);
+    if (keyframe_it != mapping.keyframe_for_input_frame_.end()) {
+      data_by_keyframe[keyframe_it->second] = frame_and_data.second;
+    }
+  }
+  return data_by_keyframe;
+}
+
+/**
+ * Key data by input frame id instead of keyframe id.
+ */
+template <typename DataType>
+std::unordered_map<FrameId, DataType> remapToInputFrames(
+    const std::unordered_map<FrameId, DataType> &data_by_keyframe,
+    const KeyframeMapping &mapping) {
+  std::unordered_map<FrameId, DataType> data_by_input_frame;
+  for (const auto &keyframe_and_data : data_by_keyframe) {
+    data_by_input_frame[mapping.input_frame_for_keyframe_.at(
+        keyframe_and_data.first)] = keyframe_and_data.second;
+  }
+  return data_by_input_frame;
+}
+
+/**
+ * Keep only the keyframe observations in the feature tracks (with keyframe
+ * ids). Pixel observations from skipped frames can't be attached to another
+ * pose, so they are dropped, as are tracks with no keyframe observations.
+ */
+inline std::unordered_map<FeatureId, StructuredVisionFeatureTrack>
+remapFeatureTracksToKeyframes(
+    const std::unordered_map<FeatureId, StructuredVisionFeatureTrack>
+        &visual_features,
+    const KeyframeMapping &mapping) {
+  std::unordered_map<FeatureId, StructuredVisionFeatureTrack>
+      keyframe_visual_features;
+  for (const auto &feature_and_track : visual_features) {
+    VisionFeatureTrack keyframe_track(
+        feature_and_track.second.feature_track.feature_id_);
+    for (const auto &frame_and_obs :
+         feature_and_track.second.feature_track.feature_observations_) {
+      auto keyframe_it =
+          mapping.keyframe_for_input_frame_.find(frame_and_obs.first);
+      if (keyframe_it == mapping.keyframe_for_input_frame_.end()) {
+        continue;
+      }
+      keyframe_track.feature_observations_.emplace(
+          keyframe_it->second,
+          VisionFeature(keyframe_it->second,
+                        frame_and_obs.second.pixel_by_camera_id,
+                        frame_and_obs.second.primary_camera_id));
+    }
+    if (!keyframe_track.feature_observations_.empty()) {
+      keyframe_visual_features[feature_and_track.first] =
+          StructuredVisionFeatureTrack(feature_and_track.second.feature_pos_,
+                                       keyframe_track);
+    }
+  }
+  return keyframe_visual_features;
+}
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_KEYFRAME_SELECTION_H
@@ -9,6 +9,8 @@
 #include <analysis/cumulative_timer_factory.h>
 #include <ceres/problem.h>
 #include <refactoring/offline/limit_trajectory_evaluation_params.h>
+#include <refactoring/offline/session_end_merge_params.h>
+#include <refactoring/optimization/loss_function_pool.h>
 #include <refactoring/optimization/object_pose_graph.h>
 #include <refactoring/optimization/object_pose_graph_optimizer.h>
 #include <refactoring/optimization/pose_graph_plus_objects_optimizer.h>
@@ -78,9 +80,15 @@ class OfflineProblemRunner {
                                const int &)> &visualization_callback,
       const std::function<pose_graph_optimization::OptimizationIterationParams(
           const FrameId &)> &iteration_params_provider_func,
-      const std::function<bool(const std::shared_ptr<PoseGraphType> &)>
-          object_merger,
-      const std::function<bool(const FrameId &)> &gba_checker)
+      const std::function<bool(const std::shared_ptr<PoseGraphType> &,
+                               std::unordered_set<ObjectId> &)> object_merger,
+      const std::function<bool(const FrameId &)> &gba_checker,
+      const std::function<void(const InputProblemData &,
+                               const std::shared_ptr<PoseGraphType> &,
+                               const FrameId &)> &frame_completed_callback =
+          nullptr,
+      const SessionEndMergeParams &session_end_merge_params =
+          SessionEndMergeParams())
       : residual_params_(residual_params),
         limit_trajectory_eval_params_(limit_trajectory_eval_params),
         pgo_solver_params_(pgo_solver_params),
@@ -95,7 +103,9 @@ class OfflineProblemRunner {
         visualization_callback_(visualization_callback),
         iteration_params_provider_func_(iteration_params_provider_func),
         object_merger_(object_merger),
-        gba_checker_(gba_checker) {}
+        gba_checker_(gba_checker),
+        frame_completed_callback_(frame_completed_callback),
+        session_end_merge_params_(session_end_merge_params) {}
 
   bool runOptimization(
       const InputProblemData &problem_data,
@@ -110,10 +120,18 @@ class OfflineProblemRunner {
     if (opt_logger.has_value()) {
       opt_logger->writeOptInfoHeader();
     }
-    ceres::Problem problem;
+    pgo_plus_ellipsoids_problem_.reset();
     LOG(INFO) << "Running pose graph creator";
     pose_graph_creator_(problem_data, pose_graph);
 
+    // Robot pose transforms used by the visual residuals are refreshed once
+    // per evaluation point instead of once per residual
+    ceres::Problem::Options problem_options =
+        createProblemOptionsForPooledLossFunctions();
+    problem_options.evaluation_callback =
+        pose_graph->getRobotPoseTransformCache().get();
+    ceres::Problem problem(problem_options);
+
     if ((start_at_frame == 0) && (add_data_for_starting_frame)) {
       frame_data_adder_(problem_data, pose_graph, 0, 0);
     }
@@ -159,6 +177,7 @@ class OfflineProblemRunner {
     LOG(INFO) << "Ready to run optimization";
 
     FrameId first_frame = std::max((FrameId)1, start_at_frame);
+    FrameTelemetryLogger *frame_telemetry = getFrameTelemetryLogger(opt_logger);
 
     for (FrameId next_frame_id = first_frame; next_frame_id <= max_frame_id;
          next_frame_id++) {
@@ -181,7 +200,13 @@ class OfflineProblemRunner {
       optimization_scope_params.min_frame_id_ = start_opt_with_frame;
       optimization_scope_params.max_frame_id_ = next_frame_id;
 
+      if (frame_telemetry != nullptr) {
+        frame_telemetry->startFrame(next_frame_id);
+      }
+
       if ((next_frame_id != start_at_frame) || (add_data_for_starting_frame)) {
+        FrameTelemetryStageTimer front_end_timer(
+            frame_telemetry, FrameTelemetryStage::FRONT_END);
         frame_data_adder_(
             problem_data, pose_graph, start_opt_with_frame, next_frame_id);
       }
@@ -197,6 +222,15 @@ class OfflineProblemRunner {
                                     problem)) {
         return false;
       }
+      if (frame_completed_callback_) {
+        frame_completed_callback_(problem_data, pose_graph, next_frame_id);
+      }
+      if (frame_telemetry != nullptr) {
+        frame_telemetry->finishFrame();
+      }
+    }
+    if (frame_telemetry != nullptr) {
+      frame_telemetry->flush();
     }
 
     visualization_callback_(problem_data,
@@ -287,10 +321,37 @@ class OfflineProblemRunner {
       const FrameId &)>
       iteration_params_provider_func_;
 
-  std::function<bool(const std::shared_ptr<PoseGraphType> &)> object_merger_;
+  /**
+   * Merges objects in the pose graph (and front end). Returns true if any
+   * objects were merged and outputs the ids of the objects that others were
+   * merged into.
+   */
+  std::function<bool(const std::shared_ptr<PoseGraphType> &,
+                     std::unordered_set<ObjectId> &)>
+      object_merger_;
 
   std::function<bool(const FrameId &)> gba_checker_;
 
+  /**
+   * Called once all data for a frame has been added and optimized (before
+   * session-end post-processing). Everything the runner needs to resume after
+   * this frame is settled at this point, so this is where checkpoints are
+   * taken.
+   */
+  std::function<void(const InputProblemData &,
+                     const std::shared_ptr<PoseGraphType> &,
+                     const FrameId &)>
+      frame_completed_callback_;
+
+  SessionEndMergeParams session_end_merge_params_;
+
+  /**
+   * Pose-graph + object problem kept across global optimizations. Must be
+   * reset when the pose graph is replaced or has objects removed.
+   */
+  PgoPlusEllipsoidsProblem<PoseGraphType, CachedFactorInfo>
+      pgo_plus_ellipsoids_problem_;
+
   bool isConsecutivePosesStable_(
       const std::shared_ptr<PoseGraphType> &pose_graph,
       const FrameId &min_frame_id,
@@ -342,16 +403,22 @@ class OfflineProblemRunner {
       std::optional<vslam_types_refactor::OptimizationLogger> &opt_logger,
       std::shared_ptr<PoseGraphType> &pose_graph,
       ceres::Problem &problem,
-      const int &attempt_num = 0) {
+      const int &attempt_num = 0,
+      const bool &allow_global_ba = true) {
     pose_graph_optimization::OptimizationIterationParams iteration_params =
         iteration_params_provider_func_(next_frame_id);
+    FrameTelemetryLogger *frame_telemetry = getFrameTelemetryLogger(opt_logger);
 
-    visualization_callback_(problem_data,
-                            pose_graph,
-                            start_opt_with_frame,
-                            next_frame_id,
-                            VisualizationTypeEnum::BEFORE_EACH_OPTIMIZATION,
-                            attempt_num);
+    {
+      FrameTelemetryStageTimer visualization_timer(
+          frame_telemetry, FrameTelemetryStage::VISUALIZATION);
+      visualization_callback_(problem_data,
+                              pose_graph,
+                              start_opt_with_frame,
+                              next_frame_id,
+                              VisualizationTypeEnum::BEFORE_EACH_OPTIMIZATION,
+                              attempt_num);
+    }
     std::vector<std::shared_ptr<ceres::IterationCallback>> ceres_callbacks =
         ceres_callback_creator_(
             problem_data, pose_graph, start_opt_with_frame, next_frame_id);
@@ -361,7 +428,7 @@ class OfflineProblemRunner {
           next_frame_id, start_opt_with_frame == 0, false, false);
     }
 
-    bool global_ba = gba_checker_(next_frame_id);
+    bool global_ba = allow_global_ba && gba_checker_(next_frame_id);
 
     bool run_visual_feature_opt = true;
     if (global_ba) {
@@ -392,6 +459,8 @@ class OfflineProblemRunner {
                   .getOrCreateFunctionTimer(gba_timer_name)
                   .get());
 #endif
+          FrameTelemetryStageTimer pgo_timer(
+              frame_telemetry, FrameTelemetryStage::PGO_PLUS_OBJECTS);
           // TODO Need to run 1 iteration of tracking first
           LOG(INFO) << "Running tracking before PGO";
           pose_graph_optimizer::OptimizationScopeParams tracking_params =
@@ -452,8 +521,11 @@ class OfflineProblemRunner {
                                next_frame_id == max_frame_id,
                                opt_logger,
                                pose_graph,
-                               attempt_num != 0);
+                               attempt_num != 0,
+                               &pgo_plus_ellipsoids_problem_);
         }
+        FrameTelemetryStageTimer visualization_timer(
+            frame_telemetry, FrameTelemetryStage::VISUALIZATION);
         visualization_callback_(
             problem_data,
             pose_graph,
@@ -510,6 +582,8 @@ class OfflineProblemRunner {
                   .getOrCreateFunctionTimer(phase_one_build_opt_timer_name)
                   .get());
 #endif
+          FrameTelemetryStageTimer build_timer(
+              frame_telemetry, FrameTelemetryStage::BUILD_OPTIMIZATION);
           current_residual_block_info =
               optimizer_.buildPoseGraphOptimization(optimization_scope_params,
                                                     residual_params_,
@@ -543,6 +617,8 @@ class OfflineProblemRunner {
                   .getOrCreateFunctionTimer(phase_one_solve_invoc)
                   .get());
 #endif
+          FrameTelemetryStageTimer solve_timer(
+              frame_telemetry, FrameTelemetryStage::SOLVE_OPTIMIZATION);
           phase1_optim_success = optimizer_.solveOptimization(
               &problem,
               iteration_params.phase_one_opt_params_,
@@ -557,6 +633,8 @@ class OfflineProblemRunner {
                   .getOrCreateFunctionTimer(phase_one_solve_invoc)
                   .get());
 #endif
+          FrameTelemetryStageTimer solve_timer(
+              frame_telemetry, FrameTelemetryStage::SOLVE_OPTIMIZATION);
           phase1_optim_success = optimizer_.solveOptimization(
               &problem,
               iteration_params.phase_one_opt_params_,
@@ -587,6 +665,8 @@ class OfflineProblemRunner {
                   .getOrCreateFunctionTimer(kTimerNamePostOptResidualCompute)
                   .get());
 #endif
+          FrameTelemetryStageTimer outlier_timer(
+              frame_telemetry, FrameTelemetryStage::OUTLIER_IDENTIFICATION);
           size_t residual_idx = 0;
           for (size_t block_idx = 0; block_idx < residual_block_ids.size();
                ++block_idx) {
@@ -660,6 +740,8 @@ class OfflineProblemRunner {
                       kTimerNameTwoPhaseOptOutlierIdentification)
                   .get());
 #endif
+          FrameTelemetryStageTimer outlier_timer(
+              frame_telemetry, FrameTelemetryStage::OUTLIER_IDENTIFICATION);
           std::unordered_map<
               FactorType,
               std::map<double, ceres::ResidualBlockId, std::greater<double>>>
@@ -724,6 +806,8 @@ class OfflineProblemRunner {
                     .getOrCreateFunctionTimer(phase_two_build_invoc_timer_name)
                     .get());
 #endif
+            FrameTelemetryStageTimer build_timer(
+                frame_telemetry, FrameTelemetryStage::BUILD_OPTIMIZATION);
             optimizer_.buildPoseGraphOptimization(
                 optimization_scope_params,
                 residual_params_,
@@ -751,6 +835,8 @@ class OfflineProblemRunner {
                     .getOrCreateFunctionTimer(phase_two_solve_invoc_timer_name)
                     .get());
 #endif
+            FrameTelemetryStageTimer solve_timer(
+                frame_telemetry, FrameTelemetryStage::SOLVE_OPTIMIZATION);
             if (!optimizer_.solveOptimization(
                     &problem,
                     iteration_params.phase_two_opt_params_,
@@ -782,6 +868,8 @@ class OfflineProblemRunner {
         }
       }
 
+      FrameTelemetryStageTimer visualization_timer(
+          frame_telemetry, FrameTelemetryStage::VISUALIZATION);
       visualization_callback_(problem_data,
                               pose_graph,
                               start_opt_with_frame,
@@ -809,15 +897,98 @@ class OfflineProblemRunner {
             .get());
 #endif
 
-    // Until there are no more objects to merge, check if a merge should be
-    // performed, and then if so, rerun the optimization to update the estimates
+    // Apply all merges first (merging can make further merges possible), so
+    // the estimates only need to be updated once
+    std::unordered_set<ObjectId> merged_into_objects;
+    std::unordered_set<ObjectId> merged_into_objects_for_round;
+    while (object_merger_(pose_graph, merged_into_objects_for_round)) {
+      merged_into_objects.insert(merged_into_objects_for_round.begin(),
+                                 merged_into_objects_for_round.end());
+      merged_into_objects_for_round.clear();
+    }
+    if (merged_into_objects.empty()) {
+      return true;
+    }
+
     int post_process_round = 1;
-    while (object_merger_(pose_graph)) {
-      ceres::Problem merged_problem;
-      optimizer_.clearPastOptimizationData();
+    if (session_end_merge_params_.localize_reoptimization_) {
+      // Objects may have been merged into another object in a later round
+      std::optional<FrameId> first_observing_frame;
+      for (const ObjectId &merged_into_obj : merged_into_objects) {
+        std::vector<ObjectObservationFactor> observation_factors;
+        pose_graph->getObservationFactorsForObjId(merged_into_obj,
+                                                  observation_factors);
+        for (const ObjectObservationFactor &obs_factor : observation_factors) {
+          first_observing_frame =
+              std::min(first_observing_frame.value_or(obs_factor.frame_id_),
+                       obs_factor.frame_id_);
+        }
+      }
 
-      // Rerun optimization
-      if (!runOptimizationIteration(0,
+      if (first_observing_frame.has_value()) {
+        FrameId neighborhood =
+            session_end_merge_params_.reoptimization_frame_neighborhood_;
+        FrameId window_start =
+            (first_observing_frame.value() > neighborhood)
+                ? (first_observing_frame.value() - neighborhood)
+                : 0;
+        // The optimizer only holds the poses at the start of the window
+        // constant, so the window runs to the last frame to keep the poses
+        // after the merged objects' observations connected to the rest of the
+        // trajectory
+        FrameId window_end = max_frame_id;
+        LOG(INFO) << "Re-optimizing frames " << window_start << " to "
+                  << window_end << " after merging into "
+                  << merged_into_objects.size() << " objects";
+
+        std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph>
+            pre_reopt_pose_graph = pose_graph->makeDeepCopy();
+        pose_graph_optimizer::OptimizationScopeParams local_scope_params =
+            optimization_scope_params;
+        local_scope_params.min_frame_id_ = window_start;
+        local_scope_params.max_frame_id_ = window_end;
+
+        ceres::Problem::Options merged_problem_options =
+            createProblemOptionsForPooledLossFunctions();
+        merged_problem_options.evaluation_callback =
+            pose_graph->getRobotPoseTransformCache().get();
+        ceres::Problem merged_problem(merged_problem_options);
+        optimizer_.clearPastOptimizationData();
+        pgo_plus_ellipsoids_problem_.reset();
+        if (!runOptimizationIteration(window_start,
+                                      window_end,
+                                      problem_data,
+                                      optimization_factors_enabled_params,
+                                      local_scope_params,
+                                      max_frame_id,
+                                      opt_logger,
+                                      pose_graph,
+                                      merged_problem,
+                                      post_process_round,
+                                      false)) {
+          return false;
+        }
+        post_process_round++;
+
+        double max_change = getMaxPositionChange(
+            pre_reopt_pose_graph, pose_graph, window_start, window_end);
+        LOG(INFO) << "Max position change from localized re-optimization: "
+                  << max_change;
+        if (max_change <=
+            session_end_merge_params_.full_reoptimization_change_threshold_) {
+          return true;
+        }
+      }
+    }
+
+    ceres::Problem::Options merged_problem_options =
+        createProblemOptionsForPooledLossFunctions();
+    merged_problem_options.evaluation_callback =
+        pose_graph->getRobotPoseTransformCache().get();
+    ceres::Problem merged_problem(merged_problem_options);
+    optimizer_.clearPastOptimizationData();
+    pgo_plus_ellipsoids_problem_.reset();
+    return runOptimizationIteration(0,
                                     max_frame_id,
                                     problem_data,
                                     optimization_factors_enabled_params,
@@ -826,12 +997,49 @@ class OfflineProblemRunner {
                                     opt_logger,
                                     pose_graph,
                                     merged_problem,
-                                    post_process_round)) {
-        return false;
+                                    post_process_round);
+  }
+
+  /**
+   * Get the largest position change of any robot pose (in the given frame
+   * range) or object between two versions of the pose graph.
+   */
+  double getMaxPositionChange(
+      const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph>
+          &original_pose_graph,
+      const std::shared_ptr<PoseGraphType> &updated_pose_graph,
+      const FrameId &min_frame_id,
+      const FrameId &max_frame_id) {
+    double max_change = 0;
+    for (FrameId frame_id = min_frame_id; frame_id <= max_frame_id;
+         frame_id++) {
+      std::optional<RawPose3d<double>> original_pose =
+          original_pose_graph->getRobotPose(frame_id);
+      std::optional<RawPose3d<double>> updated_pose =
+          updated_pose_graph->getRobotPose(frame_id);
+      if (original_pose.has_value() && updated_pose.has_value()) {
+        max_change = std::max(
+            max_change,
+            (updated_pose->topRows(3) - original_pose->topRows(3)).norm());
       }
-      post_process_round++;
     }
-    return true;
+
+    std::unordered_map<ObjectId, std::pair<std::string, RawEllipsoid<double>>>
+        original_objects;
+    std::unordered_map<ObjectId, std::pair<std::string, RawEllipsoid<double>>>
+        updated_objects;
+    original_pose_graph->getObjectEstimates(original_objects);
+    updated_pose_graph->getObjectEstimates(updated_objects);
+    for (const auto &updated_obj : updated_objects) {
+      auto original_obj = original_objects.find(updated_obj.first);
+      if (original_obj != original_objects.end()) {
+        max_change = std::max(max_change,
+                              (updated_obj.second.second.topRows(3) -
+                               original_obj->second.second.topRows(3))
+                                  .norm());
+      }
+    }
+    return max_change;
   }
 };
 }  // namespace vslam_types_refactor
@@ -0,0 +1,243 @@
+//
+// Created by amanda on 3/11/23.
+//
+
+#ifndef UT_VSLAM_PIPELINED_FRAME_FEATURE_LOADER_H
+#define UT_VSLAM_PIPELINED_FRAME_FEATURE_LOADER_H
+
+#include <base_lib/async_work_queue.h>
+#include <base_lib/parallel_utils.h>
+#include <glog/logging.h>
+#include <refactoring/offline/offline_problem_data.h>
+
+#include <future>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+/**
+ * Low level feature observations for a single frame, by camera and then by
+ * feature.
+ */
+using FrameFeatureObservations = std::unordered_map<
+    CameraId,
+    std::unordered_map<FeatureId, PixelCoord<double>>>;
+
+/**
+ * Provides the low level feature observations for each frame, assembling the
+ * observations for upcoming frames in the background while the current frame
+ * is processed.
+ *
+ * On creation, a lightweight index from frame to the feature observations in
+ * that frame is built (in parallel) on a background thread. The per-frame
+ * observation maps are only materialized when requested, with at most
+ * max_frames_in_flight frames after the requested frame assembled ahead of
+ * time by a single background thread.
+ *
+ * Observations should be requested by only one thread.
+ */
+class PipelinedFrameFeatureLoader {
+ public:
+  /**
+   * Create the loader and start indexing the feature tracks.
+   *
+   * @param visual_features       Feature tracks to load observations from.
+   *                              Must outlive the loader and not be modified
+   *                              while it exists.
+   * @param max_frames_in_flight  Maximum number of frames to assemble ahead
+   *                              of the requested frame. If 0, observations
+   *                              are only assembled when requested.
+   * @param num_index_threads     Number of threads to use when indexing the
+   *                              feature tracks. If not positive, the hardware
+   *                              concurrency is used.
+   */
+  PipelinedFrameFeatureLoader(
+      const std::unordered_map<FeatureId, StructuredVisionFeatureTrack>
+          &visual_features,
+      const size_t &max_frames_in_flight,
+      const int &num_index_threads = 0)
+      : visual_features_(visual_features),
+        max_frames_in_flight_(max_frames_in_flight) {
+    std::function<void()> index_builder = [this, num_index_threads]() {
+      buildIndex(num_index_threads);
+    };
+    index_ready_ = std::async(std::launch::async, index_builder).share();
+    if (max_frames_in_flight_ > 0) {
+      assembly_queue_ = std::make_unique<util::AsyncWorkQueue<AssemblyRequest>>(
+          max_frames_in_flight_,
+          util::DROP_NEWEST,
+          [&](AssemblyRequest &request) {
+            request.result_promise_->set_value(
+                assembleObservationsForFrame(request.frame_id_));
+          });
+    }
+  }
+
+  ~PipelinedFrameFeatureLoader() {
+    // Don't let the index thread outlive the index
+    index_ready_.wait();
+  }
+
+  PipelinedFrameFeatureLoader(const PipelinedFrameFeatureLoader &) = delete;
+  PipelinedFrameFeatureLoader &operator=(const PipelinedFrameFeatureLoader &) =
+      delete;
+
+  /**
+   * Get the feature observations for a frame, waiting for them if they are
+   * being assembled in the background and assembling them now otherwise.
+   * Starts assembling the observations for the frames after it.
+   *
+   * @param frame_id                    Frame to get observations for.
+   * @param observations_for_frame[out] Feature observations by camera.
+   *
+   * @return True if there were any observations in the frame.
+   */
+  bool getObservationsForFrame(
+      const FrameId &frame_id,
+      FrameFeatureObservations &observations_for_frame) {
+    index_ready_.wait();
+    auto pending_result = pending_results_.find(frame_id);
+    if (pending_result != pending_results_.end()) {
+      observations_for_frame = pending_result->second.get();
+      pending_results_.erase(pending_result);
+    } else {
+      observations_for_frame = assembleObservationsForFrame(frame_id);
+    }
+
+    // Frames before this one shouldn't be requested again
+    pending_results_.erase(pending_results_.begin(),
+                           pending_results_.lower_bound(frame_id));
+
+    prefetchFramesAfter(frame_id);
+    return !observations_for_frame.empty();
+  }
+
+ private:
+  using FeatureIdAndTrack =
+      std::pair<const FeatureId, StructuredVisionFeatureTrack>;
+  using FeatureObservationRef = std::pair<FeatureId, const VisionFeature *>;
+  using FrameIndex =
+      std::unordered_map<FrameId, std::vector<FeatureObservationRef>>;
+
+  struct AssemblyRequest {
+    FrameId frame_id_;
+    std::shared_ptr<std::promise<FrameFeatureObservations>> result_promise_;
+  };
+
+  const std::unordered_map<FeatureId, StructuredVisionFeatureTrack>
+      &visual_features_;
+  size_t max_frames_in_flight_;
+
+  /**
+   * Index from frame to the observations in it, split into one index per
+   * chunk of feature tracks. Written only by the indexing thread, before
+   * index_ready_ is set.
+   */
+  std::vector<FrameIndex> index_by_chunk_;
+  FrameId max_indexed_frame_id_ = 0;
+  std::shared_future<void> index_ready_;
+
+  /**
+   * Observations for frames that are being assembled but were not yet
+   * requested. Only accessed by the thread requesting observations.
+   */
+  std::map<FrameId, std::shared_future<FrameFeatureObservations>>
+      pending_results_;
+
+  /**
+   * Declared last so that the background thread is stopped before the other
+   * members are destroyed.
+   */
+  std::unique_ptr<util::AsyncWorkQueue<AssemblyRequest>> assembly_queue_;
+
+  void buildIndex(const int &num_index_threads) {
+    std::vector<const FeatureIdAndTrack *> feature_tracks;
+    feature_tracks.reserve(visual_features_.size());
+    for (const auto &feature_track : visual_features_) {
+      feature_tracks.emplace_back(&feature_track);
+    }
+
+    size_t num_chunks =
+        util::getNumWorkerThreads(num_index_threads, feature_tracks.size());
+    size_t tracks_per_chunk = feature_tracks.size() / num_chunks + 1;
+    index_by_chunk_.resize(num_chunks);
+    std::vector<FrameId> max_frame_id_by_chunk(num_chunks, 0);
+    util::parallelFor(
+        num_chunks, (int)num_chunks, [&](const size_t &chunk_num) {
+          size_t end_track =
+              std::min((chunk_num + 1) * tracks_per_chunk,
+                       feature_tracks.size());
+          for (size_t track_num = chunk_num * tracks_per_chunk;
+               track_num < end_track;
+               track_num++) {
+            FeatureId feature_id = feature_tracks[track_num]->first;
+            for (const auto &frame_and_obs :
+                 feature_tracks[track_num]
+                     ->second.feature_track.feature_observations_) {
+              index_by_chunk_[chunk_num][frame_and_obs.first].emplace_back(
+                  feature_id, &(frame_and_obs.second));
+              max_frame_id_by_chunk[chunk_num] = std::max(
+                  max_frame_id_by_chunk[chunk_num], frame_and_obs.first);
+            }
+          }
+        });
+    for (const FrameId &chunk_max_frame_id : max_frame_id_by_chunk) {
+      max_indexed_frame_id_ =
+          std::max(max_indexed_frame_id_, chunk_max_frame_id);
+    }
+  }
+
+  FrameFeatureObservations assembleObservationsForFrame(
+      const FrameId &frame_id) const {
+    FrameFeatureObservations observations_for_frame;
+    for (const FrameIndex &chunk_index : index_by_chunk_) {
+      auto observations_in_chunk = chunk_index.find(frame_id);
+      if (observations_in_chunk == chunk_index.end()) {
+        continue;
+      }
+      for (const FeatureObservationRef &feature_obs :
+           observations_in_chunk->second) {
+        for (const auto &cam_and_pixel :
+             feature_obs.second->pixel_by_camera_id) {
+          observations_for_frame[cam_and_pixel.first][feature_obs.first] =
+              cam_and_pixel.second;
+        }
+      }
+    }
+    return observations_for_frame;
+  }
+
+  void prefetchFramesAfter(const FrameId &frame_id) {
+    if (assembly_queue_ == nullptr) {
+      return;
+    }
+    for (FrameId next_frame = frame_id + 1;
+         (next_frame <= max_indexed_frame_id_) &&
+         (next_frame <= frame_id + max_frames_in_flight_);
+         next_frame++) {
+      if (pending_results_.find(next_frame) != pending_results_.end()) {
+        continue;
+      }
+      if (pending_results_.size() >= max_frames_in_flight_) {
+        return;
+      }
+      AssemblyRequest request;
+      request.frame_id_ = next_frame;
+      request.result_promise_ =
+          std::make_shared<std::promise<FrameFeatureObservations>>();
+      std::shared_future<FrameFeatureObservations> result_future =
+          request.result_promise_->get_future().share();
+      if (!assembly_queue_->push(std::move(request))) {
+        return;
+      }
+      pending_results_[next_frame] = result_future;
+    }
+  }
+};
+
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_PIPELINED_FRAME_FEATURE_LOADER_H
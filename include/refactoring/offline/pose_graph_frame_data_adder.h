@@ -10,6 +10,8 @@
 #include <refactoring/optimization/object_pose_graph.h>
 #include <refactoring/types/vslam_types_math_util.h>
 
+#include <future>
+
 namespace vslam_types_refactor {
 
 template <typename ProblemDataType>
@@ -128,6 +130,17 @@ void addVisualFeatureFactorsForFrame(
 }
 
 // TODO maybe make generic to both types of object pose graphs
+/**
+ * Add the frame, its relative pose factor, and the visual feature and bounding
+ * box observations for the frame to the pose graph.
+ *
+ * If run_front_ends_concurrently is true, the visual feature front end runs on
+ * a separate thread while the bounding box front end runs on this one. The
+ * front ends only add to the feature and object parts of the pose graph,
+ * respectively, and only read frame data that is added before they start (see
+ * ObjAndLowLevelFeaturePoseGraph), so the result is the same as running them
+ * one after the other.
+ */
 template <typename ObjectAssociationInfo,
           typename PendingObjectInfo,
           typename RawBoundingBoxContextInfo,
@@ -169,7 +182,8 @@ void addFrameDataAssociatedBoundingBox(
         const ProblemDataType &)> bb_associator_retriever,
     const std::function<std::pair<bool, RawBoundingBoxContextInfo>(
         const FrameId &, const CameraId &, const ProblemDataType &)>
-        &bb_context_retriever) {
+        &bb_context_retriever,
+    const bool &run_front_ends_concurrently) {
   Pose3D<double> pose_at_frame_init_est;
   if (!input_problem_data.getRobotPoseEstimateForFrame(
           frame_to_add, pose_at_frame_init_est)) {
@@ -227,27 +241,33 @@ void addFrameDataAssociatedBoundingBox(
   //                                 pose_graph,
   //                                 frame_to_add,
   //                                 reprojection_error_provider);
-  visual_feature_frame_data_adder(
-      input_problem_data, pose_graph, min_frame_id, frame_to_add);
+  std::function<void()> visual_feature_stage = [&]() {
+    visual_feature_frame_data_adder(
+        input_problem_data, pose_graph, min_frame_id, frame_to_add);
+  };
 
   // Add bounding box observations
-  std::unordered_map<CameraId, std::vector<RawBoundingBox>>
-      bounding_boxes_for_frame;
-  if (!bb_retriever(frame_to_add, bounding_boxes_for_frame)) {
-    LOG(WARNING) << "Could not get bounding boxes for frame " << frame_to_add;
-    return;
-  }
+  std::function<void()> bounding_box_stage = [&]() {
+    std::unordered_map<CameraId, std::vector<RawBoundingBox>>
+        bounding_boxes_for_frame;
+    if (!bb_retriever(frame_to_add, bounding_boxes_for_frame)) {
+      LOG(WARNING) << "Could not get bounding boxes for frame "
+                   << frame_to_add;
+      return;
+    }
 
-  std::shared_ptr<AbstractBoundingBoxFrontEnd<ReprojectionErrorFactor,
-                                              ObjectAssociationInfo,
-                                              PendingObjectInfo,
-                                              RawBoundingBoxContextInfo,
-                                              RefinedBoundingBoxContextInfo,
-                                              SingleBbContextInfo,
-                                              FrontEndObjMapData>>
-      bb_associator = bb_associator_retriever(pose_graph, input_problem_data);
+    std::shared_ptr<AbstractBoundingBoxFrontEnd<ReprojectionErrorFactor,
+                                                ObjectAssociationInfo,
+                                                PendingObjectInfo,
+                                                RawBoundingBoxContextInfo,
+                                                RefinedBoundingBoxContextInfo,
+                                                SingleBbContextInfo,
+                                                FrontEndObjMapData>>
+        bb_associator =
+            bb_associator_retriever(pose_graph, input_problem_data);
 
-  if (!bounding_boxes_for_frame.empty()) {
+    // Cameras are processed in order because each camera's associations
+    // depend on the objects created and pending from the previous cameras
     for (const auto &cam_id_and_bbs : bounding_boxes_for_frame) {
       std::pair<bool, RawBoundingBoxContextInfo> context = bb_context_retriever(
           frame_to_add, cam_id_and_bbs.first, input_problem_data);
@@ -258,7 +278,19 @@ void addFrameDataAssociatedBoundingBox(
                                                   context.second);
       }
     }
+  };
+
+  if (!run_front_ends_concurrently) {
+    visual_feature_stage();
+    bounding_box_stage();
+    return;
   }
+
+  std::future<void> visual_feature_stage_result =
+      std::async(std::launch::async, visual_feature_stage);
+  bounding_box_stage();
+  // Rethrows anything thrown by the visual feature front end
+  visual_feature_stage_result.get();
 }
 
 }  // namespace vslam_types_refactor
@@ -0,0 +1,52 @@
+//
+// Created by amanda on 3/8/23.
+//
+
+#ifndef UT_VSLAM_SESSION_END_MERGE_PARAMS_H
+#define UT_VSLAM_SESSION_END_MERGE_PARAMS_H
+
+#include <refactoring/types/vslam_basic_types_refactor.h>
+
+namespace vslam_types_refactor {
+/**
+ * Controls the re-optimization after objects are merged at the end of a
+ * session.
+ */
+struct SessionEndMergeParams {
+  /**
+   * If true, after all merges are applied, only the frames from shortly before
+   * the first observation of the merged objects (see the neighborhood below)
+   * to the end of the trajectory are re-optimized. If false, a full global
+   * optimization is run after the merges.
+   */
+  bool localize_reoptimization_ = true;
+
+  /**
+   * Number of frames before the first observation of the merged objects to
+   * include in the localized re-optimization.
+   */
+  FrameId reoptimization_frame_neighborhood_ = 20;
+
+  /**
+   * If the position of any robot pose or object changes by more than this (in
+   * meters) in the localized re-optimization, a full global optimization is
+   * run afterwards.
+   */
+  double full_reoptimization_change_threshold_ = 0.5;
+
+  bool operator==(const SessionEndMergeParams &rhs) const {
+    return (localize_reoptimization_ == rhs.localize_reoptimization_) &&
+           (reoptimization_frame_neighborhood_ ==
+            rhs.reoptimization_frame_neighborhood_) &&
+           (full_reoptimization_change_threshold_ ==
+            rhs.full_reoptimization_change_threshold_);
+  }
+
+  bool operator!=(const SessionEndMergeParams &rhs) const {
+    return !operator==(rhs);
+  }
+};
+
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_SESSION_END_MERGE_PARAMS_H
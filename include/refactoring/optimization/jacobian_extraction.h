@@ -14,11 +14,7 @@
 namespace vslam_types_refactor {
 
 std::pair<std::pair<std::vector<int>, std::vector<int>>, std::vector<int>>
-writeJacobianToFile(const ceres::CRSMatrix &crs_matrix,
-                    const std::string &jacobian_file);
-
-void writeJacobianMatlabFormatToFile(const ceres::CRSMatrix &crs_matrix,
-                                     const std::string &jacobian_file);
+findZeroAndTinyJacobianColumns(const ceres::CRSMatrix &crs_matrix);
 
 void generateGenericFactorInfoForFactor(
     const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> &pose_graph,
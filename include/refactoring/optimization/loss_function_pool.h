@@ -0,0 +1,67 @@
+//
+// Created by amanda on 3/15/23.
+//
+
+#ifndef UT_VSLAM_LOSS_FUNCTION_POOL_H
+#define UT_VSLAM_LOSS_FUNCTION_POOL_H
+
+#include <ceres/loss_function.h>
+#include <ceres/problem.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace vslam_types_refactor {
+
+/**
+ * Loss functions shared by every residual that uses the same loss parameter,
+ * instead of allocating one per residual each time a problem is built. Loss
+ * functions don't hold any per-residual state, so sharing is safe, including
+ * across threads.
+ *
+ * Loss functions from the pool live for the whole process, so problems that
+ * they are added to must not take ownership of them (see
+ * createProblemOptionsForPooledLossFunctions).
+ */
+class LossFunctionPool {
+ protected:
+  LossFunctionPool() = default;
+
+ public:
+  // NOTE: Make sure to keep variables returned by this function passed by
+  // reference so that the singleton pattern holds.
+  static LossFunctionPool &getInstance() {
+    static LossFunctionPool pool_instance;
+    return pool_instance;
+  }
+
+  ceres::LossFunction *getHuberLoss(const double &huber_loss_param) {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    std::unique_ptr<ceres::LossFunction> &huber_loss =
+        huber_losses_by_param_[huber_loss_param];
+    if (huber_loss == nullptr) {
+      huber_loss = std::make_unique<ceres::HuberLoss>(huber_loss_param);
+    }
+    return huber_loss.get();
+  }
+
+ private:
+  std::mutex pool_mutex_;
+  std::map<double, std::unique_ptr<ceres::LossFunction>> huber_losses_by_param_;
+};
+
+/**
+ * Options for a problem that residuals with loss functions from the
+ * LossFunctionPool are added to. Any loss functions added to the problem that
+ * are not from the pool must be freed by the caller.
+ */
+inline ceres::Problem::Options createProblemOptionsForPooledLossFunctions() {
+  ceres::Problem::Options problem_options;
+  problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+  return problem_options;
+}
+
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_LOSS_FUNCTION_POOL_H
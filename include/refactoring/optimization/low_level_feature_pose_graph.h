@@ -5,9 +5,12 @@
 #ifndef UT_VSLAM_LOW_LEVEL_FEATURE_POSE_GRAPH_H
 #define UT_VSLAM_LOW_LEVEL_FEATURE_POSE_GRAPH_H
 
+#include <refactoring/factors/robot_pose_transform_cache.h>
 #include <refactoring/types/vslam_basic_types_refactor.h>
 #include <refactoring/types/vslam_types_conversion.h>
 
+#include <map>
+#include <set>
 #include <unordered_set>
 
 namespace vslam_types_refactor {
@@ -321,15 +324,17 @@ class LowLevelFeaturePoseGraph {
       const FrameId &min_frame_id,
       const FrameId &max_frame_id,
       std::unordered_set<FeatureId> &matching_features) {
-    for (const auto &object_id_and_most_recent_frame :
-         last_observed_frame_by_feature_) {
-      if (object_id_and_most_recent_frame.second >= min_frame_id) {
-        if (first_observed_frame_by_feature_.find(
-                object_id_and_most_recent_frame.first) !=
+    // Only features last observed at or after the min frame can overlap the
+    // window, so start from there and check the first observation of each
+    for (auto last_frame_it =
+             features_by_last_observed_frame_.lower_bound(min_frame_id);
+         last_frame_it != features_by_last_observed_frame_.end();
+         last_frame_it++) {
+      for (const FeatureId &feature_id : last_frame_it->second) {
+        if (first_observed_frame_by_feature_.find(feature_id) !=
             first_observed_frame_by_feature_.end()) {
-          if (first_observed_frame_by_feature_[object_id_and_most_recent_frame
-                                                   .first] <= max_frame_id) {
-            matching_features.insert(object_id_and_most_recent_frame.first);
+          if (first_observed_frame_by_feature_[feature_id] <= max_frame_id) {
+            matching_features.insert(feature_id);
           }
         }
       }
@@ -337,11 +342,19 @@ class LowLevelFeaturePoseGraph {
   }
 
   virtual std::unordered_set<FrameId> getFrameIds() {
-    std::unordered_set<FrameId> frames;
-    for (const auto &frame_and_pose : robot_poses_) {
-      frames.insert(frame_and_pose.first);
+    return std::unordered_set<FrameId>(ordered_frame_ids_.begin(),
+                                       ordered_frame_ids_.end());
+  }
+
+  virtual void getFrameIdsBetweenFrameIdsInclusive(
+      const FrameId &min_frame_id,
+      const FrameId &max_frame_id,
+      std::unordered_set<FrameId> &matching_frames) {
+    if (min_frame_id > max_frame_id) {
+      return;
     }
-    return frames;
+    matching_frames.insert(ordered_frame_ids_.lower_bound(min_frame_id),
+                           ordered_frame_ids_.upper_bound(max_frame_id));
   }
 
   virtual void getVisualFeatureFactorIdsBetweenFrameIdsInclusive(
@@ -349,13 +362,15 @@ class LowLevelFeaturePoseGraph {
       const FrameId &max_frame_id,
       util::BoostHashSet<std::pair<FactorType, FeatureFactorId>>
           &matching_factors) {
-    for (const auto &frame_and_matching_factors :
-         visual_feature_factors_by_frame_) {
-      if ((frame_and_matching_factors.first >= min_frame_id) &&
-          (frame_and_matching_factors.first <= max_frame_id)) {
-        matching_factors.insert(frame_and_matching_factors.second.begin(),
-                                frame_and_matching_factors.second.end());
-      }
+    if (min_frame_id > max_frame_id) {
+      return;
+    }
+    for (auto frame_it =
+             visual_feature_factors_by_frame_.lower_bound(min_frame_id);
+         frame_it != visual_feature_factors_by_frame_.upper_bound(max_frame_id);
+         frame_it++) {
+      matching_factors.insert(frame_it->second.begin(),
+                              frame_it->second.end());
     }
   }
 
@@ -421,6 +436,7 @@ class LowLevelFeaturePoseGraph {
     visual_feature_factors_by_frame_[frame_id] = {};
     RawPose3d<double> raw_pose = convertPoseToArray(initial_pose_estimate);
     robot_poses_[frame_id] = RobotPoseNode(raw_pose);
+    ordered_frame_ids_.insert(frame_id);
   }
 
   virtual FeatureFactorId addVisualFactor(
@@ -443,10 +459,16 @@ class LowLevelFeaturePoseGraph {
 
     FrameId smallest_frame_id = ordered_frame_ids.front();
     FrameId largest_frame_id = ordered_frame_ids.back();
-    if ((last_observed_frame_by_feature_.find(feature_id) ==
-         last_observed_frame_by_feature_.end()) ||
-        (last_observed_frame_by_feature_.at(feature_id) < largest_frame_id)) {
+    if (last_observed_frame_by_feature_.find(feature_id) ==
+        last_observed_frame_by_feature_.end()) {
       last_observed_frame_by_feature_[feature_id] = largest_frame_id;
+      features_by_last_observed_frame_[largest_frame_id].insert(feature_id);
+    } else if (last_observed_frame_by_feature_.at(feature_id) <
+               largest_frame_id) {
+      removeFeatureFromLastObservedFrameIndex(
+          feature_id, last_observed_frame_by_feature_.at(feature_id));
+      last_observed_frame_by_feature_[feature_id] = largest_frame_id;
+      features_by_last_observed_frame_[largest_frame_id].insert(feature_id);
     }
     if ((first_observed_frame_by_feature_.find(feature_id) ==
          first_observed_frame_by_feature_.end()) ||
@@ -483,6 +505,15 @@ class LowLevelFeaturePoseGraph {
     return std::make_pair(min_frame_id_, max_frame_id_);
   }
 
+  /**
+   * Cache of per-frame transforms for the robot pose blocks of this pose
+   * graph. Should be set as the evaluation callback of problems that contain
+   * residuals using it.
+   */
+  std::shared_ptr<RobotPoseTransformCache> getRobotPoseTransformCache() const {
+    return robot_pose_transform_cache_;
+  }
+
   virtual void getVisualFeatureEstimates(
       std::unordered_map<FeatureId, Position3d<double>>
           &visual_feature_estimates) const {}
@@ -519,6 +550,10 @@ class LowLevelFeaturePoseGraph {
   void setRobotPosePtrs(
       const std::unordered_map<FrameId, RobotPoseNode> &robot_poses) {
     robot_poses_ = robot_poses;
+    ordered_frame_ids_.clear();
+    for (const auto &frame_and_pose : robot_poses_) {
+      ordered_frame_ids_.insert(frame_and_pose.first);
+    }
   }
 
   void getRobotPosePtrs(
@@ -539,8 +574,10 @@ class LowLevelFeaturePoseGraph {
     max_feature_factor_id_ = pose_graph_state.max_feature_factor_id_;
     max_pose_factor_id_ = pose_graph_state.max_pose_factor_id_;
     pose_factors_by_frame_ = pose_graph_state.pose_factors_by_frame_;
-    visual_feature_factors_by_frame_ =
-        pose_graph_state.visual_feature_factors_by_frame_;
+    visual_feature_factors_by_frame_.clear();
+    visual_feature_factors_by_frame_.insert(
+        pose_graph_state.visual_feature_factors_by_frame_.begin(),
+        pose_graph_state.visual_feature_factors_by_frame_.end());
     visual_factors_by_feature_ = pose_graph_state.visual_factors_by_feature_;
     pose_factors_ = pose_graph_state.pose_factors_;
     factors_ = pose_graph_state.factors_;
@@ -548,10 +585,16 @@ class LowLevelFeaturePoseGraph {
         pose_graph_state.last_observed_frame_by_feature_;
     first_observed_frame_by_feature_ =
         pose_graph_state.first_observed_frame_by_feature_;
+    features_by_last_observed_frame_.clear();
+    for (const auto &feature_and_last_frame : last_observed_frame_by_feature_) {
+      features_by_last_observed_frame_[feature_and_last_frame.second].insert(
+          feature_and_last_frame.first);
+    }
 
     for (const auto &robot_pose : pose_graph_state.robot_poses_) {
       RawPose3d<double> pose(robot_pose.second);
       robot_poses_[robot_pose.first] = RobotPoseNode(pose);
+      ordered_frame_ids_.insert(robot_pose.first);
     }
   }
 
@@ -567,8 +610,10 @@ class LowLevelFeaturePoseGraph {
     pose_graph_state.max_feature_factor_id_ = max_feature_factor_id_;
     pose_graph_state.max_pose_factor_id_ = max_pose_factor_id_;
     pose_graph_state.pose_factors_by_frame_ = pose_factors_by_frame_;
-    pose_graph_state.visual_feature_factors_by_frame_ =
-        visual_feature_factors_by_frame_;
+    pose_graph_state.visual_feature_factors_by_frame_.clear();
+    pose_graph_state.visual_feature_factors_by_frame_.insert(
+        visual_feature_factors_by_frame_.begin(),
+        visual_feature_factors_by_frame_.end());
     pose_graph_state.visual_factors_by_feature_ = visual_factors_by_feature_;
     pose_graph_state.pose_factors_ = pose_factors_;
     pose_graph_state.factors_ = factors_;
@@ -607,14 +652,23 @@ class LowLevelFeaturePoseGraph {
 
   std::unordered_map<FrameId, RobotPoseNode> robot_poses_;
 
+  std::shared_ptr<RobotPoseTransformCache> robot_pose_transform_cache_ =
+      std::make_shared<RobotPoseTransformCache>();
+
+  /**
+   * Frame ids of robot_poses_, in order, so frame windows can be looked up
+   * without visiting every frame.
+   */
+  std::set<FrameId> ordered_frame_ids_;
+
   std::unordered_map<FrameId,
                      util::BoostHashSet<std::pair<FactorType, FeatureFactorId>>>
       pose_factors_by_frame_;
 
   // For factors involving multiple frames, the value will be stored for each
-  // associated frame id
-  std::unordered_map<FrameId,
-                     std::vector<std::pair<FactorType, FeatureFactorId>>>
+  // associated frame id. Ordered by frame so window queries are
+  // O(log n + window size).
+  std::map<FrameId, std::vector<std::pair<FactorType, FeatureFactorId>>>
       visual_feature_factors_by_frame_;
 
   std::unordered_map<FeatureId,
@@ -629,6 +683,26 @@ class LowLevelFeaturePoseGraph {
   std::unordered_map<FeatureId, FrameId> last_observed_frame_by_feature_;
 
   std::unordered_map<FeatureId, FrameId> first_observed_frame_by_feature_;
+
+  /**
+   * Inverse of last_observed_frame_by_feature_, used to find the features
+   * that could have been observed in a window without checking every feature.
+   */
+  std::map<FrameId, std::unordered_set<FeatureId>>
+      features_by_last_observed_frame_;
+
+  void removeFeatureFromLastObservedFrameIndex(
+      const FeatureId &feature_id, const FrameId &last_observed_frame) {
+    auto last_frame_it =
+        features_by_last_observed_frame_.find(last_observed_frame);
+    if (last_frame_it == features_by_last_observed_frame_.end()) {
+      return;
+    }
+    last_frame_it->second.erase(feature_id);
+    if (last_frame_it->second.empty()) {
+      features_by_last_observed_frame_.erase(last_frame_it);
+    }
+  }
 };
 
 class ReprojectionLowLevelFeaturePoseGraph
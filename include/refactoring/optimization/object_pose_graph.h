@@ -272,6 +272,17 @@ struct ObjectAndReprojectionFeaturePoseGraphState {
 };
 
 // TODO consider making generic to other object representations
+/**
+ * Pose graph with low-level visual features and objects.
+ *
+ * The object methods that add to the graph (addNewEllipsoid,
+ * addObjectObservation, and addShapeDimPriorBasedOnSemanticClass) only modify
+ * members of this class, and the feature methods (addFeature and
+ * addVisualFactor) only modify the feature members of the low-level feature
+ * pose graph. The two sets of methods can be called concurrently (as the
+ * visual feature and bounding box front ends do for a frame), provided that
+ * nothing adds or removes frames, cameras, or pose factors at the same time.
+ */
 template <typename VisualFeatureFactorType>
 class ObjAndLowLevelFeaturePoseGraph
     : public virtual LowLevelFeaturePoseGraph<VisualFeatureFactorType> {
@@ -325,6 +336,78 @@ class ObjAndLowLevelFeaturePoseGraph
     ltm_object_ids = long_term_map_object_ids_;
   }
 
+  /**
+   * Add an object from the long-term map to the pose graph (for long-term
+   * maps whose objects are loaded as the robot gets near them).
+   *
+   * @param object_id       Id of the object in the long-term map.
+   * @param semantic_class  Semantic class of the object.
+   * @param ellipsoid       Map estimate of the object.
+   *
+   * @return True if the object was added, false if an object with the id is
+   * already in the pose graph.
+   */
+  virtual bool addLongTermMapObject(const ObjectId &object_id,
+                                    const std::string &semantic_class,
+                                    const RawEllipsoid<double> &ellipsoid) {
+    if (ellipsoid_estimates_.find(object_id) != ellipsoid_estimates_.end()) {
+      return false;
+    }
+    long_term_map_object_ids_.insert(object_id);
+    max_object_id_ = std::max(max_object_id_, object_id);
+    initializeEllipsoidWithId(
+        EllipsoidEstimateNode(ellipsoid), object_id, semantic_class);
+    return true;
+  }
+
+  /**
+   * Remove a long-term map object that has not been observed in this session
+   * (so nothing but its shape prior refers to it).
+   *
+   * @param object_id Id of the long-term map object to remove.
+   *
+   * @return True if the object was removed, false if it isn't a long-term map
+   * object in the pose graph or has been observed.
+   */
+  virtual bool removeUnobservedLongTermMapObject(const ObjectId &object_id) {
+    if (long_term_map_object_ids_.find(object_id) ==
+        long_term_map_object_ids_.end()) {
+      return false;
+    }
+    auto obs_factors_it = observation_factors_by_object_.find(object_id);
+    if ((obs_factors_it != observation_factors_by_object_.end()) &&
+        (!obs_factors_it->second.empty())) {
+      return false;
+    }
+    auto obj_only_factors_it = object_only_factors_by_object_.find(object_id);
+    if (obj_only_factors_it != object_only_factors_by_object_.end()) {
+      for (const std::pair<FactorType, FeatureFactorId> &obj_only_factor :
+           obj_only_factors_it->second) {
+        if (obj_only_factor.first == kShapeDimPriorFactorTypeId) {
+          shape_dim_prior_factors_.erase(obj_only_factor.second);
+        }
+      }
+      object_only_factors_by_object_.erase(obj_only_factors_it);
+    }
+    observation_factors_by_object_.erase(object_id);
+    ellipsoid_estimates_.erase(object_id);
+    semantic_class_for_object_.erase(object_id);
+    long_term_map_object_ids_.erase(object_id);
+    return true;
+  }
+
+  /**
+   * Make sure new objects get ids larger than the given one (e.g. the ids of
+   * long-term map objects that haven't been added to the pose graph yet).
+   *
+   * @param max_reserved_object_id Largest id that new objects can't use.
+   */
+  void reserveObjectIdsThrough(const ObjectId &max_reserved_object_id) {
+    max_reserved_object_id_ =
+        std::max(max_reserved_object_id_, max_reserved_object_id);
+    max_object_id_ = std::max(max_object_id_, max_reserved_object_id_);
+  }
+
   ObjectId addNewEllipsoid(const ObjectDim<double> &object_dim,
                            const RawPose3d<double> &object_pose,
                            const std::string &semantic_class) {
@@ -383,10 +466,10 @@ class ObjAndLowLevelFeaturePoseGraph
     FrameId frame_id = observation_factor.frame_id_;
     if (last_observed_frame_by_object_.find(object_id) ==
         last_observed_frame_by_object_.end()) {
-      last_observed_frame_by_object_[object_id] = frame_id;
+      setLastObservedFrameForObject(object_id, frame_id);
     } else {
       if (last_observed_frame_by_object_[object_id] < frame_id) {
-        last_observed_frame_by_object_[object_id] = frame_id;
+        setLastObservedFrameForObject(object_id, frame_id);
       }
     }
     if (first_observed_frame_by_object_.find(object_id) ==
@@ -502,15 +585,17 @@ class ObjAndLowLevelFeaturePoseGraph
       const FrameId &min_frame_id,
       const FrameId &max_frame_id,
       std::unordered_set<ObjectId> &matching_objects) {
-    for (const auto &object_id_and_most_recent_frame :
-         last_observed_frame_by_object_) {
-      if (object_id_and_most_recent_frame.second >= min_frame_id) {
-        if (first_observed_frame_by_object_.find(
-                object_id_and_most_recent_frame.first) !=
+    // Only objects last observed at or after the min frame can overlap the
+    // window, so start from there and check the first observation of each
+    for (auto last_frame_it =
+             objects_by_last_observed_frame_.lower_bound(min_frame_id);
+         last_frame_it != objects_by_last_observed_frame_.end();
+         last_frame_it++) {
+      for (const ObjectId &object_id : last_frame_it->second) {
+        if (first_observed_frame_by_object_.find(object_id) !=
             first_observed_frame_by_object_.end()) {
-          if (first_observed_frame_by_object_[object_id_and_most_recent_frame
-                                                  .first] <= max_frame_id) {
-            matching_objects.insert(object_id_and_most_recent_frame.first);
+          if (first_observed_frame_by_object_[object_id] <= max_frame_id) {
+            matching_objects.insert(object_id);
           }
         }
       }
@@ -522,13 +607,15 @@ class ObjAndLowLevelFeaturePoseGraph
       const FrameId &max_frame_id,
       util::BoostHashSet<std::pair<FactorType, FeatureFactorId>>
           &matching_observation_factor_ids) {
-    for (const auto &frame_id_and_factors : observation_factors_by_frame_) {
-      if ((frame_id_and_factors.first >= min_frame_id) &&
-          (frame_id_and_factors.first <= max_frame_id)) {
-        matching_observation_factor_ids.insert(
-            frame_id_and_factors.second.begin(),
-            frame_id_and_factors.second.end());
-      }
+    if (min_frame_id > max_frame_id) {
+      return;
+    }
+    for (auto frame_it =
+             observation_factors_by_frame_.lower_bound(min_frame_id);
+         frame_it != observation_factors_by_frame_.upper_bound(max_frame_id);
+         frame_it++) {
+      matching_observation_factor_ids.insert(frame_it->second.begin(),
+                                             frame_it->second.end());
     }
   }
 
@@ -752,10 +839,12 @@ class ObjAndLowLevelFeaturePoseGraph
             } else {
               object_observation_factors_[observation_factor_id.second]
                   .object_id_ = merge_group.first;
-              last_observed_frame_by_object_[merge_group.first] = std::max(
-                  last_observed_frame_by_object_[merge_group.first],
-                  object_observation_factors_[observation_factor_id.second]
-                      .frame_id_);
+              setLastObservedFrameForObject(
+                  merge_group.first,
+                  std::max(last_observed_frame_by_object_[merge_group.first],
+                           object_observation_factors_[observation_factor_id
+                                                           .second]
+                               .frame_id_));
               first_observed_frame_by_object_[merge_group.first] = std::max(
                   first_observed_frame_by_object_[merge_group.first],
                   object_observation_factors_[observation_factor_id.second]
@@ -779,6 +868,11 @@ class ObjAndLowLevelFeaturePoseGraph
     for (const ObjectId &object_to_remove : objects_to_remove) {
       ellipsoid_estimates_.erase(object_to_remove);
       semantic_class_for_object_.erase(object_to_remove);
+      if (last_observed_frame_by_object_.find(object_to_remove) !=
+          last_observed_frame_by_object_.end()) {
+        removeObjectFromLastObservedFrameIndex(
+            object_to_remove, last_observed_frame_by_object_[object_to_remove]);
+      }
       last_observed_frame_by_object_.erase(object_to_remove);
       first_observed_frame_by_object_.erase(object_to_remove);
 
@@ -811,7 +905,7 @@ class ObjAndLowLevelFeaturePoseGraph
       tmp_max = std::max(obj_est.first, tmp_max);
     }
     min_object_id_ = tmp_min;
-    max_object_id_ = tmp_max;
+    max_object_id_ = std::max(tmp_max, max_reserved_object_id_);
     return true;
   }
 
@@ -825,6 +919,11 @@ class ObjAndLowLevelFeaturePoseGraph
         pose_graph_state.last_observed_frame_by_object_;
     first_observed_frame_by_object_ =
         pose_graph_state.first_observed_frame_by_object_;
+    objects_by_last_observed_frame_.clear();
+    for (const auto &object_and_last_frame : last_observed_frame_by_object_) {
+      objects_by_last_observed_frame_[object_and_last_frame.second].insert(
+          object_and_last_frame.first);
+    }
     min_object_observation_factor_ =
         pose_graph_state.min_object_observation_factor_;
     max_object_observation_factor_ =
@@ -834,8 +933,10 @@ class ObjAndLowLevelFeaturePoseGraph
     long_term_map_object_ids_ = pose_graph_state.long_term_map_object_ids_;
     object_observation_factors_ = pose_graph_state.object_observation_factors_;
     shape_dim_prior_factors_ = pose_graph_state.shape_dim_prior_factors_;
-    observation_factors_by_frame_ =
-        pose_graph_state.observation_factors_by_frame_;
+    observation_factors_by_frame_.clear();
+    observation_factors_by_frame_.insert(
+        pose_graph_state.observation_factors_by_frame_.begin(),
+        pose_graph_state.observation_factors_by_frame_.end());
     observation_factors_by_object_ =
         pose_graph_state.observation_factors_by_object_;
     object_only_factors_by_object_ =
@@ -869,8 +970,10 @@ class ObjAndLowLevelFeaturePoseGraph
     pose_graph_state.long_term_map_object_ids_ = long_term_map_object_ids_;
     pose_graph_state.object_observation_factors_ = object_observation_factors_;
     pose_graph_state.shape_dim_prior_factors_ = shape_dim_prior_factors_;
-    pose_graph_state.observation_factors_by_frame_ =
-        observation_factors_by_frame_;
+    pose_graph_state.observation_factors_by_frame_.clear();
+    pose_graph_state.observation_factors_by_frame_.insert(
+        observation_factors_by_frame_.begin(),
+        observation_factors_by_frame_.end());
     pose_graph_state.observation_factors_by_object_ =
         observation_factors_by_object_;
     pose_graph_state.object_only_factors_by_object_ =
@@ -901,11 +1004,24 @@ class ObjAndLowLevelFeaturePoseGraph
   ObjectId min_object_id_;
   ObjectId max_object_id_;
 
+  /**
+   * Ids up to this one are reserved (see reserveObjectIdsThrough). Not part of
+   * the pose graph state; set again when the pose graph is restored.
+   */
+  ObjectId max_reserved_object_id_ = 0;
+
   std::unordered_map<ObjectId, EllipsoidEstimateNode> ellipsoid_estimates_;
   std::unordered_map<ObjectId, std::string> semantic_class_for_object_;
   std::unordered_map<ObjectId, FrameId> last_observed_frame_by_object_;
   std::unordered_map<ObjectId, FrameId> first_observed_frame_by_object_;
 
+  /**
+   * Inverse of last_observed_frame_by_object_, used to find the objects that
+   * could have been observed in a window without checking every object.
+   */
+  std::map<FrameId, std::unordered_set<ObjectId>>
+      objects_by_last_observed_frame_;
+
   FeatureFactorId min_object_observation_factor_;
   FeatureFactorId max_object_observation_factor_;
 
@@ -919,8 +1035,8 @@ class ObjAndLowLevelFeaturePoseGraph
   std::unordered_map<FeatureFactorId, ShapeDimPriorFactor>
       shape_dim_prior_factors_;
 
-  std::unordered_map<FrameId,
-                     util::BoostHashSet<std::pair<FactorType, FeatureFactorId>>>
+  // Ordered by frame so window queries are O(log n + window size)
+  std::map<FrameId, util::BoostHashSet<std::pair<FactorType, FeatureFactorId>>>
       observation_factors_by_frame_;
 
   std::unordered_map<ObjectId,
@@ -935,6 +1051,30 @@ class ObjAndLowLevelFeaturePoseGraph
                                         std::unordered_set<ObjectId>> &)>
       long_term_map_factor_provider_;
 
+  void setLastObservedFrameForObject(const ObjectId &object_id,
+                                     const FrameId &frame_id) {
+    if (last_observed_frame_by_object_.find(object_id) !=
+        last_observed_frame_by_object_.end()) {
+      removeObjectFromLastObservedFrameIndex(
+          object_id, last_observed_frame_by_object_[object_id]);
+    }
+    last_observed_frame_by_object_[object_id] = frame_id;
+    objects_by_last_observed_frame_[frame_id].insert(object_id);
+  }
+
+  void removeObjectFromLastObservedFrameIndex(
+      const ObjectId &object_id, const FrameId &last_observed_frame) {
+    auto last_frame_it =
+        objects_by_last_observed_frame_.find(last_observed_frame);
+    if (last_frame_it == objects_by_last_observed_frame_.end()) {
+      return;
+    }
+    last_frame_it->second.erase(object_id);
+    if (last_frame_it->second.empty()) {
+      objects_by_last_observed_frame_.erase(last_frame_it);
+    }
+  }
+
   ObjAndLowLevelFeaturePoseGraph(const ObjAndLowLevelFeaturePoseGraph &other) =
       default;
 };
@@ -1028,6 +1168,9 @@ class ObjectAndReprojectionFeaturePoseGraph
     }
     copy->setRobotPosePtrs(robot_poses_copy);
     // ObjectAndReprojectionFeaturePoseGraph::robot_poses_ = robot_poses_copy;
+    // The copy's pose blocks are new, and it may be solved independently
+    copy->robot_pose_transform_cache_ =
+        std::make_shared<RobotPoseTransformCache>();
 
     std::unordered_map<FeatureId, VisualFeatureNode> feature_positions_copy;
     for (const auto &feature_pos_est : this->feature_positions_) {
@@ -193,14 +193,10 @@ class ObjectPoseGraphOptimizer {
     // TODO do we run into a problem of unstability of the min node is the
     // only one that has observed the feature (do we loose all of that past
     // information?)
-    std::unordered_set<vslam_types_refactor::FrameId> all_frames =
-        pose_graph->getFrameIds();
-    for (const vslam_types_refactor::FrameId &frame_id : all_frames) {
-      if ((frame_id >= optimization_scope.min_frame_id_) &&
-          (frame_id <= optimization_scope.max_frame_id_)) {
-        optimized_frames.insert(frame_id);
-      }
-    }
+    pose_graph->getFrameIdsBetweenFrameIdsInclusive(
+        optimization_scope.min_frame_id_,
+        optimization_scope.max_frame_id_,
+        optimized_frames);
 
     if (use_feature_pose_factors) {
       //      LOG(INFO) << "Using feature-pose factors";
@@ -627,6 +623,17 @@ class ObjectPoseGraphOptimizer {
       opt_logger->setOptimizationParams(last_optimized_objects_,
                                         last_optimized_features_,
                                         last_optimized_nodes_);
+      if (opt_logger->getFrameTelemetryLogger() != nullptr) {
+        std::map<int, size_t> num_residuals_by_factor_type;
+        for (const auto &factor_type_and_residuals :
+             residual_blocks_and_cached_info_by_factor_id_) {
+          int factor_type = factor_type_and_residuals.first;
+          num_residuals_by_factor_type[factor_type] =
+              factor_type_and_residuals.second.size();
+        }
+        opt_logger->setResidualCountsByFactorType(
+            num_residuals_by_factor_type);
+      }
     }
     return current_residual_block_info;
   }
@@ -660,8 +667,10 @@ class ObjectPoseGraphOptimizer {
       options.update_state_every_iteration = true;
     }
     options.max_num_iterations = solver_params.max_num_iterations_;
-    options.num_threads = 10;
-    options.linear_solver_type = ceres::SPARSE_SCHUR;
+    options.num_threads = solver_params.num_threads_;
+    options.linear_solver_type = solver_params.linear_solver_type_;
+    options.trust_region_strategy_type =
+        solver_params.trust_region_strategy_type_;
     options.use_nonmonotonic_steps = solver_params.allow_non_monotonic_steps_;
     options.function_tolerance = solver_params.function_tolerance_;
     options.gradient_tolerance = solver_params.gradient_tolerance_;
@@ -735,8 +744,10 @@ class ObjectPoseGraphOptimizer {
       options.update_state_every_iteration = true;
     }
     options.max_num_iterations = solver_params.max_num_iterations_;
-    options.num_threads = 10;
-    options.linear_solver_type = ceres::SPARSE_SCHUR;
+    options.num_threads = solver_params.num_threads_;
+    options.linear_solver_type = solver_params.linear_solver_type_;
+    options.trust_region_strategy_type =
+        solver_params.trust_region_strategy_type_;
     options.use_nonmonotonic_steps = solver_params.allow_non_monotonic_steps_;
     options.function_tolerance = solver_params.function_tolerance_;
     options.gradient_tolerance = solver_params.gradient_tolerance_;
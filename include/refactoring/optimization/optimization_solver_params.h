@@ -5,6 +5,8 @@
 #ifndef UT_VSLAM_OPTIMIZATION_SOLVER_PARAMS_H
 #define UT_VSLAM_OPTIMIZATION_SOLVER_PARAMS_H
 
+#include <ceres/types.h>
+
 namespace pose_graph_optimization {
 
 struct OptimizationSolverParams {
@@ -23,12 +25,23 @@ struct OptimizationSolverParams {
   double max_trust_region_radius_ = 1e16;     // Ceres default
   // TODO
 
+  // These are not read from the config file. They keep the values the solver
+  // has always used unless a tool (such as the solver sweep in
+  // run_opt_from_pg_state) overrides them
+  ceres::LinearSolverType linear_solver_type_ = ceres::SPARSE_SCHUR;
+  ceres::TrustRegionStrategyType trust_region_strategy_type_ =
+      ceres::LEVENBERG_MARQUARDT;  // Ceres default
+  int num_threads_ = 10;
+
   bool operator==(const OptimizationSolverParams &rhs) const {
     return (max_num_iterations_ == rhs.max_num_iterations_) &&
            (allow_non_monotonic_steps_ == rhs.allow_non_monotonic_steps_) &&
            (function_tolerance_ == rhs.function_tolerance_) &&
            (gradient_tolerance_ == rhs.gradient_tolerance_) &&
-           (parameter_tolerance_ == rhs.parameter_tolerance_);
+           (parameter_tolerance_ == rhs.parameter_tolerance_) &&
+           (linear_solver_type_ == rhs.linear_solver_type_) &&
+           (trust_region_strategy_type_ == rhs.trust_region_strategy_type_) &&
+           (num_threads_ == rhs.num_threads_);
   }
 
   bool operator!=(const OptimizationSolverParams &rhs) const {
@@ -6,11 +6,16 @@
 #define UT_VSLAM_POSE_GRAPH_PLUS_OBJECTS_OPTIMIZER_H
 
 #include <ceres/problem.h>
+#include <glog/logging.h>
 #include <refactoring/factors/relative_pose_factor.h>
 #include <refactoring/factors/relative_pose_factor_utils.h>
+#include <refactoring/optimization/loss_function_pool.h>
 #include <refactoring/optimization/object_pose_graph.h>
 #include <refactoring/optimization/object_pose_graph_optimizer.h>
 
+#include <memory>
+#include <optional>
+
 namespace vslam_types_refactor {
 
 struct RelativePoseFactorInfoWithFrames {
@@ -20,6 +25,229 @@ struct RelativePoseFactorInfoWithFrames {
   FrameId after_pose_frame_id_;
 };
 
+/**
+ * Pose-graph + ellipsoid optimization problem that is kept across global
+ * optimizations.
+ *
+ * Rebuilding the problem for each global optimization costs time proportional
+ * to the trajectory length. Instead, this keeps the ceres problem, the
+ * relative pose (odometry) factors, and the object factors between runs. Each
+ * run only adds factors for the new frames and object observations and
+ * updates the measurements of the existing relative pose factors in place.
+ *
+ * The retained state references parameter blocks in the pose graph, so it
+ * must be reset whenever objects or frames are removed from the pose graph
+ * (ex. when objects are merged). It is reset automatically if it is used with
+ * a different pose graph, window start, or parameters.
+ */
+template <typename PoseGraphType, typename CachedFactorInfo>
+class PgoPlusEllipsoidsProblem {
+ public:
+  using PgoOptimizer = pose_graph_optimizer::ObjectPoseGraphOptimizer<
+      ReprojectionErrorFactor,
+      util::EmptyStruct,
+      ObjectAndReprojectionFeaturePoseGraph>;
+
+  using ResidualCreator = std::function<bool(
+      const std::pair<vslam_types_refactor::FactorType,
+                      vslam_types_refactor::FeatureFactorId> &,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams &,
+      const std::shared_ptr<PoseGraphType> &,
+      ceres::Problem *,
+      ceres::ResidualBlockId &,
+      CachedFactorInfo &)>;
+
+  /**
+   * Discard the retained problem. The next run will rebuild it from scratch.
+   */
+  void reset() {
+    optimizer_.reset();
+    problem_.reset();
+    relative_pose_factors_.clear();
+    pose_graph_ = nullptr;
+    min_frame_id_.reset();
+    residual_params_.reset();
+    pgo_solver_params_.reset();
+  }
+
+  /**
+   * Prepare the problem for a run, resetting it first if the retained state
+   * was built for a different pose graph, window start, or parameters.
+   *
+   * @param residual_creator    Creates the object residuals.
+   * @param pose_graph          Pose graph to optimize.
+   * @param min_frame_id        First frame in the optimization window.
+   * @param residual_params     Residual parameters.
+   * @param pgo_solver_params   Pose-graph + object optimization params.
+   */
+  void prepare(
+      const ResidualCreator &residual_creator,
+      const std::shared_ptr<PoseGraphType> &pose_graph,
+      const FrameId &min_frame_id,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+          &residual_params,
+      const pose_graph_optimization::PoseGraphPlusObjectsOptimizationParams
+          &pgo_solver_params) {
+    if ((problem_ != nullptr) && (pose_graph_ == pose_graph.get()) &&
+        (min_frame_id_ == min_frame_id) &&
+        (residual_params_ == residual_params) &&
+        (pgo_solver_params_ == pgo_solver_params)) {
+      return;
+    }
+    reset();
+    // Object factors don't depend on the current estimates, so they never need
+    // to be refreshed
+    optimizer_ = std::make_unique<PgoOptimizer>(
+        [](const std::pair<vslam_types_refactor::FactorType,
+                           vslam_types_refactor::FeatureFactorId> &,
+           const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> &,
+           const util::EmptyStruct &) { return false; },
+        residual_creator);
+    ceres::Problem::Options problem_options =
+        createProblemOptionsForPooledLossFunctions();
+    // Blocks for objects that leave the optimization scope are removed
+    // individually from a problem that keeps growing
+    problem_options.enable_fast_removal = true;
+    problem_options.evaluation_callback =
+        pose_graph->getRobotPoseTransformCache().get();
+    problem_ = std::make_unique<ceres::Problem>(problem_options);
+    pose_graph_ = pose_graph.get();
+    min_frame_id_ = min_frame_id;
+    residual_params_ = residual_params;
+    pgo_solver_params_ = pgo_solver_params;
+  }
+
+  /**
+   * Set the relative pose factors between consecutive frames up to the given
+   * frame to the relative poses between the current estimates. Factors that
+   * are already in the problem are updated in place and factors for new
+   * frames are added.
+   *
+   * @param max_frame_id  Last frame to add relative pose factors for.
+   * @param pose_graph    Pose graph containing the current estimates.
+   *
+   * @return True if the factors were updated, false if a pose estimate or
+   * parameter block was missing.
+   */
+  bool addOrUpdateRelativePoseFactors(
+      const FrameId &max_frame_id,
+      const std::shared_ptr<PoseGraphType> &pose_graph) {
+    if (relative_pose_factors_.size() > max_frame_id) {
+      // Fewer frames than the last run; shouldn't happen without a reset, but
+      // keep the problem consistent if it does
+      LOG(WARNING) << "Relative pose factors exist beyond frame "
+                   << max_frame_id << "; removing them";
+      for (size_t factor_num = max_frame_id;
+           factor_num < relative_pose_factors_.size();
+           factor_num++) {
+        problem_->RemoveResidualBlock(
+            relative_pose_factors_[factor_num].first);
+      }
+      relative_pose_factors_.resize(max_frame_id);
+    }
+
+    const pose_graph_optimization::RelativePoseCovarianceOdomModelParams
+        &cov_params = pgo_solver_params_->relative_pose_cov_params_;
+    std::optional<RawPose3d<double>> raw_before_pose =
+        pose_graph->getRobotPose(0);
+    if (!raw_before_pose.has_value()) {
+      LOG(ERROR) << "Could not find current estimate for frame num " << 0;
+      return false;
+    }
+    Pose3D<double> before_pose = convertToPose3D(raw_before_pose.value());
+
+    // TODO maybe at some point, we should have connections between other
+    // nearby poses
+    for (FrameId frame_num = 1; frame_num <= max_frame_id; frame_num++) {
+      std::optional<RawPose3d<double>> raw_after_pose =
+          pose_graph->getRobotPose(frame_num);
+      if (!raw_after_pose.has_value()) {
+        LOG(ERROR) << "Could not find current estimate for frame num "
+                   << frame_num;
+        return false;
+      }
+      Pose3D<double> after_pose = convertToPose3D(raw_after_pose.value());
+
+      Pose3D<double> relative_pose =
+          getPose2RelativeToPose1(before_pose, after_pose);
+      Covariance<double, 6> relative_pose_cov =
+          generateOdomCov(relative_pose,
+                          cov_params.transl_error_mult_for_transl_error_,
+                          cov_params.transl_error_mult_for_rot_error_,
+                          cov_params.rot_error_mult_for_transl_error_,
+                          cov_params.rot_error_mult_for_rot_error_);
+
+      size_t factor_num = frame_num - 1;
+      if (factor_num < relative_pose_factors_.size()) {
+        relative_pose_factors_[factor_num].second->setMeasurement(
+            relative_pose, relative_pose_cov);
+      } else {
+        double *before_pose_block;
+        double *after_pose_block;
+        if (!pose_graph_optimizer::getParamBlockForPose(
+                frame_num - 1, pose_graph, &before_pose_block)) {
+          LOG(ERROR) << "Could not find parameter block for frame "
+                     << (frame_num - 1);
+          return false;
+        }
+        if (!pose_graph_optimizer::getParamBlockForPose(
+                frame_num, pose_graph, &after_pose_block)) {
+          LOG(ERROR) << "Could not find parameter block for frame "
+                     << frame_num;
+          return false;
+        }
+        RelativePoseFactor *factor;
+        ceres::ResidualBlockId residual_id = problem_->AddResidualBlock(
+            RelativePoseFactor::createRelativePoseFactor(
+                relative_pose, relative_pose_cov, &factor),
+            LossFunctionPool::getInstance().getHuberLoss(
+                pgo_solver_params_->relative_pose_factor_huber_loss_),
+            before_pose_block,
+            after_pose_block);
+        relative_pose_factors_.emplace_back(residual_id, factor);
+      }
+      before_pose = after_pose;
+    }
+    return true;
+  }
+
+  PgoOptimizer &getOptimizer() { return *optimizer_; }
+
+  ceres::Problem *getProblem() { return problem_.get(); }
+
+ private:
+  std::unique_ptr<PgoOptimizer> optimizer_;
+
+  std::unique_ptr<ceres::Problem> problem_;
+
+  /**
+   * Relative pose factors in the problem. Entry i is the factor between frames
+   * i and i + 1. The cost functors are owned by the problem.
+   */
+  std::vector<std::pair<ceres::ResidualBlockId, RelativePoseFactor *>>
+      relative_pose_factors_;
+
+  /**
+   * State that the retained problem was built for. The pose graph is only used
+   * for comparison.
+   */
+  const PoseGraphType *pose_graph_ = nullptr;
+  std::optional<FrameId> min_frame_id_;
+  std::optional<pose_graph_optimization::ObjectVisualPoseGraphResidualParams>
+      residual_params_;
+  std::optional<pose_graph_optimization::PoseGraphPlusObjectsOptimizationParams>
+      pgo_solver_params_;
+};
+
+/**
+ * Run pose-graph optimization with ellipsoids, with relative pose factors
+ * between consecutive frames generated from the current estimates, and then
+ * adjust the visual features to the new poses (if enabled).
+ *
+ * If persistent_pgo_problem is provided, the pose-graph problem is reused
+ * from (and kept for) other runs on the same pose graph. Otherwise, it is
+ * built from scratch for this run.
+ */
 template <typename PoseGraphType, typename CachedFactorInfo>
 bool runPgoPlusEllipsoids(
     const FrameId &max_frame_id,
@@ -44,37 +272,33 @@ bool runPgoPlusEllipsoids(
     const bool &final_run,
     std::optional<vslam_types_refactor::OptimizationLogger> &opt_logger,
     std::shared_ptr<PoseGraphType> &pose_graph,
-    const bool &for_map_merge = false) {
-  // Construct set of relative pose factors
-  std::vector<RelativePoseFactorInfoWithFrames> relative_pose_factors;
-  relative_pose_factors.insert(relative_pose_factors.end(),
-                               non_local_relative_pose_factors.begin(),
-                               non_local_relative_pose_factors.end());
-
-  std::unordered_map<FrameId, RawPose3d<double>> raw_robot_pose_estimates;
-  pose_graph->getRobotPoseEstimates(raw_robot_pose_estimates);
+    const bool &for_map_merge = false,
+    PgoPlusEllipsoidsProblem<PoseGraphType, CachedFactorInfo>
+        *persistent_pgo_problem = nullptr) {
   std::unordered_map<FeatureId, std::pair<FrameId, Position3d<double>>>
       relative_positions_from_first;
 
-  // Create new optimizer with ellipsoid factors only (use_visual_features =
-  // false) Have relative pose factors already in problem
-  std::function<bool(
-      const std::pair<vslam_types_refactor::FactorType,
-                      vslam_types_refactor::FeatureFactorId> &,
-      const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> &,
-      const util::EmptyStruct &)>
-      refresh_residual_checker =
-          [](const std::pair<vslam_types_refactor::FactorType,
-                             vslam_types_refactor::FeatureFactorId> &,
-             const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> &,
-             const util::EmptyStruct &) { return true; };
-
-  pose_graph_optimizer::ObjectPoseGraphOptimizer<
-      ReprojectionErrorFactor,
-      util::EmptyStruct,
-      ObjectAndReprojectionFeaturePoseGraph>
-      optimizer(refresh_residual_checker, residual_creator);
-  ceres::Problem problem;
+  // Without a problem retained from previous runs, build one just for this run
+  std::optional<PgoPlusEllipsoidsProblem<PoseGraphType, CachedFactorInfo>>
+      one_time_pgo_problem;
+  if (persistent_pgo_problem == nullptr) {
+    one_time_pgo_problem.emplace();
+    persistent_pgo_problem = &(one_time_pgo_problem.value());
+  }
+  PgoPlusEllipsoidsProblem<PoseGraphType, CachedFactorInfo> &pgo_problem =
+      *persistent_pgo_problem;
+
+  // Optimizer with ellipsoid factors only (use_visual_features = false). Has
+  // relative pose factors already in problem
+  pgo_problem.prepare(residual_creator,
+                      pose_graph,
+                      optimization_scope_params.min_frame_id_,
+                      residual_params,
+                      pgo_solver_params);
+  ceres::Problem &problem = *(pgo_problem.getProblem());
+
+  // Loop closure factors are only kept for this run
+  std::vector<ceres::ResidualBlockId> non_local_residual_ids;
 
   {
 #ifdef RUN_TIMERS
@@ -87,57 +311,23 @@ bool runPgoPlusEllipsoids(
             .get());
 #endif
 
-    // TODO maybe at some point, we should have connections between other nearby
-    // poses
-    // Construct relative pose factors from local windows
-    for (FrameId frame_num = 1; frame_num <= max_frame_id; frame_num++) {
-      if (raw_robot_pose_estimates.find(frame_num) ==
-          raw_robot_pose_estimates.end()) {
-        LOG(ERROR) << "Could not find current estimate for frame num "
-                   << frame_num;
-        return false;
-      }
-      if (raw_robot_pose_estimates.find(frame_num - 1) ==
-          raw_robot_pose_estimates.end()) {
-        LOG(ERROR) << "Could not find current estimate for frame num "
-                   << (frame_num - 1);
-        return false;
-      }
-
-      Pose3D<double> before_pose =
-          convertToPose3D(raw_robot_pose_estimates.at(frame_num - 1));
-      Pose3D<double> after_pose =
-          convertToPose3D(raw_robot_pose_estimates.at(frame_num));
-
-      Pose3D<double> relative_pose =
-          getPose2RelativeToPose1(before_pose, after_pose);
-
-      RelativePoseFactorInfoWithFrames relative_info;
-      relative_info.before_pose_frame_id_ = frame_num - 1;
-      relative_info.after_pose_frame_id_ = frame_num;
-      relative_info.measured_pose_deviation_ = relative_pose;
-      relative_info.pose_deviation_cov_ =
-          generateOdomCov(relative_pose,
-                          pgo_solver_params.relative_pose_cov_params_
-                              .transl_error_mult_for_transl_error_,
-                          pgo_solver_params.relative_pose_cov_params_
-                              .transl_error_mult_for_rot_error_,
-                          pgo_solver_params.relative_pose_cov_params_
-                              .rot_error_mult_for_transl_error_,
-                          pgo_solver_params.relative_pose_cov_params_
-                              .rot_error_mult_for_rot_error_);
-      relative_pose_factors.emplace_back(relative_info);
+    // Update the relative pose factors from local windows
+    if (!pgo_problem.addOrUpdateRelativePoseFactors(max_frame_id,
+                                                    pose_graph)) {
+      pgo_problem.reset();
+      return false;
     }
 
     // Add to ceres problem
     for (const RelativePoseFactorInfoWithFrames &factor :
-         relative_pose_factors) {
+         non_local_relative_pose_factors) {
       double *before_pose_block;
       double *after_pose_block;
       if (!pose_graph_optimizer::getParamBlockForPose(
               factor.before_pose_frame_id_, pose_graph, &before_pose_block)) {
         LOG(ERROR) << "Could not find parameter block for frame "
                    << factor.before_pose_frame_id_;
+        pgo_problem.reset();
         return false;
       }
 
@@ -145,16 +335,17 @@ bool runPgoPlusEllipsoids(
               factor.after_pose_frame_id_, pose_graph, &after_pose_block)) {
         LOG(ERROR) << "Could not find parameter block for frame "
                    << factor.after_pose_frame_id_;
+        pgo_problem.reset();
         return false;
       }
 
-      problem.AddResidualBlock(
+      non_local_residual_ids.emplace_back(problem.AddResidualBlock(
           RelativePoseFactor::createRelativePoseFactor(
               factor.measured_pose_deviation_, factor.pose_deviation_cov_),
-          new ceres::HuberLoss(
+          LossFunctionPool::getInstance().getHuberLoss(
               pgo_solver_params.relative_pose_factor_huber_loss_),
           before_pose_block,
-          after_pose_block);
+          after_pose_block));
     }
 
     pose_graph_optimizer::OptimizationScopeParams
@@ -199,11 +390,12 @@ bool runPgoPlusEllipsoids(
     if (opt_logger.has_value()) {
       opt_logger->setOptimizationTypeParams(max_frame_id, false, true, true);
     }
-    optimizer.buildPoseGraphOptimization(optimization_scope_params_for_pgo,
-                                         residual_params,
-                                         pose_graph,
-                                         &problem,
-                                         opt_logger);
+    pgo_problem.getOptimizer().buildPoseGraphOptimization(
+        optimization_scope_params_for_pgo,
+        residual_params,
+        pose_graph,
+        &problem,
+        opt_logger);
   }
   {
 #ifdef RUN_TIMERS
@@ -216,13 +408,18 @@ bool runPgoPlusEllipsoids(
             .get());
 #endif
     // Run optimization
-    if (!optimizer.solveOptimization(
-            &problem,
-            final_run ? pgo_solver_params.final_pgo_optimization_solver_params_
-                      : pgo_solver_params.pgo_optimization_solver_params_,
-            ceres_callbacks,
-            opt_logger,
-            nullptr)) {
+    bool pgo_success = pgo_problem.getOptimizer().solveOptimization(
+        &problem,
+        final_run ? pgo_solver_params.final_pgo_optimization_solver_params_
+                  : pgo_solver_params.pgo_optimization_solver_params_,
+        ceres_callbacks,
+        opt_logger,
+        nullptr);
+    for (const ceres::ResidualBlockId &non_local_residual_id :
+         non_local_residual_ids) {
+      problem.RemoveResidualBlock(non_local_residual_id);
+    }
+    if (!pgo_success) {
       // TODO do we want to quit or just silently let this iteration fail?
       LOG(ERROR) << "Pose-graph + object optimization failed at max frame id "
                  << max_frame_id;
@@ -285,6 +482,21 @@ bool runPgoPlusEllipsoids(
     optimization_scope_params_for_vf_adjustment.fix_poses_ = true;
     optimization_scope_params_for_vf_adjustment.fix_objects_ = true;
     optimization_scope_params_for_vf_adjustment.include_object_factors_ = false;
+
+    // Use a separate problem so the retained pose-graph problem keeps its
+    // object factors
+    typename PgoPlusEllipsoidsProblem<PoseGraphType, CachedFactorInfo>::
+        PgoOptimizer vf_adjustment_optimizer(
+            [](const std::pair<vslam_types_refactor::FactorType,
+                               vslam_types_refactor::FeatureFactorId> &,
+               const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> &,
+               const util::EmptyStruct &) { return true; },
+            residual_creator);
+    ceres::Problem::Options vf_adjustment_problem_options =
+        createProblemOptionsForPooledLossFunctions();
+    vf_adjustment_problem_options.evaluation_callback =
+        pose_graph->getRobotPoseTransformCache().get();
+    ceres::Problem vf_adjustment_problem(vf_adjustment_problem_options);
     {
 #ifdef RUN_TIMERS
       std::string opt_vf_adjust_build_timer_name =
@@ -295,11 +507,11 @@ bool runPgoPlusEllipsoids(
               .getOrCreateFunctionTimer(opt_vf_adjust_build_timer_name)
               .get());
 #endif
-      optimizer.buildPoseGraphOptimization(
+      vf_adjustment_optimizer.buildPoseGraphOptimization(
           optimization_scope_params_for_vf_adjustment,
           residual_params,
           pose_graph,
-          &problem,
+          &vf_adjustment_problem,
           opt_logger);
     }
     {
@@ -313,8 +525,8 @@ bool runPgoPlusEllipsoids(
               .get());
 #endif
       // Run optimization
-      if (!optimizer.solveOptimization(
-              &problem,
+      if (!vf_adjustment_optimizer.solveOptimization(
+              &vf_adjustment_problem,
               final_run
                   ? pgo_solver_params.final_pgo_optimization_solver_params_
                   : pgo_solver_params.pgo_optimization_solver_params_,
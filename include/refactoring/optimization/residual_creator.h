@@ -10,7 +10,9 @@
 #include <refactoring/factors/bounding_box_factor.h>
 #include <refactoring/factors/reprojection_cost_functor.h>
 #include <refactoring/factors/reprojection_cost_functor_analytic_jacobian.h>
+#include <refactoring/factors/reprojection_cost_functor_cached_pose.h>
 #include <refactoring/factors/shape_prior_factor.h>
+#include <refactoring/optimization/loss_function_pool.h>
 #include <refactoring/optimization/object_pose_graph.h>
 #include <refactoring/optimization/optimization_solver_params.h>
 
@@ -99,7 +101,7 @@ bool createObjectObservationResidual(
   }
 
   residual_id = problem->AddResidualBlock(
-      BoundingBoxFactor::createBoundingBoxFactor(
+      BoundingBoxCostFunctionAnalyticJacobian::createBoundingBoxFactor(
           residual_params.object_residual_params_.invalid_ellipsoid_error_val_,
           factor.bounding_box_corners_,
           intrinsics,
@@ -109,8 +111,9 @@ bool createObjectObservationResidual(
           factor.frame_id_,
           factor.camera_id_,
           debug),
-      new ceres::HuberLoss(residual_params.object_residual_params_
-                               .object_observation_huber_loss_param_),
+      LossFunctionPool::getInstance().getHuberLoss(
+          residual_params.object_residual_params_
+              .object_observation_huber_loss_param_),
       ellipsoid_param_block,
       robot_pose_block);
   return true;
@@ -162,8 +165,9 @@ bool createObjectShapeDimPriorResidual(
   residual_id = problem->AddResidualBlock(
       ShapePriorFactor::createShapeDimPrior(factor.mean_shape_dim_,
                                             factor.shape_dim_cov_),
-      new ceres::HuberLoss(residual_params.object_residual_params_
-                               .shape_dim_prior_factor_huber_loss_param_),
+      LossFunctionPool::getInstance().getHuberLoss(
+          residual_params.object_residual_params_
+              .shape_dim_prior_factor_huber_loss_param_),
       ellipsoid_param_block);
   return true;
 }
@@ -249,17 +253,21 @@ bool createReprojectionErrorResidual(
   }
 
   residual_id = problem->AddResidualBlock(
-      ReprojectionCostFunctor::create(
-          // This version seems to cause major problems with the covariance
-          // extraction (is something wrong with the Jacobian?), but the
-          // trajectory/ellipsoid output looks fine
-          // ReprojectionCostFunctorAnalyticJacobian::create(
+      // ReprojectionCostFunctorAnalyticJacobian seems to cause major problems
+      // with the covariance extraction (is something wrong with the
+      // Jacobian?). This one computes the same residual as
+      // ReprojectionCostFunctor, with the pose rotation shared across the
+      // frame's residuals
+      ReprojectionCostFunctorCachedPose::create(
           intrinsics,
           extrinsics,
           factor.feature_pos_,
-          factor.reprojection_error_std_dev_),
-      new ceres::HuberLoss(residual_params.visual_residual_params_
-                               .reprojection_error_huber_loss_param_),
+          factor.reprojection_error_std_dev_,
+          pose_graph->getRobotPoseTransformCache()->getOrAddRobotPose(
+              robot_pose_block)),
+      LossFunctionPool::getInstance().getHuberLoss(
+          residual_params.visual_residual_params_
+              .reprojection_error_huber_loss_param_),
       robot_pose_block,
       feature_position_block);
 
@@ -337,7 +345,8 @@ bool createRelPoseResidual(
   residual_id = problem->AddResidualBlock(
       RelativePoseFactor::createRelativePoseFactor(
           factor.measured_pose_deviation_, factor.pose_deviation_cov_),
-      new ceres::HuberLoss(residual_params.relative_pose_factor_huber_loss_),
+      LossFunctionPool::getInstance().getHuberLoss(
+          residual_params.relative_pose_factor_huber_loss_),
       robot_pose1_block,
       robot_pose2_block);
 
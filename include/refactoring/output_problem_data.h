@@ -7,6 +7,8 @@
 
 #include <refactoring/types/vslam_obj_opt_types_refactor.h>
 
+#include <unordered_set>
+
 namespace vslam_types_refactor {
 struct EllipsoidResults {
   std::unordered_map<ObjectId, std::pair<std::string, EllipsoidState<double>>>
@@ -43,6 +45,9 @@ struct LongTermObjectMapAndResults {
                                             std::pair<BbCornerPair<double>,
                                                       std::optional<double>>>>>>
       associated_observed_corner_locations_;
+  // Objects in the final pose graph that have observation factors (after any
+  // objects were merged)
+  std::unordered_set<ObjectId> observed_objects_;
 };
 
 struct ObjectDataAssociationResults {
@@ -58,6 +58,24 @@ void extractSpatialEstimateOnlyResults(
                                         output_data.visual_feature_results_);
 }
 
+void extractObservedObjects(
+    const std::shared_ptr<
+        vslam_types_refactor::ObjectAndReprojectionFeaturePoseGraph>
+        &pose_graph,
+    std::unordered_set<ObjectId> &observed_objects) {
+  std::unordered_map<ObjectId, std::pair<std::string, RawEllipsoid<double>>>
+      raw_ests;
+  pose_graph->getObjectEstimates(raw_ests);
+  for (const auto &raw_est : raw_ests) {
+    std::vector<ObjectObservationFactor> observation_factors;
+    if (pose_graph->getObservationFactorsForObjId(raw_est.first,
+                                                  observation_factors) &&
+        !observation_factors.empty()) {
+      observed_objects.insert(raw_est.first);
+    }
+  }
+}
+
 template <typename LongTermObjectMap>
 void extractLongTermObjectMapAndResults(
     const std::shared_ptr<
@@ -75,6 +93,7 @@ void extractLongTermObjectMapAndResults(
   extractRobotPoseEstimates(pose_graph, output_data.robot_pose_results_);
   extractVisualFeaturePositionEstimates(pose_graph,
                                         output_data.visual_feature_results_);
+  extractObservedObjects(pose_graph, output_data.observed_objects_);
   long_term_object_map_extractor(pose_graph,
                                  optimization_factors_enabled_params,
                                  output_data.long_term_map_);
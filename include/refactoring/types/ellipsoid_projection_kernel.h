@@ -0,0 +1,384 @@
+//
+// Created by amanda on 3/9/23.
+//
+
+#ifndef UT_VSLAM_ELLIPSOID_PROJECTION_KERNEL_H
+#define UT_VSLAM_ELLIPSOID_PROJECTION_KERNEL_H
+
+#include <glog/logging.h>
+#include <refactoring/types/ellipsoid_utils.h>
+#include <refactoring/types/vslam_math_util.h>
+#include <refactoring/types/vslam_obj_opt_types_refactor.h>
+
+#include <eigen3/Eigen/Dense>
+#include <optional>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+/**
+ * Number of robot pose parameters (translation followed by axis-angle).
+ */
+const static int kRobotPoseParameterizationSize = 6;
+
+/**
+ * Quantities for projecting ellipsoids into one camera at one robot pose
+ * that don't depend on the ellipsoid. Computing these once per frame/camera
+ * lets ellipsoids be projected without building transforms for each one.
+ */
+struct EllipsoidProjectionCameraFrame {
+  /**
+   * Rotation and translation of the world frame relative to the camera.
+   */
+  Eigen::Matrix3d world_to_cam_rot_;
+  Eigen::Vector3d world_to_cam_transl_;
+
+  /**
+   * Translation of the robot frame relative to the camera (from the inverse
+   * of the extrinsics).
+   */
+  Eigen::Vector3d robot_to_cam_transl_;
+
+  /**
+   * Change in the camera frame's orientation (expressed in the camera frame)
+   * per change in the robot pose's axis-angle parameters (world to camera
+   * rotation times the SO(3) left Jacobian of the robot's rotation).
+   */
+  Eigen::Matrix3d robot_rot_jacobian_in_cam_;
+};
+
+namespace ellipsoid_projection_internal {
+
+/**
+ * Get the rotation for an axis-angle vector, matching PoseArrayToAffine (and
+ * getEllipsoidDimMatAndTf), which use the identity for tiny rotations.
+ */
+inline Eigen::Matrix3d axisAngleToRotation(const Eigen::Vector3d &axis_angle) {
+  double angle = axis_angle.norm();
+  if (angle < kSmallAngleThreshold) {
+    return Eigen::Matrix3d::Identity();
+  }
+  return Eigen::AngleAxisd(angle, axis_angle / angle).toRotationMatrix();
+}
+
+/**
+ * Get the SO(3) left Jacobian for an axis-angle vector (relates a change in
+ * the axis-angle parameters to a rotation applied on the left).
+ */
+inline Eigen::Matrix3d leftJacobian(const Eigen::Vector3d &axis_angle) {
+  // The left Jacobian is the right Jacobian of the inverse rotation
+  Eigen::Vector3d inverse_axis_angle = -axis_angle;
+  return GetRodriguesJacobian(inverse_axis_angle);
+}
+
+/**
+ * Pull the entries of a symmetric 3x3 matrix that the bounding box depends on
+ * (q11, q13, q22, q23, q33 using 1-based indices).
+ */
+inline Eigen::Matrix<double, 5, 1> getBoundingBoxEntries(
+    const Eigen::Matrix3d &sym_mat) {
+  return Eigen::Matrix<double, 5, 1>(sym_mat(0, 0),
+                                     sym_mat(0, 2),
+                                     sym_mat(1, 1),
+                                     sym_mat(1, 2),
+                                     sym_mat(2, 2));
+}
+
+/**
+ * Get the bounding box entries (see getBoundingBoxEntries) of
+ * x * y^T + y * x^T.
+ */
+inline Eigen::Matrix<double, 5, 1> getSymmetricOuterProductEntries(
+    const Eigen::Vector3d &x, const Eigen::Vector3d &y) {
+  return Eigen::Matrix<double, 5, 1>(2 * x(0) * y(0),
+                                     x(0) * y(2) + x(2) * y(0),
+                                     2 * x(1) * y(1),
+                                     x(1) * y(2) + x(2) * y(1),
+                                     2 * x(2) * y(2));
+}
+
+/**
+ * Get the bounding box entries (see getBoundingBoxEntries) of
+ * [u]_x * sym_mat - sym_mat * [u]_x for a symmetric matrix, which is the
+ * change in sym_mat when it is rotated by a small rotation u.
+ */
+inline Eigen::Matrix<double, 5, 1> getRotatedSymmetricMatrixEntries(
+    const Eigen::Vector3d &u, const Eigen::Matrix3d &sym_mat) {
+  Eigen::Matrix3d half = SkewSymmetric(u) * sym_mat;
+  return getBoundingBoxEntries(half + half.transpose());
+}
+}  // namespace ellipsoid_projection_internal
+
+/**
+ * Compute the projection quantities that are shared by all ellipsoids seen
+ * from a camera at a robot pose.
+ *
+ * @param robot_pose        Robot's pose in the world frame (6 entries:
+ *                          translation, then axis-angle rotation).
+ * @param robot_to_cam_tf   Transform that provides the robot's position in
+ *                          the camera frame (inverse of extrinsics).
+ *
+ * @return Per-frame projection quantities.
+ */
+inline EllipsoidProjectionCameraFrame createEllipsoidProjectionCameraFrame(
+    const double *robot_pose, const Eigen::Affine3d &robot_to_cam_tf) {
+  Eigen::Vector3d robot_transl(robot_pose[0], robot_pose[1], robot_pose[2]);
+  Eigen::Vector3d robot_axis_angle(robot_pose[3], robot_pose[4], robot_pose[5]);
+  Eigen::Matrix3d robot_rot =
+      ellipsoid_projection_internal::axisAngleToRotation(robot_axis_angle);
+
+  EllipsoidProjectionCameraFrame frame;
+  frame.world_to_cam_rot_ = robot_to_cam_tf.linear() * robot_rot.transpose();
+  frame.world_to_cam_transl_ =
+      robot_to_cam_tf.translation() - frame.world_to_cam_rot_ * robot_transl;
+  frame.robot_to_cam_transl_ = robot_to_cam_tf.translation();
+  frame.robot_rot_jacobian_in_cam_ =
+      frame.world_to_cam_rot_ *
+      ellipsoid_projection_internal::leftJacobian(robot_axis_angle);
+  return frame;
+}
+
+/**
+ * Get the predicted (rectified) bounding box for an ellipsoid and optionally
+ * its Jacobians with respect to the robot pose and ellipsoid parameters.
+ *
+ * This gives the same corners as getCornerLocationsVectorRectified, but
+ * works on the precomputed per-frame quantities and computes the Jacobians in
+ * closed form instead of with automatic differentiation. Rotation Jacobians
+ * use the SO(3) left Jacobian of the axis-angle parameters.
+ *
+ * @param frame                     Per-frame projection quantities.
+ * @param ellipsoid                 Ellipsoid parameters (translation, rotation,
+ *                                  dimensions; kEllipsoidParamterizationSize
+ *                                  entries).
+ * @param corner_results[out]       Predicted rectified corners (max x, min x,
+ *                                  max y, min y, as in
+ *                                  getCornerLocationsVectorRectified).
+ * @param robot_pose_jacobian[out]  Row-major 4 x 6 Jacobian of the corners
+ *                                  with respect to the robot pose. Not
+ *                                  computed if null.
+ * @param ellipsoid_jacobian[out]   Row-major 4 x kEllipsoidParamterizationSize
+ *                                  Jacobian of the corners with respect to the
+ *                                  ellipsoid. Not computed if null.
+ *
+ * @return True if the ellipsoid projects to a valid bounding box, false
+ * otherwise (outputs are not set in this case).
+ */
+inline bool projectEllipsoidRectified(
+    const EllipsoidProjectionCameraFrame &frame,
+    const double *ellipsoid,
+    Eigen::Vector4d &corner_results,
+    double *robot_pose_jacobian = nullptr,
+    double *ellipsoid_jacobian = nullptr) {
+  Eigen::Vector3d ellipsoid_transl(ellipsoid[0], ellipsoid[1], ellipsoid[2]);
+#ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
+  Eigen::Matrix3d ellipsoid_rot =
+      Eigen::AngleAxisd(ellipsoid[3], Eigen::Vector3d::UnitZ())
+          .toRotationMatrix();
+#else
+  Eigen::Vector3d ellipsoid_axis_angle(
+      ellipsoid[3], ellipsoid[4], ellipsoid[5]);
+  Eigen::Matrix3d ellipsoid_rot =
+      ellipsoid_projection_internal::axisAngleToRotation(ellipsoid_axis_angle);
+#endif
+  const double *dims = &(ellipsoid[kEllipsoidPoseParameterizationSize]);
+  Eigen::Vector3d dim_diag;
+  for (int dim_num = 0; dim_num < 3; dim_num++) {
+    double half_dim = dims[dim_num] / 2;
+    dim_diag(dim_num) = half_dim * half_dim + kDimensionRegularizationConstant;
+  }
+
+  // Ellipsoid axes and center in the camera frame
+  Eigen::Matrix3d ellipsoid_axes_in_cam =
+      frame.world_to_cam_rot_ * ellipsoid_rot;
+  Eigen::Vector3d ellipsoid_center_in_cam =
+      frame.world_to_cam_rot_ * ellipsoid_transl + frame.world_to_cam_transl_;
+
+  // Dual conic: Q = A D A^T - b b^T
+  Eigen::Matrix3d shape_in_cam = ellipsoid_axes_in_cam *
+                                 dim_diag.asDiagonal() *
+                                 ellipsoid_axes_in_cam.transpose();
+  Eigen::Matrix3d q_mat =
+      shape_in_cam -
+      ellipsoid_center_in_cam * ellipsoid_center_in_cam.transpose();
+
+  // Check if behind camera
+  double t_z = ellipsoid_center_in_cam.z();
+  double q33_adjusted_sqrt = sqrt(shape_in_cam(2, 2));
+  if (((t_z + q33_adjusted_sqrt) < 0) && ((t_z - q33_adjusted_sqrt) < 0)) {
+    LOG(WARNING)
+        << "Ellipsoid fully behind camera plane. Not physically possible.";
+  }
+
+  double q1_1 = q_mat(0, 0);
+  double q1_3 = q_mat(0, 2);
+  double q2_2 = q_mat(1, 1);
+  double q2_3 = q_mat(1, 2);
+  double q3_3 = q_mat(2, 2);
+
+  double x_sqrt_arg = (q1_3 * q1_3) - (q1_1 * q3_3);
+  double y_sqrt_arg = (q2_3 * q2_3) - (q2_2 * q3_3);
+  if ((x_sqrt_arg <= 0) || (y_sqrt_arg <= 0)) {
+    return false;
+  }
+  double x_sqrt_component = sqrt(x_sqrt_arg);
+  double y_sqrt_component = sqrt(y_sqrt_arg);
+
+  corner_results << q1_3 + x_sqrt_component, q1_3 - x_sqrt_component,
+      q2_3 + y_sqrt_component, q2_3 - y_sqrt_component;
+  corner_results = corner_results / q3_3;
+
+  if ((robot_pose_jacobian == nullptr) && (ellipsoid_jacobian == nullptr)) {
+    return true;
+  }
+
+  // Derivatives of the corners with respect to the entries of Q that they
+  // depend on (q11, q13, q22, q23, q33)
+  Eigen::Matrix<double, 4, 5> corners_wrt_q =
+      Eigen::Matrix<double, 4, 5>::Zero();
+  for (int sign_idx = 0; sign_idx < 2; sign_idx++) {
+    double sign = (sign_idx == 0) ? 1 : -1;
+    int x_row = sign_idx;
+    int y_row = 2 + sign_idx;
+    corners_wrt_q(x_row, 0) = -sign / (2 * x_sqrt_component);
+    corners_wrt_q(x_row, 1) = (1 + sign * q1_3 / x_sqrt_component) / q3_3;
+    corners_wrt_q(x_row, 4) =
+        ((-sign * q1_1 / (2 * x_sqrt_component)) - corner_results(x_row)) /
+        q3_3;
+    corners_wrt_q(y_row, 2) = -sign / (2 * y_sqrt_component);
+    corners_wrt_q(y_row, 3) = (1 + sign * q2_3 / y_sqrt_component) / q3_3;
+    corners_wrt_q(y_row, 4) =
+        ((-sign * q2_2 / (2 * y_sqrt_component)) - corner_results(y_row)) /
+        q3_3;
+  }
+
+  using ellipsoid_projection_internal::getRotatedSymmetricMatrixEntries;
+  using ellipsoid_projection_internal::getSymmetricOuterProductEntries;
+
+  if (robot_pose_jacobian != nullptr) {
+    Eigen::Matrix<double, 5, kRobotPoseParameterizationSize> q_wrt_robot;
+    for (int axis = 0; axis < 3; axis++) {
+      // Moving the robot moves the ellipsoid center the opposite way
+      q_wrt_robot.col(axis) = getSymmetricOuterProductEntries(
+          frame.world_to_cam_rot_.col(axis), ellipsoid_center_in_cam);
+
+      // Rotating the robot rotates Q the opposite way and moves the camera
+      // center (which is offset from the robot origin)
+      Eigen::Vector3d rot_in_cam = frame.robot_rot_jacobian_in_cam_.col(axis);
+      Eigen::Vector3d center_change =
+          rot_in_cam.cross(-frame.robot_to_cam_transl_);
+      q_wrt_robot.col(3 + axis) =
+          -getRotatedSymmetricMatrixEntries(rot_in_cam, q_mat) +
+          getSymmetricOuterProductEntries(center_change,
+                                          ellipsoid_center_in_cam);
+    }
+    Eigen::Map<Eigen::Matrix<double,
+                             4,
+                             kRobotPoseParameterizationSize,
+                             Eigen::RowMajor>>
+        robot_pose_jacobian_mat(robot_pose_jacobian);
+    robot_pose_jacobian_mat = corners_wrt_q * q_wrt_robot;
+  }
+
+  if (ellipsoid_jacobian != nullptr) {
+    Eigen::Matrix<double, 5, kEllipsoidParamterizationSize> q_wrt_ellipsoid;
+    for (int axis = 0; axis < 3; axis++) {
+      q_wrt_ellipsoid.col(axis) = -getSymmetricOuterProductEntries(
+          frame.world_to_cam_rot_.col(axis), ellipsoid_center_in_cam);
+
+      const Eigen::Vector3d axis_in_cam = ellipsoid_axes_in_cam.col(axis);
+      q_wrt_ellipsoid.col(kEllipsoidPoseParameterizationSize + axis) =
+          (dims[axis] / 4) *
+          getSymmetricOuterProductEntries(axis_in_cam, axis_in_cam);
+    }
+#ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
+    q_wrt_ellipsoid.col(3) = getRotatedSymmetricMatrixEntries(
+        frame.world_to_cam_rot_.col(2), shape_in_cam);
+#else
+    Eigen::Matrix3d ellipsoid_rot_jacobian_in_cam =
+        frame.world_to_cam_rot_ *
+        ellipsoid_projection_internal::leftJacobian(ellipsoid_axis_angle);
+    for (int axis = 0; axis < 3; axis++) {
+      q_wrt_ellipsoid.col(3 + axis) = getRotatedSymmetricMatrixEntries(
+          ellipsoid_rot_jacobian_in_cam.col(axis), shape_in_cam);
+    }
+#endif
+    Eigen::Map<Eigen::Matrix<double,
+                             4,
+                             kEllipsoidParamterizationSize,
+                             Eigen::RowMajor>>
+        ellipsoid_jacobian_mat(ellipsoid_jacobian);
+    ellipsoid_jacobian_mat = corners_wrt_q * q_wrt_ellipsoid;
+  }
+  return true;
+}
+
+/**
+ * Get the predicted (rectified) bounding boxes for many ellipsoids seen by
+ * one camera at one robot pose.
+ *
+ * @param frame                 Per-frame projection quantities.
+ * @param ellipsoids            Ellipsoid parameters.
+ * @param corner_results[out]   Predicted rectified corners for each
+ *                              ellipsoid (same order as the ellipsoids), or
+ *                              nullopt if the ellipsoid doesn't project to a
+ *                              valid bounding box.
+ */
+inline void projectEllipsoidsRectified(
+    const EllipsoidProjectionCameraFrame &frame,
+    const std::vector<RawEllipsoid<double>> &ellipsoids,
+    std::vector<std::optional<BbCorners<double>>> &corner_results) {
+  corner_results.resize(ellipsoids.size());
+  for (size_t ellipsoid_num = 0; ellipsoid_num < ellipsoids.size();
+       ellipsoid_num++) {
+    Eigen::Vector4d corners;
+    if (projectEllipsoidRectified(
+            frame, ellipsoids[ellipsoid_num].data(), corners)) {
+      corner_results[ellipsoid_num] = corners;
+    } else {
+      corner_results[ellipsoid_num] = std::nullopt;
+    }
+  }
+}
+
+/**
+ * Get the predicted bounding boxes (in pixels) for many ellipsoids seen by
+ * one camera at one robot pose.
+ *
+ * @param robot_pose            Robot's pose in the world frame.
+ * @param cam_extrinsics        Camera's pose relative to the robot.
+ * @param cam_intrinsics        Camera intrinsics.
+ * @param ellipsoids            Ellipsoid parameters.
+ * @param corner_results[out]   Predicted corners for each ellipsoid (same
+ *                              order as the ellipsoids), or nullopt if the
+ *                              ellipsoid doesn't project to a valid bounding
+ *                              box.
+ */
+inline void projectEllipsoidsToBoundingBoxes(
+    const RawPose3d<double> &robot_pose,
+    const CameraExtrinsics<double> &cam_extrinsics,
+    const CameraIntrinsicsMat<double> &cam_intrinsics,
+    const std::vector<RawEllipsoid<double>> &ellipsoids,
+    std::vector<std::optional<BbCorners<double>>> &corner_results) {
+  EllipsoidProjectionCameraFrame frame = createEllipsoidProjectionCameraFrame(
+      robot_pose.data(), convertToAffine(cam_extrinsics).inverse());
+  projectEllipsoidsRectified(frame, ellipsoids, corner_results);
+
+  Eigen::Vector4d adjust_center(cam_intrinsics(0, 2),
+                                cam_intrinsics(0, 2),
+                                cam_intrinsics(1, 2),
+                                cam_intrinsics(1, 2));
+  Eigen::Vector4d adjust_scale(cam_intrinsics(0, 0),
+                               cam_intrinsics(0, 0),
+                               cam_intrinsics(1, 1),
+                               cam_intrinsics(1, 1));
+  for (std::optional<BbCorners<double>> &corners : corner_results) {
+    if (corners.has_value()) {
+      corners =
+          (adjust_scale.asDiagonal() * corners.value()) + adjust_center;
+    }
+  }
+}
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_ELLIPSOID_PROJECTION_KERNEL_H
@@ -44,7 +44,7 @@ namespace vslam_types_refactor {
 
 // Adapted from CalculateEpipolarErrorVec from IV_SLAM (feature_evaluator.cpp)
 // https://github.com/ut-amrl/IV_SLAM/blob/main/introspective_ORB_SLAM/src/feature_evaluator.cpp#L2754
-Eigen::Vector2d getNormalizedEpipolarErrorVec(
+inline Eigen::Vector2d getNormalizedEpipolarErrorVec(
     const CameraIntrinsicsMat<double> &intrinsics1,
     const CameraIntrinsicsMat<double> &intrinsics2,
     const CameraExtrinsics<double> &extrinsics1,
@@ -148,6 +148,19 @@ struct VisualFeatureCachedInfo {
   }
 };
 
+/**
+ * Caches of the visual feature front end (everything that changes as frames
+ * are added). Used to checkpoint and restore the front end.
+ */
+struct VisualFeatureFrontEndState {
+  std::unordered_map<FeatureId, FrameId> first_observed_frame_by_feature_;
+  std::unordered_set<FeatureId> added_feature_ids_;
+  std::unordered_map<FeatureId, VisualFeatureCachedInfo>
+      pending_feature_factors_;
+  std::unordered_map<FeatureId, VisualFeatureCachedInfo>
+      pending_feature_factors_for_initialized_features_;
+};
+
 // TODO support general pose graph
 template <typename ProblemDataType>
 class VisualFeatureFrontend {
@@ -377,6 +390,22 @@ class VisualFeatureFrontend {
     }
   }
 
+  void getState(VisualFeatureFrontEndState &state) const {
+    state.first_observed_frame_by_feature_ = first_observed_frame_by_feature_;
+    state.added_feature_ids_ = added_feature_ids_;
+    state.pending_feature_factors_ = pending_feature_factors_;
+    state.pending_feature_factors_for_initialized_features_ =
+        pending_feature_factors_for_initialized_features_;
+  }
+
+  void setState(const VisualFeatureFrontEndState &state) {
+    first_observed_frame_by_feature_ = state.first_observed_frame_by_feature_;
+    added_feature_ids_ = state.added_feature_ids_;
+    pending_feature_factors_ = state.pending_feature_factors_;
+    pending_feature_factors_for_initialized_features_ =
+        state.pending_feature_factors_for_initialized_features_;
+  }
+
  protected:
   std::function<bool(const FrameId &)> gba_checker_;
   std::function<double(
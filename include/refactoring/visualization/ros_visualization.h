@@ -8,6 +8,7 @@
 #include <cv_bridge/cv_bridge.h>
 #include <pcl_ros/point_cloud.h>
 #include <refactoring/image_processing/debugging_image_utils.h>
+#include <refactoring/image_processing/decoded_image_cache.h>
 #include <refactoring/types/ellipsoid_utils.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/Image.h>
@@ -1111,8 +1112,9 @@ class RosVisualization {
     if (image.has_value()) {
       //      image_stamp = image.value()->header.stamp;
       try {
-        cv_ptr = cv_bridge::toCvCopy(image.value(),
-                                     sensor_msgs::image_encodings::BGR8);
+        cv_ptr = DecodedImageCache::getInstance()
+                     .getDecodedImage(image.value())
+                     ->copyBgr();
         cv_ptr->header.frame_id = frame_id;
         image_stamp = ros::Time::now();
         cv_ptr->header.stamp = image_stamp;
@@ -1227,7 +1229,8 @@ class RosVisualization {
     cv_bridge::CvImagePtr cv_ptr;
     ros::Time image_stamp;
     try {
-      cv_ptr = cv_bridge::toCvCopy(image, sensor_msgs::image_encodings::BGR8);
+      cv_ptr =
+          DecodedImageCache::getInstance().getDecodedImage(image)->copyBgr();
       cv_ptr->header.frame_id = frame_id;
       image_stamp = ros::Time::now();
       cv_ptr->header.stamp = image_stamp;
@@ -1339,8 +1342,9 @@ class RosVisualization {
     if (image.has_value()) {
       //      image_stamp = image.value()->header.stamp;
       try {
-        cv_ptr = cv_bridge::toCvCopy(image.value(),
-                                     sensor_msgs::image_encodings::BGR8);
+        cv_ptr = DecodedImageCache::getInstance()
+                     .getDecodedImage(image.value())
+                     ->copyBgr();
         cv_ptr->header.frame_id = camera_frame_id;
         image_stamp = ros::Time::now();
         cv_ptr->header.stamp = image_stamp;
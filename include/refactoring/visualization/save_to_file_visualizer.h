@@ -7,6 +7,7 @@
 
 #include <base_lib/basic_utils.h>
 #include <file_io/file_access_utils.h>
+#include <refactoring/image_processing/decoded_image_cache.h>
 #include <refactoring/types/vslam_obj_opt_types_refactor.h>
 #include <util/random.h>
 
@@ -120,8 +121,9 @@ class SaveToFileVisualizer {
           sensor_msgs::Image::ConstPtr image = images.at(frame_id).at(cam_id);
           img_height_and_width = std::make_pair(image->height, image->width);
           try {
-            cv_ptr =
-                cv_bridge::toCvCopy(image, sensor_msgs::image_encodings::BGR8);
+            cv_ptr = DecodedImageCache::getInstance()
+                         .getDecodedImage(image)
+                         ->copyBgr();
             image_stamp = ros::Time::now();
             cv_ptr->header.stamp = image_stamp;
           } catch (cv_bridge::Exception &e) {
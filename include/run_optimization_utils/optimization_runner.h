@@ -6,11 +6,15 @@
 #define UT_VSLAM_OPTIMIZATION_RUNNER_H
 
 #include <debugging/optimization_logger.h>
+#include <file_io/async_checkpoint_writer.h>
 #include <file_io/cv_file_storage/object_and_reprojection_feature_pose_graph_file_storage_io.h>
+#include <file_io/cv_file_storage/offline_runner_checkpoint_file_storage_io.h>
 #include <refactoring/configuration/full_ov_slam_config.h>
 #include <refactoring/long_term_map/long_term_map_factor_creator.h>
+#include <refactoring/long_term_map/long_term_map_tiles.h>
 #include <refactoring/long_term_map/long_term_object_map_extraction.h>
 #include <refactoring/offline/offline_problem_runner.h>
+#include <refactoring/offline/pipelined_frame_feature_loader.h>
 #include <refactoring/offline/pose_graph_frame_data_adder.h>
 #include <refactoring/optimization/pose_graph_utils.h>
 #include <refactoring/visual_feature_frontend/visual_feature_front_end.h>
@@ -83,7 +87,18 @@ bool runFullOptimization(
         &ltm_factor_creator,
     LongTermObjectMapAndResults<MainLtm> &output_results,
     const FrameId &start_opt_at_frame = 0,
-    const bool &run_data_adder_for_first_frame = true) {
+    const bool &run_data_adder_for_first_frame = true,
+    const std::optional<OfflineRunnerCheckpointState> &resume_checkpoint =
+        std::nullopt,
+    const FrameId &runner_checkpoint_every_n_frames = 0,
+    const std::shared_ptr<
+        file_io::AsyncCheckpointWriter<OfflineRunnerCheckpointState>>
+        &runner_checkpoint_writer = nullptr,
+    const SessionEndMergeParams &session_end_merge_params =
+        SessionEndMergeParams(),
+    const size_t &feature_prefetch_frames = 0,
+    const bool &run_front_ends_concurrently = false,
+    const std::shared_ptr<TiledLongTermMapObjects> &ltm_tiles = nullptr) {
 #ifdef RUN_TIMERS
   // Create an instance so that the factory never goes out of scope
   CumulativeTimerFactory &instance = CumulativeTimerFactory::getInstance();
@@ -129,6 +144,11 @@ bool runFullOptimization(
 //    }
 //  }
 
+  // Index the feature tracks in the background while the rest of the
+  // optimization is set up
+  PipelinedFrameFeatureLoader feature_loader(visual_features,
+                                             feature_prefetch_frames);
+
   std::unordered_map<CameraId, std::pair<double, double>>
       img_heights_and_widths;
   for (const auto &frame_and_imgs : images) {
@@ -140,28 +160,30 @@ bool runFullOptimization(
             std::make_pair(img->height, img->width);
       }
     }
-  }
-
-  std::unordered_map<
-      FrameId,
-      std::unordered_map<CameraId,
-                         std::unordered_map<FeatureId, PixelCoord<double>>>>
-      low_level_features_map;
-
-  for (const auto &feature_track : visual_features) {
-    FeatureId feat_id = feature_track.first;
-    for (const auto &feat_obs_by_frame :
-         feature_track.second.feature_track.feature_observations_) {
-      FrameId frame_id = feat_obs_by_frame.first;
-      for (const auto &feat_obs_for_cam :
-           feat_obs_by_frame.second.pixel_by_camera_id) {
-        CameraId cam_id = feat_obs_for_cam.first;
-        low_level_features_map[frame_id][cam_id][feat_id] =
-            feat_obs_for_cam.second;
-      }
+    // Only need one image per camera
+    if (img_heights_and_widths.size() >= camera_intrinsics_by_camera.size()) {
+      break;
     }
   }
 
+  // Filled in one frame at a time as frames are added (and before frames are
+  // visualized)
+  std::unordered_map<FrameId, FrameFeatureObservations> low_level_features_map;
+  std::unordered_set<FrameId> frames_with_loaded_features;
+  std::function<void(const FrameId &)> frame_features_loader =
+      [&](const FrameId &frame_id) {
+        if (frames_with_loaded_features.find(frame_id) !=
+            frames_with_loaded_features.end()) {
+          return;
+        }
+        frames_with_loaded_features.insert(frame_id);
+        FrameFeatureObservations observations_for_frame;
+        if (feature_loader.getObservationsForFrame(frame_id,
+                                                   observations_for_frame)) {
+          low_level_features_map[frame_id] = std::move(observations_for_frame);
+        }
+      };
+
   MainProbData input_problem_data(
       camera_intrinsics_by_camera,
       camera_extrinsics_by_camera,
@@ -314,6 +336,10 @@ bool runFullOptimization(
       config.visual_feature_params_.inlier_epipolar_err_thresh_,
       config.visual_feature_params_.check_past_n_frames_for_epipolar_err_,
       config.visual_feature_params_.enforce_epipolar_error_requirement_);
+  if (resume_checkpoint.has_value()) {
+    visual_feature_fronted.setState(
+        resume_checkpoint->visual_feature_front_end_state_);
+  }
   std::function<void(const MainProbData &,
                      const MainPgPtr &,
                      const FrameId &,
@@ -388,6 +414,7 @@ bool runFullOptimization(
                                  const MainProbData &problem_data) {
         FeatureBasedContextInfo context;
         bool success = false;
+        frame_features_loader(frame_id);
         if (low_level_features_map.find(frame_id) !=
             low_level_features_map.end()) {
           if (low_level_features_map.at(frame_id).find(camera_id) !=
@@ -412,6 +439,11 @@ bool runFullOptimization(
           config.bounding_box_front_end_params_
               .feature_based_bb_association_params_,
           long_term_map_front_end_data);
+  if (resume_checkpoint.has_value() &&
+      resume_checkpoint->bounding_box_front_end_state_.has_value()) {
+    feature_based_associator_creator.setStateToRestore(
+        resume_checkpoint->bounding_box_front_end_state_.value());
+  }
   std::function<std::shared_ptr<AbstractBoundingBoxFrontEnd<
       ReprojectionErrorFactor,
       FeatureBasedFrontEndObjAssociationInfo,
@@ -439,6 +471,25 @@ bool runFullOptimization(
                 .getOrCreateFunctionTimer(kTimerNameFrameDataAdderTopLevel)
                 .get());
 #endif
+        frame_features_loader(frame_to_add);
+        if (ltm_tiles != nullptr) {
+          // Load the long-term map objects near the robot before the bounding
+          // box front end looks for objects to associate with
+          std::optional<RawPose3d<double>> prev_robot_pose;
+          if (frame_to_add > 0) {
+            prev_robot_pose = pose_graph->getRobotPose(frame_to_add - 1);
+          }
+          Pose3D<double> robot_pose;
+          if (prev_robot_pose.has_value()) {
+            robot_pose = convertToPose3D(prev_robot_pose.value());
+          } else if (!problem_data.getRobotPoseEstimateForFrame(frame_to_add,
+                                                                robot_pose)) {
+            LOG(WARNING) << "No pose to load long-term map objects near for "
+                            "frame "
+                         << frame_to_add;
+          }
+          ltm_tiles->updateWorkingSet(robot_pose.transl_, pose_graph);
+        }
         addFrameDataAssociatedBoundingBox(problem_data,
                                           pose_graph,
                                           min_frame_id,
@@ -448,7 +499,8 @@ bool runFullOptimization(
                                           pose_deviation_cov_creator,
                                           bb_retriever,
                                           bb_associator_retriever,
-                                          bb_context_retriever);
+                                          bb_context_retriever,
+                                          run_front_ends_concurrently);
       };
 
   CovarianceExtractorParams ltm_covariance_params;
@@ -494,6 +546,11 @@ bool runFullOptimization(
                                           &optimization_factors_enabled_params,
                                   LongTermObjectMapAndResults<MainLtm>
                                       &output_problem_data) {
+        if (ltm_tiles != nullptr) {
+          // The next long-term map should also have the objects that were
+          // never near this session's trajectory
+          ltm_tiles->loadAllObjects(pose_graph);
+        }
         if (!output_checkpoints_dir.empty()) {
           // Write pose graph state to file
           outputPoseGraphToFile(pose_graph,
@@ -562,8 +619,10 @@ bool runFullOptimization(
             return true;
           };
 
-  std::function<bool(const std::shared_ptr<MainPg> &)> object_merger =
-      [&](const std::shared_ptr<MainPg> &pose_graph) {
+  std::function<bool(const std::shared_ptr<MainPg> &,
+                     std::unordered_set<ObjectId> &)>
+      object_merger = [&](const std::shared_ptr<MainPg> &pose_graph,
+                          std::unordered_set<ObjectId> &merged_into_objects) {
         std::unordered_map<ObjectId, std::unordered_set<ObjectId>>
             merge_results;
         if (!merge_decider(pose_graph, merge_results)) {
@@ -584,6 +643,9 @@ bool runFullOptimization(
         if (!mergeObjects(merge_results, pose_graph, front_end)) {
           LOG(ERROR) << "Error merging objects";
         }
+        for (const auto &merge_group : merge_results) {
+          merged_into_objects.insert(merge_group.first);
+        }
         return true;
       };
 
@@ -600,19 +662,68 @@ bool runFullOptimization(
                      const VisualizationTypeEnum &,
                      const int &)>
       bound_visualization_callback =
-          std::bind(visualization_callback,
-                    img_heights_and_widths,
-                    all_observed_corner_locations_with_uncertainty,
-                    associated_observed_corner_locations,
-                    bounding_boxes_for_pending_object,
-                    pending_objects,
-                    low_level_features_map,
-                    std::placeholders::_1,
-                    std::placeholders::_2,
-                    std::placeholders::_3,
-                    std::placeholders::_4,
-                    std::placeholders::_5,
-                    std::placeholders::_6);
+          [&](const MainProbData &problem_data,
+              const MainPgPtr &pose_graph,
+              const FrameId &min_frame_id,
+              const FrameId &max_frame_id_to_opt,
+              const VisualizationTypeEnum &visualization_type,
+              const int &attempt_num) {
+            // Frames that were added before resuming from a checkpoint may
+            // not have been loaded yet
+            for (FrameId frame_id = min_frame_id;
+                 frame_id <= max_frame_id_to_opt;
+                 frame_id++) {
+              frame_features_loader(frame_id);
+            }
+            visualization_callback(
+                img_heights_and_widths,
+                all_observed_corner_locations_with_uncertainty,
+                associated_observed_corner_locations,
+                bounding_boxes_for_pending_object,
+                pending_objects,
+                low_level_features_map,
+                problem_data,
+                pose_graph,
+                min_frame_id,
+                max_frame_id_to_opt,
+                visualization_type,
+                attempt_num);
+          };
+
+  std::function<void(const MainProbData &, const MainPgPtr &, const FrameId &)>
+      frame_completed_callback;
+  if ((runner_checkpoint_every_n_frames > 0) &&
+      !output_checkpoints_dir.empty()) {
+    frame_completed_callback = [&](const MainProbData &problem_data,
+                                   const MainPgPtr &pose_graph,
+                                   const FrameId &frame_id) {
+      if ((frame_id % runner_checkpoint_every_n_frames) != 0) {
+        return;
+      }
+      OfflineRunnerCheckpointState runner_checkpoint;
+      runner_checkpoint.last_frame_processed_ = frame_id;
+      pose_graph->getState(runner_checkpoint.pose_graph_state_);
+      visual_feature_fronted.getState(
+          runner_checkpoint.visual_feature_front_end_state_);
+      // The front end isn't created until the first bounding box is seen
+      FeatureBasedBoundingBoxFrontEndState bb_front_end_state;
+      if (feature_based_associator_creator.getFrontEndState(
+              bb_front_end_state)) {
+        runner_checkpoint.bounding_box_front_end_state_ = bb_front_end_state;
+      }
+      std::string out_file =
+          file_io::ensureDirectoryPathEndsWithSlash(output_checkpoints_dir) +
+          kRunnerCheckpointOutputFileBaseName + std::to_string(frame_id) +
+          file_io::kJsonExtension;
+      LOG(INFO) << "Dumping runner checkpoint after frame " << frame_id;
+      if (runner_checkpoint_writer != nullptr) {
+        runner_checkpoint_writer->writeCheckpoint(std::move(runner_checkpoint),
+                                                  out_file);
+      } else {
+        outputRunnerCheckpointToFile(runner_checkpoint, out_file);
+      }
+    };
+  }
 
   OfflineProblemRunner<MainProbData,
                        ReprojectionErrorFactor,
@@ -633,7 +744,9 @@ bool runFullOptimization(
                              bound_visualization_callback,
                              solver_params_provider_func,
                              object_merger,
-                             gba_checker);
+                             gba_checker,
+                             frame_completed_callback,
+                             session_end_merge_params);
 
   bool optimization_result = offline_problem_runner.runOptimization(
       input_problem_data,
@@ -0,0 +1,386 @@
+//
+// Created by amanda on 3/13/23.
+//
+
+#ifndef UT_VSLAM_SOLVER_SWEEP_H
+#define UT_VSLAM_SOLVER_SWEEP_H
+
+#include <ceres/types.h>
+#include <file_io/file_io_utils.h>
+#include <glog/logging.h>
+#include <refactoring/optimization/optimization_factors_enabled_params.h>
+#include <refactoring/optimization/optimization_solver_params.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+/**
+ * Values to try for each swept setting. Settings with no values keep the value
+ * from the base parameters. Every combination of the values is run.
+ */
+struct SolverSweepParams {
+  std::vector<ceres::LinearSolverType> linear_solver_types_;
+  std::vector<ceres::TrustRegionStrategyType> trust_region_strategy_types_;
+  std::vector<int> num_threads_;
+  std::vector<double> initial_trust_region_radii_;
+  std::vector<double> reprojection_error_huber_loss_params_;
+  std::vector<double> object_observation_huber_loss_params_;
+};
+
+struct SolverSweepSetting {
+  pose_graph_optimization::OptimizationSolverParams solver_params_;
+  pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+      residual_params_;
+};
+
+/**
+ * Outcome of optimizing with one setting. Plain data so that it can be passed
+ * back from the process that ran the optimization.
+ */
+struct SolverSweepResult {
+  bool success_ = false;
+  double wall_time_ = 0;
+  double ceres_time_ = 0;
+  size_t num_iterations_ = 0;
+  double initial_cost_ = 0;
+  double final_cost_ = 0;
+};
+
+/**
+ * Parse a comma separated list of Ceres linear solver types (ex.
+ * "SPARSE_SCHUR,DENSE_SCHUR").
+ *
+ * @return False if any of the entries isn't a linear solver type.
+ */
+inline bool parseLinearSolverTypes(
+    const std::string &types_str,
+    std::vector<ceres::LinearSolverType> &linear_solver_types) {
+  for (const std::string &type_str :
+       file_io::parseCommaSeparatedStrings(types_str)) {
+    ceres::LinearSolverType linear_solver_type;
+    if (!ceres::StringToLinearSolverType(
+            std::string(file_io::trimCsvField(type_str)),
+            &linear_solver_type)) {
+      LOG(ERROR) << "Unknown linear solver type " << type_str;
+      return false;
+    }
+    linear_solver_types.emplace_back(linear_solver_type);
+  }
+  return true;
+}
+
+/**
+ * Parse a comma separated list of Ceres trust region strategies (ex.
+ * "LEVENBERG_MARQUARDT,DOGLEG").
+ *
+ * @return False if any of the entries isn't a trust region strategy.
+ */
+inline bool parseTrustRegionStrategyTypes(
+    const std::string &types_str,
+    std::vector<ceres::TrustRegionStrategyType> &strategy_types) {
+  for (const std::string &type_str :
+       file_io::parseCommaSeparatedStrings(types_str)) {
+    ceres::TrustRegionStrategyType strategy_type;
+    if (!ceres::StringToTrustRegionStrategyType(
+            std::string(file_io::trimCsvField(type_str)), &strategy_type)) {
+      LOG(ERROR) << "Unknown trust region strategy " << type_str;
+      return false;
+    }
+    strategy_types.emplace_back(strategy_type);
+  }
+  return true;
+}
+
+/**
+ * Parse a comma separated list of numbers.
+ *
+ * @return False if any of the entries isn't a number.
+ */
+template <typename NumType>
+bool parseSweepValues(const std::string &values_str,
+                      std::vector<NumType> &values) {
+  for (const std::string &value_str :
+       file_io::parseCommaSeparatedStrings(values_str)) {
+    NumType value;
+    if (!file_io::tryParseCsvField(value_str, value)) {
+      LOG(ERROR) << "Could not parse sweep value " << value_str;
+      return false;
+    }
+    values.emplace_back(value);
+  }
+  return true;
+}
+
+namespace solver_sweep_internal {
+
+/**
+ * Replace the settings with one copy per value, with the value set by the
+ * setter. Leaves the settings alone if there are no values.
+ */
+template <typename ValueType>
+void expandSettings(
+    const std::vector<ValueType> &values,
+    const std::function<void(const ValueType &, SolverSweepSetting &)> &setter,
+    std::vector<SolverSweepSetting> &settings) {
+  if (values.empty()) {
+    return;
+  }
+  std::vector<SolverSweepSetting> expanded_settings;
+  expanded_settings.reserve(settings.size() * values.size());
+  for (const SolverSweepSetting &setting : settings) {
+    for (const ValueType &value : values) {
+      expanded_settings.emplace_back(setting);
+      setter(value, expanded_settings.back());
+    }
+  }
+  settings = expanded_settings;
+}
+}  // namespace solver_sweep_internal
+
+/**
+ * Create one setting per combination of the swept values.
+ *
+ * @param base_solver_params    Solver params to use for unswept values.
+ * @param base_residual_params  Residual params to use for unswept values.
+ * @param sweep_params          Values to sweep over.
+ *
+ * @return Settings to run.
+ */
+inline std::vector<SolverSweepSetting> createSolverSweepSettings(
+    const pose_graph_optimization::OptimizationSolverParams
+        &base_solver_params,
+    const pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+        &base_residual_params,
+    const SolverSweepParams &sweep_params) {
+  SolverSweepSetting base_setting;
+  base_setting.solver_params_ = base_solver_params;
+  base_setting.residual_params_ = base_residual_params;
+  std::vector<SolverSweepSetting> settings = {base_setting};
+
+  solver_sweep_internal::expandSettings<ceres::LinearSolverType>(
+      sweep_params.linear_solver_types_,
+      [](const ceres::LinearSolverType &value, SolverSweepSetting &setting) {
+        setting.solver_params_.linear_solver_type_ = value;
+      },
+      settings);
+  solver_sweep_internal::expandSettings<ceres::TrustRegionStrategyType>(
+      sweep_params.trust_region_strategy_types_,
+      [](const ceres::TrustRegionStrategyType &value,
+         SolverSweepSetting &setting) {
+        setting.solver_params_.trust_region_strategy_type_ = value;
+      },
+      settings);
+  solver_sweep_internal::expandSettings<int>(
+      sweep_params.num_threads_,
+      [](const int &value, SolverSweepSetting &setting) {
+        setting.solver_params_.num_threads_ = value;
+      },
+      settings);
+  solver_sweep_internal::expandSettings<double>(
+      sweep_params.initial_trust_region_radii_,
+      [](const double &value, SolverSweepSetting &setting) {
+        setting.solver_params_.initial_trust_region_radius_ = value;
+      },
+      settings);
+  solver_sweep_internal::expandSettings<double>(
+      sweep_params.reprojection_error_huber_loss_params_,
+      [](const double &value, SolverSweepSetting &setting) {
+        setting.residual_params_.visual_residual_params_
+            .reprojection_error_huber_loss_param_ = value;
+      },
+      settings);
+  solver_sweep_internal::expandSettings<double>(
+      sweep_params.object_observation_huber_loss_params_,
+      [](const double &value, SolverSweepSetting &setting) {
+        setting.residual_params_.object_residual_params_
+            .object_observation_huber_loss_param_ = value;
+      },
+      settings);
+  return settings;
+}
+
+/**
+ * Create the scope for optimizing the whole trajectory with the given factors.
+ */
+inline pose_graph_optimizer::OptimizationScopeParams
+createFullTrajectoryOptimizationScope(
+    const pose_graph_optimizer::OptimizationFactorsEnabledParams
+        &factors_enabled_params,
+    const FrameId &min_frame_id,
+    const FrameId &max_frame_id) {
+  pose_graph_optimizer::OptimizationScopeParams scope;
+  scope.min_low_level_feature_observations_per_frame_ =
+      factors_enabled_params.min_low_level_feature_observations_per_frame_;
+  scope.fix_poses_ = factors_enabled_params.fix_poses_;
+  scope.fix_objects_ = factors_enabled_params.fix_objects_;
+  scope.fix_visual_features_ = factors_enabled_params.fix_visual_features_;
+  scope.fix_ltm_objects_ = factors_enabled_params.fix_ltm_objects_;
+  scope.include_visual_factors_ =
+      factors_enabled_params.include_visual_factors_;
+  scope.include_object_factors_ =
+      factors_enabled_params.include_object_factors_;
+  scope.use_pom_ = factors_enabled_params.use_pom_;
+  scope.poses_prior_to_window_to_keep_constant_ =
+      factors_enabled_params.poses_prior_to_window_to_keep_constant_;
+  scope.min_low_level_feature_observations_ =
+      factors_enabled_params.min_low_level_feature_observations_;
+  scope.min_object_observations_ =
+      factors_enabled_params.min_object_observations_;
+  scope.min_frame_id_ = min_frame_id;
+  scope.max_frame_id_ = max_frame_id;
+  return scope;
+}
+
+/**
+ * Run each setting in a child process, with up to max_processes running at
+ * once. Since each child has its own copy of the parent's memory, every
+ * setting starts from the same problem state and nothing the children do
+ * affects the parent.
+ *
+ * Processes running at the same time compete for cores, which skews their
+ * wall times, so max_processes times the threads per solve should stay below
+ * the number of cores.
+ *
+ * @param settings        Settings to run.
+ * @param max_processes   Maximum number of child processes at once.
+ * @param setting_runner  Runs the optimization for a setting (in the child).
+ * @param results[out]    Result for each setting. If a child exits without
+ *                        reporting a result (ex. crashes), the result is
+ *                        marked unsuccessful.
+ */
+inline void runSolverSweepInProcesses(
+    const std::vector<SolverSweepSetting> &settings,
+    const size_t &max_processes,
+    const std::function<SolverSweepResult(const SolverSweepSetting &)>
+        &setting_runner,
+    std::vector<SolverSweepResult> &results) {
+  results.assign(settings.size(), SolverSweepResult());
+
+  // Pid to the setting index and the read end of its result pipe
+  std::unordered_map<pid_t, std::pair<size_t, int>> running_processes;
+
+  std::function<void()> wait_for_process = [&]() {
+    int status;
+    pid_t finished_pid = waitpid(-1, &status, 0);
+    auto finished_process = running_processes.find(finished_pid);
+    if (finished_process == running_processes.end()) {
+      return;
+    }
+    size_t setting_idx = finished_process->second.first;
+    int read_fd = finished_process->second.second;
+    SolverSweepResult result;
+    if ((read(read_fd, &result, sizeof(result)) == sizeof(result)) &&
+        WIFEXITED(status) && (WEXITSTATUS(status) == 0)) {
+      results[setting_idx] = result;
+    } else {
+      LOG(ERROR) << "Solver sweep setting " << setting_idx
+                 << " did not report a result";
+    }
+    close(read_fd);
+    running_processes.erase(finished_process);
+  };
+
+  for (size_t setting_idx = 0; setting_idx < settings.size(); setting_idx++) {
+    while (running_processes.size() >= std::max(max_processes, (size_t)1)) {
+      wait_for_process();
+    }
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+      LOG(ERROR) << "Could not create pipe for solver sweep setting "
+                 << setting_idx;
+      continue;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+      LOG(ERROR) << "Could not fork for solver sweep setting " << setting_idx;
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+      continue;
+    }
+    if (pid == 0) {
+      close(pipe_fds[0]);
+      SolverSweepResult result = setting_runner(settings[setting_idx]);
+      bool written =
+          write(pipe_fds[1], &result, sizeof(result)) == sizeof(result);
+      close(pipe_fds[1]);
+      // Skip the parent's exit handlers and destructors
+      _exit(written ? 0 : 1);
+    }
+    close(pipe_fds[1]);
+    running_processes[pid] = std::make_pair(setting_idx, pipe_fds[0]);
+    LOG(INFO) << "Started solver sweep setting " << setting_idx + 1 << " of "
+              << settings.size();
+  }
+  while (!running_processes.empty()) {
+    wait_for_process();
+  }
+}
+
+/**
+ * Write one line per setting with the swept values and its result.
+ */
+inline void writeSolverSweepResultsToFile(
+    const std::string &file_name,
+    const std::vector<SolverSweepSetting> &settings,
+    const std::vector<SolverSweepResult> &results) {
+  CHECK_EQ(settings.size(), results.size());
+  std::vector<std::pair<SolverSweepSetting, SolverSweepResult>>
+      settings_and_results;
+  for (size_t setting_idx = 0; setting_idx < settings.size(); setting_idx++) {
+    settings_and_results.emplace_back(settings[setting_idx],
+                                      results[setting_idx]);
+  }
+  std::function<std::vector<std::string>(
+      const std::pair<SolverSweepSetting, SolverSweepResult> &)>
+      to_str_list_converter =
+          [](const std::pair<SolverSweepSetting, SolverSweepResult>
+                 &setting_and_result) {
+            const pose_graph_optimization::OptimizationSolverParams
+                &solver_params = setting_and_result.first.solver_params_;
+            const pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+                &residual_params = setting_and_result.first.residual_params_;
+            const SolverSweepResult &result = setting_and_result.second;
+            return std::vector<std::string>(
+                {ceres::LinearSolverTypeToString(
+                     solver_params.linear_solver_type_),
+                 ceres::TrustRegionStrategyTypeToString(
+                     solver_params.trust_region_strategy_type_),
+                 std::to_string(solver_params.num_threads_),
+                 std::to_string(solver_params.initial_trust_region_radius_),
+                 std::to_string(residual_params.visual_residual_params_
+                                    .reprojection_error_huber_loss_param_),
+                 std::to_string(residual_params.object_residual_params_
+                                    .object_observation_huber_loss_param_),
+                 std::to_string(result.success_ ? 1 : 0),
+                 std::to_string(result.wall_time_),
+                 std::to_string(result.ceres_time_),
+                 std::to_string(result.num_iterations_),
+                 std::to_string(result.initial_cost_),
+                 std::to_string(result.final_cost_)});
+          };
+  file_io::writeObjectsToFile(file_name,
+                              {"linear_solver_type",
+                               "trust_region_strategy",
+                               "num_threads",
+                               "initial_trust_region_radius",
+                               "reprojection_error_huber_loss_param",
+                               "object_observation_huber_loss_param",
+                               "success",
+                               "wall_time",
+                               "ceres_time",
+                               "num_iterations",
+                               "initial_cost",
+                               "final_cost"},
+                              settings_and_results,
+                              to_str_list_converter);
+}
+
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_SOLVER_SWEEP_H
@@ -0,0 +1,219 @@
+//
+// Created by amanda on 3/9/23.
+//
+
+// Benchmarks for projecting ellipsoids to bounding boxes, comparing the
+// templated projection, the closed-form kernel, and the bounding box factors.
+//
+// Each benchmark is run at several ellipsoid counts and reports the
+// ellipsoids processed per second.
+
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+#include <refactoring/factors/bounding_box_factor.h>
+#include <refactoring/types/ellipsoid_projection_kernel.h>
+
+#include <map>
+#include <memory>
+#include <random>
+
+using namespace vslam_types_refactor;
+
+namespace {
+
+/**
+ * Camera, robot pose, ellipsoids, and bounding box factors shared by all
+ * benchmarks for one ellipsoid count.
+ */
+struct ProjectionScene {
+  CameraIntrinsicsMat<double> intrinsics_;
+  CameraExtrinsics<double> extrinsics_;
+  Eigen::Affine3d robot_to_cam_tf_;
+  RawPose3d<double> robot_pose_;
+  std::vector<RawEllipsoid<double>> ellipsoids_;
+  std::vector<std::unique_ptr<ceres::CostFunction>> autodiff_factors_;
+  std::vector<std::unique_ptr<ceres::CostFunction>> analytic_factors_;
+};
+
+std::unique_ptr<ProjectionScene> createProjectionScene(
+    const int64_t &num_ellipsoids) {
+  std::unique_ptr<ProjectionScene> scene = std::make_unique<ProjectionScene>();
+  scene->intrinsics_ << 500, 0, 320, 0, 500, 240, 0, 0, 1;
+  Eigen::Matrix3d cam_rot_in_robot;
+  cam_rot_in_robot << 0, 0, 1, -1, 0, 0, 0, -1, 0;
+  scene->extrinsics_ =
+      CameraExtrinsics<double>(Position3d<double>(0.2, 0.05, 0.7),
+                               Orientation3D<double>(cam_rot_in_robot));
+  scene->robot_to_cam_tf_ = convertToAffine(scene->extrinsics_).inverse();
+  scene->robot_pose_ << 1.0, -0.5, 0.1, 0.02, -0.03, 0.4;
+
+  // Ellipsoids scattered in front of the camera
+  std::mt19937 rand_gen(0);
+  std::uniform_real_distribution<double> dist_ahead(4.0, 12.0);
+  std::uniform_real_distribution<double> dist_lateral(-3.0, 3.0);
+  std::uniform_real_distribution<double> dist_angle(-0.5, 0.5);
+  std::uniform_real_distribution<double> dist_dim(0.3, 1.5);
+  for (int64_t ellipsoid_num = 0; ellipsoid_num < num_ellipsoids;
+       ellipsoid_num++) {
+    RawEllipsoid<double> ellipsoid;
+#ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
+    ellipsoid << dist_ahead(rand_gen), dist_lateral(rand_gen),
+        dist_lateral(rand_gen) / 3, dist_angle(rand_gen), dist_dim(rand_gen),
+        dist_dim(rand_gen), dist_dim(rand_gen);
+#else
+    ellipsoid << dist_ahead(rand_gen), dist_lateral(rand_gen),
+        dist_lateral(rand_gen) / 3, dist_angle(rand_gen), dist_angle(rand_gen),
+        dist_angle(rand_gen), dist_dim(rand_gen), dist_dim(rand_gen),
+        dist_dim(rand_gen);
+#endif
+    scene->ellipsoids_.emplace_back(ellipsoid);
+  }
+
+  BbCorners<double> detection(300, 340, 220, 260);
+  Covariance<double, 4> bb_cov = Covariance<double, 4>::Identity() * 25;
+  for (int64_t ellipsoid_num = 0; ellipsoid_num < num_ellipsoids;
+       ellipsoid_num++) {
+    scene->autodiff_factors_.emplace_back(
+        BoundingBoxFactor::createBoundingBoxFactor(1e6,
+                                                   detection,
+                                                   scene->intrinsics_,
+                                                   scene->extrinsics_,
+                                                   bb_cov,
+                                                   std::nullopt,
+                                                   std::nullopt,
+                                                   std::nullopt));
+    scene->analytic_factors_.emplace_back(
+        BoundingBoxCostFunctionAnalyticJacobian::createBoundingBoxFactor(
+            1e6,
+            detection,
+            scene->intrinsics_,
+            scene->extrinsics_,
+            bb_cov,
+            std::nullopt,
+            std::nullopt,
+            std::nullopt));
+  }
+  return scene;
+}
+
+const ProjectionScene &getProjectionScene(const benchmark::State &state) {
+  static std::map<int64_t, std::unique_ptr<ProjectionScene>> scenes_by_size;
+  std::unique_ptr<ProjectionScene> &scene = scenes_by_size[state.range(0)];
+  if (scene == nullptr) {
+    scene = createProjectionScene(state.range(0));
+  }
+  return *scene;
+}
+
+void setEllipsoidsProcessed(const ProjectionScene &scene,
+                            benchmark::State &state) {
+  state.SetItemsProcessed(state.iterations() * scene.ellipsoids_.size());
+}
+
+void BM_TemplatedCorners(benchmark::State &state) {
+  const ProjectionScene &scene = getProjectionScene(state);
+  Eigen::Vector4d corners;
+  for (auto _ : state) {
+    for (const RawEllipsoid<double> &ellipsoid : scene.ellipsoids_) {
+      getCornerLocationsVectorRectified(ellipsoid.data(),
+                                        scene.robot_pose_.data(),
+                                        scene.robot_to_cam_tf_,
+                                        corners);
+      benchmark::DoNotOptimize(corners);
+    }
+  }
+  setEllipsoidsProcessed(scene, state);
+}
+
+void BM_KernelCorners(benchmark::State &state) {
+  const ProjectionScene &scene = getProjectionScene(state);
+  Eigen::Vector4d corners;
+  for (auto _ : state) {
+    EllipsoidProjectionCameraFrame frame = createEllipsoidProjectionCameraFrame(
+        scene.robot_pose_.data(), scene.robot_to_cam_tf_);
+    for (const RawEllipsoid<double> &ellipsoid : scene.ellipsoids_) {
+      projectEllipsoidRectified(frame, ellipsoid.data(), corners);
+      benchmark::DoNotOptimize(corners);
+    }
+  }
+  setEllipsoidsProcessed(scene, state);
+}
+
+void BM_KernelBatchCorners(benchmark::State &state) {
+  const ProjectionScene &scene = getProjectionScene(state);
+  for (auto _ : state) {
+    std::vector<std::optional<BbCorners<double>>> batch_corners;
+    projectEllipsoidsToBoundingBoxes(scene.robot_pose_,
+                                     scene.extrinsics_,
+                                     scene.intrinsics_,
+                                     scene.ellipsoids_,
+                                     batch_corners);
+    benchmark::DoNotOptimize(batch_corners.data());
+  }
+  setEllipsoidsProcessed(scene, state);
+}
+
+/**
+ * Evaluate each factor's residuals and jacobians once per iteration.
+ */
+void evaluateFactors(
+    const ProjectionScene &scene,
+    const std::vector<std::unique_ptr<ceres::CostFunction>> &factors,
+    benchmark::State &state) {
+  double residuals[4];
+  double ellipsoid_jacobian[4 * kEllipsoidParamterizationSize];
+  double robot_pose_jacobian[4 * kRobotPoseParameterizationSize];
+  double *jacobians[2] = {ellipsoid_jacobian, robot_pose_jacobian};
+  for (auto _ : state) {
+    for (size_t ellipsoid_num = 0; ellipsoid_num < factors.size();
+         ellipsoid_num++) {
+      const double *params[2] = {scene.ellipsoids_[ellipsoid_num].data(),
+                                 scene.robot_pose_.data()};
+      factors[ellipsoid_num]->Evaluate(params, residuals, jacobians);
+      benchmark::DoNotOptimize(residuals);
+      benchmark::DoNotOptimize(jacobians);
+    }
+  }
+  setEllipsoidsProcessed(scene, state);
+}
+
+void BM_AutodiffFactorWithJacobians(benchmark::State &state) {
+  const ProjectionScene &scene = getProjectionScene(state);
+  evaluateFactors(scene, scene.autodiff_factors_, state);
+}
+
+void BM_AnalyticFactorWithJacobians(benchmark::State &state) {
+  const ProjectionScene &scene = getProjectionScene(state);
+  evaluateFactors(scene, scene.analytic_factors_, state);
+}
+
+/**
+ * Ellipsoid counts to run each benchmark at.
+ */
+void addEllipsoidCounts(benchmark::internal::Benchmark *benchmark) {
+  benchmark->ArgName("ellipsoids");
+  benchmark->Arg(10);
+  benchmark->Arg(100);
+  benchmark->Arg(1000);
+}
+
+}  // namespace
+
+BENCHMARK(BM_TemplatedCorners)->Apply(addEllipsoidCounts);
+BENCHMARK(BM_KernelCorners)->Apply(addEllipsoidCounts);
+BENCHMARK(BM_KernelBatchCorners)->Apply(addEllipsoidCounts);
+BENCHMARK(BM_AutodiffFactorWithJacobians)->Apply(addEllipsoidCounts);
+BENCHMARK(BM_AnalyticFactorWithJacobians)->Apply(addEllipsoidCounts);
+
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
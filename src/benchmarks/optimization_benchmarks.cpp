@@ -0,0 +1,457 @@
+//
+// Created by amanda on 3/12/23.
+//
+
+// Throughput benchmarks for the optimization back end on synthetic scenes.
+//
+// Each benchmark is run at several scene sizes (poses, landmarks, ellipsoids).
+// To record results for tracking, run with
+//   --benchmark_out=<file>.json --benchmark_out_format=json
+// and compare runs with Google Benchmark's compare.py.
+
+#include <benchmark/benchmark.h>
+#include <benchmarks/synthetic_scene_generator.h>
+#include <glog/logging.h>
+#include <refactoring/bounding_box_frontend/bounding_box_front_end_helpers.h>
+#include <refactoring/long_term_map/long_term_object_map_extraction.h>
+#include <refactoring/optimization/object_pose_graph_optimizer.h>
+#include <run_optimization_utils/run_opt_utils.h>
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+using namespace vslam_types_refactor;
+
+namespace {
+
+/**
+ * Number of frames in the local bundle adjustment window.
+ */
+const FrameId kLocalBaWindowSize = 20;
+
+/**
+ * Solver iterations are capped so that timings measure per-iteration cost
+ * rather than how quickly a particular scene converges.
+ */
+const int kMaxSolverIterations = 10;
+
+/**
+ * Minimum IoU for a bounding box to be considered a match for an object.
+ */
+const double kMinAssociationIou = 0.2;
+
+typedef pose_graph_optimizer::ObjectPoseGraphOptimizer<ReprojectionErrorFactor,
+                                                       util::EmptyStruct,
+                                                       MainPg>
+    BenchmarkOptimizer;
+
+/**
+ * Scene and pose graph shared by all benchmarks at one scale. Benchmarks that
+ * modify the pose graph work on a deep copy of it.
+ */
+struct BenchmarkScene {
+  SyntheticSceneParams params_;
+  SyntheticScene scene_;
+  MainPgPtr pose_graph_;
+};
+
+const BenchmarkScene &getBenchmarkScene(const benchmark::State &state) {
+  static std::map<std::tuple<int64_t, int64_t, int64_t>,
+                  std::unique_ptr<BenchmarkScene>>
+      scenes_by_size;
+  std::tuple<int64_t, int64_t, int64_t> scene_size =
+      std::make_tuple(state.range(0), state.range(1), state.range(2));
+  std::unique_ptr<BenchmarkScene> &scene = scenes_by_size[scene_size];
+  if (scene == nullptr) {
+    scene = std::make_unique<BenchmarkScene>();
+    scene->params_.num_poses_ = state.range(0);
+    scene->params_.num_landmarks_ = state.range(1);
+    scene->params_.num_ellipsoids_ = state.range(2);
+    scene->scene_ = generateSyntheticScene(scene->params_);
+    scene->pose_graph_ =
+        createPoseGraphForSyntheticScene(scene->scene_, scene->params_);
+  }
+  return *scene;
+}
+
+/**
+ * Residual creation functions, as set up by the optimization runner without a
+ * long-term map.
+ */
+class BenchmarkResidualCreator {
+ public:
+  BenchmarkResidualCreator()
+      : cached_info_creator_(dummyCachedInfoCreator),
+        long_term_map_residual_creator_(
+            [](const MainFactorInfo &,
+               const MainPgPtr &,
+               const pose_graph_optimization::
+                   ObjectVisualPoseGraphResidualParams &,
+               const std::function<bool(const MainFactorInfo &,
+                                        const MainPgPtr &,
+                                        util::EmptyStruct &)> &,
+               ceres::Problem *,
+               ceres::ResidualBlockId &,
+               util::EmptyStruct &) { return false; }) {
+    residual_creator_ = generateResidualCreator(long_term_map_residual_creator_,
+                                                cached_info_creator_);
+    non_debug_residual_creator_ =
+        [&](const MainFactorInfo &factor_id,
+            const pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+                &residual_params,
+            const MainPgPtr &pose_graph,
+            ceres::Problem *problem,
+            ceres::ResidualBlockId &residual_id,
+            util::EmptyStruct &cached_info) {
+          return residual_creator_(factor_id,
+                                   residual_params,
+                                   pose_graph,
+                                   false,
+                                   problem,
+                                   residual_id,
+                                   cached_info);
+        };
+  }
+
+  BenchmarkResidualCreator(const BenchmarkResidualCreator &) = delete;
+  BenchmarkResidualCreator &operator=(const BenchmarkResidualCreator &) =
+      delete;
+
+  BenchmarkOptimizer createOptimizer() const {
+    return BenchmarkOptimizer(checkFactorRefresh, non_debug_residual_creator_);
+  }
+
+  std::function<bool(
+      const MainFactorInfo &,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams &,
+      const MainPgPtr &,
+      const bool &,
+      ceres::Problem *,
+      ceres::ResidualBlockId &,
+      util::EmptyStruct &)>
+      residual_creator_;
+
+ private:
+  // The generated residual creator refers to these, so they must stay put
+  std::function<bool(
+      const MainFactorInfo &, const MainPgPtr &, util::EmptyStruct &)>
+      cached_info_creator_;
+  std::function<bool(
+      const MainFactorInfo &,
+      const MainPgPtr &,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams &,
+      const std::function<bool(
+          const MainFactorInfo &, const MainPgPtr &, util::EmptyStruct &)> &,
+      ceres::Problem *,
+      ceres::ResidualBlockId &,
+      util::EmptyStruct &)>
+      long_term_map_residual_creator_;
+  std::function<bool(
+      const MainFactorInfo &,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams &,
+      const MainPgPtr &,
+      ceres::Problem *,
+      ceres::ResidualBlockId &,
+      util::EmptyStruct &)>
+      non_debug_residual_creator_;
+};
+
+pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+createResidualParams() {
+  pose_graph_optimization::ObjectVisualPoseGraphResidualParams residual_params;
+  pose_graph_optimization::RelativePoseCovarianceOdomModelParams &cov_params =
+      residual_params.relative_pose_cov_params_;
+  cov_params.transl_error_mult_for_transl_error_ = 0.1;
+  cov_params.transl_error_mult_for_rot_error_ = 0.1;
+  cov_params.rot_error_mult_for_transl_error_ = 0.1;
+  cov_params.rot_error_mult_for_rot_error_ = 0.1;
+  return residual_params;
+}
+
+pose_graph_optimizer::OptimizationScopeParams createOptimizationScope(
+    const FrameId &min_frame_id, const FrameId &max_frame_id) {
+  pose_graph_optimizer::OptimizationScopeParams scope;
+  // No relative pose factors, so every frame is constrained only by features
+  scope.min_low_level_feature_observations_per_frame_ = 0;
+  scope.include_object_factors_ = true;
+  scope.include_visual_factors_ = true;
+  scope.fix_poses_ = false;
+  scope.fix_objects_ = false;
+  scope.fix_visual_features_ = false;
+  scope.use_pom_ = false;
+  scope.fix_ltm_objects_ = false;
+  scope.poses_prior_to_window_to_keep_constant_ = 1;
+  scope.min_frame_id_ = min_frame_id;
+  scope.max_frame_id_ = max_frame_id;
+  return scope;
+}
+
+pose_graph_optimization::OptimizationSolverParams createSolverParams() {
+  pose_graph_optimization::OptimizationSolverParams solver_params;
+  solver_params.max_num_iterations_ = kMaxSolverIterations;
+  return solver_params;
+}
+
+void setSceneCounters(const BenchmarkScene &scene, benchmark::State &state) {
+  state.counters["feature_obs"] = scene.scene_.feature_observations_.size();
+  state.counters["object_obs"] = scene.scene_.object_observations_.size();
+}
+
+double getIou(const BbCorners<double> &bb_1, const BbCorners<double> &bb_2) {
+  double intersection_width =
+      std::min(bb_1(1), bb_2(1)) - std::max(bb_1(0), bb_2(0));
+  double intersection_height =
+      std::min(bb_1(3), bb_2(3)) - std::max(bb_1(2), bb_2(2));
+  if ((intersection_width <= 0) || (intersection_height <= 0)) {
+    return 0;
+  }
+  double intersection = intersection_width * intersection_height;
+  double area_1 = (bb_1(1) - bb_1(0)) * (bb_1(3) - bb_1(2));
+  double area_2 = (bb_2(1) - bb_2(0)) * (bb_2(3) - bb_2(2));
+  return intersection / (area_1 + area_2 - intersection);
+}
+
+/**
+ * Solve bundle adjustment over the frames from min_frame_id to the end of the
+ * trajectory, on a fresh copy of the pose graph each iteration.
+ */
+void runBundleAdjustmentBenchmark(benchmark::State &state,
+                                  const FrameId &window_size) {
+  const BenchmarkScene &scene = getBenchmarkScene(state);
+  BenchmarkResidualCreator residual_creator;
+  FrameId max_frame_id = scene.params_.num_poses_ - 1;
+  FrameId min_frame_id =
+      (max_frame_id > window_size) ? (max_frame_id - window_size) : 0;
+  pose_graph_optimizer::OptimizationScopeParams scope =
+      createOptimizationScope(min_frame_id, max_frame_id);
+  pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+      residual_params = createResidualParams();
+  pose_graph_optimization::OptimizationSolverParams solver_params =
+      createSolverParams();
+  std::optional<OptimizationLogger> opt_logger;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    MainPgPtr pose_graph = scene.pose_graph_->makeDeepCopy();
+    BenchmarkOptimizer optimizer = residual_creator.createOptimizer();
+    ceres::Problem::Options problem_options =
+        createProblemOptionsForPooledLossFunctions();
+    problem_options.evaluation_callback =
+        pose_graph->getRobotPoseTransformCache().get();
+    std::unique_ptr<ceres::Problem> problem =
+        std::make_unique<ceres::Problem>(problem_options);
+    state.ResumeTiming();
+
+    optimizer.buildPoseGraphOptimization(
+        scope, residual_params, pose_graph, problem.get(), opt_logger);
+    bool solved = optimizer.solveOptimization(
+        problem.get(), solver_params, {}, opt_logger, nullptr, nullptr);
+    benchmark::DoNotOptimize(solved);
+
+    state.PauseTiming();
+    problem.reset();
+    state.ResumeTiming();
+  }
+  setSceneCounters(scene, state);
+}
+
+void BM_ResidualConstruction(benchmark::State &state) {
+  const BenchmarkScene &scene = getBenchmarkScene(state);
+  BenchmarkResidualCreator residual_creator;
+  pose_graph_optimizer::OptimizationScopeParams scope =
+      createOptimizationScope(0, scene.params_.num_poses_ - 1);
+  pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+      residual_params = createResidualParams();
+  std::optional<OptimizationLogger> opt_logger;
+  MainPgPtr pose_graph = scene.pose_graph_->makeDeepCopy();
+
+  int num_residual_blocks = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    BenchmarkOptimizer optimizer = residual_creator.createOptimizer();
+    ceres::Problem::Options problem_options =
+        createProblemOptionsForPooledLossFunctions();
+    problem_options.evaluation_callback =
+        pose_graph->getRobotPoseTransformCache().get();
+    std::unique_ptr<ceres::Problem> problem =
+        std::make_unique<ceres::Problem>(problem_options);
+    state.ResumeTiming();
+
+    optimizer.buildPoseGraphOptimization(
+        scope, residual_params, pose_graph, problem.get(), opt_logger);
+
+    state.PauseTiming();
+    num_residual_blocks = problem->NumResidualBlocks();
+    problem.reset();
+    state.ResumeTiming();
+  }
+  setSceneCounters(scene, state);
+  state.counters["residual_blocks"] = num_residual_blocks;
+}
+
+void BM_LocalBundleAdjustment(benchmark::State &state) {
+  runBundleAdjustmentBenchmark(state, kLocalBaWindowSize);
+}
+
+void BM_GlobalBundleAdjustment(benchmark::State &state) {
+  runBundleAdjustmentBenchmark(state, state.range(0));
+}
+
+void BM_PoseGraphDeepCopy(benchmark::State &state) {
+  const BenchmarkScene &scene = getBenchmarkScene(state);
+  for (auto _ : state) {
+    MainPgPtr pose_graph_copy = scene.pose_graph_->makeDeepCopy();
+    benchmark::DoNotOptimize(pose_graph_copy.get());
+  }
+  setSceneCounters(scene, state);
+}
+
+/**
+ * Geometric association of every frame's bounding boxes to the current
+ * ellipsoid estimates: project the ellipsoids, score each bounding box against
+ * the projections by IoU, and solve the assignment.
+ */
+void BM_BoundingBoxAssociation(benchmark::State &state) {
+  const BenchmarkScene &scene = getBenchmarkScene(state);
+  const CameraExtrinsics<double> &extrinsics =
+      scene.scene_.camera_extrinsics_by_camera_.at(kSyntheticSceneCameraId);
+  const CameraIntrinsicsMat<double> &intrinsics =
+      scene.scene_.camera_intrinsics_by_camera_.at(kSyntheticSceneCameraId);
+
+  std::unordered_map<ObjectId, EllipsoidEstimateNode> ellipsoid_estimates;
+  scene.pose_graph_->getEllipsoidEstimatePtrs(ellipsoid_estimates);
+  std::vector<ObjectId> object_ids;
+  std::vector<RawEllipsoid<double>> ellipsoids;
+  for (const auto &obj_and_estimate : ellipsoid_estimates) {
+    object_ids.emplace_back(obj_and_estimate.first);
+    ellipsoids.emplace_back(*(obj_and_estimate.second.ellipsoid_));
+  }
+  std::unordered_map<FrameId, std::vector<BbCorners<double>>> bbs_by_frame;
+  for (const ObjectObservationFactor &factor :
+       scene.scene_.object_observations_) {
+    bbs_by_frame[factor.frame_id_].emplace_back(factor.bounding_box_corners_);
+  }
+
+  int64_t num_matched = 0;
+  for (auto _ : state) {
+    num_matched = 0;
+    for (const auto &frame_and_bbs : bbs_by_frame) {
+      std::optional<RawPose3d<double>> robot_pose =
+          scene.pose_graph_->getRobotPose(frame_and_bbs.first);
+      std::vector<std::optional<BbCorners<double>>> projected_bbs;
+      projectEllipsoidsToBoundingBoxes(robot_pose.value(),
+                                       extrinsics,
+                                       intrinsics,
+                                       ellipsoids,
+                                       projected_bbs);
+
+      std::vector<std::vector<std::pair<AssociatedObjectIdentifier, double>>>
+          candidates_with_scores(frame_and_bbs.second.size());
+      for (size_t bb_idx = 0; bb_idx < frame_and_bbs.second.size();
+           bb_idx++) {
+        for (size_t obj_idx = 0; obj_idx < projected_bbs.size(); obj_idx++) {
+          if (!projected_bbs[obj_idx].has_value()) {
+            continue;
+          }
+          double iou = getIou(frame_and_bbs.second[bb_idx],
+                              projected_bbs[obj_idx].value());
+          if (iou < kMinAssociationIou) {
+            continue;
+          }
+          AssociatedObjectIdentifier candidate;
+          candidate.initialized_ellipsoid_ = true;
+          candidate.object_id_ = object_ids[obj_idx];
+          candidates_with_scores[bb_idx].emplace_back(candidate, iou);
+        }
+      }
+      std::vector<AssociatedObjectIdentifier> assignments =
+          optimallyAssignBoundingBoxes(candidates_with_scores, 0);
+      for (const AssociatedObjectIdentifier &assignment : assignments) {
+        if (assignment.initialized_ellipsoid_) {
+          num_matched++;
+        }
+      }
+    }
+    benchmark::DoNotOptimize(num_matched);
+  }
+  setSceneCounters(scene, state);
+  state.counters["matched_bbs"] = num_matched;
+}
+
+void BM_LongTermMapCovarianceExtraction(benchmark::State &state) {
+  const BenchmarkScene &scene = getBenchmarkScene(state);
+  BenchmarkResidualCreator residual_creator;
+
+  std::function<bool(const FactorType &, const FeatureFactorId &, ObjectId &)>
+      long_term_map_obj_retriever = [](const FactorType &,
+                                       const FeatureFactorId &,
+                                       ObjectId &) { return false; };
+  pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+      residual_params = createResidualParams();
+  IndependentEllipsoidsLongTermObjectMapExtractor<util::EmptyStruct>
+      ltm_extractor(CovarianceExtractorParams(),
+                    residual_creator.residual_creator_,
+                    long_term_map_obj_retriever,
+                    LongTermMapExtractionTunableParams(),
+                    residual_params,
+                    createSolverParams());
+  pose_graph_optimizer::OptimizationFactorsEnabledParams factors_enabled;
+  factors_enabled.min_low_level_feature_observations_per_frame_ = 0;
+  std::function<bool(std::unordered_map<ObjectId, util::EmptyStruct> &)>
+      front_end_map_data_extractor =
+          [](std::unordered_map<ObjectId, util::EmptyStruct> &) {
+            return true;
+          };
+
+  for (auto _ : state) {
+    IndependentEllipsoidsLongTermObjectMap<util::EmptyStruct> ltm;
+    bool extracted =
+        ltm_extractor.extractLongTermObjectMap(scene.pose_graph_,
+                                               factors_enabled,
+                                               front_end_map_data_extractor,
+                                               "",
+                                               std::nullopt,
+                                               ltm);
+    if (!extracted) {
+      state.SkipWithError("Long-term map extraction failed");
+      break;
+    }
+  }
+  setSceneCounters(scene, state);
+}
+
+/**
+ * Scene sizes (poses, landmarks, ellipsoids) to run each benchmark at.
+ */
+void addSceneSizes(benchmark::internal::Benchmark *benchmark) {
+  benchmark->ArgNames({"poses", "landmarks", "ellipsoids"});
+  benchmark->Args({50, 500, 10});
+  benchmark->Args({200, 2000, 40});
+  benchmark->Args({800, 8000, 160});
+  benchmark->Unit(benchmark::kMillisecond);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ResidualConstruction)->Apply(addSceneSizes);
+BENCHMARK(BM_LocalBundleAdjustment)->Apply(addSceneSizes);
+BENCHMARK(BM_GlobalBundleAdjustment)->Apply(addSceneSizes);
+BENCHMARK(BM_PoseGraphDeepCopy)->Apply(addSceneSizes);
+BENCHMARK(BM_BoundingBoxAssociation)->Apply(addSceneSizes);
+BENCHMARK(BM_LongTermMapCovarianceExtraction)->Apply(addSceneSizes);
+
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  // The optimizer logs full solver reports at INFO and the projection warns
+  // about ellipsoids behind the camera, which is expected for these scenes
+  FLAGS_logtostderr = true;
+  FLAGS_minloglevel = google::ERROR;
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
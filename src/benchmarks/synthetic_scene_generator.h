@@ -0,0 +1,325 @@
+//
+// Created by amanda on 3/12/23.
+//
+
+#ifndef UT_VSLAM_SYNTHETIC_SCENE_GENERATOR_H
+#define UT_VSLAM_SYNTHETIC_SCENE_GENERATOR_H
+
+#include <refactoring/optimization/object_pose_graph.h>
+#include <refactoring/types/ellipsoid_projection_kernel.h>
+#include <refactoring/types/vslam_obj_opt_types_refactor.h>
+#include <refactoring/types/vslam_types_math_util.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vslam_types_refactor {
+
+const CameraId kSyntheticSceneCameraId = 1;
+const std::string kSyntheticSceneSemanticClass = "synthetic";
+
+/**
+ * Parameters for generating a synthetic scene: a robot driving along a gently
+ * curving path through a corridor of landmarks, with ellipsoidal objects on
+ * both sides of the path.
+ */
+struct SyntheticSceneParams {
+  size_t num_poses_ = 100;
+  size_t num_landmarks_ = 1000;
+  size_t num_ellipsoids_ = 20;
+
+  /**
+   * Distance (m) travelled between poses.
+   */
+  double pose_spacing_ = 0.5;
+
+  /**
+   * Landmarks and ellipsoids farther than this (m) from the camera aren't
+   * observed.
+   */
+  double max_observation_depth_ = 25;
+
+  double pixel_noise_std_dev_ = 1.0;
+  double bounding_box_noise_std_dev_ = 3.0;
+
+  /**
+   * Standard deviations of the noise added to the estimates the pose graph is
+   * initialized with (robot/object position (m), robot/object orientation
+   * (rad), landmark position (m), object dimensions (m)).
+   */
+  double init_position_noise_std_dev_ = 0.1;
+  double init_orientation_noise_std_dev_ = 0.02;
+  double init_landmark_noise_std_dev_ = 0.2;
+  double init_dimension_noise_std_dev_ = 0.1;
+
+  unsigned int random_seed_ = 0;
+};
+
+/**
+ * Synthetic scene with ground truth and noisy measurements.
+ */
+struct SyntheticScene {
+  std::unordered_map<CameraId, CameraIntrinsicsMat<double>>
+      camera_intrinsics_by_camera_;
+  std::unordered_map<CameraId, CameraExtrinsics<double>>
+      camera_extrinsics_by_camera_;
+  std::pair<double, double> img_height_and_width_;
+
+  /**
+   * Ground truth. Frame ids and feature ids are the indices in these vectors,
+   * and object i is added to the pose graph with id i + 1.
+   */
+  std::vector<Pose3D<double>> robot_poses_;
+  std::vector<Position3d<double>> landmarks_;
+  std::vector<RawEllipsoid<double>> ellipsoids_;
+
+  /**
+   * Noisy measurements. Frame ids of the bounding boxes match the frame
+   * ids of the observations at the same index.
+   */
+  std::vector<ReprojectionErrorFactor> feature_observations_;
+  std::vector<ObjectObservationFactor> object_observations_;
+
+  std::unordered_map<std::string,
+                     std::pair<ObjectDim<double>, Covariance<double, 3>>>
+      shape_mean_and_cov_by_semantic_class_;
+};
+
+namespace synthetic_scene_internal {
+inline RawEllipsoid<double> createRawEllipsoid(const Position3d<double> &center,
+                                               const double &yaw,
+                                               const ObjectDim<double> &dims) {
+  RawEllipsoid<double> ellipsoid;
+#ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
+  ellipsoid << center, yaw, dims;
+#else
+  ellipsoid << center, 0, 0, yaw, dims;
+#endif
+  return ellipsoid;
+}
+}  // namespace synthetic_scene_internal
+
+/**
+ * Generate a synthetic scene.
+ *
+ * @param params  Scene parameters.
+ *
+ * @return Scene with ground truth and noisy observations.
+ */
+inline SyntheticScene generateSyntheticScene(
+    const SyntheticSceneParams &params) {
+  SyntheticScene scene;
+  std::mt19937 rand_gen(params.random_seed_);
+  std::normal_distribution<double> unit_noise(0.0, 1.0);
+
+  CameraIntrinsicsMat<double> intrinsics;
+  intrinsics << 500, 0, 320, 0, 500, 240, 0, 0, 1;
+  scene.img_height_and_width_ = std::make_pair(480.0, 640.0);
+  // Camera looking along the robot's x axis
+  Eigen::Matrix3d cam_rot_in_robot;
+  cam_rot_in_robot << 0, 0, 1, -1, 0, 0, 0, -1, 0;
+  CameraExtrinsics<double> extrinsics(Position3d<double>(0.2, 0.05, 0.7),
+                                      Orientation3D<double>(cam_rot_in_robot));
+  scene.camera_intrinsics_by_camera_[kSyntheticSceneCameraId] = intrinsics;
+  scene.camera_extrinsics_by_camera_[kSyntheticSceneCameraId] = extrinsics;
+
+  // Sinusoidal path along the x axis
+  const double kLateralAmplitude = 2.0;
+  const double kLateralFrequency = 0.1;
+  for (size_t pose_num = 0; pose_num < params.num_poses_; pose_num++) {
+    double x = pose_num * params.pose_spacing_;
+    double y = kLateralAmplitude * sin(kLateralFrequency * x);
+    double yaw = atan(kLateralAmplitude * kLateralFrequency *
+                      cos(kLateralFrequency * x));
+    scene.robot_poses_.emplace_back(
+        Position3d<double>(x, y, 0),
+        Orientation3D<double>(yaw, Eigen::Vector3d::UnitZ()));
+  }
+  double path_length = params.num_poses_ * params.pose_spacing_;
+
+  std::uniform_real_distribution<double> landmark_x(
+      -5, path_length + params.max_observation_depth_);
+  std::uniform_real_distribution<double> landmark_y(-8, 8);
+  std::uniform_real_distribution<double> landmark_z(0, 4);
+  for (size_t landmark_num = 0; landmark_num < params.num_landmarks_;
+       landmark_num++) {
+    scene.landmarks_.emplace_back(
+        landmark_x(rand_gen), landmark_y(rand_gen), landmark_z(rand_gen));
+  }
+
+  // Objects alternate between the two sides of the path
+  std::uniform_real_distribution<double> object_x(0, path_length + 10);
+  std::uniform_real_distribution<double> object_offset(3.5, 6);
+  std::uniform_real_distribution<double> object_yaw(-M_PI, M_PI);
+  std::uniform_real_distribution<double> object_dim(0.5, 1.5);
+  for (size_t ellipsoid_num = 0; ellipsoid_num < params.num_ellipsoids_;
+       ellipsoid_num++) {
+    double side = (ellipsoid_num % 2 == 0) ? 1 : -1;
+    ObjectDim<double> dims(
+        object_dim(rand_gen), object_dim(rand_gen), object_dim(rand_gen));
+    double x = object_x(rand_gen);
+    Position3d<double> center(x,
+                              kLateralAmplitude * sin(kLateralFrequency * x) +
+                                  side * object_offset(rand_gen),
+                              dims.z() / 2);
+    scene.ellipsoids_.emplace_back(synthetic_scene_internal::createRawEllipsoid(
+        center, object_yaw(rand_gen), dims));
+  }
+  Covariance<double, 3> shape_cov = Covariance<double, 3>::Identity() * 0.25;
+  scene.shape_mean_and_cov_by_semantic_class_[kSyntheticSceneSemanticClass] =
+      std::make_pair(ObjectDim<double>(1, 1, 1), shape_cov);
+
+  Covariance<double, 4> bb_cov = Covariance<double, 4>::Identity() *
+                                 pow(params.bounding_box_noise_std_dev_, 2);
+  for (FrameId frame_id = 0; frame_id < scene.robot_poses_.size();
+       frame_id++) {
+    const Pose3D<double> &robot_pose = scene.robot_poses_[frame_id];
+    Pose3D<double> cam_pose = combinePoses(robot_pose, extrinsics);
+    for (FeatureId feature_id = 0; feature_id < scene.landmarks_.size();
+         feature_id++) {
+      Position3d<double> landmark_rel_cam =
+          getPositionRelativeToPose(cam_pose, scene.landmarks_[feature_id]);
+      if ((landmark_rel_cam.z() < 0.5) ||
+          (landmark_rel_cam.z() > params.max_observation_depth_)) {
+        continue;
+      }
+      PixelCoord<double> pixel = getProjectedPixelCoord(
+          scene.landmarks_[feature_id], robot_pose, extrinsics, intrinsics);
+      if ((pixel.x() < 0) || (pixel.y() < 0) ||
+          (pixel.x() >= scene.img_height_and_width_.second) ||
+          (pixel.y() >= scene.img_height_and_width_.first)) {
+        continue;
+      }
+      pixel += params.pixel_noise_std_dev_ *
+               PixelCoord<double>(unit_noise(rand_gen), unit_noise(rand_gen));
+      scene.feature_observations_.emplace_back(frame_id,
+                                               feature_id,
+                                               kSyntheticSceneCameraId,
+                                               pixel,
+                                               params.pixel_noise_std_dev_);
+    }
+
+    std::vector<std::optional<BbCorners<double>>> projected_bbs;
+    projectEllipsoidsToBoundingBoxes(convertPoseToArray(robot_pose),
+                                     extrinsics,
+                                     intrinsics,
+                                     scene.ellipsoids_,
+                                     projected_bbs);
+    for (size_t ellipsoid_num = 0; ellipsoid_num < projected_bbs.size();
+         ellipsoid_num++) {
+      if (!projected_bbs[ellipsoid_num].has_value()) {
+        continue;
+      }
+      const BbCorners<double> &bb = projected_bbs[ellipsoid_num].value();
+      Position3d<double> center_rel_cam = getPositionRelativeToPose(
+          cam_pose,
+          Position3d<double>(scene.ellipsoids_[ellipsoid_num].topRows(3)));
+      // Skip distant objects and objects that are mostly out of the image
+      if ((center_rel_cam.z() > params.max_observation_depth_) ||
+          (bb(0) < 0) || (bb(2) < 0) ||
+          (bb(1) >= scene.img_height_and_width_.second) ||
+          (bb(3) >= scene.img_height_and_width_.first)) {
+        continue;
+      }
+      BbCorners<double> noisy_bb = bb;
+      for (int corner_num = 0; corner_num < 4; corner_num++) {
+        noisy_bb(corner_num) +=
+            params.bounding_box_noise_std_dev_ * unit_noise(rand_gen);
+      }
+      scene.object_observations_.emplace_back(frame_id,
+                                              kSyntheticSceneCameraId,
+                                              ellipsoid_num + 1,
+                                              noisy_bb,
+                                              bb_cov,
+                                              1.0);
+    }
+  }
+  return scene;
+}
+
+/**
+ * Create a pose graph containing all of the frames, landmarks, objects, and
+ * observations in the scene, initialized with noisy estimates.
+ *
+ * @param scene   Scene to create the pose graph for.
+ * @param params  Parameters the scene was generated with (used for the
+ *                initialization noise).
+ *
+ * @return Pose graph for the scene.
+ */
+inline std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph>
+createPoseGraphForSyntheticScene(const SyntheticScene &scene,
+                                 const SyntheticSceneParams &params) {
+  std::mt19937 rand_gen(params.random_seed_ + 1);
+  std::normal_distribution<double> unit_noise(0.0, 1.0);
+  auto noise_vec = [&](const double &std_dev) {
+    return Eigen::Vector3d(unit_noise(rand_gen),
+                           unit_noise(rand_gen),
+                           unit_noise(rand_gen)) *
+           std_dev;
+  };
+
+  std::function<bool(
+      const std::unordered_set<ObjectId> &,
+      util::BoostHashMap<std::pair<FactorType, FeatureFactorId>,
+                         std::unordered_set<ObjectId>> &)>
+      long_term_map_factor_provider =
+          [](const std::unordered_set<ObjectId> &,
+             util::BoostHashMap<std::pair<FactorType, FeatureFactorId>,
+                                std::unordered_set<ObjectId>> &) {
+            return true;
+          };
+  std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> pose_graph =
+      std::make_shared<ObjectAndReprojectionFeaturePoseGraph>(
+          scene.shape_mean_and_cov_by_semantic_class_,
+          scene.camera_extrinsics_by_camera_,
+          scene.camera_intrinsics_by_camera_,
+          std::unordered_map<ObjectId,
+                             std::pair<std::string, RawEllipsoid<double>>>(),
+          long_term_map_factor_provider);
+
+  for (FrameId frame_id = 0; frame_id < scene.robot_poses_.size();
+       frame_id++) {
+    Pose3D<double> init_pose = scene.robot_poses_[frame_id];
+    // Keep the first pose exact since it anchors the trajectory
+    if (frame_id != 0) {
+      init_pose.transl_ += noise_vec(params.init_position_noise_std_dev_);
+      Eigen::Vector3d rot_noise =
+          noise_vec(params.init_orientation_noise_std_dev_);
+      if (rot_noise.norm() > 0) {
+        init_pose.orientation_ = Orientation3D<double>(
+            Eigen::AngleAxisd(rot_noise.norm(), rot_noise.normalized()) *
+            init_pose.orientation_);
+      }
+    }
+    pose_graph->addFrame(frame_id, init_pose);
+  }
+  for (FeatureId feature_id = 0; feature_id < scene.landmarks_.size();
+       feature_id++) {
+    pose_graph->addFeature(feature_id,
+                           scene.landmarks_[feature_id] +
+                               noise_vec(params.init_landmark_noise_std_dev_));
+  }
+  for (const RawEllipsoid<double> &ellipsoid : scene.ellipsoids_) {
+    RawEllipsoid<double> init_ellipsoid = ellipsoid;
+    init_ellipsoid.topRows(3) += noise_vec(params.init_position_noise_std_dev_);
+    init_ellipsoid.bottomRows(3) +=
+        noise_vec(params.init_dimension_noise_std_dev_);
+    pose_graph->addNewEllipsoid(EllipsoidEstimateNode(init_ellipsoid),
+                                kSyntheticSceneSemanticClass);
+  }
+  for (const ReprojectionErrorFactor &factor : scene.feature_observations_) {
+    pose_graph->addVisualFactor(factor);
+  }
+  for (const ObjectObservationFactor &factor : scene.object_observations_) {
+    pose_graph->addObjectObservation(factor);
+  }
+  return pose_graph;
+}
+
+}  // namespace vslam_types_refactor
+
+#endif  // UT_VSLAM_SYNTHETIC_SCENE_GENERATOR_H
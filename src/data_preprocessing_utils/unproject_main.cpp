@@ -1,5 +1,7 @@
+#include <base_lib/parallel_utils.h>
 #include <file_io/camera_extrinsics_with_id_io.h>
 #include <file_io/camera_intrinsics_with_id_io.h>
+#include <file_io/csv_tokenizer.h>
 #include <file_io/features_ests_with_id_io.h>
 #include <file_io/file_access_utils.h>
 #include <file_io/node_id_and_timestamp_io.h>
@@ -8,10 +10,16 @@
 #include <glog/logging.h>
 #include <refactoring/types/vslam_types_math_util.h>
 
+#include <algorithm>
+#include <cmath>
 #include <experimental/filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -70,6 +78,12 @@ DEFINE_string(
     "id follwed by depth (distance from left camera). All data in this folder "
     "has been adjusted so that the first frame has id 0.");
 
+DEFINE_int32(num_threads,
+             0,
+             "Number of threads to use for loading the per-frame files and "
+             "unprojecting features. If not positive, the hardware concurrency "
+             "is used.");
+
 namespace {
 const std::string kIntrinsicCalibrationPath = "camera_matrix.txt";
 const std::string kExtrinsicCalibrationPath = "extrinsics.txt";
@@ -87,8 +101,9 @@ struct FeatureProjector {
   vtr::FrameId frame_id_;
   vtr::FeatureId feature_id_;
   vtr::PixelCoord<double> measurement_;
-  vtr::Pose3D<double> robot_pose_;
-  double depth_;
+  // NaN until a depth is loaded for the frame that the feature is unprojected
+  // from
+  double depth_ = std::numeric_limits<double>::quiet_NaN();
   vtr::CameraId cam_id_;
 
   FeatureProjector() {}
@@ -102,6 +117,98 @@ struct FeatureProjector {
         cam_id_(camera_id) {}
 };
 
+/**
+ * Get the .txt files in the directory, sorted by name so that the results
+ * don't depend on the directory iteration order.
+ */
+std::vector<fs::path> getTxtFilesInDirectory(const std::string& directory) {
+  std::vector<fs::path> txt_files;
+  for (const auto& entry : fs::directory_iterator(fs::path(directory))) {
+    const auto file_extension = entry.path().extension().string();
+    if (!is_regular_file(entry) || file_extension != ".txt") {
+      continue;
+    }
+    txt_files.emplace_back(entry.path());
+  }
+  std::sort(txt_files.begin(), txt_files.end());
+  return txt_files;
+}
+
+/**
+ * Read a per-frame file with space separated values. Runs of spaces are
+ * treated as a single separator.
+ *
+ * @param file_path     File to read.
+ * @param lines[out]    Lines in the file, each split into its fields (empty
+ *                      for blank lines). Fields reference the mapped file, so
+ *                      they are only valid while the mapped file is.
+ * @param mapped_file   Mapping of the file. Must outlive the fields.
+ */
+void readSpaceSeparatedFile(
+    const fs::path& file_path,
+    std::vector<std::vector<std::string_view>>& lines,
+    file_io::MappedTextFile& mapped_file) {
+  if (!mapped_file.open(file_path.string())) {
+    LOG(FATAL) << "Failed to load: " << file_path
+               << " are you sure this a valid data file? ";
+  }
+  std::string_view contents = mapped_file.contents();
+  std::vector<std::string_view> fields;
+  size_t line_start = 0;
+  while (line_start < contents.size()) {
+    size_t line_end = contents.find('\n', line_start);
+    if (line_end == std::string_view::npos) {
+      line_end = contents.size();
+    }
+    file_io::splitCsvLine(
+        contents.substr(line_start, line_end - line_start), fields, ' ');
+    line_start = line_end + 1;
+
+    std::vector<std::string_view> non_empty_fields;
+    for (const std::string_view& field : fields) {
+      if (!file_io::trimCsvField(field).empty()) {
+        non_empty_fields.emplace_back(field);
+      }
+    }
+    lines.emplace_back(non_empty_fields);
+  }
+}
+
+/**
+ * Read the per-frame files in the directory in parallel. Each file starts with
+ * a line containing the frame id.
+ *
+ * @tparam FrameData          Data read from each file.
+ * @param directory           Directory containing the files.
+ * @param frame_data_reader   Reads the data from the lines following the
+ *                            frame id line. Must be safe to call concurrently.
+ *
+ * @return Frame id and data for each file, in file name order.
+ */
+template <typename FrameData>
+std::vector<std::pair<vtr::FrameId, FrameData>> readFrameFilesInDirectory(
+    const std::string& directory,
+    const std::function<void(const std::vector<std::vector<std::string_view>>&,
+                             FrameData&)>& frame_data_reader) {
+  std::vector<fs::path> frame_files = getTxtFilesInDirectory(directory);
+  std::vector<std::pair<vtr::FrameId, FrameData>> data_by_file(
+      frame_files.size());
+  util::parallelFor(
+      frame_files.size(), FLAGS_num_threads, [&](const size_t& file_idx) {
+        file_io::MappedTextFile mapped_file;
+        std::vector<std::vector<std::string_view>> lines;
+        readSpaceSeparatedFile(frame_files[file_idx], lines, mapped_file);
+        if (lines.empty() || lines.front().empty()) {
+          LOG(FATAL) << "No frame id in " << frame_files[file_idx];
+        }
+        file_io::parseCsvField(lines.front().front(),
+                               data_by_file[file_idx].first);
+        lines.erase(lines.begin());
+        frame_data_reader(lines, data_by_file[file_idx].second);
+      });
+  return data_by_file;
+}
+
 void LoadCameraIntrinsics(
     const std::string& intrinsics_path,
     std::unordered_map<vtr::CameraId, vtr::CameraIntrinsicsMat<double>>&
@@ -171,39 +278,41 @@ void loadTrajectoryFromVelocities(
   vtr::Pose3D<double> extrinsics_inv = vtr::poseInverse(primary_cam_extrinsics);
 
   // load all relative poses (velocity)
+  std::function<void(const std::vector<std::vector<std::string_view>>&,
+                     vtr::Pose3D<double> &)>
+      velocity_reader = [&](const std::vector<std::vector<std::string_view>>&
+                                lines,
+                            vtr::Pose3D<double>& base_link_velocity) {
+        if (lines.empty() || (lines.front().size() < 7)) {
+          LOG(FATAL) << "Missing velocity in velocity file";
+        }
+        std::vector<float> pose_entries;
+        for (size_t entry_idx = 0; entry_idx < 7; entry_idx++) {
+          pose_entries.emplace_back(
+              file_io::parseCsvField<float>(lines.front()[entry_idx]));
+        }
+        vtr::Position3d<double> translation(
+            pose_entries[0], pose_entries[1], pose_entries[2]);
+        vtr::Orientation3D<double> rotation_a(
+            Eigen::Quaterniond(pose_entries[6],
+                               pose_entries[3],
+                               pose_entries[4],
+                               pose_entries[5]));
+
+        // We want to get the poses of the robot frame rather than the camera,
+        // so we need to adjust the relative poses to refer to the robot frame
+        vtr::Pose3D<double> cam_velocity(translation, rotation_a);
+        base_link_velocity =
+            vtr::combinePoses(primary_cam_extrinsics,
+                              vtr::combinePoses(cam_velocity, extrinsics_inv));
+      };
   std::unordered_map<vtr::FrameId, vtr::Pose3D<double>> velocities_by_frame_id;
   min_orig_frame_id = std::numeric_limits<vtr::FrameId>::max();
-  for (const auto& entry :
-       fs::directory_iterator(fs::path(dataset_path + kVelocitiesFolder))) {
-    const auto file_extension = entry.path().extension().string();
-    if (!is_regular_file(entry) || file_extension != ".txt") {
-      continue;
-    }
-    std::ifstream data_file_stream(entry.path());
-    if (data_file_stream.fail()) {
-      LOG(FATAL) << "Failed to load: " << entry.path()
-                 << " are you sure this a valid data file? ";
-      return;
-    }
-    std::string line;
-    getline(data_file_stream, line);
-    vtr::FrameId frame_id;
-    std::stringstream ss_frame_id(line);
-    ss_frame_id >> frame_id;
-    getline(data_file_stream, line);
-    std::stringstream ss_robot_pose(line);
-    float x, y, z, qx, qy, qz, qw;
-    ss_robot_pose >> x >> y >> z >> qx >> qy >> qz >> qw;
-    vtr::Position3d<double> translation(x, y, z);
-    vtr::Orientation3D<double> rotation_a(Eigen::Quaterniond(qw, qx, qy, qz));
-
-    // We want to get the poses of the robot frame rather than the camera, so we
-    // need to adjust the relative poses to refer to the robot frame
-    vtr::Pose3D<double> cam_velocity(translation, rotation_a);
-    vtr::Pose3D<double> base_link_velocity =
-        vtr::combinePoses(primary_cam_extrinsics,
-                          vtr::combinePoses(cam_velocity, extrinsics_inv));
-    velocities_by_frame_id[frame_id] = base_link_velocity;
+  for (const std::pair<vtr::FrameId, vtr::Pose3D<double>>& frame_velocity :
+       readFrameFilesInDirectory(dataset_path + kVelocitiesFolder,
+                                 velocity_reader)) {
+    vtr::FrameId frame_id = frame_velocity.first;
+    velocities_by_frame_id[frame_id] = frame_velocity.second;
 
     // Frame id - 1 because velocity is presumed to be relative to the prior
     // frame (therefore implying that frame_id -1 exists)
@@ -227,179 +336,239 @@ void loadTrajectoryFromVelocities(
 void LoadDepths(
     const std::string& dataset_path,
     std::unordered_map<vtr::FeatureId, FeatureProjector>& features) {
-  for (const auto& entry :
-       fs::directory_iterator(fs::path(dataset_path + kDepthsFolder))) {
-    const auto file_extension = entry.path().extension().string();
-    if (!is_regular_file(entry) || file_extension != ".txt") {
-      continue;
-    }
-    std::ifstream data_file_stream(entry.path());
-    if (data_file_stream.fail()) {
-      LOG(FATAL) << "Failed to load: " << entry.path()
-                 << " are you sure this a valid data file? ";
-      return;
-    }
-    std::string line;
-    getline(data_file_stream, line);
-    vtr::FrameId frame_id;
-    std::stringstream ss_frame_id(line);
-    ss_frame_id >> frame_id;
-    getline(data_file_stream, line);  // skip the second line
-
-    vtr::FeatureId feature_id;
-    float depth;
-    while (getline(data_file_stream, line)) {
-      std::stringstream ss_depth(line);
-      ss_depth >> feature_id >> depth;
-      if (features[feature_id].frame_id_ == frame_id) {
-        features[feature_id].depth_ = depth;
+  std::function<void(const std::vector<std::vector<std::string_view>>&,
+                     std::vector<std::pair<vtr::FeatureId, double>>&)>
+      depths_reader =
+          [](const std::vector<std::vector<std::string_view>>& lines,
+             std::vector<std::pair<vtr::FeatureId, double>>& frame_depths) {
+            // Skip the second line
+            for (size_t line_idx = 1; line_idx < lines.size(); line_idx++) {
+              const std::vector<std::string_view>& fields = lines[line_idx];
+              if (fields.empty()) {
+                continue;
+              }
+              if (fields.size() < 2) {
+                LOG(FATAL) << "Depth line has " << fields.size()
+                           << " entries, expected feature id and depth";
+              }
+              frame_depths.emplace_back(
+                  file_io::parseCsvField<vtr::FeatureId>(fields[0]),
+                  file_io::parseCsvField<float>(fields[1]));
+            }
+          };
+
+  for (const std::pair<vtr::FrameId,
+                       std::vector<std::pair<vtr::FeatureId, double>>>&
+           frame_depths : readFrameFilesInDirectory(
+               dataset_path + kDepthsFolder, depths_reader)) {
+    for (const std::pair<vtr::FeatureId, double>& feature_depth :
+         frame_depths.second) {
+      auto feature_it = features.find(feature_depth.first);
+      if ((feature_it != features.end()) &&
+          (feature_it->second.frame_id_ == frame_depths.first)) {
+        feature_it->second.depth_ = feature_depth.second;
       }
     }
   }
 }
 
-void LoadFeaturesWithRelPoses(
-    const std::string& dataset_path,
-    std::unordered_map<vtr::FeatureId, FeatureProjector>& features,
-    std::unordered_map<vtr::FrameId, vtr::Pose3D<double>>& trajectory,
-    vtr::FeatureId& min_feature_id,
-    vtr::FeatureId& max_feature_id) {
-  for (const auto& entry : fs::directory_iterator(fs::path(dataset_path))) {
-    const auto file_extension = entry.path().extension().string();
-    if (!is_regular_file(entry) || file_extension != ".txt") {
-      continue;
-    }
-    std::ifstream data_file_stream(entry.path());
-    if (data_file_stream.fail()) {
-      LOG(FATAL) << "Failed to load: " << entry.path()
-                 << " are you sure this a valid data file? ";
-      return;
-    }
-    // TODO need to verify that frame ids here have already been converted to 0
-    // indexing
-    std::string line;
-    getline(data_file_stream, line);
-    vtr::FrameId frame_id;
-    std::stringstream ss_frame_id(line);
-    ss_frame_id >> frame_id;
-    getline(data_file_stream, line);  // skip the absolute pose line
-
-    vtr::FeatureId feature_id;
-    vtr::CameraId camera1_id, camera2_id;
-    float measurement_x1, measurement_y1, measurement_x2, measurement_y2;
-    while (getline(data_file_stream, line)) {
-      std::stringstream ss_feature(line);
-      ss_feature >> feature_id >> camera1_id >> measurement_x1 >>
-          measurement_y1 >> camera2_id >> measurement_x2 >> measurement_y2;
-      if (feature_id > max_feature_id) {
-        max_feature_id = feature_id;
-      }
-      if (feature_id < min_feature_id) {
-        min_feature_id = feature_id;
+/**
+ * Load the feature measurements and their depths.
+ *
+ * @param dataset_path    Directory with the feature detection files and the
+ *                        depths folder.
+ * @param features[out]   Measurement to unproject for each feature (from the
+ *                        first frame that observed it), sorted by feature id.
+ */
+void LoadFeaturesWithRelPoses(const std::string& dataset_path,
+                              std::vector<FeatureProjector>& features) {
+  std::function<void(const std::vector<std::vector<std::string_view>>&,
+                     std::vector<FeatureProjector>&)>
+      features_reader =
+          [](const std::vector<std::vector<std::string_view>>& lines,
+             std::vector<FeatureProjector>& frame_features) {
+            // Skip the absolute pose line
+            for (size_t line_idx = 1; line_idx < lines.size(); line_idx++) {
+              const std::vector<std::string_view>& fields = lines[line_idx];
+              if (fields.empty()) {
+                continue;
+              }
+              if (fields.size() < 4) {
+                LOG(FATAL) << "Feature line has " << fields.size()
+                           << " entries, expected at least 4";
+              }
+              // Frame id is filled in once the whole file is read
+              frame_features.emplace_back(FeatureProjector(
+                  0,
+                  file_io::parseCsvField<vtr::FeatureId>(fields[0]),
+                  vtr::PixelCoord<double>(
+                      file_io::parseCsvField<float>(fields[2]),
+                      file_io::parseCsvField<float>(fields[3])),
+                  file_io::parseCsvField<vtr::CameraId>(fields[1])));
+            }
+          };
+
+  // TODO need to verify that frame ids here have already been converted to 0
+  // indexing
+  std::unordered_map<vtr::FeatureId, FeatureProjector> features_by_id;
+  for (std::pair<vtr::FrameId, std::vector<FeatureProjector>>& frame_features :
+       readFrameFilesInDirectory(dataset_path, features_reader)) {
+    for (FeatureProjector& feature : frame_features.second) {
+      feature.frame_id_ = frame_features.first;
+      auto feature_it = features_by_id.find(feature.feature_id_);
+      if ((feature_it == features_by_id.end()) ||
+          (feature_it->second.frame_id_ > feature.frame_id_)) {
+        features_by_id[feature.feature_id_] = feature;
       }
-      features[feature_id] = FeatureProjector(
-          frame_id,
-          feature_id,
-          vtr::PixelCoord<double>(measurement_x1, measurement_y1),
-          camera1_id);
     }
   }
 
   // iterate through all depths associated with the left camera measuremnts
-  LoadDepths(dataset_path, features);
+  LoadDepths(dataset_path, features_by_id);
 
-  // Update the robot poses in features
-  for (auto& feature : features) {
-    size_t frame_id = feature.second.frame_id_;
-    feature.second.robot_pose_ = trajectory[frame_id];
+  features.clear();
+  features.reserve(features_by_id.size());
+  for (const auto& feature : features_by_id) {
+    features.emplace_back(feature.second);
   }
+  std::sort(features.begin(),
+            features.end(),
+            [](const FeatureProjector& feature_1,
+               const FeatureProjector& feature_2) {
+              return feature_1.feature_id_ < feature_2.feature_id_;
+            });
 }
 
-std::unordered_map<vtr::FeatureId, vtr::Position3d<double>> EstimatePoints3D(
-    const std::unordered_map<vtr::FeatureId, FeatureProjector>& features,
+/**
+ * Features observed by one camera in one frame, which share the inverse
+ * intrinsics and camera pose used to unproject them.
+ */
+struct UnprojectionBatch {
+  vtr::CameraId cam_id_;
+  vtr::FrameId frame_id_;
+  std::vector<size_t> feature_indices_;
+};
+
+/**
+ * Get the position of each feature in the world frame from its measurement
+ * and depth. Features are unprojected in batches (one per camera and frame)
+ * in parallel.
+ *
+ * @param features        Features, sorted by feature id.
+ * @param trajectory      Robot pose for each frame.
+ * @param intrinsics_map  Intrinsics for each camera.
+ * @param extrinsics_map  Extrinsics for each camera.
+ *
+ * @return Estimated position for each feature that could be unprojected,
+ * sorted by feature id.
+ */
+std::vector<file_io::FeatureEstWithId> EstimatePoints3D(
+    const std::vector<FeatureProjector>& features,
+    const std::unordered_map<vtr::FrameId, vtr::Pose3D<double>>& trajectory,
     const std::unordered_map<vtr::CameraId, vtr::CameraIntrinsicsMat<double>>&
         intrinsics_map,
     const std::unordered_map<vtr::CameraId, vtr::CameraExtrinsics<double>>&
         extrinsics_map) {
-  std::unordered_map<vtr::FeatureId,
-                     std::pair<vtr::FrameId, vtr::Position3d<double>>>
-      points;
-  for (const auto& feature : features) {
-    if (points.find(feature.first) != points.end()) {
-      if (points[feature.first].first < feature.second.frame_id_) {
-        continue;
-      }
+  std::map<std::pair<vtr::CameraId, vtr::FrameId>, std::vector<size_t>>
+      feature_indices_by_cam_and_frame;
+  size_t num_without_depth = 0;
+  for (size_t feature_idx = 0; feature_idx < features.size(); feature_idx++) {
+    const FeatureProjector& feature = features[feature_idx];
+    if (!std::isfinite(feature.depth_)) {
+      num_without_depth++;
+      continue;
+    }
+    feature_indices_by_cam_and_frame[std::make_pair(feature.cam_id_,
+                                                    feature.frame_id_)]
+        .emplace_back(feature_idx);
+  }
+  if (num_without_depth > 0) {
+    LOG(WARNING) << "No depth found for " << num_without_depth
+                 << " features. Skipping them";
+  }
+
+  std::unordered_map<vtr::CameraId, Eigen::Matrix3d> intrinsics_inv_by_cam;
+  for (const auto& cam_intrinsics : intrinsics_map) {
+    intrinsics_inv_by_cam[cam_intrinsics.first] =
+        cam_intrinsics.second.inverse();
+  }
+
+  std::vector<UnprojectionBatch> batches;
+  for (auto& cam_and_frame_features : feature_indices_by_cam_and_frame) {
+    UnprojectionBatch batch;
+    batch.cam_id_ = cam_and_frame_features.first.first;
+    batch.frame_id_ = cam_and_frame_features.first.second;
+    batch.feature_indices_ = std::move(cam_and_frame_features.second);
+    if (intrinsics_inv_by_cam.find(batch.cam_id_) ==
+        intrinsics_inv_by_cam.end()) {
+      LOG(WARNING) << "No intrinsics found for cam id " << batch.cam_id_
+                   << " associated with " << batch.feature_indices_.size()
+                   << " features at frame " << batch.frame_id_
+                   << ". Skipping features";
+      continue;
     }
-    vtr::CameraId cam_id = feature.second.cam_id_;
-    if (intrinsics_map.find(cam_id) == intrinsics_map.end()) {
-      LOG(WARNING) << "No intrinsics found for cam id " << cam_id
-                   << " associated with feature " << feature.first
-                   << " at frame " << feature.second.frame_id_
-                   << ". Skipping feature";
+    if (extrinsics_map.find(batch.cam_id_) == extrinsics_map.end()) {
+      LOG(WARNING) << "No extrinsics found for cam id " << batch.cam_id_
+                   << " associated with " << batch.feature_indices_.size()
+                   << " features at frame " << batch.frame_id_
+                   << ". Skipping features";
       continue;
     }
-    if (extrinsics_map.find(cam_id) == extrinsics_map.end()) {
-      LOG(WARNING) << "No intrinsics found for cam id " << cam_id
-                   << " associated with feature " << feature.first
-                   << " at frame " << feature.second.frame_id_
-                   << ". Skipping feature";
+    if (trajectory.find(batch.frame_id_) == trajectory.end()) {
+      LOG(WARNING) << "No robot pose found for frame " << batch.frame_id_
+                   << ". Skipping " << batch.feature_indices_.size()
+                   << " features";
       continue;
     }
-    const vtr::CameraIntrinsicsMat<double> intrinsics =
-        intrinsics_map.at(cam_id);
-    const vtr::CameraExtrinsics<double> extrinsics = extrinsics_map.at(cam_id);
-    vtr::Position3d<double> point =
-        getWorldFramePos(feature.second.measurement_,
-                         intrinsics,
-                         extrinsics,
-                         feature.second.robot_pose_,
-                         feature.second.depth_);
-    points[feature.first] = std::make_pair(feature.second.frame_id_, point);
-    //    if (!dumpToFile) {  // debug
-    //                        //      std::cout << feature.second << std::endl;
-    //      std::cout << "point: " << point.transpose() << std::endl;
-    //      std::cout << std::endl;
-    //    }
-  }
-  std::unordered_map<vtr::FeatureId, vtr::Position3d<double>> feature_ests;
-  for (const auto& point : points) {
-    feature_ests[point.first] = point.second.second;
+    batches.emplace_back(std::move(batch));
   }
-  return feature_ests;
-}
 
-void writePointsToFile(
-    const std::string& output_file,
-    const std::unordered_map<vtr::FeatureId, vtr::Position3d<double>>& points,
-    const vtr::FeatureId& min_feature_id,
-    const vtr::FeatureId& max_feature_id) {
-  std::ofstream fp;
-  //  fp.open(dataset_path + kFeaturesPath, std::fstream::trunc);
-  fp.open(output_file, std::fstream::trunc);
-  if (!fp.is_open()) {
-    LOG(FATAL) << "[dataset_path + kFeaturesPath] Fail to load: "
-               << output_file;
-    //               << dataset_path + kFeaturesPath;
-    return;
-  }
+  std::vector<vtr::Position3d<double>> points(features.size());
+  // Not vector<bool>, since batches set their entries concurrently
+  std::vector<uint8_t> has_point(features.size(), 0);
+  util::parallelFor(
+      batches.size(), FLAGS_num_threads, [&](const size_t& batch_idx) {
+        const UnprojectionBatch& batch = batches[batch_idx];
+        vtr::Transform6Dof<double> cam_pose_in_world =
+            vtr::convertToAffine(vtr::combinePoses(
+                trajectory.at(batch.frame_id_),
+                extrinsics_map.at(batch.cam_id_)));
+        // Rotation from depth-scaled homogeneous pixels to the world frame,
+        // so each point is one matrix product column plus the translation
+        Eigen::Matrix3d pixel_to_world =
+            cam_pose_in_world.linear() *
+            intrinsics_inv_by_cam.at(batch.cam_id_);
+
+        size_t batch_size = batch.feature_indices_.size();
+        Eigen::Matrix3Xd scaled_pixels(3, batch_size);
+        for (size_t i = 0; i < batch_size; i++) {
+          const FeatureProjector& feature =
+              features[batch.feature_indices_[i]];
+          scaled_pixels.col(i) =
+              feature.depth_ * vtr::pixelToHomogeneous(feature.measurement_);
+        }
+        Eigen::Matrix3Xd batch_points =
+            (pixel_to_world * scaled_pixels).colwise() +
+            cam_pose_in_world.translation();
+        for (size_t i = 0; i < batch_size; i++) {
+          points[batch.feature_indices_[i]] = batch_points.col(i);
+          has_point[batch.feature_indices_[i]] = 1;
+        }
+      });
+
   std::vector<file_io::FeatureEstWithId> feature_ests;
-  for (vtr::FeatureId feat_id = min_feature_id; feat_id <= max_feature_id;
-       feat_id++) {
-    if (points.find(feat_id) == points.end()) {
+  for (size_t feature_idx = 0; feature_idx < features.size(); feature_idx++) {
+    if (!has_point[feature_idx]) {
       continue;
     }
-    vtr::Position3d<double> point = points.at(feat_id);
-
     file_io::FeatureEstWithId feat;
-    feat.feature_id = feat_id;
-    feat.x = point.x();
-    feat.y = point.y();
-    feat.z = point.z();
-
+    feat.feature_id = features[feature_idx].feature_id_;
+    feat.x = points[feature_idx].x();
+    feat.y = points[feature_idx].y();
+    feat.z = points[feature_idx].z();
     feature_ests.emplace_back(feat);
   }
-
-  file_io::writeFeatureEstsWithIdToFile(output_file, feature_ests);
+  return feature_ests;
 }
 
 int main(int argc, char** argv) {
@@ -443,14 +612,9 @@ int main(int argc, char** argv) {
                                trajectory,
                                min_orig_frame_id);
 
-  std::unordered_map<vtr::FeatureId, FeatureProjector> features_map;
-  vtr::FeatureId min_feature_id = std::numeric_limits<vtr::FeatureId>::max();
-  vtr::FeatureId max_feature_id = std::numeric_limits<vtr::FeatureId>::min();
-  LoadFeaturesWithRelPoses(processed_data_path,
-                           features_map,
-                           trajectory,
-                           min_feature_id,
-                           max_feature_id);
+  std::vector<FeatureProjector> features;
+  LOG(INFO) << "Loading features and depths";
+  LoadFeaturesWithRelPoses(processed_data_path, features);
   // LoadFeaturesWithAbsPosesByFrameId(FLAGS_dataset_path, 500, features_map);
   // intrinsics: project 3D point from camera's baselink frame to 2D measurement
   std::unordered_map<vtr::CameraId, vtr::CameraIntrinsicsMat<double>>
@@ -460,16 +624,14 @@ int main(int argc, char** argv) {
   LoadCameraIntrinsics(calibration_path + kIntrinsicCalibrationPath,
                        intrinsics_map);
 
-  // debug
-  std::unordered_map<vtr::FeatureId, vtr::Position3d<double>> feature_ests =
-      EstimatePoints3D(features_map, intrinsics_map, extrinsics_map);
+  LOG(INFO) << "Unprojecting " << features.size() << " features";
+  std::vector<file_io::FeatureEstWithId> feature_ests =
+      EstimatePoints3D(features, trajectory, intrinsics_map, extrinsics_map);
 
   std::string output_features_dir = processed_data_path + kFeaturesFolderPath;
   file_io::makeDirectoryIfDoesNotExist(output_features_dir);
-  writePointsToFile(output_features_dir + kFeaturesFile,
-                    feature_ests,
-                    min_feature_id,
-                    max_feature_id);
+  file_io::writeFeatureEstsWithIdToFile(output_features_dir + kFeaturesFile,
+                                        feature_ests);
   std::string robot_poses_dir = processed_data_path + kPosesFolder;
   file_io::makeDirectoryIfDoesNotExist(robot_poses_dir);
 
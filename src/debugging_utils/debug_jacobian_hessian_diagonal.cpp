@@ -6,6 +6,7 @@
 #include <file_io/camera_extrinsics_with_id_io.h>
 #include <file_io/cv_file_storage/output_problem_data_file_storage_io.h>
 #include <file_io/cv_file_storage/vslam_basic_types_file_storage_io.h>
+#include <file_io/debug_dump_io.h>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <refactoring/image_processing/debugging_image_utils.h>
@@ -21,7 +22,8 @@ using namespace vslam_types_refactor;
 
 DEFINE_string(jacobian_residual_info_file,
               "",
-              "File containing jacobian parameter and residual info");
+              "File containing jacobian parameter and residual info (binary "
+              "if it has the .bin extension, JSON otherwise)");
 DEFINE_string(hessian_diag_entries_file,
               "",
               "File that contains the entries of the hessian diagonal");
@@ -95,29 +97,21 @@ int main(int argc, char **argv) {
   std::vector<GenericFactorInfo> generic_factor_infos;
   std::vector<ParameterBlockInfo> parameter_block_infos;
 
-  SerializableVector<ParameterBlockInfo, SerializableParameterBlockInfo>
-      serializable_param_info;
-  SerializableVector<GenericFactorInfo, SerializableGenericFactorInfo>
-      serializable_factors;
-
   LOG(INFO) << "Reading jacobian param/residual info from "
             << FLAGS_jacobian_residual_info_file;
-  cv::FileStorage jacobian_info_fs(FLAGS_jacobian_residual_info_file,
-                                   cv::FileStorage::READ);
-  jacobian_info_fs["jacobian_param_block_info"] >> serializable_param_info;
-  jacobian_info_fs["jacobian_residual_info"] >> serializable_factors;
-  jacobian_info_fs.release();
+  if (!readJacobianResidualInfoFromFile(FLAGS_jacobian_residual_info_file,
+                                        parameter_block_infos,
+                                        generic_factor_infos)) {
+    LOG(ERROR) << "Could not read jacobian param/residual info";
+    exit(1);
+  }
 
-  SerializableObjectDataAssociationResults ser_data_assoc_results;
   ObjectDataAssociationResults data_assoc_results;
-  cv::FileStorage data_assoc_results_in(FLAGS_data_association_file,
-                                        cv::FileStorage::READ);
-  data_assoc_results_in["bounding_box_associations"] >> ser_data_assoc_results;
-  data_assoc_results_in.release();
-  data_assoc_results = ser_data_assoc_results.getEntry();
-
-  generic_factor_infos = serializable_factors.getEntry();
-  parameter_block_infos = serializable_param_info.getEntry();
+  if (!readObjectDataAssociationResultsFromFile(FLAGS_data_association_file,
+                                                data_assoc_results)) {
+    LOG(ERROR) << "Could not read data associations";
+    exit(1);
+  }
 
   std::unordered_map<ObjectId, util::BoostHashSet<std::pair<FrameId, CameraId>>>
       frames_for_each_obj;
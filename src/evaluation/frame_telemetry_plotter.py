@@ -0,0 +1,73 @@
+import argparse
+import json
+
+import matplotlib.pyplot as plt
+import pandas as pd
+
+kStageNames = ["front_end", "build", "solve", "outlier", "pgo_plus_objects", "visualization"]
+
+
+def readFrameTelemetry(telemetryFileName):
+    records = []
+    with open(telemetryFileName, 'r') as telemetryFile:
+        for line in telemetryFile:
+            line = line.strip()
+            if not line:
+                continue
+            record = json.loads(line)
+            flatRecord = {
+                "frame_id": record["frame_id"],
+                "total_time": record["total_time"],
+                "num_solves": record["num_solves"],
+                "num_ceres_iterations": record["num_ceres_iterations"],
+                "rss_mb": record["rss_bytes"] / (1024.0 * 1024.0),
+                "peak_rss_mb": record["peak_rss_bytes"] / (1024.0 * 1024.0)}
+            for stageName in kStageNames:
+                flatRecord[stageName] = record["stage_times"].get(stageName, 0.0)
+            for factorType, numResiduals in record["num_residuals_by_factor_type"].items():
+                flatRecord["num_residuals_type_" + factorType] = numResiduals
+            records.append(flatRecord)
+    return pd.DataFrame(records).fillna(0).set_index("frame_id")
+
+
+def printSlowestFrames(telemetry, numFrames):
+    slowest = telemetry.sort_values("total_time", ascending=False).head(numFrames)
+    columns = ["total_time"] + kStageNames + ["num_ceres_iterations", "rss_mb"]
+    print("Slowest " + str(numFrames) + " frames:")
+    print(slowest[columns].to_string(float_format=lambda val: "%.4f" % val))
+
+
+def plotFrameTelemetry(telemetry, savepath=None):
+    fig, (timeAx, memAx) = plt.subplots(2, 1, sharex=True, figsize=(12, 8))
+    timeAx.stackplot(telemetry.index, [telemetry[stageName] for stageName in kStageNames], labels=kStageNames)
+    timeAx.plot(telemetry.index, telemetry["total_time"], color="black", linewidth=0.5, label="total")
+    timeAx.set_ylabel("Seconds")
+    timeAx.set_title("Per-frame processing time")
+    timeAx.legend(loc="upper left")
+
+    memAx.plot(telemetry.index, telemetry["rss_mb"], label="rss")
+    memAx.plot(telemetry.index, telemetry["peak_rss_mb"], label="peak rss")
+    memAx.set_ylabel("MB")
+    memAx.set_xlabel("Frame id")
+    memAx.legend(loc="upper left")
+
+    if savepath:
+        plt.savefig(savepath, bbox_inches="tight")
+    else:
+        plt.show()
+
+
+def parseArgs():
+    parser = argparse.ArgumentParser(description='Plot per-frame telemetry from an offline run.')
+    parser.add_argument('--telemetry_file_name', required=True,
+                        help='frame_telemetry.jsonl file from the run\'s logs directory')
+    parser.add_argument('--num_slowest_frames', required=False, type=int, default=10)
+    parser.add_argument('--savepath', required=False, default="")
+    return parser.parse_args()
+
+
+if __name__ == "__main__":
+    args = parseArgs()
+    telemetry = readFrameTelemetry(args.telemetry_file_name)
+    printSlowestFrames(telemetry, args.num_slowest_frames)
+    plotFrameTelemetry(telemetry, args.savepath if args.savepath else None)
@@ -2,6 +2,7 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <refactoring/bounding_box_frontend/bounding_box_retriever.h>
+#include <refactoring/image_processing/decoded_image_cache.h>
 #include <refactoring/image_processing/image_processing_utils.h>
 #include <ros/ros.h>
 #include <rosbag/bag.h>
@@ -139,15 +140,15 @@ int main(int argc, char **argv) {
       fs::path rel_image_path =
           fs::path(std::to_string(cam_id_and_image.first)) /
           (std::to_string(frame_id) + ".png");
-      cv_bridge::CvImagePtr cv_ptr;
       try {
-        cv_ptr = cv_bridge::toCvCopy(cam_id_and_image.second,
-                                     sensor_msgs::image_encodings::BGR8);
+        cv::imwrite(image_path,
+                    vtr::DecodedImageCache::getInstance()
+                        .getDecodedImage(cam_id_and_image.second)
+                        ->getBgr());
       } catch (cv_bridge::Exception &e) {
         LOG(ERROR) << "cv_bridge exception: " << e.what();
         exit(1);
       }
-      cv::imwrite(image_path, cv_ptr->image);
       cam_ids_and_ofiles.at(cam_id_and_image.first)
           << rel_image_path.string() << std::endl;
     }
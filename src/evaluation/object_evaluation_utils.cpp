@@ -3,6 +3,8 @@
 //
 
 #include <evaluation/object_evaluation_utils.h>
+#include <evaluation/position_kd_tree.h>
+#include <refactoring/bounding_box_frontend/optimal_assignment.h>
 #include <refactoring/types/ellipsoid_utils.h>
 #include <refactoring/types/vslam_types_math_util.h>
 #include <util/random.h>
@@ -20,101 +22,172 @@ const static double kMaxDistanceForInliers = 5.0;
 const static int kMaxPointsPerDirection = 1000;
 }  // namespace
 
-void associateObjects(const FullDOFEllipsoidResults &estimated_objects,
-                      const FullDOFEllipsoidResults &gt_objects,
-                      const bool &one_to_one,
-                      std::unordered_map<ObjectId, std::optional<ObjectId>>
-                          &gt_objects_for_est_objs,
-                      const double &max_assoc_dist) {
-  std::unordered_map<std::string, std::unordered_set<ObjectId>>
-      est_obj_by_class;
-  std::unordered_map<std::string, std::unordered_set<ObjectId>> gt_obj_by_class;
-
-  for (const auto &est_obj : estimated_objects) {
-    if (est_obj_by_class.find(est_obj.second.first) == est_obj_by_class.end()) {
-      est_obj_by_class[est_obj.second.first] = {};
+namespace {
+/**
+ * Ground truth object centers, with a KD-tree per semantic class.
+ */
+class GtObjectCenterIndex {
+ public:
+  explicit GtObjectCenterIndex(const FullDOFEllipsoidResults &gt_objects) {
+    std::unordered_map<std::string,
+                       std::vector<std::pair<ObjectId, Position3d<double>>>>
+        centers_by_class;
+    for (const auto &gt_obj : gt_objects) {
+      gt_obj_idx_by_id_[gt_obj.first] = gt_obj_ids_.size();
+      gt_obj_ids_.emplace_back(gt_obj.first);
+      centers_by_class[gt_obj.second.first].emplace_back(
+          std::make_pair(gt_obj.first, gt_obj.second.second.pose_.transl_));
+    }
+    for (const auto &class_centers : centers_by_class) {
+      trees_by_class_[class_centers.first] =
+          PositionKdTree(class_centers.second);
     }
-    est_obj_by_class[est_obj.second.first].insert(est_obj.first);
-    gt_objects_for_est_objs[est_obj.first] = std::nullopt;
   }
 
-  for (const auto &gt_obj : gt_objects) {
-    if (gt_obj_by_class.find(gt_obj.second.first) == gt_obj_by_class.end()) {
-      gt_obj_by_class[gt_obj.second.first] = {};
+  /**
+   * Get the tree for the class, or nullptr if there are no ground truth
+   * objects of the class.
+   */
+  const PositionKdTree *getTreeForClass(
+      const std::string &semantic_class) const {
+    auto tree_it = trees_by_class_.find(semantic_class);
+    if (tree_it == trees_by_class_.end()) {
+      return nullptr;
     }
-    gt_obj_by_class[gt_obj.second.first].insert(gt_obj.first);
+    return &(tree_it->second);
   }
 
-  if (one_to_one) {
-    std::vector<std::pair<double, std::pair<ObjectId, ObjectId>>> obj_distances;
-    for (const auto &est_obj : estimated_objects) {
-      Position3d<double> est_obj_pos =
-          estimated_objects.at(est_obj.first).second.pose_.transl_;
-      std::unordered_set<ObjectId> gt_objs_for_class =
-          gt_obj_by_class.at(est_obj.second.first);
-      for (const ObjectId &gt_obj : gt_objs_for_class) {
-        Position3d<double> gt_pos = gt_objects.at(gt_obj).second.pose_.transl_;
-        double norm = (gt_pos - est_obj_pos).norm();
-        obj_distances.emplace_back(
-            std::make_pair(norm, std::make_pair(est_obj.first, gt_obj)));
-      }
-    }
+  size_t getNumGtObjects() const { return gt_obj_ids_.size(); }
 
-    std::sort(
-        obj_distances.begin(),
-        obj_distances.end(),
-        util::sort_pair_by_first<double, std::pair<ObjectId, ObjectId>>());
+  size_t getGtObjectIdx(const ObjectId &gt_obj_id) const {
+    return gt_obj_idx_by_id_.at(gt_obj_id);
+  }
 
-    std::unordered_set<ObjectId> assigned_gt_objs;
+  ObjectId getGtObjectId(const size_t &gt_obj_idx) const {
+    return gt_obj_ids_[gt_obj_idx];
+  }
 
-    for (const std::pair<double, std::pair<ObjectId, ObjectId>> &norm_for_objs :
-         obj_distances) {
-      if (norm_for_objs.first > max_assoc_dist) {
-        break;
-      }
-      ObjectId est_obj = norm_for_objs.second.first;
-      ObjectId gt_obj = norm_for_objs.second.second;
+ private:
+  std::unordered_map<std::string, PositionKdTree> trees_by_class_;
+  std::vector<ObjectId> gt_obj_ids_;
+  std::unordered_map<ObjectId, size_t> gt_obj_idx_by_id_;
+};
+
+/**
+ * Estimated object centers, stored contiguously so that they can be
+ * re-transformed on every alignment iteration without copying the ellipsoid
+ * results.
+ */
+struct EstObjectCenters {
+  std::vector<ObjectId> obj_ids_;
+  std::vector<const std::string *> semantic_classes_;
+  Eigen::Matrix3Xd centers_;
+
+  explicit EstObjectCenters(const FullDOFEllipsoidResults &estimated_objects)
+      : centers_(3, estimated_objects.size()) {
+    for (const auto &est_obj : estimated_objects) {
+      centers_.col(obj_ids_.size()) = est_obj.second.second.pose_.transl_;
+      obj_ids_.emplace_back(est_obj.first);
+      semantic_classes_.emplace_back(&(est_obj.second.first));
+    }
+  }
 
-      if (assigned_gt_objs.find(gt_obj) != assigned_gt_objs.end()) {
+  Eigen::Matrix3Xd getTransformedCenters(
+      const Pose3D<double> &transformation) const {
+    Transform6Dof<double> transform_mat = convertToAffine(transformation);
+    return (transform_mat.linear() * centers_).colwise() +
+           transform_mat.translation();
+  }
+};
+
+/**
+ * Associate the estimated objects with ground truth objects of the same
+ * class. Only ground truth objects within max_assoc_dist of an estimated
+ * object are candidates for it (found with radius queries on the KD-trees).
+ *
+ * When associating one to one, the assignment maximizes the number of
+ * associated ground truth objects and then minimizes the total distance
+ * between associated objects. Otherwise, each estimated object is associated
+ * with the closest ground truth object.
+ */
+void associateObjectCenters(
+    const EstObjectCenters &est_objects,
+    const Eigen::Matrix3Xd &est_centers,
+    const GtObjectCenterIndex &gt_index,
+    const bool &one_to_one,
+    const double &max_assoc_dist,
+    std::unordered_map<ObjectId, std::optional<ObjectId>>
+        &gt_objects_for_est_objs) {
+  for (const ObjectId &est_obj_id : est_objects.obj_ids_) {
+    gt_objects_for_est_objs[est_obj_id] = std::nullopt;
+  }
+
+  if (!one_to_one) {
+    for (size_t est_idx = 0; est_idx < est_objects.obj_ids_.size();
+         est_idx++) {
+      const PositionKdTree *gt_tree =
+          gt_index.getTreeForClass(*(est_objects.semantic_classes_[est_idx]));
+      if (gt_tree == nullptr) {
         continue;
       }
-      if ((gt_objects_for_est_objs.find(est_obj) !=
-           gt_objects_for_est_objs.end()) &&
-          (gt_objects_for_est_objs.at(est_obj).has_value())) {
-        continue;
+      std::optional<std::pair<ObjectId, double>> closest_gt_obj =
+          gt_tree->nearest(est_centers.col(est_idx), max_assoc_dist);
+      if (closest_gt_obj.has_value()) {
+        gt_objects_for_est_objs[est_objects.obj_ids_[est_idx]] =
+            closest_gt_obj->first;
       }
-      gt_objects_for_est_objs[est_obj] = gt_obj;
-      assigned_gt_objs.insert(gt_obj);
     }
-  } else {
-    for (const auto &est_obj : estimated_objects) {
-      Position3d<double> est_obj_pos =
-          estimated_objects.at(est_obj.first).second.pose_.transl_;
-      std::unordered_set<ObjectId> gt_objs_for_class =
-          gt_obj_by_class.at(est_obj.second.first);
-      for (const ObjectId &gt_obj : gt_objs_for_class) {
-        Position3d<double> gt_pos = gt_objects.at(gt_obj).second.pose_.transl_;
-        if ((gt_pos - est_obj_pos).norm() > max_assoc_dist) {
-          continue;
-        }
-        bool closest_position = true;
-        std::optional<ObjectId> curr_obj =
-            gt_objects_for_est_objs.at(est_obj.first);
-        if (curr_obj.has_value()) {
-          Position3d<double> curr_closest_pos =
-              gt_objects.at(curr_obj.value()).second.pose_.transl_;
-          if ((est_obj_pos - curr_closest_pos).norm() <
-              (est_obj_pos - gt_pos).norm()) {
-            closest_position = false;
-          }
-        }
-        if (closest_position) {
-          gt_objects_for_est_objs[est_obj.first] = gt_obj;
-        }
-      }
+    return;
+  }
+
+  // Ground truth objects are the rows, since there are usually fewer of them
+  // than estimated objects and the solver cost grows with the rows squared
+  SparseAssignmentProblem problem;
+  problem.num_rows_ = gt_index.getNumGtObjects();
+  problem.num_cols_ = est_objects.obj_ids_.size();
+  std::vector<std::pair<ObjectId, double>> candidates;
+  for (size_t est_idx = 0; est_idx < est_objects.obj_ids_.size(); est_idx++) {
+    const PositionKdTree *gt_tree =
+        gt_index.getTreeForClass(*(est_objects.semantic_classes_[est_idx]));
+    if (gt_tree == nullptr) {
+      continue;
+    }
+    candidates.clear();
+    gt_tree->radiusSearch(est_centers.col(est_idx), max_assoc_dist, candidates);
+    for (const std::pair<ObjectId, double> &candidate : candidates) {
+      problem.entry_rows_.emplace_back(
+          gt_index.getGtObjectIdx(candidate.first));
+      problem.entry_cols_.emplace_back(est_idx);
+      problem.entry_scores_.emplace_back(-candidate.second);
+    }
+  }
+
+  std::vector<std::optional<size_t>> est_idx_for_gt_obj =
+      solveSparseAssignment(problem);
+  for (size_t gt_idx = 0; gt_idx < est_idx_for_gt_obj.size(); gt_idx++) {
+    if (est_idx_for_gt_obj[gt_idx].has_value()) {
+      gt_objects_for_est_objs[est_objects.obj_ids_[est_idx_for_gt_obj[gt_idx]
+                                                       .value()]] =
+          gt_index.getGtObjectId(gt_idx);
     }
   }
 }
+}  // namespace
+
+void associateObjects(const FullDOFEllipsoidResults &estimated_objects,
+                      const FullDOFEllipsoidResults &gt_objects,
+                      const bool &one_to_one,
+                      std::unordered_map<ObjectId, std::optional<ObjectId>>
+                          &gt_objects_for_est_objs,
+                      const double &max_assoc_dist) {
+  EstObjectCenters est_objects(estimated_objects);
+  associateObjectCenters(est_objects,
+                         est_objects.centers_,
+                         GtObjectCenterIndex(gt_objects),
+                         one_to_one,
+                         max_assoc_dist,
+                         gt_objects_for_est_objs);
+}
 
 void findTransformationForAssociatedObjects(
     const FullDOFEllipsoidResults &estimated_objects,
@@ -148,6 +221,10 @@ void associateObjectsAndFindTransformation(
   Pose3D<double> curr_transform;
   bool converged = false;
   int num_iter = 0;
+  // The ground truth objects don't move, so they're indexed once. Only the
+  // estimated object centers are transformed on each iteration
+  GtObjectCenterIndex gt_index(gt_objects);
+  EstObjectCenters est_objects(estimated_objects);
   //  if (vis_manager != nullptr) {
   //    vis_manager->visualizeEllipsoids(gt_objects, GROUND_TRUTH, false);
   //    vis_manager->visualizeEllipsoids(estimated_objects, INITIAL, false);
@@ -161,8 +238,6 @@ void associateObjectsAndFindTransformation(
   while (!converged) {
     std::unordered_map<ObjectId, std::optional<ObjectId>>
         tmp_gt_objects_for_est_objs;
-    FullDOFEllipsoidResults tmp_aligned_objects;
-    adjustObjectFrame(estimated_objects, curr_transform, tmp_aligned_objects);
 
     //    if (vis_manager != nullptr) {
     //      std::vector<std::pair<Position3d<double>, Position3d<double>>>
@@ -199,11 +274,12 @@ void associateObjectsAndFindTransformation(
     //            getchar();
     //    }
 
-    associateObjects(tmp_aligned_objects,
-                     gt_objects,
-                     true,
-                     tmp_gt_objects_for_est_objs,
-                     kMaxDistanceForInliers);
+    associateObjectCenters(est_objects,
+                           est_objects.getTransformedCenters(curr_transform),
+                           gt_index,
+                           true,
+                           kMaxDistanceForInliers,
+                           tmp_gt_objects_for_est_objs);
 
     //    if (vis_manager != nullptr) {
     //      std::vector<std::pair<Position3d<double>, Position3d<double>>>
@@ -262,12 +338,13 @@ void associateObjectsAndFindTransformation(
 
   est_obj_transformation = curr_transform;
 
-  FullDOFEllipsoidResults tmp_aligned_objects;
-  adjustObjectFrame(
-      estimated_objects, est_obj_transformation, tmp_aligned_objects);
-
-  associateObjects(
-      tmp_aligned_objects, gt_objects, one_to_one, gt_objects_for_est_objs);
+  associateObjectCenters(
+      est_objects,
+      est_objects.getTransformedCenters(est_obj_transformation),
+      gt_index,
+      one_to_one,
+      std::numeric_limits<double>::infinity(),
+      gt_objects_for_est_objs);
 
   //  if (vis_manager != nullptr) {
   //    LOG(INFO) << "Final assignments";
@@ -2,6 +2,7 @@
 // Created by amanda on 2/19/23.
 //
 
+#include <base_lib/parallel_utils.h>
 #include <base_lib/pose_utils.h>
 #include <evaluation/object_evaluation_utils.h>
 #include <file_io/cv_file_storage/full_sequence_object_metrics_file_storage_io.h>
@@ -65,6 +66,10 @@ DEFINE_string(metrics_out_file,
 //              "",
 //              "Directory where the rosbags are stored");
 DEFINE_string(param_prefix, "", "Prefix for published topics");
+DEFINE_int32(num_threads,
+             0,
+             "Number of trajectories to compute metrics for in parallel. If "
+             "not positive, the hardware concurrency is used.");
 
 const std::string kIndivObjectsBaseFileName = "ellipsoids.csv";
 const std::string kIndivObjectsWithIdsBaseFileName = "ellipsoid_results.json";
@@ -147,109 +152,134 @@ FullDOFEllipsoidResults readEllipsoidResults(
   }
 }
 
-FullSequenceObjectMetrics computeMetrics(
+/**
+ * Compute the object metrics for one trajectory. Safe to call concurrently
+ * for different trajectories.
+ *
+ * @param gt_objs                 Ground truth objects.
+ * @param est_objs_for_traj       Objects estimated for the trajectory.
+ * @param aligned_est_objs[out]   Estimated objects after alignment to the
+ *                                ground truth.
+ *
+ * @return Metrics for the trajectory.
+ */
+SingleTrajectoryObjectMetrics computeMetricsForTrajectory(
     const FullDOFEllipsoidResults &gt_objs,
-    const std::vector<FullDOFEllipsoidResults> &est_objs_by_traj,
-    std::shared_ptr<vslam_types_refactor::RosVisualization> &vis_manager) {
-  FullSequenceObjectMetrics full_metrics;
-
-  for (size_t traj_num = 0; traj_num < est_objs_by_traj.size(); traj_num++) {
-    LOG(INFO) << "Starting Trajectory " << traj_num
-              << " ------------------------------------------";
-    //    getchar();
-    SingleTrajectoryObjectMetrics metrics_for_traj;
-    FullDOFEllipsoidResults est_objs_for_traj = est_objs_by_traj.at(traj_num);
-
-    std::unordered_map<ObjectId, std::optional<ObjectId>>
-        opt_gt_obj_for_est_obj;
-    Pose3D<double> est_obj_transformation;
-    associateObjectsAndFindTransformation(
-        est_objs_for_traj,
-        gt_objs,
-        false,
-        opt_gt_obj_for_est_obj,
-        est_obj_transformation
-        //                                          , vis_manager
-    );
-
-    FullDOFEllipsoidResults aligned_est_objs;
-    adjustObjectFrame(
-        est_objs_for_traj, est_obj_transformation, aligned_est_objs);
-
-    if (vis_manager != nullptr) {
-      vis_manager->visualizeEllipsoids(
-          aligned_est_objs, PlotType::ESTIMATED, false);
-
-      vis_manager->visualizeEllipsoids(
-          est_objs_for_traj, PlotType::INITIAL, false);
+    const FullDOFEllipsoidResults &est_objs_for_traj,
+    FullDOFEllipsoidResults &aligned_est_objs) {
+  SingleTrajectoryObjectMetrics metrics_for_traj;
+
+  std::unordered_map<ObjectId, std::optional<ObjectId>>
+      opt_gt_obj_for_est_obj;
+  Pose3D<double> est_obj_transformation;
+  associateObjectsAndFindTransformation(
+      est_objs_for_traj,
+      gt_objs,
+      false,
+      opt_gt_obj_for_est_obj,
+      est_obj_transformation
+      //                                          , vis_manager
+  );
+
+  adjustObjectFrame(
+      est_objs_for_traj, est_obj_transformation, aligned_est_objs);
+
+  std::unordered_map<ObjectId, std::optional<double>> dist_from_gt_by_obj;
+  getPositionDistancesList(
+      aligned_est_objs, gt_objs, opt_gt_obj_for_est_obj, dist_from_gt_by_obj);
+
+  std::unordered_map<ObjectId, double> iou_per_gt_obj;
+  getIoUsForObjects(
+      aligned_est_objs, gt_objs, opt_gt_obj_for_est_obj, iou_per_gt_obj
+      //                      , vis_manager
+  );
+
+  std::vector<double> deviations;
+  for (const auto &est_obj_dist : dist_from_gt_by_obj) {
+    if (est_obj_dist.second.has_value()) {
+      deviations.emplace_back(est_obj_dist.second.value());
     }
+  }
 
-    std::unordered_map<ObjectId, std::optional<double>> dist_from_gt_by_obj;
-    getPositionDistancesList(
-        aligned_est_objs, gt_objs, opt_gt_obj_for_est_obj, dist_from_gt_by_obj);
-
-    std::unordered_map<ObjectId, double> iou_per_gt_obj;
-    getIoUsForObjects(
-        aligned_est_objs, gt_objs, opt_gt_obj_for_est_obj, iou_per_gt_obj
-        //                      , vis_manager
-    );
-
-    std::vector<double> deviations;
-    for (const auto &est_obj_dist : dist_from_gt_by_obj) {
-      if (est_obj_dist.second.has_value()) {
-        deviations.emplace_back(est_obj_dist.second.value());
-      }
-    }
+  MetricsDistributionStatistics pos_dev_stats =
+      computeMetricsDistributionStatistics(deviations);
 
-    MetricsDistributionStatistics pos_dev_stats =
-        computeMetricsDistributionStatistics(deviations);
+  std::vector<double> ious;
+  for (const auto &iou_for_obj : iou_per_gt_obj) {
+    ious.emplace_back(iou_for_obj.second);
+  }
+  MetricsDistributionStatistics iou_stats =
+      computeMetricsDistributionStatistics(ious);
 
-    std::vector<double> ious;
-    for (const auto &iou_for_obj : iou_per_gt_obj) {
-      ious.emplace_back(iou_for_obj.second);
-    }
-    MetricsDistributionStatistics iou_stats =
-        computeMetricsDistributionStatistics(ious);
+  std::unordered_map<ObjectId, size_t> num_objs_for_gt_objs;
+  for (const auto &gt_obj_entry : gt_objs) {
+    num_objs_for_gt_objs[gt_obj_entry.first] = 0;
+  }
 
-    std::unordered_map<ObjectId, size_t> num_objs_for_gt_objs;
-    for (const auto &gt_obj_entry : gt_objs) {
-      num_objs_for_gt_objs[gt_obj_entry.first] = 0;
+  for (const auto &obj_assignment : opt_gt_obj_for_est_obj) {
+    if (obj_assignment.second.has_value()) {
+      num_objs_for_gt_objs[obj_assignment.second.value()]++;
     }
+  }
 
-    for (const auto &obj_assignment : opt_gt_obj_for_est_obj) {
-      if (obj_assignment.second.has_value()) {
-        num_objs_for_gt_objs[obj_assignment.second.value()]++;
-      }
+  int missed_gt_objs_ = 0;
+  size_t assignments_to_gt_objs = 0;
+  for (const auto &num_objs_for_gt_obj : num_objs_for_gt_objs) {
+    if (num_objs_for_gt_obj.second == 0) {
+      missed_gt_objs_++;
+    } else {
+      assignments_to_gt_objs += num_objs_for_gt_obj.second;
     }
+  }
+  metrics_for_traj.num_gt_objs_ = gt_objs.size();
+  metrics_for_traj.recall_ =
+      ((double)(metrics_for_traj.num_gt_objs_ - missed_gt_objs_)) /
+      metrics_for_traj.num_gt_objs_;
+  metrics_for_traj.missed_gt_objs_ = missed_gt_objs_;
+  metrics_for_traj.objects_per_gt_obj_ =
+      ((double)assignments_to_gt_objs) / (gt_objs.size() - missed_gt_objs_);
+  metrics_for_traj.opt_gt_obj_for_est_obj_ = opt_gt_obj_for_est_obj;
+  metrics_for_traj.iou_for_gt_obj_ = iou_per_gt_obj;
+  metrics_for_traj.pos_diff_for_est_obj_ = dist_from_gt_by_obj;
+  metrics_for_traj.average_pos_deviation_ = pos_dev_stats.average_;
+  metrics_for_traj.median_pos_deviation_ = pos_dev_stats.median_;
+  metrics_for_traj.pos_dev_stats_ = pos_dev_stats;
+  metrics_for_traj.avg_iou_ = iou_stats.average_;
+  metrics_for_traj.median_iou_ = iou_stats.median_;
+  metrics_for_traj.iou_stats_ = iou_stats;
+  return metrics_for_traj;
+}
 
-    int missed_gt_objs_ = 0;
-    size_t assignments_to_gt_objs = 0;
-    for (const auto &num_objs_for_gt_obj : num_objs_for_gt_objs) {
-      if (num_objs_for_gt_obj.second == 0) {
-        missed_gt_objs_++;
-      } else {
-        assignments_to_gt_objs += num_objs_for_gt_obj.second;
-      }
+FullSequenceObjectMetrics computeMetrics(
+    const FullDOFEllipsoidResults &gt_objs,
+    const std::vector<FullDOFEllipsoidResults> &est_objs_by_traj,
+    std::shared_ptr<vslam_types_refactor::RosVisualization> &vis_manager) {
+  FullSequenceObjectMetrics full_metrics;
+  full_metrics.indiv_trajectory_object_metrics_.resize(
+      est_objs_by_traj.size());
+  std::vector<FullDOFEllipsoidResults> aligned_est_objs_by_traj(
+      est_objs_by_traj.size());
+  util::parallelFor(
+      est_objs_by_traj.size(), FLAGS_num_threads, [&](const size_t &traj_num) {
+        LOG(INFO) << "Starting Trajectory " << traj_num
+                  << " ------------------------------------------";
+        full_metrics.indiv_trajectory_object_metrics_[traj_num] =
+            computeMetricsForTrajectory(gt_objs,
+                                        est_objs_by_traj.at(traj_num),
+                                        aligned_est_objs_by_traj[traj_num]);
+      });
+
+  // Visualization isn't thread safe, so it's done after all trajectories are
+  // evaluated
+  if (vis_manager != nullptr) {
+    for (size_t traj_num = 0; traj_num < est_objs_by_traj.size();
+         traj_num++) {
+      vis_manager->visualizeEllipsoids(
+          aligned_est_objs_by_traj[traj_num], PlotType::ESTIMATED, false);
+
+      vis_manager->visualizeEllipsoids(
+          est_objs_by_traj.at(traj_num), PlotType::INITIAL, false);
     }
-    metrics_for_traj.num_gt_objs_ = gt_objs.size();
-    metrics_for_traj.recall_ =
-        ((double)(metrics_for_traj.num_gt_objs_ - missed_gt_objs_)) /
-        metrics_for_traj.num_gt_objs_;
-    metrics_for_traj.missed_gt_objs_ = missed_gt_objs_;
-    metrics_for_traj.objects_per_gt_obj_ =
-        ((double)assignments_to_gt_objs) / (gt_objs.size() - missed_gt_objs_);
-    metrics_for_traj.opt_gt_obj_for_est_obj_ = opt_gt_obj_for_est_obj;
-    metrics_for_traj.iou_for_gt_obj_ = iou_per_gt_obj;
-    metrics_for_traj.pos_diff_for_est_obj_ = dist_from_gt_by_obj;
-    metrics_for_traj.average_pos_deviation_ = pos_dev_stats.average_;
-    metrics_for_traj.median_pos_deviation_ = pos_dev_stats.median_;
-    metrics_for_traj.pos_dev_stats_ = pos_dev_stats;
-    metrics_for_traj.avg_iou_ = iou_stats.average_;
-    metrics_for_traj.median_iou_ = iou_stats.median_;
-    metrics_for_traj.iou_stats_ = iou_stats;
-
-    full_metrics.indiv_trajectory_object_metrics_.emplace_back(
-        metrics_for_traj);
   }
   return full_metrics;
 }
@@ -1,3 +1,4 @@
+#include <base_lib/parallel_utils.h>
 #include <base_lib/pose_utils.h>
 #include <ceres/ceres.h>
 #include <ceres/problem.h>
@@ -440,6 +441,423 @@ std::vector<RelativePoseFactorInfo> createRelativePoseFactorInfo(
   return pose_factor_infos;
 }
 
+/**
+ * Independent piece of the interpolation problem. Contains the non-fixed
+ * poses that are connected to each other by factors, along with the fixed
+ * poses that bound them.
+ */
+struct InterpolationSegment {
+  std::vector<pose::Timestamp> variable_stamps_;
+  std::vector<pose::Timestamp> anchor_stamps_;
+  std::vector<size_t> factor_indices_;
+};
+
+size_t findSegmentRoot(std::vector<size_t> &parents, size_t node_idx) {
+  while (parents[node_idx] != node_idx) {
+    parents[node_idx] = parents[parents[node_idx]];
+    node_idx = parents[node_idx];
+  }
+  return node_idx;
+}
+
+/**
+ * Split the interpolation problem into independent segments.
+ *
+ * Fixed poses are constant in the optimization, so they separate the problem
+ * into independent pieces, except for factors that connect two non-fixed poses
+ * on either side of a fixed pose (ex. the odometry factor for an interval that
+ * contains a coarse trajectory timestamp). Those factors carry the same
+ * measurement as the pair of factors created through the fixed pose, so they
+ * are left out unless removing them would leave a pose unconstrained.
+ *
+ * @param sorted_stamps       All timestamps in the problem, sorted.
+ * @param factors             Factors in the problem.
+ * @param fixed_stamps        Timestamps that have fixed poses.
+ *
+ * @return Segments that can be solved independently.
+ */
+std::vector<InterpolationSegment> createInterpolationSegments(
+    const std::vector<pose::Timestamp> &sorted_stamps,
+    const std::vector<RelativePoseFactorInfo> &factors,
+    const util::BoostHashSet<pose::Timestamp> &fixed_stamps) {
+  util::BoostHashMap<pose::Timestamp, size_t> index_by_stamp;
+  std::vector<size_t> num_fixed_up_to_index;
+  size_t num_fixed = 0;
+  for (size_t stamp_idx = 0; stamp_idx < sorted_stamps.size(); stamp_idx++) {
+    index_by_stamp[sorted_stamps[stamp_idx]] = stamp_idx;
+    if (fixed_stamps.find(sorted_stamps[stamp_idx]) != fixed_stamps.end()) {
+      num_fixed++;
+    }
+    num_fixed_up_to_index.emplace_back(num_fixed);
+  }
+
+  std::vector<bool> factor_spans_fixed(factors.size(), false);
+  std::vector<size_t> num_kept_factors_by_stamp_idx(sorted_stamps.size(), 0);
+  for (size_t factor_idx = 0; factor_idx < factors.size(); factor_idx++) {
+    const RelativePoseFactorInfo &factor = factors[factor_idx];
+    size_t before_idx = index_by_stamp.at(factor.before_pose_timestamp_);
+    size_t after_idx = index_by_stamp.at(factor.after_pose_timestamp_);
+    size_t min_idx = std::min(before_idx, after_idx);
+    size_t max_idx = std::max(before_idx, after_idx);
+    if ((fixed_stamps.find(factor.before_pose_timestamp_) ==
+         fixed_stamps.end()) &&
+        (fixed_stamps.find(factor.after_pose_timestamp_) ==
+         fixed_stamps.end()) &&
+        (num_fixed_up_to_index[max_idx] > num_fixed_up_to_index[min_idx])) {
+      factor_spans_fixed[factor_idx] = true;
+    } else {
+      num_kept_factors_by_stamp_idx[before_idx]++;
+      num_kept_factors_by_stamp_idx[after_idx]++;
+    }
+  }
+
+  // Keep spanning factors for any pose that would otherwise have no factors
+  for (size_t factor_idx = 0; factor_idx < factors.size(); factor_idx++) {
+    if (!factor_spans_fixed[factor_idx]) {
+      continue;
+    }
+    size_t before_idx =
+        index_by_stamp.at(factors[factor_idx].before_pose_timestamp_);
+    size_t after_idx =
+        index_by_stamp.at(factors[factor_idx].after_pose_timestamp_);
+    if ((num_kept_factors_by_stamp_idx[before_idx] == 0) ||
+        (num_kept_factors_by_stamp_idx[after_idx] == 0)) {
+      factor_spans_fixed[factor_idx] = false;
+      num_kept_factors_by_stamp_idx[before_idx]++;
+      num_kept_factors_by_stamp_idx[after_idx]++;
+    }
+  }
+
+  std::vector<size_t> parents(sorted_stamps.size());
+  for (size_t stamp_idx = 0; stamp_idx < sorted_stamps.size(); stamp_idx++) {
+    parents[stamp_idx] = stamp_idx;
+  }
+  for (size_t factor_idx = 0; factor_idx < factors.size(); factor_idx++) {
+    const RelativePoseFactorInfo &factor = factors[factor_idx];
+    if (factor_spans_fixed[factor_idx] ||
+        (fixed_stamps.find(factor.before_pose_timestamp_) !=
+         fixed_stamps.end()) ||
+        (fixed_stamps.find(factor.after_pose_timestamp_) !=
+         fixed_stamps.end())) {
+      continue;
+    }
+    size_t before_root = findSegmentRoot(
+        parents, index_by_stamp.at(factor.before_pose_timestamp_));
+    size_t after_root = findSegmentRoot(
+        parents, index_by_stamp.at(factor.after_pose_timestamp_));
+    parents[std::max(before_root, after_root)] =
+        std::min(before_root, after_root);
+  }
+
+  std::vector<InterpolationSegment> segments;
+  std::unordered_map<size_t, size_t> segment_idx_by_root;
+  for (size_t stamp_idx = 0; stamp_idx < sorted_stamps.size(); stamp_idx++) {
+    if (fixed_stamps.find(sorted_stamps[stamp_idx]) != fixed_stamps.end()) {
+      continue;
+    }
+    size_t root = findSegmentRoot(parents, stamp_idx);
+    if (segment_idx_by_root.find(root) == segment_idx_by_root.end()) {
+      segment_idx_by_root[root] = segments.size();
+      segments.emplace_back(InterpolationSegment());
+    }
+    segments[segment_idx_by_root.at(root)].variable_stamps_.emplace_back(
+        sorted_stamps[stamp_idx]);
+  }
+
+  std::vector<util::BoostHashSet<pose::Timestamp>> anchors_by_segment(
+      segments.size());
+  for (size_t factor_idx = 0; factor_idx < factors.size(); factor_idx++) {
+    if (factor_spans_fixed[factor_idx]) {
+      continue;
+    }
+    const RelativePoseFactorInfo &factor = factors[factor_idx];
+    bool before_fixed = fixed_stamps.find(factor.before_pose_timestamp_) !=
+                        fixed_stamps.end();
+    bool after_fixed = fixed_stamps.find(factor.after_pose_timestamp_) !=
+                       fixed_stamps.end();
+    if (before_fixed && after_fixed) {
+      // Doesn't constrain anything
+      continue;
+    }
+    pose::Timestamp variable_stamp = before_fixed
+                                         ? factor.after_pose_timestamp_
+                                         : factor.before_pose_timestamp_;
+    size_t segment_idx = segment_idx_by_root.at(
+        findSegmentRoot(parents, index_by_stamp.at(variable_stamp)));
+    segments[segment_idx].factor_indices_.emplace_back(factor_idx);
+    if (before_fixed) {
+      anchors_by_segment[segment_idx].insert(factor.before_pose_timestamp_);
+    } else if (after_fixed) {
+      anchors_by_segment[segment_idx].insert(factor.after_pose_timestamp_);
+    }
+  }
+
+  for (size_t segment_idx = 0; segment_idx < segments.size(); segment_idx++) {
+    segments[segment_idx].anchor_stamps_.insert(
+        segments[segment_idx].anchor_stamps_.end(),
+        anchors_by_segment[segment_idx].begin(),
+        anchors_by_segment[segment_idx].end());
+    std::sort(segments[segment_idx].anchor_stamps_.begin(),
+              segments[segment_idx].anchor_stamps_.end(),
+              pose::timestamp_sort());
+  }
+  return segments;
+}
+
+bool factorErrorWithinTolerance(
+    const RelativePoseFactorInfo &factor,
+    const util::BoostHashMap<pose::Timestamp, Pose3D<double>> &poses,
+    const SegmentedInterpolationParams &segment_params) {
+  Pose3D<double> est_pose_deviation =
+      getPose2RelativeToPose1(poses.at(factor.before_pose_timestamp_),
+                              poses.at(factor.after_pose_timestamp_));
+  Pose3D<double> error = getPose2RelativeToPose1(
+      factor.measured_pose_deviation_, est_pose_deviation);
+  return (error.transl_.norm() <=
+          segment_params.closed_form_max_factor_transl_error_) &&
+         (abs(error.orientation_.angle()) <=
+          segment_params.closed_form_max_factor_rot_error_);
+}
+
+/**
+ * Try to solve the segment in closed form. This requires that the poses of
+ * the segment (in time order) form a chain of factors from an anchor (fixed
+ * pose) at one end to (optionally) an anchor at the other end.
+ *
+ * The poses are dead-reckoned from the first anchor. If there is an anchor at
+ * the other end, the discrepancy between the dead-reckoned pose and the fixed
+ * pose there is distributed along the chain, proportional to the distance
+ * travelled, by interpolating along the SE(3) geodesic.
+ *
+ * @param segment           Segment to solve.
+ * @param factors           All factors (indexed by the segment's factor
+ *                          indices).
+ * @param initial_estimates Initial estimates (contains the anchor poses).
+ * @param segment_params    Parameters for closed form solving.
+ * @param segment_results   Poses for the variable timestamps in the segment.
+ *                          Populated even if the closed form solution is
+ *                          rejected for exceeding the error tolerance, so
+ *                          that it can be used as the initial estimate for
+ *                          optimization.
+ *
+ * @return True if the closed form solution was acceptable, false if the
+ * segment needs to be optimized.
+ */
+bool solveSegmentInClosedForm(
+    const InterpolationSegment &segment,
+    const std::vector<RelativePoseFactorInfo> &factors,
+    const util::BoostHashMap<pose::Timestamp, Pose3D<double>>
+        &initial_estimates,
+    const SegmentedInterpolationParams &segment_params,
+    util::BoostHashMap<pose::Timestamp, Pose3D<double>> &segment_results) {
+  if (segment.anchor_stamps_.empty() || (segment.anchor_stamps_.size() > 2)) {
+    return false;
+  }
+
+  std::vector<pose::Timestamp> chain;
+  bool has_start_anchor = pose::timestamp_sort()(
+      segment.anchor_stamps_.front(), segment.variable_stamps_.front());
+  bool has_end_anchor = pose::timestamp_sort()(segment.variable_stamps_.back(),
+                                               segment.anchor_stamps_.back());
+  if ((segment.anchor_stamps_.size() == 2) &&
+      !(has_start_anchor && has_end_anchor)) {
+    // Anchor in the middle of the segment, so it's not a chain
+    return false;
+  }
+  if (!has_start_anchor && !has_end_anchor) {
+    return false;
+  }
+  if (has_start_anchor) {
+    chain.emplace_back(segment.anchor_stamps_.front());
+  }
+  chain.insert(chain.end(),
+               segment.variable_stamps_.begin(),
+               segment.variable_stamps_.end());
+  if (has_end_anchor) {
+    chain.emplace_back(segment.anchor_stamps_.back());
+  }
+  if (!has_start_anchor) {
+    // Only anchored at the end, so dead-reckon backwards from it
+    std::reverse(chain.begin(), chain.end());
+  }
+
+  util::BoostHashMap<std::pair<pose::Timestamp, pose::Timestamp>, size_t>
+      factor_by_stamps;
+  for (const size_t &factor_idx : segment.factor_indices_) {
+    const RelativePoseFactorInfo &factor = factors[factor_idx];
+    factor_by_stamps[std::make_pair(factor.before_pose_timestamp_,
+                                    factor.after_pose_timestamp_)] = factor_idx;
+  }
+
+  util::BoostHashMap<pose::Timestamp, Pose3D<double>> chain_poses;
+  std::vector<double> dist_along_chain = {0};
+  chain_poses[chain.front()] = initial_estimates.at(chain.front());
+  for (size_t chain_idx = 1; chain_idx < chain.size(); chain_idx++) {
+    pose::Timestamp prev_stamp = chain[chain_idx - 1];
+    pose::Timestamp curr_stamp = chain[chain_idx];
+    Pose3D<double> curr_rel_prev;
+    auto factor_it =
+        factor_by_stamps.find(std::make_pair(prev_stamp, curr_stamp));
+    if (factor_it != factor_by_stamps.end()) {
+      curr_rel_prev = factors[factor_it->second].measured_pose_deviation_;
+    } else {
+      factor_it = factor_by_stamps.find(std::make_pair(curr_stamp, prev_stamp));
+      if (factor_it == factor_by_stamps.end()) {
+        return false;
+      }
+      curr_rel_prev =
+          poseInverse(factors[factor_it->second].measured_pose_deviation_);
+    }
+    chain_poses[curr_stamp] =
+        combinePoses(chain_poses.at(prev_stamp), curr_rel_prev);
+    dist_along_chain.emplace_back(dist_along_chain.back() +
+                                  curr_rel_prev.transl_.norm());
+  }
+
+  if (has_start_anchor && has_end_anchor) {
+    // Discrepancy (in the world frame) between the fixed end pose and the
+    // dead-reckoned one
+    pose::Timestamp end_stamp = chain.back();
+    Pose3D<double> discrepancy =
+        combinePoses(initial_estimates.at(end_stamp),
+                     poseInverse(chain_poses.at(end_stamp)));
+    if ((discrepancy.transl_.norm() >
+         segment_params.closed_form_max_transl_discrepancy_) ||
+        (abs(discrepancy.orientation_.angle()) >
+         segment_params.closed_form_max_rot_discrepancy_)) {
+      return false;
+    }
+    Transform6Dof<double> discrepancy_mat = convertToAffine(discrepancy);
+    Eigen::Matrix4d discrepancy_log = discrepancy_mat.matrix().log();
+    double total_dist = dist_along_chain.back();
+    for (size_t chain_idx = 1; chain_idx < chain.size() - 1; chain_idx++) {
+      double fraction = (total_dist > kMinStdDev)
+                            ? (dist_along_chain[chain_idx] / total_dist)
+                            : ((double)chain_idx) / (chain.size() - 1);
+      Eigen::Matrix4d partial_correction_mat =
+          (fraction * discrepancy_log).exp();
+      Transform6Dof<double> partial_correction(partial_correction_mat);
+      chain_poses[chain[chain_idx]] =
+          combinePoses(convertAffineToPose3D(partial_correction),
+                       chain_poses.at(chain[chain_idx]));
+    }
+    chain_poses[end_stamp] = initial_estimates.at(end_stamp);
+  }
+
+  for (const pose::Timestamp &variable_stamp : segment.variable_stamps_) {
+    segment_results[variable_stamp] = chain_poses.at(variable_stamp);
+  }
+
+  for (const size_t &factor_idx : segment.factor_indices_) {
+    if (!factorErrorWithinTolerance(
+            factors[factor_idx], chain_poses, segment_params)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool solveInterpolationSegment(
+    const InterpolationSegment &segment,
+    const std::vector<RelativePoseFactorInfo> &factors,
+    const util::BoostHashMap<pose::Timestamp, Pose3D<double>>
+        &initial_estimates,
+    const SegmentedInterpolationParams &segment_params,
+    util::BoostHashMap<pose::Timestamp, Pose3D<double>> &segment_results) {
+  if (segment.factor_indices_.empty()) {
+    for (const pose::Timestamp &variable_stamp : segment.variable_stamps_) {
+      segment_results[variable_stamp] = initial_estimates.at(variable_stamp);
+    }
+    return true;
+  }
+
+  util::BoostHashMap<pose::Timestamp, Pose3D<double>> closed_form_results;
+  if (segment_params.use_closed_form_when_consistent_) {
+    if (solveSegmentInClosedForm(segment,
+                                 factors,
+                                 initial_estimates,
+                                 segment_params,
+                                 closed_form_results)) {
+      segment_results = closed_form_results;
+      return true;
+    }
+  }
+
+  util::BoostHashMap<pose::Timestamp, Pose3D<double>> segment_initial_ests;
+  for (const pose::Timestamp &variable_stamp : segment.variable_stamps_) {
+    if (closed_form_results.find(variable_stamp) !=
+        closed_form_results.end()) {
+      segment_initial_ests[variable_stamp] =
+          closed_form_results.at(variable_stamp);
+    } else {
+      segment_initial_ests[variable_stamp] =
+          initial_estimates.at(variable_stamp);
+    }
+  }
+  for (const pose::Timestamp &anchor_stamp : segment.anchor_stamps_) {
+    segment_initial_ests[anchor_stamp] = initial_estimates.at(anchor_stamp);
+  }
+  std::vector<RelativePoseFactorInfo> segment_factors;
+  for (const size_t &factor_idx : segment.factor_indices_) {
+    segment_factors.emplace_back(factors[factor_idx]);
+  }
+
+  util::BoostHashMap<pose::Timestamp, Pose3D<double>> optimized_poses;
+  std::vector<pose::Timestamp> sorted_segment_stamps;
+  bool success = runOptimization(segment_initial_ests,
+                                 segment_factors,
+                                 segment.anchor_stamps_,
+                                 optimized_poses,
+                                 sorted_segment_stamps);
+  for (const pose::Timestamp &variable_stamp : segment.variable_stamps_) {
+    segment_results[variable_stamp] = optimized_poses.at(variable_stamp);
+  }
+  return success;
+}
+
+void runSegmentedOptimization(
+    const util::BoostHashMap<pose::Timestamp, Pose3D<double>>
+        &initial_estimates,
+    const std::vector<RelativePoseFactorInfo> &factors,
+    const std::vector<pose::Timestamp> &fixed_timestamps,
+    const std::vector<pose::Timestamp> &sorted_stamps,
+    const SegmentedInterpolationParams &segment_params,
+    util::BoostHashMap<pose::Timestamp, Pose3D<double>> &results) {
+  util::BoostHashSet<pose::Timestamp> fixed_stamps_set(
+      fixed_timestamps.begin(), fixed_timestamps.end());
+  std::vector<InterpolationSegment> segments =
+      createInterpolationSegments(sorted_stamps, factors, fixed_stamps_set);
+
+  std::vector<util::BoostHashMap<pose::Timestamp, Pose3D<double>>>
+      results_by_segment(segments.size());
+  // Using char instead of bool so that segments can be written concurrently
+  std::vector<char> success_by_segment(segments.size(), false);
+  util::parallelFor(
+      segments.size(), segment_params.num_threads_, [&](const size_t &seg_idx) {
+        success_by_segment[seg_idx] =
+            solveInterpolationSegment(segments[seg_idx],
+                                      factors,
+                                      initial_estimates,
+                                      segment_params,
+                                      results_by_segment[seg_idx]);
+      });
+
+  for (size_t segment_idx = 0; segment_idx < segments.size(); segment_idx++) {
+    if (!success_by_segment[segment_idx]) {
+      LOG(ERROR) << "Optimization failed for interpolation segment starting "
+                    "at timestamp "
+                 << segments[segment_idx].variable_stamps_.front().first
+                 << ", "
+                 << segments[segment_idx].variable_stamps_.front().second;
+    }
+    results.insert(results_by_segment[segment_idx].begin(),
+                   results_by_segment[segment_idx].end());
+  }
+  for (const pose::Timestamp &fixed_stamp : fixed_timestamps) {
+    results[fixed_stamp] = initial_estimates.at(fixed_stamp);
+  }
+}
+
 void interpolate3dPosesUsingOdom(
     const std::vector<std::pair<pose::Timestamp, pose::Pose2d>> &odom_poses,
     const std::vector<std::pair<pose::Timestamp, Pose3D<double>>>
@@ -449,8 +867,8 @@ void interpolate3dPosesUsingOdom(
         void(const util::BoostHashMap<pose::Timestamp, Pose3D<double>> &,
              const std::vector<RelativePoseFactorInfo> &)> &vis_function,
     util::BoostHashMap<pose::Timestamp, Pose3D<double>> &interpolated_poses,
-    util::BoostHashMap<pose::Timestamp, Pose3D<double>>
-        &odom_poses_adjusted_3d) {
+    util::BoostHashMap<pose::Timestamp, Pose3D<double>> &odom_poses_adjusted_3d,
+    const SegmentedInterpolationParams &segment_params) {
   util::BoostHashMap<pose::Timestamp, pose::Timestamp> closest_odom_stamps;
   std::optional<Pose3D<double>> approx_odom_adjustment;
   std::vector<RelativePoseFactorInfo> pose_factor_infos =
@@ -508,11 +926,20 @@ void interpolate3dPosesUsingOdom(
   std::sort(all_stamps.begin(), all_stamps.end(), pose::timestamp_sort());
 
   vis_function(poses_by_timestamp, pose_factor_infos);
-  runOptimization(poses_by_timestamp,
-                  pose_factor_infos,
-                  coarse_timestamps,
-                  interpolated_poses,
-                  all_stamps);
+  if (segment_params.solve_in_segments_) {
+    runSegmentedOptimization(poses_by_timestamp,
+                             pose_factor_infos,
+                             coarse_timestamps,
+                             all_stamps,
+                             segment_params,
+                             interpolated_poses);
+  } else {
+    runOptimization(poses_by_timestamp,
+                    pose_factor_infos,
+                    coarse_timestamps,
+                    interpolated_poses,
+                    all_stamps);
+  }
   vis_function(interpolated_poses, pose_factor_infos);
 
   LOG(INFO) << "Storing interpolated poses";
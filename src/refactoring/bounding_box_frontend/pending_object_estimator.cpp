@@ -8,6 +8,7 @@
 #include <refactoring/bounding_box_frontend/pending_object_estimator.h>
 #include <refactoring/factors/bounding_box_factor.h>
 #include <refactoring/factors/shape_prior_factor.h>
+#include <refactoring/optimization/loss_function_pool.h>
 
 namespace vslam_types_refactor {
 
@@ -25,7 +26,7 @@ refineInitialEstimateForPendingObjects(
     const std::shared_ptr<vslam_types_refactor::ObjAndLowLevelFeaturePoseGraph<
         VisualFeatureFactorType>> &pose_graph,
     const PendingObjectEstimatorParams &estimator_params) {
-  ceres::Problem problem;
+  ceres::Problem problem(createProblemOptionsForPooledLossFunctions());
   std::unordered_map<ObjectId, EllipsoidEstimateNode> raw_ests;
   std::unordered_map<FrameId, RobotPoseNode> robot_pose_nodes;
   std::unordered_map<FrameId, RawPose3d<double>> robot_pose_estimates;
@@ -68,7 +69,7 @@ refineInitialEstimateForPendingObjects(
       double *robot_pose_block = robot_pose_nodes[obs.frame_id_].pose_->data();
       added_poses.insert(obs.frame_id_);
       problem.AddResidualBlock(
-          BoundingBoxFactor::createBoundingBoxFactor(
+          BoundingBoxCostFunctionAnalyticJacobian::createBoundingBoxFactor(
               estimator_params.object_residual_params_
                   .invalid_ellipsoid_error_val_,
               obs.bounding_box_corners_,
@@ -78,8 +79,9 @@ refineInitialEstimateForPendingObjects(
               std::nullopt,
               std::nullopt,
               std::nullopt),
-          new ceres::HuberLoss(estimator_params.object_residual_params_
-                                   .object_observation_huber_loss_param_),
+          LossFunctionPool::getInstance().getHuberLoss(
+              estimator_params.object_residual_params_
+                  .object_observation_huber_loss_param_),
           ellipsoid_ptr,
           robot_pose_block);
     }
@@ -88,8 +90,9 @@ refineInitialEstimateForPendingObjects(
         ShapePriorFactor::createShapeDimPrior(
             mean_and_cov_by_semantic_class.at(semantic_class).first,
             mean_and_cov_by_semantic_class.at(semantic_class).second),
-        new ceres::HuberLoss(estimator_params.object_residual_params_
-                                 .shape_dim_prior_factor_huber_loss_param_),
+        LossFunctionPool::getInstance().getHuberLoss(
+            estimator_params.object_residual_params_
+                .shape_dim_prior_factor_huber_loss_param_),
         ellipsoid_ptr);
   }
   // Set poses constant
@@ -0,0 +1,111 @@
+#include <base_lib/basic_utils.h>
+#include <file_io/cv_file_storage/long_term_object_map_file_storage_io.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <refactoring/long_term_map/long_term_map_compaction.h>
+
+#include <chrono>
+#include <filesystem>
+
+namespace vtr = vslam_types_refactor;
+
+typedef vtr::IndependentEllipsoidsLongTermObjectMap<util::EmptyStruct> MainLtm;
+
+DEFINE_string(long_term_map_input,
+              "",
+              "File name that stores the long-term map to compact.");
+DEFINE_string(long_term_map_output,
+              "",
+              "File name to output the compacted long-term map to. If empty, "
+              "only the sizes are reported.");
+DEFINE_double(merge_distance,
+              0.5,
+              "Objects of the same class with centers within this distance "
+              "(m) are merged. 0 disables merging");
+DEFINE_bool(x_y_only_merge,
+            true,
+            "Only consider the x-y distance between object centers when "
+            "merging");
+DEFINE_uint64(max_unobserved_sessions,
+              0,
+              "Objects that haven't been observed in this many consecutive "
+              "sessions are removed. 0 disables removal");
+
+/**
+ * Read the long-term map from the file.
+ *
+ * @return Time taken to read and deserialize the map (seconds).
+ */
+double readLongTermMap(const std::string &file_name, MainLtm &long_term_map) {
+  std::chrono::steady_clock::time_point start_time =
+      std::chrono::steady_clock::now();
+  cv::FileStorage ltm_in_fs(file_name, cv::FileStorage::READ);
+  vtr::SerializableIndependentEllipsoidsLongTermObjectMap<
+      util::EmptyStruct,
+      vtr::SerializableEmptyStruct>
+      serializable_ltm;
+  ltm_in_fs["long_term_map"] >> serializable_ltm;
+  ltm_in_fs.release();
+  long_term_map = serializable_ltm.getEntry();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start_time)
+      .count();
+}
+
+size_t getNumObjects(const MainLtm &long_term_map) {
+  vtr::EllipsoidResults ellipsoids;
+  long_term_map.getLtmEllipsoidResults(ellipsoids);
+  return ellipsoids.ellipsoids_.size();
+}
+
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  FLAGS_logtostderr = true;  // Don't log to disk - log to terminal
+  FLAGS_colorlogtostderr = true;
+
+  if (FLAGS_long_term_map_input.empty()) {
+    LOG(ERROR) << "No long-term map input file provided";
+    exit(1);
+  }
+
+  MainLtm long_term_map;
+  double input_load_time =
+      readLongTermMap(FLAGS_long_term_map_input, long_term_map);
+
+  vtr::LongTermMapCompactionParams compaction_params;
+  compaction_params.max_merge_distance_ = FLAGS_merge_distance;
+  compaction_params.x_y_only_merge_ = FLAGS_x_y_only_merge;
+  compaction_params.max_unobserved_sessions_ = FLAGS_max_unobserved_sessions;
+  vtr::LongTermMapCompactionStats stats =
+      vtr::LongTermMapCompactor(compaction_params).compact(long_term_map);
+
+  LOG(INFO) << "Merged " << stats.num_merged_ << " objects and removed "
+            << stats.num_removed_unobserved_ << " unobserved objects";
+  LOG(INFO) << "Before: " << stats.num_objects_before_ << " objects, "
+            << std::filesystem::file_size(FLAGS_long_term_map_input)
+            << " bytes, loaded in " << input_load_time << " s";
+
+  if (FLAGS_long_term_map_output.empty()) {
+    LOG(INFO) << "After: " << stats.num_objects_after_ << " objects";
+    return 0;
+  }
+
+  cv::FileStorage ltm_out_fs(FLAGS_long_term_map_output,
+                             cv::FileStorage::WRITE);
+  ltm_out_fs << "long_term_map"
+             << vtr::SerializableIndependentEllipsoidsLongTermObjectMap<
+                    util::EmptyStruct,
+                    vtr::SerializableEmptyStruct>(long_term_map);
+  ltm_out_fs.release();
+
+  // Reload the output so the load time covers reading from disk too
+  MainLtm compacted_long_term_map;
+  double output_load_time =
+      readLongTermMap(FLAGS_long_term_map_output, compacted_long_term_map);
+  LOG(INFO) << "After: " << getNumObjects(compacted_long_term_map)
+            << " objects, "
+            << std::filesystem::file_size(FLAGS_long_term_map_output)
+            << " bytes, loaded in " << output_load_time << " s";
+  return 0;
+}
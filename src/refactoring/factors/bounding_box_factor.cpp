@@ -39,4 +39,81 @@ BoundingBoxFactor::BoundingBoxFactor(
                         ((corner_pixel_locations(3) - cy) / fy));
 }
 
+bool BoundingBoxFactor::evaluateWithAnalyticJacobian(
+    const double *ellipsoid,
+    const double *robot_pose,
+    double *residuals_ptr,
+    double *ellipsoid_jacobian,
+    double *robot_pose_jacobian) const {
+  Eigen::Map<Eigen::Vector4d> residuals(residuals_ptr);
+  Eigen::Vector4d corner_results;
+  Eigen::Matrix<double, 4, kEllipsoidParamterizationSize, Eigen::RowMajor>
+      corners_wrt_ellipsoid;
+  Eigen::Matrix<double, 4, kRobotPoseParameterizationSize, Eigen::RowMajor>
+      corners_wrt_robot_pose;
+  bool valid_case = projectEllipsoidRectified(
+      createEllipsoidProjectionCameraFrame(robot_pose, robot_to_cam_tf_),
+      ellipsoid,
+      corner_results,
+      (robot_pose_jacobian == nullptr) ? nullptr
+                                       : corners_wrt_robot_pose.data(),
+      (ellipsoid_jacobian == nullptr) ? nullptr : corners_wrt_ellipsoid.data());
+
+  if (!valid_case) {
+    residuals.setConstant(invalid_ellipse_error_);
+    if (ellipsoid_jacobian != nullptr) {
+      Eigen::Map<Eigen::Matrix<double,
+                               4,
+                               kEllipsoidParamterizationSize,
+                               Eigen::RowMajor>>(ellipsoid_jacobian)
+          .setZero();
+    }
+    if (robot_pose_jacobian != nullptr) {
+      Eigen::Map<Eigen::Matrix<double,
+                               4,
+                               kRobotPoseParameterizationSize,
+                               Eigen::RowMajor>>(robot_pose_jacobian)
+          .setZero();
+    }
+    if (debug_ && obj_id_.has_value() && frame_id_.has_value() &&
+        camera_id_.has_value()) {
+      LOG(INFO) << "Residuals for obj id " << obj_id_.value()
+                << " at frame/cam " << frame_id_.value() << "/"
+                << camera_id_.value() << " (invalid case): " << residuals;
+    }
+    return true;
+  }
+
+  residuals = sqrt_inf_mat_bounding_box_corners_rectified_ *
+              (corner_results - rectified_corner_locations_);
+  if (ellipsoid_jacobian != nullptr) {
+    Eigen::Map<Eigen::Matrix<double,
+                             4,
+                             kEllipsoidParamterizationSize,
+                             Eigen::RowMajor>>
+        ellipsoid_jacobian_mat(ellipsoid_jacobian);
+    ellipsoid_jacobian_mat =
+        sqrt_inf_mat_bounding_box_corners_rectified_ * corners_wrt_ellipsoid;
+  }
+  if (robot_pose_jacobian != nullptr) {
+    Eigen::Map<Eigen::Matrix<double,
+                             4,
+                             kRobotPoseParameterizationSize,
+                             Eigen::RowMajor>>
+        robot_pose_jacobian_mat(robot_pose_jacobian);
+    robot_pose_jacobian_mat =
+        sqrt_inf_mat_bounding_box_corners_rectified_ * corners_wrt_robot_pose;
+  }
+  if (debug_ && obj_id_.has_value() && frame_id_.has_value() &&
+      camera_id_.has_value()) {
+    LOG(INFO) << "Corners for obj id " << obj_id_.value() << " at frame/cam "
+              << frame_id_.value() << "/" << camera_id_.value() << ": "
+              << corner_results;
+    LOG(INFO) << "Residuals for obj id " << obj_id_.value()
+              << " at frame/cam " << frame_id_.value() << "/"
+              << camera_id_.value() << ": " << residuals;
+  }
+  return true;
+}
+
 }  // namespace vslam_types_refactor
\ No newline at end of file
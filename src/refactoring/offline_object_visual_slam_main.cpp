@@ -1,8 +1,10 @@
 #include <analysis/cumulative_timer_constants.h>
 #include <analysis/cumulative_timer_factory.h>
+#include <base_lib/async_work_queue.h>
 #include <base_lib/basic_utils.h>
 #include <base_lib/pose_utils.h>
 #include <debugging/ground_truth_utils.h>
+#include <file_io/async_checkpoint_writer.h>
 #include <file_io/bounding_box_by_node_id_io.h>
 #include <file_io/bounding_box_by_timestamp_io.h>
 #include <file_io/camera_extrinsics_with_id_io.h>
@@ -11,8 +13,11 @@
 #include <file_io/cv_file_storage/config_file_storage_io.h>
 #include <file_io/cv_file_storage/long_term_object_map_file_storage_io.h>
 #include <file_io/cv_file_storage/object_and_reprojection_feature_pose_graph_file_storage_io.h>
+#include <file_io/cv_file_storage/offline_runner_checkpoint_file_storage_io.h>
 #include <file_io/cv_file_storage/output_problem_data_file_storage_io.h>
+#include <file_io/cv_file_storage/pose_graph_checkpoint_writer.h>
 #include <file_io/cv_file_storage/vslam_basic_types_file_storage_io.h>
+#include <file_io/debug_dump_io.h>
 #include <file_io/node_id_and_timestamp_io.h>
 #include <file_io/pose_3d_with_timestamp_io.h>
 #include <file_io/pose_io_utils.h>
@@ -20,9 +25,14 @@
 #include <glog/logging.h>
 #include <refactoring/bounding_box_frontend/bounding_box_retriever.h>
 #include <refactoring/bounding_box_frontend/feature_based_bounding_box_front_end.h>
+#include <refactoring/bounding_box_frontend/pipelined_bounding_box_querier.h>
 #include <refactoring/configuration/full_ov_slam_config.h>
+#include <refactoring/image_processing/decoded_image_cache.h>
 #include <refactoring/image_processing/image_processing_utils.h>
+#include <refactoring/long_term_map/long_term_map_compaction.h>
 #include <refactoring/long_term_map/long_term_map_factor_creator.h>
+#include <refactoring/long_term_map/long_term_map_tiles.h>
+#include <refactoring/offline/keyframe_selection.h>
 #include <refactoring/offline/offline_problem_data.h>
 #include <refactoring/offline/offline_problem_runner.h>
 #include <refactoring/output_problem_data.h>
@@ -38,6 +48,7 @@
 namespace vtr = vslam_types_refactor;
 
 const std::string kCeresOptInfoLogFile = "ceres_opt_summary.csv";
+const std::string kFrameTelemetryLogFile = "frame_telemetry.jsonl";
 
 typedef vtr::IndependentEllipsoidsLongTermObjectMap<
     //    std::unordered_map<vtr::ObjectId, vtr::RoshanAggregateBbInfo>>
@@ -54,6 +65,8 @@ typedef std::shared_ptr<MainPg> MainPgPtr;
 typedef std::pair<vslam_types_refactor::FactorType,
                   vslam_types_refactor::FeatureFactorId>
     MainFactorInfo;
+typedef file_io::AsyncCheckpointWriter<vtr::OfflineRunnerCheckpointState>
+    RunnerCheckpointWriter;
 
 DEFINE_string(param_prefix, "", "param_prefix");
 DEFINE_string(intrinsics_file, "", "File with camera intrinsics");
@@ -84,7 +97,9 @@ DEFINE_string(low_level_feats_dir,
 DEFINE_string(bb_associations_out_file,
               "",
               "File to write ellipsoid results and associated bounding boxes "
-              "to. Skipped if this param is not set");
+              "to. Written in the binary stream format if the file has the "
+              ".bin extension, JSON otherwise. Skipped if this param is not "
+              "set");
 DEFINE_string(ltm_opt_jacobian_info_directory,
               "",
               "Directory to write jacobian info from the LTM optimization for");
@@ -119,6 +134,140 @@ DEFINE_string(input_checkpoints_dir,
 DEFINE_bool(disable_log_to_stderr,
             false,
             "Set to true if the logging to standard error should be disabled");
+DEFINE_bool(async_checkpoint_writing,
+            true,
+            "Set to true to write pose graph checkpoints (when "
+            "output_checkpoints_dir is set) on a background thread instead of "
+            "blocking the optimization while serializing");
+DEFINE_int32(checkpoint_every_n_frames,
+             0,
+             "If positive (and output_checkpoints_dir is set), write a pose "
+             "graph checkpoint after the optimization for every n-th frame");
+DEFINE_int32(runner_checkpoint_every_n_frames,
+             0,
+             "If positive (and output_checkpoints_dir is set), write a full "
+             "runner checkpoint (pose graph, visual feature front end and "
+             "feature-based bounding box front end state) after the "
+             "optimization for every n-th frame. These can be used with "
+             "resume_from_checkpoint_file. Not checkpointed: the optimization "
+             "logger, per-frame telemetry and cumulative timers (these restart "
+             "at the resumed frame) and the solver problems (these are "
+             "rebuilt, so estimates match an uninterrupted run up to solver "
+             "round-off)");
+DEFINE_string(resume_from_checkpoint_file,
+              "",
+              "Runner checkpoint file (written because of "
+              "runner_checkpoint_every_n_frames) to resume the optimization "
+              "from. If empty, the optimization starts from the first frame.");
+DEFINE_bool(async_visualization,
+            false,
+            "Set to true to render and publish visualizations and debug images "
+            "on a background thread from a snapshot of the estimates, instead "
+            "of blocking the optimization");
+DEFINE_int32(async_visualization_queue_size,
+             4,
+             "Maximum number of visualization snapshots waiting to be rendered "
+             "when async_visualization is set");
+DEFINE_bool(async_visualization_drop_frames,
+            true,
+            "When async_visualization is set and the queue is full, drop the "
+            "oldest pending snapshot instead of blocking the optimization");
+DEFINE_bool(localize_session_end_merge_reoptimization,
+            true,
+            "After merging objects at the end of the session, re-optimize only "
+            "the frames near the merged objects' observations (followed by a "
+            "full optimization only if the estimates change significantly)");
+DEFINE_int32(session_end_merge_reoptimization_neighborhood,
+             20,
+             "Number of frames before the merged objects' first observation "
+             "to include in the localized re-optimization after merging");
+DEFINE_double(session_end_merge_full_reoptimization_threshold,
+              0.5,
+              "If any pose or object moves more than this (m) in the "
+              "localized re-optimization after merging, run a full "
+              "optimization afterwards");
+DEFINE_int32(bb_detection_prefetch_frames,
+             4,
+             "Maximum number of frames ahead of the current frame for which "
+             "bounding boxes are detected in the background. 0 queries the "
+             "detector only when a frame is processed. Not used when "
+             "precomputed bounding boxes are provided");
+DEFINE_int32(feature_prefetch_frames,
+             8,
+             "Maximum number of frames ahead of the current frame for which "
+             "the low level feature observations are assembled in the "
+             "background. 0 assembles them only when a frame is processed");
+DEFINE_bool(concurrent_front_ends,
+            false,
+            "Run the visual feature front end on a separate thread while the "
+            "bounding box front end processes the same frame");
+DEFINE_double(ltm_tile_size,
+              0,
+              "If positive, the long-term map is split into square tiles of "
+              "this size (m) and only the objects in tiles near the robot are "
+              "kept in the pose graph. If 0, all long-term map objects are "
+              "added up front");
+DEFINE_double(ltm_tile_load_radius,
+              50,
+              "Long-term map objects in tiles within this distance (m) of the "
+              "robot are added to the pose graph. Only used if ltm_tile_size "
+              "is positive");
+DEFINE_double(ltm_tile_unload_radius,
+              75,
+              "Long-term map objects that haven't been observed are removed "
+              "from the pose graph when no tile within this distance (m) of "
+              "the robot contains them. Only used if ltm_tile_size is "
+              "positive");
+DEFINE_double(ltm_compaction_merge_distance,
+              0,
+              "If positive, long-term map objects of the same class with "
+              "centers (x-y only) within this distance (m) are merged before "
+              "the long-term map is written");
+DEFINE_uint64(ltm_max_unobserved_sessions,
+              0,
+              "If positive, long-term map objects that haven't been observed "
+              "in this many consecutive sessions are removed before the "
+              "long-term map is written");
+DEFINE_uint64(decoded_image_cache_size,
+              vtr::kDefaultDecodedImageCacheCapacity,
+              "Number of decoded images kept for reuse by the front ends and "
+              "visualizers");
+DEFINE_bool(select_keyframes,
+            false,
+            "If true, only keyframes become pose graph nodes instead of every "
+            "frame. Keyframes are selected from the pose change (using the "
+            "sparsifier thresholds in the config), feature parallax and "
+            "detection novelty. Results are output with the input frame ids");
+DEFINE_double(keyframe_max_median_feature_parallax,
+              0,
+              "A frame becomes a keyframe if the median pixel displacement of "
+              "the features it shares with the last keyframe exceeds this. 0 "
+              "disables this check");
+DEFINE_double(keyframe_min_tracked_feature_fraction,
+              0,
+              "A frame becomes a keyframe if it observes less than this "
+              "fraction of the last keyframe's features. 0 disables this "
+              "check");
+DEFINE_bool(keyframe_on_new_detections,
+            false,
+            "A frame becomes a keyframe if it has more precomputed detections "
+            "of any class than the last keyframe");
+DEFINE_string(bb_detection_cache_dir,
+              "",
+              "Directory for caching detected bounding boxes by image "
+              "contents, so reruns on the same images don't query the "
+              "detector. Caching is disabled if empty");
+DEFINE_string(bb_detector_model,
+              "",
+              "Identifies the model (and configuration) served by the "
+              "bounding box detection service. Required when "
+              "bb_detection_cache_dir is set, so that detections from "
+              "different models are cached separately");
+DEFINE_bool(log_frame_telemetry,
+            true,
+            "Write per-frame stage timings, solver iterations, residual counts "
+            "and memory use to the logs directory (newline-delimited JSON). "
+            "Only used if logs_directory is set");
 
 std::unordered_map<
     vtr::FrameId,
@@ -203,12 +352,16 @@ void createPoseGraph(
         const std::unordered_set<vtr::ObjectId> &,
         util::BoostHashMap<MainFactorInfo, std::unordered_set<vtr::ObjectId>>
             &)> &long_term_map_factor_provider,
+    const bool &add_ltm_objects,
     MainPgPtr &pose_graph) {
   std::unordered_map<vtr::ObjectId,
                      std::pair<std::string, vtr::RawEllipsoid<double>>>
       ltm_objects;
   vtr::EllipsoidResults ellipsoids_in_map;
-  if (input_problem_data.getLongTermObjectMap() != nullptr) {
+  // If not added here, the long-term map objects are added by tile as the
+  // robot gets near them
+  if ((add_ltm_objects) &&
+      (input_problem_data.getLongTermObjectMap() != nullptr)) {
     input_problem_data.getLongTermObjectMap()->getEllipsoidResults(
         ellipsoids_in_map);
   }
@@ -313,19 +466,235 @@ void publishLowLevelFeaturesLatestImages(
   }
 }
 
-void visualizationStub(
-    const std::shared_ptr<vtr::RosVisualization> &vis_manager,
-    vtr::SaveToFileVisualizer &save_to_file_visualizer,
-    const std::unordered_map<vtr::CameraId, vtr::CameraExtrinsics<double>>
-        &extrinsics,
-    const std::unordered_map<vtr::CameraId, vtr::CameraIntrinsicsMat<double>>
-        &intrinsics,
-    const std::unordered_map<vtr::CameraId, std::pair<double, double>>
-        &img_heights_and_widths,
-    const std::unordered_map<
-        vtr::FrameId,
-        std::unordered_map<vtr::CameraId, sensor_msgs::Image::ConstPtr>>
-        &images,
+/**
+ * Estimates to render in the visualization, converted from the pose graph and
+ * the input problem data.
+ */
+struct VisualizationEstimates {
+  std::unordered_map<vtr::FrameId, vtr::Pose3D<double>> initial_trajectory_;
+  std::unordered_map<vtr::FrameId, vtr::Pose3D<double>> optimized_trajectory_;
+  std::unordered_map<vtr::ObjectId,
+                     std::pair<std::string, vtr::EllipsoidState<double>>>
+      optimized_ellipsoid_estimates_with_classes_;
+  std::unordered_map<vtr::FeatureId, vtr::Position3d<double>> feature_ests_;
+  std::unordered_map<
+      vtr::ObjectId,
+      std::pair<std::string,
+                std::pair<vtr::EllipsoidState<double>,
+                          vtr::Covariance<double,
+                                          vtr::kEllipsoidParamterizationSize>>>>
+      ltm_ellipsoids_;
+};
+
+/**
+ * Copy of the state needed to render the visualization for one optimization.
+ * Once created, this does not reference anything that the optimizer or the
+ * front end modifies, so it can be rendered on another thread.
+ */
+struct VisualizationSnapshot {
+  vtr::FrameId min_frame_optimized_;
+  vtr::FrameId max_frame_optimized_;
+  vtr::VisualizationTypeEnum visualization_stage_;
+
+  VisualizationEstimates estimates_;
+
+  std::unordered_map<vtr::CameraId, std::pair<double, double>>
+      img_heights_and_widths_;
+
+  // Per-frame observations are only copied for the frames in the optimized
+  // window
+  std::unordered_map<
+      vtr::FrameId,
+      std::unordered_map<
+          vtr::CameraId,
+          std::unordered_map<vtr::FeatureId, vtr::PixelCoord<double>>>>
+      observed_features_;
+  std::shared_ptr<std::unordered_map<
+      vtr::FrameId,
+      std::unordered_map<vtr::CameraId,
+                         std::vector<std::pair<vtr::BbCornerPair<double>,
+                                               std::optional<double>>>>>>
+      all_observed_corner_locations_with_uncertainty_;
+  std::shared_ptr<std::unordered_map<
+      vtr::FrameId,
+      std::unordered_map<
+          vtr::CameraId,
+          std::unordered_map<
+              vtr::ObjectId,
+              std::pair<vtr::BbCornerPair<double>, std::optional<double>>>>>>
+      observed_corner_locations_;
+  std::shared_ptr<std::vector<std::unordered_map<
+      vtr::FrameId,
+      std::unordered_map<vtr::CameraId,
+                         std::pair<vtr::BbCornerPair<double>, double>>>>>
+      bounding_boxes_for_pending_object_;
+  std::shared_ptr<std::vector<
+      std::pair<std::string, std::optional<vtr::EllipsoidState<double>>>>>
+      pending_objects_;
+};
+
+template <typename FrameKeyedMap>
+std::shared_ptr<FrameKeyedMap> copyFramesInWindow(
+    const FrameKeyedMap &frame_keyed_map,
+    const vtr::FrameId &min_frame_id,
+    const vtr::FrameId &max_frame_id) {
+  std::shared_ptr<FrameKeyedMap> window_copy =
+      std::make_shared<FrameKeyedMap>();
+  for (vtr::FrameId frame_id = min_frame_id; frame_id <= max_frame_id;
+       frame_id++) {
+    auto frame_entry = frame_keyed_map.find(frame_id);
+    if (frame_entry != frame_keyed_map.end()) {
+      (*window_copy)[frame_id] = frame_entry->second;
+    }
+  }
+  return window_copy;
+}
+
+void writeCheckpoint(
+    const std::shared_ptr<vtr::PoseGraphCheckpointWriter> &checkpoint_writer,
+    std::shared_ptr<
+        vtr::ObjAndLowLevelFeaturePoseGraph<vtr::ReprojectionErrorFactor>>
+        &pose_graph,
+    const std::string &out_file) {
+  MainPgPtr derived_pose_graph = std::dynamic_pointer_cast<MainPg>(pose_graph);
+  if (checkpoint_writer != nullptr) {
+    checkpoint_writer->writeCheckpoint(derived_pose_graph, out_file);
+  } else {
+    vtr::outputPoseGraphToFile(derived_pose_graph, out_file);
+  }
+}
+
+void dumpCheckpointsForVisualizationStage(
+    std::shared_ptr<
+        vtr::ObjAndLowLevelFeaturePoseGraph<vtr::ReprojectionErrorFactor>>
+        &pose_graph,
+    const vtr::FrameId &max_frame_optimized,
+    const vtr::VisualizationTypeEnum &visualization_stage,
+    const vtr::FrameId &final_frame_id,
+    const std::string &output_checkpoints_dir,
+    const int &checkpoint_every_n_frames,
+    const std::shared_ptr<vtr::PoseGraphCheckpointWriter> &checkpoint_writer,
+    const int &attempt) {
+  if (output_checkpoints_dir.empty()) {
+    return;
+  }
+  std::string checkpoints_dir =
+      file_io::ensureDirectoryPathEndsWithSlash(output_checkpoints_dir);
+  switch (visualization_stage) {
+    case vtr::BEFORE_EACH_OPTIMIZATION:
+      if (max_frame_optimized == final_frame_id) {
+        LOG(INFO) << "Dumping pose graph before final opt";
+        writeCheckpoint(checkpoint_writer,
+                        pose_graph,
+                        checkpoints_dir +
+                            vtr::kPreOptimizationCheckpointOutputFileBaseName +
+                            std::to_string(final_frame_id) +
+                            vtr::kAttemptSuffix + std::to_string(attempt) +
+                            file_io::kJsonExtension);
+      }
+      break;
+    case vtr::AFTER_EACH_OPTIMIZATION:
+      if ((checkpoint_every_n_frames > 0) &&
+          ((max_frame_optimized % checkpoint_every_n_frames) == 0)) {
+        LOG(INFO) << "Dumping periodic checkpoint after frame "
+                  << max_frame_optimized;
+        writeCheckpoint(checkpoint_writer,
+                        pose_graph,
+                        checkpoints_dir +
+                            vtr::kPeriodicCheckpointOutputFileBaseName +
+                            std::to_string(max_frame_optimized) +
+                            file_io::kJsonExtension);
+      }
+      break;
+    case vtr::AFTER_ALL_POSTPROCESSING:
+      LOG(INFO) << "Dumping pose graph after all pose graph adjustments";
+      writeCheckpoint(checkpoint_writer,
+                      pose_graph,
+                      checkpoints_dir +
+                          vtr::kPostPostprocessingCheckpointOutputFileBaseName +
+                          file_io::kJsonExtension);
+      break;
+    case vtr::AFTER_ALL_OPTIMIZATION:
+      LOG(INFO) << "Dumping pose graph after all data, before post processing";
+      writeCheckpoint(checkpoint_writer,
+                      pose_graph,
+                      checkpoints_dir +
+                          vtr::kPostFrameAddCheckpointOutputFileBaseName +
+                          file_io::kJsonExtension);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Check if anything is rendered for the given visualization stage.
+ */
+bool isRenderedVisualizationStage(
+    const vtr::VisualizationTypeEnum &visualization_stage) {
+  return (visualization_stage == vtr::BEFORE_ANY_OPTIMIZATION) ||
+         (visualization_stage == vtr::AFTER_EACH_OPTIMIZATION) ||
+         (visualization_stage == vtr::AFTER_PGO_PLUS_OBJ_OPTIMIZATION);
+}
+
+/**
+ * Get the current estimates to visualize from the pose graph, along with the
+ * initial trajectory and long-term map from the input problem data.
+ */
+void extractVisualizationEstimates(
+    const MainProbData &input_problem_data,
+    std::shared_ptr<
+        vtr::ObjAndLowLevelFeaturePoseGraph<vtr::ReprojectionErrorFactor>>
+        &pose_graph,
+    VisualizationEstimates &estimates) {
+  estimates.initial_trajectory_ = input_problem_data.getRobotPoseEstimates();
+  std::unordered_map<vtr::FrameId, vtr::RawPose3d<double>>
+      optimized_robot_pose_estimates;
+  pose_graph->getRobotPoseEstimates(optimized_robot_pose_estimates);
+  for (const auto &frame_raw_pose : optimized_robot_pose_estimates) {
+    estimates.optimized_trajectory_[frame_raw_pose.first] =
+        vtr::convertToPose3D(frame_raw_pose.second);
+  }
+
+  std::unordered_map<vtr::ObjectId,
+                     std::pair<std::string, vtr::RawEllipsoid<double>>>
+      object_estimates;
+  pose_graph->getObjectEstimates(object_estimates);
+  for (const auto &obj_and_raw_est : object_estimates) {
+    estimates.optimized_ellipsoid_estimates_with_classes_[obj_and_raw_est
+                                                              .first] =
+        std::make_pair(
+            obj_and_raw_est.second.first,
+            vtr::convertToEllipsoidState(obj_and_raw_est.second.second));
+  }
+  pose_graph->getVisualFeatureEstimates(estimates.feature_ests_);
+
+  if (input_problem_data.getLongTermObjectMap() != nullptr) {
+    vtr::EllipsoidResults ellipsoids_in_map;
+    input_problem_data.getLongTermObjectMap()->getEllipsoidResults(
+        ellipsoids_in_map);
+
+    std::unordered_map<
+        vtr::ObjectId,
+        vtr::Covariance<double, vtr::kEllipsoidParamterizationSize>>
+        ellipsoid_covariances = input_problem_data.getLongTermObjectMap()
+                                    ->getEllipsoidCovariances();
+    for (const auto &ltm_ellipsoid : ellipsoids_in_map.ellipsoids_) {
+      estimates.ltm_ellipsoids_[ltm_ellipsoid.first] = std::make_pair(
+          ltm_ellipsoid.second.first,
+          std::make_pair(ltm_ellipsoid.second.second,
+                         ellipsoid_covariances.at(ltm_ellipsoid.first)));
+    }
+  }
+}
+
+/**
+ * Take a snapshot of the estimates and front end state needed for rendering
+ * the visualization for the given stage.
+ *
+ * @return Snapshot, or no value if the stage doesn't render anything.
+ */
+std::optional<VisualizationSnapshot> createVisualizationSnapshot(
     const std::shared_ptr<std::unordered_map<
         vtr::FrameId,
         std::unordered_map<vtr::CameraId,
@@ -354,21 +723,103 @@ void visualizationStub(
             vtr::CameraId,
             std::unordered_map<vtr::FeatureId, vtr::PixelCoord<double>>>>
         &observed_features,
-    const std::unordered_map<vtr::FeatureId, vtr::Position3d<double>>
-        &initial_feat_positions,
+    const std::unordered_map<vtr::CameraId, std::pair<double, double>>
+        &img_heights_and_widths,
     const MainProbData &input_problem_data,
     std::shared_ptr<
         vtr::ObjAndLowLevelFeaturePoseGraph<vtr::ReprojectionErrorFactor>>
         &pose_graph,
     const vtr::FrameId &min_frame_optimized,
     const vtr::FrameId &max_frame_optimized,
+    const vtr::VisualizationTypeEnum &visualization_stage) {
+  if (!isRenderedVisualizationStage(visualization_stage)) {
+    return std::nullopt;
+  }
+  VisualizationSnapshot snapshot;
+  snapshot.min_frame_optimized_ = min_frame_optimized;
+  snapshot.max_frame_optimized_ = max_frame_optimized;
+  snapshot.visualization_stage_ = visualization_stage;
+  if (visualization_stage == vtr::BEFORE_ANY_OPTIMIZATION) {
+    return snapshot;
+  }
+
+  extractVisualizationEstimates(
+      input_problem_data, pose_graph, snapshot.estimates_);
+
+  snapshot.all_observed_corner_locations_with_uncertainty_ =
+      copyFramesInWindow(*all_observed_corner_locations_with_uncertainty,
+                         min_frame_optimized,
+                         max_frame_optimized);
+  snapshot.observed_corner_locations_ = copyFramesInWindow(
+      *observed_corner_locations, min_frame_optimized, max_frame_optimized);
+  snapshot.observed_features_ = *copyFramesInWindow(
+      observed_features, min_frame_optimized, max_frame_optimized);
+  snapshot.img_heights_and_widths_ = img_heights_and_widths;
+  snapshot.bounding_boxes_for_pending_object_ =
+      std::make_shared<std::vector<std::unordered_map<
+          vtr::FrameId,
+          std::unordered_map<vtr::CameraId,
+                             std::pair<vtr::BbCornerPair<double>, double>>>>>(
+          *bounding_boxes_for_pending_object);
+  snapshot.pending_objects_ = std::make_shared<std::vector<
+      std::pair<std::string, std::optional<vtr::EllipsoidState<double>>>>>(
+      *pending_objects);
+  return snapshot;
+}
+
+/**
+ * Render (publish and save to file) the visualization for the given stage.
+ */
+void renderVisualization(
+    const std::shared_ptr<vtr::RosVisualization> &vis_manager,
+    vtr::SaveToFileVisualizer &save_to_file_visualizer,
+    const std::unordered_map<vtr::CameraId, vtr::CameraExtrinsics<double>>
+        &extrinsics,
+    const std::unordered_map<vtr::CameraId, vtr::CameraIntrinsicsMat<double>>
+        &intrinsics,
+    const std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<vtr::CameraId, sensor_msgs::Image::ConstPtr>>
+        &images,
+    const std::unordered_map<vtr::FeatureId, vtr::Position3d<double>>
+        &initial_feat_positions,
     const vtr::VisualizationTypeEnum &visualization_stage,
+    const vtr::FrameId &min_frame_optimized,
+    const vtr::FrameId &max_frame_optimized,
+    const VisualizationEstimates &estimates,
+    const std::unordered_map<vtr::CameraId, std::pair<double, double>>
+        &img_heights_and_widths,
+    const std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<
+            vtr::CameraId,
+            std::unordered_map<vtr::FeatureId, vtr::PixelCoord<double>>>>
+        &observed_features,
+    const std::shared_ptr<std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<vtr::CameraId,
+                           std::vector<std::pair<vtr::BbCornerPair<double>,
+                                                 std::optional<double>>>>>>
+        &all_observed_corner_locations_with_uncertainty,
+    const std::shared_ptr<std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<
+            vtr::CameraId,
+            std::unordered_map<
+                vtr::ObjectId,
+                std::pair<vtr::BbCornerPair<double>, std::optional<double>>>>>>
+        &observed_corner_locations,
+    const std::shared_ptr<std::vector<std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<vtr::CameraId,
+                           std::pair<vtr::BbCornerPair<double>, double>>>>>
+        &bounding_boxes_for_pending_object,
+    const std::shared_ptr<std::vector<
+        std::pair<std::string, std::optional<vtr::EllipsoidState<double>>>>>
+        &pending_objects,
     const double &near_edge_threshold,
     const size_t &pending_obj_min_obs_threshold,
-    const std::optional<std::vector<vtr::Pose3D<double>>> &gt_trajectory,
-    const vtr::FrameId &final_frame_id,
-    const std::string &output_checkpoints_dir,
-    const int &attempt = 0) {
+    const std::optional<std::vector<vtr::Pose3D<double>>> &gt_trajectory) {
 #ifdef RUN_TIMERS
   CumulativeFunctionTimer::Invocation invoc(
       vtr::CumulativeTimerFactory::getInstance()
@@ -385,87 +836,29 @@ void visualizationStub(
 
       sleep(3);
       break;
-    case vtr::BEFORE_EACH_OPTIMIZATION:
-      if ((max_frame_optimized == final_frame_id) &&
-          (!output_checkpoints_dir.empty())) {
-        LOG(INFO) << "Dumping pose graph before final opt";
-        MainPgPtr derived_pose_graph =
-            std::dynamic_pointer_cast<MainPg>(pose_graph);
-        vtr::outputPoseGraphToFile(
-            derived_pose_graph,
-            file_io::ensureDirectoryPathEndsWithSlash(
-                FLAGS_output_checkpoints_dir) +
-                vtr::kPreOptimizationCheckpointOutputFileBaseName +
-                std::to_string(final_frame_id) + vtr::kAttemptSuffix +
-                std::to_string(attempt) + file_io::kJsonExtension);
-      }
-      break;
     case vtr::AFTER_PGO_PLUS_OBJ_OPTIMIZATION:
       pgo_opt = true;
     case vtr::AFTER_EACH_OPTIMIZATION: {
-      std::unordered_map<vtr::FrameId, vtr::RawPose3d<double>>
-          optimized_robot_pose_estimates;
-      std::unordered_map<vtr::FrameId, vtr::Pose3D<double>>
-          initial_robot_pose_estimates =
-              input_problem_data.getRobotPoseEstimates();
-      pose_graph->getRobotPoseEstimates(optimized_robot_pose_estimates);
-      std::unordered_map<vtr::FrameId, vtr::Pose3D<double>>
-          optimized_trajectory;
-      for (const auto &frame_raw_pose : optimized_robot_pose_estimates) {
-        optimized_trajectory[frame_raw_pose.first] =
-            vtr::convertToPose3D(frame_raw_pose.second);
-      }
+      const std::unordered_map<vtr::FrameId, vtr::Pose3D<double>>
+          &initial_robot_pose_estimates = estimates.initial_trajectory_;
+      const std::unordered_map<vtr::FrameId, vtr::Pose3D<double>>
+          &optimized_trajectory = estimates.optimized_trajectory_;
 
-      std::unordered_map<vtr::ObjectId,
-                         std::pair<std::string, vtr::RawEllipsoid<double>>>
-          object_estimates;
-      pose_graph->getObjectEstimates(object_estimates);
-      std::unordered_map<vtr::ObjectId,
-                         std::pair<std::string, vtr::EllipsoidState<double>>>
-          optimized_ellipsoid_estimates_with_classes;
       std::unordered_map<vtr::ObjectId, vtr::EllipsoidState<double>>
           optimized_ellipsoid_estimates;
-      for (const auto &obj_and_raw_est : object_estimates) {
-        vtr::EllipsoidState<double> ellipsoid_state =
-            vtr::convertToEllipsoidState(obj_and_raw_est.second.second);
-        optimized_ellipsoid_estimates_with_classes[obj_and_raw_est.first] =
-            std::make_pair(obj_and_raw_est.second.first, ellipsoid_state);
-        optimized_ellipsoid_estimates[obj_and_raw_est.first] = ellipsoid_state;
+      for (const auto &obj_and_est :
+           estimates.optimized_ellipsoid_estimates_with_classes_) {
+        optimized_ellipsoid_estimates[obj_and_est.first] =
+            obj_and_est.second.second;
       }
       std_msgs::ColorRGBA optimized_ellipsoid_color;
       optimized_ellipsoid_color.a = 0.5;
       //      optimized_ellipsoid_color.r = 1.0;
       optimized_ellipsoid_color.g = 1;
       vis_manager->visualizeEllipsoids(
-          optimized_ellipsoid_estimates_with_classes, vtr::ESTIMATED);
-      std::unordered_map<
-          vtr::ObjectId,
-          std::pair<
-              std::string,
-              std::pair<
-                  vtr::EllipsoidState<double>,
-                  vtr::Covariance<double, vtr::kEllipsoidParamterizationSize>>>>
-          ltm_ellipsoids;
-      if (input_problem_data.getLongTermObjectMap() != nullptr) {
-        vtr::EllipsoidResults ellipsoids_in_map;
-        input_problem_data.getLongTermObjectMap()->getEllipsoidResults(
-            ellipsoids_in_map);
-
-        // TODO do this outside of visualization loop
-        std::unordered_map<
-            vtr::ObjectId,
-            vtr::Covariance<double, vtr::kEllipsoidParamterizationSize>>
-            ellipsoid_covariances = input_problem_data.getLongTermObjectMap()
-                                        ->getEllipsoidCovariances();
-        for (const auto &ltm_ellipsoid : ellipsoids_in_map.ellipsoids_) {
-          ltm_ellipsoids[ltm_ellipsoid.first] = std::make_pair(
-              ltm_ellipsoid.second.first,
-              std::make_pair(ltm_ellipsoid.second.second,
-                             ellipsoid_covariances.at(ltm_ellipsoid.first)));
-        }
-      }
-
-      vis_manager->publishLongTermMap(ltm_ellipsoids);
+          estimates.optimized_ellipsoid_estimates_with_classes_,
+          vtr::ESTIMATED);
+      vis_manager->publishLongTermMap(estimates.ltm_ellipsoids_);
 
       std::vector<size_t> num_obs_per_pending_obj;
       for (const auto &pending_obj_obs : *bounding_boxes_for_pending_object) {
@@ -480,8 +873,8 @@ void visualizationStub(
       vis_manager->visualizePendingEllipsoids(pending_objects,
                                               num_obs_per_pending_obj,
                                               pending_obj_min_obs_threshold);
-      std::unordered_map<vtr::FeatureId, vtr::Position3d<double>> feature_ests;
-      pose_graph->getVisualFeatureEstimates(feature_ests);
+      const std::unordered_map<vtr::FeatureId, vtr::Position3d<double>>
+          &feature_ests = estimates.feature_ests_;
       std::unordered_map<
           vtr::CameraId,
           std::unordered_map<vtr::FeatureId, vtr::PixelCoord<double>>>
@@ -513,7 +906,7 @@ void visualizationStub(
           img_heights_and_widths,
           images.at(max_frame_optimized),
           max_frame_optimized,
-          input_problem_data.getRobotPoseEstimates().at(max_frame_optimized),
+          initial_robot_pose_estimates.at(max_frame_optimized),
           initial_feat_positions,
           observed_feats_for_frame,
           vtr::PlotType::INITIAL);
@@ -616,38 +1009,182 @@ void visualizationStub(
 
       break;
     }
-    case vtr::AFTER_ALL_POSTPROCESSING:
-      if (!output_checkpoints_dir.empty()) {
-        LOG(INFO) << "Dumping pose graph after all pose graph adjustments";
-        MainPgPtr derived_pose_graph =
-            std::dynamic_pointer_cast<MainPg>(pose_graph);
-        vtr::outputPoseGraphToFile(
-            derived_pose_graph,
-            file_io::ensureDirectoryPathEndsWithSlash(
-                FLAGS_output_checkpoints_dir) +
-                vtr::kPostPostprocessingCheckpointOutputFileBaseName +
-                file_io::kJsonExtension);
-      }
-      break;
-    case vtr::AFTER_ALL_OPTIMIZATION:
-      if (!output_checkpoints_dir.empty()) {
-        LOG(INFO)
-            << "Dumping pose graph after all data, before post processing";
-        MainPgPtr derived_pose_graph =
-            std::dynamic_pointer_cast<MainPg>(pose_graph);
-        vtr::outputPoseGraphToFile(
-            derived_pose_graph,
-            file_io::ensureDirectoryPathEndsWithSlash(
-                FLAGS_output_checkpoints_dir) +
-                vtr::kPostFrameAddCheckpointOutputFileBaseName +
-                file_io::kJsonExtension);
-      }
-      break;
     default:
       break;
   }
 }
 
+/**
+ * Render the visualization for a snapshot. Apart from the snapshot, this only
+ * reads data that is constant for the full run, so it can be run on a thread
+ * other than the optimization thread.
+ */
+void renderVisualizationSnapshot(
+    const std::shared_ptr<vtr::RosVisualization> &vis_manager,
+    vtr::SaveToFileVisualizer &save_to_file_visualizer,
+    const std::unordered_map<vtr::CameraId, vtr::CameraExtrinsics<double>>
+        &extrinsics,
+    const std::unordered_map<vtr::CameraId, vtr::CameraIntrinsicsMat<double>>
+        &intrinsics,
+    const std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<vtr::CameraId, sensor_msgs::Image::ConstPtr>>
+        &images,
+    const std::unordered_map<vtr::FeatureId, vtr::Position3d<double>>
+        &initial_feat_positions,
+    const VisualizationSnapshot &snapshot,
+    const double &near_edge_threshold,
+    const size_t &pending_obj_min_obs_threshold,
+    const std::optional<std::vector<vtr::Pose3D<double>>> &gt_trajectory) {
+  renderVisualization(vis_manager,
+                      save_to_file_visualizer,
+                      extrinsics,
+                      intrinsics,
+                      images,
+                      initial_feat_positions,
+                      snapshot.visualization_stage_,
+                      snapshot.min_frame_optimized_,
+                      snapshot.max_frame_optimized_,
+                      snapshot.estimates_,
+                      snapshot.img_heights_and_widths_,
+                      snapshot.observed_features_,
+                      snapshot.all_observed_corner_locations_with_uncertainty_,
+                      snapshot.observed_corner_locations_,
+                      snapshot.bounding_boxes_for_pending_object_,
+                      snapshot.pending_objects_,
+                      near_edge_threshold,
+                      pending_obj_min_obs_threshold,
+                      gt_trajectory);
+}
+
+void visualizationStub(
+    const std::shared_ptr<vtr::RosVisualization> &vis_manager,
+    vtr::SaveToFileVisualizer &save_to_file_visualizer,
+    const std::unordered_map<vtr::CameraId, vtr::CameraExtrinsics<double>>
+        &extrinsics,
+    const std::unordered_map<vtr::CameraId, vtr::CameraIntrinsicsMat<double>>
+        &intrinsics,
+    const std::unordered_map<vtr::CameraId, std::pair<double, double>>
+        &img_heights_and_widths,
+    const std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<vtr::CameraId, sensor_msgs::Image::ConstPtr>>
+        &images,
+    const std::shared_ptr<std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<vtr::CameraId,
+                           std::vector<std::pair<vtr::BbCornerPair<double>,
+                                                 std::optional<double>>>>>>
+        &all_observed_corner_locations_with_uncertainty,
+    const std::shared_ptr<std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<
+            vtr::CameraId,
+            std::unordered_map<
+                vtr::ObjectId,
+                std::pair<vtr::BbCornerPair<double>, std::optional<double>>>>>>
+        &observed_corner_locations,
+    const std::shared_ptr<std::vector<std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<vtr::CameraId,
+                           std::pair<vtr::BbCornerPair<double>, double>>>>>
+        &bounding_boxes_for_pending_object,
+    const std::shared_ptr<std::vector<
+        std::pair<std::string, std::optional<vtr::EllipsoidState<double>>>>>
+        &pending_objects,
+    const std::unordered_map<
+        vtr::FrameId,
+        std::unordered_map<
+            vtr::CameraId,
+            std::unordered_map<vtr::FeatureId, vtr::PixelCoord<double>>>>
+        &observed_features,
+    const std::unordered_map<vtr::FeatureId, vtr::Position3d<double>>
+        &initial_feat_positions,
+    const MainProbData &input_problem_data,
+    std::shared_ptr<
+        vtr::ObjAndLowLevelFeaturePoseGraph<vtr::ReprojectionErrorFactor>>
+        &pose_graph,
+    const vtr::FrameId &min_frame_optimized,
+    const vtr::FrameId &max_frame_optimized,
+    const vtr::VisualizationTypeEnum &visualization_stage,
+    const double &near_edge_threshold,
+    const size_t &pending_obj_min_obs_threshold,
+    const std::optional<std::vector<vtr::Pose3D<double>>> &gt_trajectory,
+    const vtr::FrameId &final_frame_id,
+    const std::string &output_checkpoints_dir,
+    const int &checkpoint_every_n_frames,
+    const std::shared_ptr<vtr::PoseGraphCheckpointWriter> &checkpoint_writer,
+    const std::shared_ptr<util::AsyncWorkQueue<VisualizationSnapshot>>
+        &async_vis_queue,
+    const int &attempt = 0) {
+  dumpCheckpointsForVisualizationStage(pose_graph,
+                                       max_frame_optimized,
+                                       visualization_stage,
+                                       final_frame_id,
+                                       output_checkpoints_dir,
+                                       checkpoint_every_n_frames,
+                                       checkpoint_writer,
+                                       attempt);
+
+  if (!isRenderedVisualizationStage(visualization_stage)) {
+    return;
+  }
+
+  if (async_vis_queue != nullptr) {
+    std::optional<VisualizationSnapshot> snapshot;
+    {
+#ifdef RUN_TIMERS
+      CumulativeFunctionTimer::Invocation invoc(
+          vtr::CumulativeTimerFactory::getInstance()
+              .getOrCreateFunctionTimer(vtr::kTimerNameVisSnapshot)
+              .get());
+#endif
+      snapshot = createVisualizationSnapshot(
+          all_observed_corner_locations_with_uncertainty,
+          observed_corner_locations,
+          bounding_boxes_for_pending_object,
+          pending_objects,
+          observed_features,
+          img_heights_and_widths,
+          input_problem_data,
+          pose_graph,
+          min_frame_optimized,
+          max_frame_optimized,
+          visualization_stage);
+    }
+    if (snapshot.has_value() &&
+        !async_vis_queue->push(std::move(snapshot.value()))) {
+      LOG(INFO) << "Visualization queue full; dropped visualization for frame "
+                << max_frame_optimized;
+    }
+    return;
+  }
+
+  VisualizationEstimates estimates;
+  if (visualization_stage != vtr::BEFORE_ANY_OPTIMIZATION) {
+    extractVisualizationEstimates(input_problem_data, pose_graph, estimates);
+  }
+  renderVisualization(vis_manager,
+                      save_to_file_visualizer,
+                      extrinsics,
+                      intrinsics,
+                      images,
+                      initial_feat_positions,
+                      visualization_stage,
+                      min_frame_optimized,
+                      max_frame_optimized,
+                      estimates,
+                      img_heights_and_widths,
+                      observed_features,
+                      all_observed_corner_locations_with_uncertainty,
+                      observed_corner_locations,
+                      bounding_boxes_for_pending_object,
+                      pending_objects,
+                      near_edge_threshold,
+                      pending_obj_min_obs_threshold,
+                      gt_trajectory);
+}
+
 int main(int argc, char **argv) {
   google::InitGoogleLogging(argv[0]);
   google::ParseCommandLineFlags(&argc, &argv, true);
@@ -662,9 +1199,12 @@ int main(int argc, char **argv) {
       FLAGS_alsologtostderr = true;
     }
     FLAGS_log_dir = FLAGS_logs_directory;
+    std::string logs_directory =
+        file_io::ensureDirectoryPathEndsWithSlash(FLAGS_logs_directory);
     opt_logger = vtr::OptimizationLogger(
-        file_io::ensureDirectoryPathEndsWithSlash(FLAGS_logs_directory) +
-        kCeresOptInfoLogFile);
+        logs_directory + kCeresOptInfoLogFile,
+        FLAGS_log_frame_telemetry ? logs_directory + kFrameTelemetryLogFile
+                                  : "");
   }
   FLAGS_colorlogtostderr = true;
 
@@ -717,6 +1257,9 @@ int main(int argc, char **argv) {
           .get());
 #endif
 
+  vtr::DecodedImageCache::getInstance().setCapacity(
+      FLAGS_decoded_image_cache_size);
+
   vtr::FullOVSLAMConfig config;
   vtr::readConfiguration(FLAGS_params_config_file, config);
 
@@ -810,6 +1353,46 @@ int main(int argc, char **argv) {
     }
   }
 
+  vtr::FrameId max_input_frame_id = max_frame_id;
+  std::optional<vtr::KeyframeMapping> keyframe_mapping;
+  if (FLAGS_select_keyframes) {
+    vtr::KeyframeSelectionParams keyframe_selection_params;
+    keyframe_selection_params.max_pose_inc_threshold_transl_ =
+        config.sparsifier_params_.max_pose_inc_threshold_transl_;
+    keyframe_selection_params.max_pose_inc_threshold_rot_ =
+        config.sparsifier_params_.max_pose_inc_threshold_rot_;
+    keyframe_selection_params.max_median_feature_parallax_ =
+        FLAGS_keyframe_max_median_feature_parallax;
+    keyframe_selection_params.min_tracked_feature_fraction_ =
+        FLAGS_keyframe_min_tracked_feature_fraction;
+    keyframe_selection_params.keyframe_on_new_detections_ =
+        FLAGS_keyframe_on_new_detections;
+    keyframe_mapping = vtr::selectKeyframes(keyframe_selection_params,
+                                            robot_poses,
+                                            visual_features,
+                                            bounding_boxes);
+
+    // Everything from here on uses the keyframe ids
+    robot_poses = vtr::remapToKeyframes(robot_poses, *keyframe_mapping);
+    bounding_boxes = vtr::remapToKeyframes(bounding_boxes, *keyframe_mapping);
+    images = vtr::remapToKeyframes(images, *keyframe_mapping);
+    visual_features =
+        vtr::remapFeatureTracksToKeyframes(visual_features, *keyframe_mapping);
+    max_frame_id = vtr::getMaxFrame(robot_poses);
+    if (config.limit_traj_eval_params_.should_limit_trajectory_evaluation_) {
+      // Last keyframe at or before the limit
+      const std::vector<vtr::FrameId> &input_frames =
+          keyframe_mapping->input_frame_for_keyframe_;
+      size_t num_keyframes_in_limit =
+          std::upper_bound(input_frames.begin(),
+                           input_frames.end(),
+                           config.limit_traj_eval_params_.max_frame_id_) -
+          input_frames.begin();
+      config.limit_traj_eval_params_.max_frame_id_ =
+          (num_keyframes_in_limit == 0) ? 0 : (num_keyframes_in_limit - 1);
+    }
+  }
+
   vtr::SaveToFileVisualizerConfig save_to_file_visualizer_config;
   save_to_file_visualizer_config.bb_assoc_visualizer_config_
       .bounding_box_inflation_size_ =
@@ -831,6 +1414,20 @@ int main(int argc, char **argv) {
                                                            util::EmptyStruct>
       ltm_factor_creator(long_term_map);
 
+  std::shared_ptr<vtr::TiledLongTermMapObjects> ltm_tiles;
+  if ((FLAGS_ltm_tile_size > 0) && (long_term_map != nullptr)) {
+    vtr::LongTermMapTilingParams ltm_tiling_params;
+    ltm_tiling_params.tile_size_ = FLAGS_ltm_tile_size;
+    ltm_tiling_params.load_radius_ = FLAGS_ltm_tile_load_radius;
+    ltm_tiling_params.unload_radius_ = FLAGS_ltm_tile_unload_radius;
+    vtr::EllipsoidResults ltm_ellipsoids;
+    long_term_map->getEllipsoidResults(ltm_ellipsoids);
+    ltm_tiles = std::make_shared<vtr::TiledLongTermMapObjects>(
+        ltm_ellipsoids, ltm_tiling_params);
+    LOG(INFO) << "Split long-term map into " << ltm_tiles->getNumTiles()
+              << " tiles";
+  }
+
   vtr::FrameId effective_max_frame_id = max_frame_id;
   if (config.limit_traj_eval_params_.should_limit_trajectory_evaluation_) {
     effective_max_frame_id =
@@ -852,9 +1449,57 @@ int main(int argc, char **argv) {
       std::bind(createPoseGraph,
                 std::placeholders::_1,
                 long_term_map_factor_provider,
+                FLAGS_ltm_tile_size <= 0,
                 std::placeholders::_2);
 
-  vtr::YoloBoundingBoxQuerier bb_querier(node_handle);
+  std::optional<vtr::OfflineRunnerCheckpointState> resume_checkpoint;
+  vtr::FrameId start_opt_at_frame = 0;
+  if (!FLAGS_resume_from_checkpoint_file.empty()) {
+    vtr::OfflineRunnerCheckpointState runner_checkpoint;
+    if (!vtr::readRunnerCheckpointFromFile(FLAGS_resume_from_checkpoint_file,
+                                           runner_checkpoint)) {
+      LOG(ERROR) << "Could not read checkpoint to resume from";
+      exit(1);
+    }
+    LOG(INFO) << "Resuming after frame "
+              << runner_checkpoint.last_frame_processed_;
+    start_opt_at_frame = runner_checkpoint.last_frame_processed_ + 1;
+    resume_checkpoint = runner_checkpoint;
+    pose_graph_creator = [&](const MainProbData &,
+                             MainPgPtr &created_pose_graph) {
+      created_pose_graph =
+          MainPg::createObjectAndReprojectionFeaturePoseGraphFromState(
+              resume_checkpoint->pose_graph_state_,
+              long_term_map_factor_provider);
+    };
+  }
+
+  std::shared_ptr<vtr::BoundingBoxDetectionCache> bb_detection_cache;
+  std::shared_ptr<vtr::YoloBoundingBoxQuerier> yolo_querier;
+  if (FLAGS_bb_detection_cache_dir.empty()) {
+    yolo_querier = std::make_shared<vtr::YoloBoundingBoxQuerier>(node_handle);
+  } else {
+    if (FLAGS_bb_detector_model.empty()) {
+      LOG(ERROR) << "The bounding box detector model must be given when "
+                    "caching detections";
+      exit(1);
+    }
+    yolo_querier = std::make_shared<vtr::YoloBoundingBoxQuerier>(
+        node_handle, "/yolov5_detect_objs", false);
+    bb_detection_cache = std::make_shared<vtr::BoundingBoxDetectionCache>(
+        FLAGS_bb_detection_cache_dir,
+        yolo_querier->getServiceName(),
+        FLAGS_bb_detector_model);
+  }
+  vtr::PipelinedBoundingBoxQuerier bb_querier(
+      [&](const sensor_msgs::Image::ConstPtr &image,
+          std::vector<vtr::RawBoundingBox> &bounding_boxes_for_image) {
+        return yolo_querier->retrieveBoundingBoxesForImage(
+            image, bounding_boxes_for_image);
+      },
+      bounding_boxes.empty() ? std::max(FLAGS_bb_detection_prefetch_frames, 0)
+                             : 0,
+      bb_detection_cache);
   std::function<bool(
       const vtr::FrameId &,
       const MainProbData &input_prob_data,
@@ -882,16 +1527,73 @@ int main(int argc, char **argv) {
                   .getOrCreateFunctionTimer(vtr::kTimerNameFromYoloBbQuerier)
                   .get());
 #endif
-          return bb_querier.retrieveBoundingBoxes(
+          bool retrieved = bb_querier.retrieveBoundingBoxes(
               frame_id_to_query_for, input_prob_data, bounding_boxes_by_cam);
+          if (!retrieved && yolo_querier->isServiceUnavailable()) {
+            LOG(ERROR) << "Bounding box detection service unavailable. "
+                          "Exiting.";
+            exit(1);
+          }
+          return retrieved;
         }
       };
 
+  vtr::SessionEndMergeParams session_end_merge_params;
+  session_end_merge_params.localize_reoptimization_ =
+      FLAGS_localize_session_end_merge_reoptimization;
+  session_end_merge_params.reoptimization_frame_neighborhood_ =
+      std::max(FLAGS_session_end_merge_reoptimization_neighborhood, 0);
+  session_end_merge_params.full_reoptimization_change_threshold_ =
+      FLAGS_session_end_merge_full_reoptimization_threshold;
+
+  // The ground truth is looked up by input frame id
   std::optional<std::vector<vtr::Pose3D<double>>> gt_trajectory =
-      vtr::getGtTrajectory(max_frame_id,
+      vtr::getGtTrajectory(max_input_frame_id,
                            FLAGS_ground_truth_trajectory_file,
                            FLAGS_ground_truth_extrinsics_file,
                            FLAGS_nodes_by_timestamp_file);
+  if (keyframe_mapping.has_value() && gt_trajectory.has_value()) {
+    std::vector<vtr::Pose3D<double>> keyframe_gt_trajectory;
+    for (const vtr::FrameId &input_frame :
+         keyframe_mapping->input_frame_for_keyframe_) {
+      keyframe_gt_trajectory.emplace_back(gt_trajectory->at(input_frame));
+    }
+    gt_trajectory = keyframe_gt_trajectory;
+  }
+
+  std::shared_ptr<vtr::PoseGraphCheckpointWriter> checkpoint_writer;
+  std::shared_ptr<RunnerCheckpointWriter> runner_checkpoint_writer;
+  if (FLAGS_async_checkpoint_writing && !FLAGS_output_checkpoints_dir.empty()) {
+    checkpoint_writer = std::make_shared<vtr::PoseGraphCheckpointWriter>();
+    runner_checkpoint_writer = std::make_shared<RunnerCheckpointWriter>(
+        vtr::outputRunnerCheckpointToFile);
+  }
+
+  std::shared_ptr<util::AsyncWorkQueue<VisualizationSnapshot>> async_vis_queue;
+  if (FLAGS_async_visualization) {
+    util::QueueFullPolicy vis_queue_full_policy =
+        FLAGS_async_visualization_drop_frames ? util::DROP_OLDEST
+                                              : util::BLOCK_PRODUCER;
+    async_vis_queue =
+        std::make_shared<util::AsyncWorkQueue<VisualizationSnapshot>>(
+            FLAGS_async_visualization_queue_size,
+            vis_queue_full_policy,
+            [&](VisualizationSnapshot &snapshot) {
+              renderVisualizationSnapshot(
+                  vis_manager,
+                  save_to_file_visualizer,
+                  camera_extrinsics_by_camera,
+                  camera_intrinsics_by_camera,
+                  images,
+                  initial_feat_positions,
+                  snapshot,
+                  config.bounding_box_covariance_generator_params_
+                      .near_edge_threshold_,
+                  config.bounding_box_front_end_params_
+                      .feature_based_bb_association_params_.min_observations_,
+                  gt_trajectory);
+            });
+  }
 
   std::function<void(
       const std::unordered_map<vtr::CameraId, std::pair<double, double>> &,
@@ -994,6 +1696,9 @@ int main(int argc, char **argv) {
                 gt_trajectory,
                 effective_max_frame_id,
                 FLAGS_output_checkpoints_dir,
+                FLAGS_checkpoint_every_n_frames,
+                checkpoint_writer,
+                async_vis_queue,
                 attempt_num);
           };
   if ((!config.optimization_factors_enabled_params_
@@ -1030,9 +1735,46 @@ int main(int argc, char **argv) {
                            bb_retriever,
                            visualization_callback,
                            ltm_factor_creator,
-                           output_results)) {
+                           output_results,
+                           start_opt_at_frame,
+                           true,
+                           resume_checkpoint,
+                           std::max(FLAGS_runner_checkpoint_every_n_frames, 0),
+                           runner_checkpoint_writer,
+                           session_end_merge_params,
+                           std::max(FLAGS_feature_prefetch_frames, 0),
+                           FLAGS_concurrent_front_ends,
+                           ltm_tiles)) {
     LOG(ERROR) << "Optimization failed";
   }
+  if (keyframe_mapping.has_value()) {
+    output_results.robot_pose_results_.robot_poses_ = vtr::remapToInputFrames(
+        output_results.robot_pose_results_.robot_poses_, *keyframe_mapping);
+    if (output_results.associated_observed_corner_locations_ != nullptr) {
+      output_results.associated_observed_corner_locations_ =
+          std::make_shared<std::unordered_map<
+              vtr::FrameId,
+              std::unordered_map<
+                  vtr::CameraId,
+                  std::unordered_map<vtr::ObjectId,
+                                     std::pair<vtr::BbCornerPair<double>,
+                                               std::optional<double>>>>>>(
+              vtr::remapToInputFrames(
+                  *(output_results.associated_observed_corner_locations_),
+                  *keyframe_mapping));
+    }
+  }
+  if (checkpoint_writer != nullptr) {
+    checkpoint_writer->flush();
+  }
+  if (runner_checkpoint_writer != nullptr) {
+    runner_checkpoint_writer->flush();
+  }
+  if (async_vis_queue != nullptr) {
+    async_vis_queue->waitUntilEmpty();
+    LOG(INFO) << "Dropped " << async_vis_queue->getNumDroppedItems()
+              << " visualization snapshots because the queue was full";
+  }
 
   if (!FLAGS_visual_feature_results_file.empty()) {
     cv::FileStorage visual_feature_fs(FLAGS_visual_feature_results_file,
@@ -1057,6 +1799,24 @@ int main(int argc, char **argv) {
     }
   }
 
+  vtr::updateUnobservedSessionCounts(
+      long_term_map, output_results.observed_objects_, output_long_term_map);
+
+  vtr::LongTermMapCompactionParams ltm_compaction_params;
+  ltm_compaction_params.max_merge_distance_ =
+      FLAGS_ltm_compaction_merge_distance;
+  ltm_compaction_params.max_unobserved_sessions_ =
+      FLAGS_ltm_max_unobserved_sessions;
+  vtr::LongTermMapCompactionStats ltm_compaction_stats =
+      vtr::LongTermMapCompactor(ltm_compaction_params)
+          .compact(output_long_term_map);
+  LOG(INFO) << "Long-term map compaction merged "
+            << ltm_compaction_stats.num_merged_ << " and removed "
+            << ltm_compaction_stats.num_removed_unobserved_
+            << " unobserved objects; "
+            << ltm_compaction_stats.num_objects_before_ << " objects before, "
+            << ltm_compaction_stats.num_objects_after_ << " after";
+
   cv::FileStorage ltm_out_fs(FLAGS_long_term_map_output,
                              cv::FileStorage::WRITE);
   ltm_out_fs << "long_term_map"
@@ -1072,17 +1832,13 @@ int main(int argc, char **argv) {
   // Output ellipsoids
 
   if (!FLAGS_bb_associations_out_file.empty()) {
-    cv::FileStorage bb_associations_out(FLAGS_bb_associations_out_file,
-                                        cv::FileStorage::WRITE);
     vtr::ObjectDataAssociationResults data_assoc_results;
     data_assoc_results.ellipsoid_pose_results_ =
         output_results.ellipsoid_results_;
     data_assoc_results.associated_bounding_boxes_ =
         *(output_results.associated_observed_corner_locations_);
-    bb_associations_out << "bounding_box_associations"
-                        << vtr::SerializableObjectDataAssociationResults(
-                               data_assoc_results);
-    bb_associations_out.release();
+    vtr::writeObjectDataAssociationResultsToFile(
+        data_assoc_results, FLAGS_bb_associations_out_file);
   }
 
   if (!FLAGS_ellipsoids_results_file.empty()) {
@@ -5,6 +5,7 @@
 #include <ceres/ceres.h>
 #include <ceres/problem.h>
 #include <file_io/cv_file_storage/generic_factor_info_file_storage_io.h>
+#include <file_io/debug_dump_io.h>
 #include <file_io/file_access_utils.h>
 #include <file_io/file_io_utils.h>
 #include <refactoring/factors/generic_factor_info.h>
@@ -12,10 +13,6 @@
 
 namespace vslam_types_refactor {
 const std::string kSparseJacobianOutBaseFileName = "sparse_jacobian";
-const std::string kSparseJacobianMatlabOutBaseFileName =
-    "sparse_jacobian_matlab";
-const std::string kSparseJacobianOrderedMatlabOutBaseFileName =
-    "ordered_sparse_jacobian_matlab";
 const std::string kResidualInfoForJacobianFile = "jacobian_residual_info";
 const std::string kResidualInfoOrderedForJacobianFile =
     "ordered_jacobian_residual_info";
@@ -25,46 +22,11 @@ const std::string kSparseJacobianOrderedOutBaseFileName =
 const std::string kJacobianFileAttemptSuffix = "_attempt_";
 
 std::pair<std::pair<std::vector<int>, std::vector<int>>, std::vector<int>>
-writeJacobianToFile(const ceres::CRSMatrix &crs_matrix,
-                    const std::string &jacobian_file) {
-  std::ofstream csv_file(jacobian_file, std::ios::trunc);
-
-  // Write num_rows, num_cols
-  file_io::writeCommaSeparatedStringsLineToFile(
-      {std::to_string(crs_matrix.num_rows),
-       std::to_string(crs_matrix.num_cols)},
-      csv_file);
-
-  // Write contents of rows (see
-  // https://github.com/ceres-solver/ceres-solver/blob/e269b64f55f30f5e9802632b79479aa24d9d07de/include/ceres/crs_matrix.h#L49
-  // for how to interpret CRS matrix contents)
-  std::vector<std::string> rows_strings;
-  for (const int &row : crs_matrix.rows) {
-    rows_strings.emplace_back(std::to_string(row));
-  }
-  file_io::writeCommaSeparatedStringsLineToFile(rows_strings, csv_file);
-
-  // Write contents of cols vector
-  std::vector<std::string> cols_strings;
+findZeroAndTinyJacobianColumns(const ceres::CRSMatrix &crs_matrix) {
   std::unordered_map<int, std::unordered_set<size_t>> indices_for_cols;
   for (size_t col_idx = 0; col_idx < crs_matrix.cols.size(); col_idx++) {
-    int col = crs_matrix.cols[col_idx];
-    if (indices_for_cols.find(col) == indices_for_cols.end()) {
-      indices_for_cols[col] = {};
-    }
-    indices_for_cols[col].insert(col_idx);
-    cols_strings.emplace_back(std::to_string(col));
+    indices_for_cols[crs_matrix.cols[col_idx]].insert(col_idx);
   }
-  file_io::writeCommaSeparatedStringsLineToFile(cols_strings, csv_file);
-
-  // Write contents of values vector
-  std::vector<std::string> values_strings;
-  for (const double &value : crs_matrix.values) {
-    std::stringstream str_stream;
-    str_stream << value;
-    values_strings.emplace_back(str_stream.str());
-  }
-  file_io::writeCommaSeparatedStringsLineToFile(values_strings, csv_file);
 
   std::unordered_set<int> cols_with_some_tiny_values;
   std::vector<int> cols_with_tiny_values;
@@ -134,60 +96,6 @@ writeJacobianToFile(const ceres::CRSMatrix &crs_matrix,
       cols_with_tiny_values);
 }
 
-void writeJacobianMatlabFormatToFile(const ceres::CRSMatrix &crs_matrix,
-                                     const std::string &jacobian_file) {
-  std::vector<int> row_indices;
-  std::vector<int> col_indices;
-  std::vector<double> matlab_vals;
-
-  for (int row_num = 0; row_num < crs_matrix.num_rows; row_num++) {
-    size_t matlab_row_num = row_num + 1;
-    int row_val = crs_matrix.rows[row_num];
-    int next_row_val = crs_matrix.rows[row_num + 1];
-    for (size_t val_idx = row_val; val_idx < next_row_val; val_idx++) {
-      int col_num = crs_matrix.cols[val_idx];
-      int matlab_col_num = col_num + 1;
-      double value = crs_matrix.values[val_idx];
-      row_indices.emplace_back(matlab_row_num);
-      col_indices.emplace_back(matlab_col_num);
-      matlab_vals.emplace_back(value);
-    }
-  }
-
-  std::ofstream csv_file(jacobian_file, std::ios::trunc);
-
-  // Write num_rows, num_cols
-  file_io::writeCommaSeparatedStringsLineToFile(
-      {std::to_string(crs_matrix.num_rows),
-       std::to_string(crs_matrix.num_cols)},
-      csv_file);
-
-  // Write rows of non-zero entries
-  // Data format:
-  // https://www.mathworks.com/help/matlab/ref/sparse.html#d124e1404622
-  std::vector<std::string> rows_strings;
-  for (const int &row : row_indices) {
-    rows_strings.emplace_back(std::to_string(row));
-  }
-  file_io::writeCommaSeparatedStringsLineToFile(rows_strings, csv_file);
-
-  // Write contents of cols vector
-  std::vector<std::string> cols_strings;
-  for (const int &col : col_indices) {
-    cols_strings.emplace_back(std::to_string(col));
-  }
-  file_io::writeCommaSeparatedStringsLineToFile(cols_strings, csv_file);
-
-  // Write contents of values vector
-  std::vector<std::string> values_strings;
-  for (const double &value : matlab_vals) {
-    std::stringstream str_stream;
-    str_stream << value;
-    values_strings.emplace_back(str_stream.str());
-  }
-  file_io::writeCommaSeparatedStringsLineToFile(values_strings, csv_file);
-}
-
 void generateGenericFactorInfoForFactor(
     const std::shared_ptr<ObjectAndReprojectionFeaturePoseGraph> &pose_graph,
     const FactorType &factor_type,
@@ -1057,17 +965,19 @@ void outputJacobianInfo(
   problem_for_ltm.Evaluate(
       options, nullptr, nullptr, nullptr, &sparse_jacobian_ordered);
 
+  // Jacobians can have millions of non-zero entries, so they're written in
+  // the binary stream format rather than as text
   std::string sparse_jacobian_out_file_base_name;
   if (attempt_num != 0) {
     sparse_jacobian_out_file_base_name =
         kSparseJacobianOutBaseFileName + kJacobianFileAttemptSuffix +
-        std::to_string(attempt_num) + file_io::kCsvExtension;
+        std::to_string(attempt_num) + file_io::kBinaryExtension;
   } else {
     sparse_jacobian_out_file_base_name =
-        kSparseJacobianOutBaseFileName + file_io::kCsvExtension;
+        kSparseJacobianOutBaseFileName + file_io::kBinaryExtension;
   }
 
-  writeJacobianToFile(
+  writeCrsMatrixToBinaryFile(
       sparse_jacobian_unordered,
       file_io::ensureDirectoryPathEndsWithSlash(jacobian_output_dir) +
           sparse_jacobian_out_file_base_name);
@@ -1076,45 +986,17 @@ void outputJacobianInfo(
   if (attempt_num != 0) {
     sparse_jacobian_ordered_out_file_base_name =
         kSparseJacobianOrderedOutBaseFileName + kJacobianFileAttemptSuffix +
-        std::to_string(attempt_num) + file_io::kCsvExtension;
+        std::to_string(attempt_num) + file_io::kBinaryExtension;
   } else {
     sparse_jacobian_ordered_out_file_base_name =
-        kSparseJacobianOrderedOutBaseFileName + file_io::kCsvExtension;
-  }
-  std::pair<std::pair<std::vector<int>, std::vector<int>>, std::vector<int>>
-      problem_cols = writeJacobianToFile(
-          sparse_jacobian_ordered,
-          file_io::ensureDirectoryPathEndsWithSlash(jacobian_output_dir) +
-              sparse_jacobian_ordered_out_file_base_name);
-
-  std::string sparse_jacobian_matlab_out_file_base_name;
-  if (attempt_num != 0) {
-    sparse_jacobian_matlab_out_file_base_name =
-        kSparseJacobianMatlabOutBaseFileName + kJacobianFileAttemptSuffix +
-        std::to_string(attempt_num) + file_io::kCsvExtension;
-  } else {
-    sparse_jacobian_matlab_out_file_base_name =
-        kSparseJacobianMatlabOutBaseFileName + file_io::kCsvExtension;
+        kSparseJacobianOrderedOutBaseFileName + file_io::kBinaryExtension;
   }
-  writeJacobianMatlabFormatToFile(
-      sparse_jacobian_unordered,
-      file_io::ensureDirectoryPathEndsWithSlash(jacobian_output_dir) +
-          sparse_jacobian_matlab_out_file_base_name);
-
-  std::string sparse_jacobian_ordered_matlab_out_file_base_name;
-  if (attempt_num != 0) {
-    sparse_jacobian_ordered_matlab_out_file_base_name =
-        kSparseJacobianOrderedMatlabOutBaseFileName +
-        kJacobianFileAttemptSuffix + std::to_string(attempt_num) +
-        file_io::kCsvExtension;
-  } else {
-    sparse_jacobian_ordered_matlab_out_file_base_name =
-        kSparseJacobianOrderedMatlabOutBaseFileName + file_io::kCsvExtension;
-  }
-  writeJacobianMatlabFormatToFile(
+  writeCrsMatrixToBinaryFile(
       sparse_jacobian_ordered,
       file_io::ensureDirectoryPathEndsWithSlash(jacobian_output_dir) +
-          sparse_jacobian_ordered_matlab_out_file_base_name);
+          sparse_jacobian_ordered_out_file_base_name);
+  std::pair<std::pair<std::vector<int>, std::vector<int>>, std::vector<int>>
+      problem_cols = findZeroAndTinyJacobianColumns(sparse_jacobian_ordered);
 
   //  if (!all_zero_columns.empty()) {
   // Get jacobian for param blocks corresponding to zero entries one at a time
@@ -1132,50 +1014,36 @@ void outputJacobianInfo(
     jacobian_residual_file_name =
         file_io::ensureDirectoryPathEndsWithSlash(jacobian_output_dir) +
         kResidualInfoForJacobianFile + kJacobianFileAttemptSuffix +
-        std::to_string(attempt_num) + file_io::kJsonExtension;
+        std::to_string(attempt_num) + file_io::kBinaryExtension;
   } else {
     jacobian_residual_file_name =
         file_io::ensureDirectoryPathEndsWithSlash(jacobian_output_dir) +
-        kResidualInfoForJacobianFile + file_io::kJsonExtension;
+        kResidualInfoForJacobianFile + file_io::kBinaryExtension;
   }
 
-  LOG(INFO) << "Outputting jacobian residuals to file " << jacobian_residual_file_name;
-  cv::FileStorage jacobian_residual_info_out(jacobian_residual_file_name,
-                                             cv::FileStorage::WRITE);
-  jacobian_residual_info_out
-      << "jacobian_param_block_info"
-      << SerializableVector<ParameterBlockInfo, SerializableParameterBlockInfo>(
-             unordered_parameter_block_infos);
-  jacobian_residual_info_out
-      << "jacobian_residual_info"
-      << SerializableVector<GenericFactorInfo, SerializableGenericFactorInfo>(
-             generic_factor_infos);
-  jacobian_residual_info_out.release();
-
-  LOG(INFO) << "Done outputting jacobian residuals to file " << jacobian_residual_file_name;
+  LOG(INFO) << "Outputting jacobian residuals to file "
+            << jacobian_residual_file_name;
+  writeJacobianResidualInfoToFile(unordered_parameter_block_infos,
+                                  generic_factor_infos,
+                                  jacobian_residual_file_name);
+  LOG(INFO) << "Done outputting jacobian residuals to file "
+            << jacobian_residual_file_name;
 
   std::string ordered_jacobian_residual_file_name;
   if (attempt_num != 0) {
     ordered_jacobian_residual_file_name =
         file_io::ensureDirectoryPathEndsWithSlash(jacobian_output_dir) +
         kResidualInfoOrderedForJacobianFile + kJacobianFileAttemptSuffix +
-        std::to_string(attempt_num) + file_io::kJsonExtension;
+        std::to_string(attempt_num) + file_io::kBinaryExtension;
   } else {
     ordered_jacobian_residual_file_name =
         file_io::ensureDirectoryPathEndsWithSlash(jacobian_output_dir) +
-        kResidualInfoOrderedForJacobianFile + file_io::kJsonExtension;
+        kResidualInfoOrderedForJacobianFile + file_io::kBinaryExtension;
   }
-  cv::FileStorage ordered_jacobian_residual_info_out(
-      ordered_jacobian_residual_file_name, cv::FileStorage::WRITE);
-  ordered_jacobian_residual_info_out
-      << "jacobian_param_block_info"
-      << SerializableVector<ParameterBlockInfo, SerializableParameterBlockInfo>(
-             ordered_parameter_block_infos);
-  ordered_jacobian_residual_info_out
-      << "jacobian_residual_info"
-      << SerializableVector<GenericFactorInfo, SerializableGenericFactorInfo>(
-             generic_factor_infos);
-  ordered_jacobian_residual_info_out.release();
-  LOG(INFO) << "Done outputting ordered jacobian to file " << ordered_jacobian_residual_file_name;
+  writeJacobianResidualInfoToFile(ordered_parameter_block_infos,
+                                  generic_factor_infos,
+                                  ordered_jacobian_residual_file_name);
+  LOG(INFO) << "Done outputting ordered jacobian to file "
+            << ordered_jacobian_residual_file_name;
 }
 }  // namespace vslam_types_refactor
@@ -19,8 +19,11 @@
 #include <refactoring/output_problem_data_extraction.h>
 #include <ros/ros.h>
 #include <run_optimization_utils/optimization_runner.h>
+#include <run_optimization_utils/solver_sweep.h>
 #include <sensor_msgs/Image.h>
 
+#include <chrono>
+
 namespace vtr = vslam_types_refactor;
 
 const std::string kCeresOptInfoLogFile = "ceres_opt_summary.csv";
@@ -63,6 +66,203 @@ DEFINE_string(input_checkpoint_file, "", "File to read state from");
 DEFINE_string(poses_by_node_id_file,
               "",
               "File with initial robot pose estimates");
+DEFINE_string(solver_sweep_results_file,
+              "",
+              "If specified, instead of running the full optimization, runs a "
+              "global bundle adjustment on the loaded state once for each "
+              "combination of the solver_sweep_* values and writes the wall "
+              "time, iterations and final cost for each to this CSV file");
+DEFINE_string(solver_sweep_linear_solvers,
+              "",
+              "Comma separated Ceres linear solver types to sweep over (ex. "
+              "SPARSE_SCHUR,DENSE_SCHUR,ITERATIVE_SCHUR)");
+DEFINE_string(solver_sweep_trust_region_strategies,
+              "",
+              "Comma separated Ceres trust region strategies to sweep over "
+              "(LEVENBERG_MARQUARDT,DOGLEG)");
+DEFINE_string(solver_sweep_num_threads,
+              "",
+              "Comma separated solver thread counts to sweep over");
+DEFINE_string(solver_sweep_initial_trust_region_radii,
+              "",
+              "Comma separated initial trust region radii to sweep over");
+DEFINE_string(solver_sweep_reprojection_huber_params,
+              "",
+              "Comma separated reprojection error Huber loss parameters to "
+              "sweep over");
+DEFINE_string(solver_sweep_object_huber_params,
+              "",
+              "Comma separated object observation Huber loss parameters to "
+              "sweep over");
+DEFINE_int32(solver_sweep_max_processes,
+             1,
+             "Maximum number of sweep settings to run at once (each in its "
+             "own process). Concurrent runs compete for cores, so keep this "
+             "times the solver threads below the number of cores for "
+             "meaningful wall times");
+
+/**
+ * Run a global bundle adjustment on the loaded pose graph for each
+ * combination of swept solver settings and write the results.
+ *
+ * @return True if the sweep values were valid.
+ */
+bool runSolverSweep(
+    const vtr::FullOVSLAMConfig &config,
+    const MainPgPtr &pose_graph,
+    vtr::IndependentEllipsoidsLongTermObjectMapFactorCreator<util::EmptyStruct,
+                                                             util::EmptyStruct>
+        &ltm_factor_creator) {
+  vtr::SolverSweepParams sweep_params;
+  if (!vtr::parseLinearSolverTypes(FLAGS_solver_sweep_linear_solvers,
+                                   sweep_params.linear_solver_types_) ||
+      !vtr::parseTrustRegionStrategyTypes(
+          FLAGS_solver_sweep_trust_region_strategies,
+          sweep_params.trust_region_strategy_types_) ||
+      !vtr::parseSweepValues(FLAGS_solver_sweep_num_threads,
+                             sweep_params.num_threads_) ||
+      !vtr::parseSweepValues(FLAGS_solver_sweep_initial_trust_region_radii,
+                             sweep_params.initial_trust_region_radii_) ||
+      !vtr::parseSweepValues(
+          FLAGS_solver_sweep_reprojection_huber_params,
+          sweep_params.reprojection_error_huber_loss_params_) ||
+      !vtr::parseSweepValues(
+          FLAGS_solver_sweep_object_huber_params,
+          sweep_params.object_observation_huber_loss_params_)) {
+    return false;
+  }
+
+  // Settings not being swept come from the final global bundle adjustment
+  std::vector<vtr::SolverSweepSetting> settings =
+      vtr::createSolverSweepSettings(
+          config.final_ba_iteration_params_.phase_one_opt_params_,
+          config.object_visual_pose_graph_residual_params_,
+          sweep_params);
+  std::pair<vtr::FrameId, vtr::FrameId> min_max_frame_id =
+      pose_graph->getMinMaxFrameId();
+  pose_graph_optimizer::OptimizationScopeParams optimization_scope =
+      vtr::createFullTrajectoryOptimizationScope(
+          config.optimization_factors_enabled_params_,
+          min_max_frame_id.first,
+          min_max_frame_id.second);
+
+  std::function<bool(
+      const MainFactorInfo &, const MainPgPtr &, util::EmptyStruct &)>
+      cached_info_creator = vtr::dummyCachedInfoCreator;
+  std::function<bool(
+      const MainFactorInfo &,
+      const MainPgPtr &,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams &,
+      const std::function<bool(
+          const MainFactorInfo &, const MainPgPtr &, util::EmptyStruct &)> &,
+      ceres::Problem *,
+      ceres::ResidualBlockId &,
+      util::EmptyStruct &)>
+      long_term_map_residual_creator_func =
+          [&](const MainFactorInfo &factor_info,
+              const MainPgPtr &pose_graph,
+              const pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+                  &residual_params,
+              const std::function<bool(const MainFactorInfo &,
+                                       const MainPgPtr &,
+                                       util::EmptyStruct &)> &cached_inf_create,
+              ceres::Problem *problem,
+              ceres::ResidualBlockId &res_id,
+              util::EmptyStruct &cached_inf) {
+            return ltm_factor_creator.createResidual(factor_info,
+                                                     pose_graph,
+                                                     residual_params,
+                                                     cached_inf_create,
+                                                     problem,
+                                                     res_id,
+                                                     cached_inf);
+          };
+  std::function<bool(
+      const MainFactorInfo &,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams &,
+      const MainPgPtr &,
+      const bool &,
+      ceres::Problem *,
+      ceres::ResidualBlockId &,
+      util::EmptyStruct &)>
+      residual_creator = vtr::generateResidualCreator(
+          long_term_map_residual_creator_func, cached_info_creator);
+  std::function<bool(
+      const MainFactorInfo &,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams &,
+      const MainPgPtr &,
+      ceres::Problem *,
+      ceres::ResidualBlockId &,
+      util::EmptyStruct &)>
+      non_debug_residual_creator =
+          [&](const MainFactorInfo &factor_id,
+              const pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+                  &solver_residual_params,
+              const MainPgPtr &pose_graph,
+              ceres::Problem *problem,
+              ceres::ResidualBlockId &residual_id,
+              util::EmptyStruct &cached_info) {
+            return residual_creator(factor_id,
+                                    solver_residual_params,
+                                    pose_graph,
+                                    false,
+                                    problem,
+                                    residual_id,
+                                    cached_info);
+          };
+
+  // Runs in a child process, so it can optimize the pose graph in place
+  std::function<vtr::SolverSweepResult(const vtr::SolverSweepSetting &)>
+      setting_runner = [&](const vtr::SolverSweepSetting &setting) {
+        vtr::ObjectPoseGraphOptimizer<vtr::ReprojectionErrorFactor,
+                                      util::EmptyStruct,
+                                      MainPg>
+            optimizer(vtr::checkFactorRefresh, non_debug_residual_creator);
+        std::optional<vtr::OptimizationLogger> sweep_logger =
+            vtr::OptimizationLogger("");
+        MainPgPtr setting_pose_graph = pose_graph;
+        ceres::Problem::Options problem_options =
+            vtr::createProblemOptionsForPooledLossFunctions();
+        problem_options.evaluation_callback =
+            setting_pose_graph->getRobotPoseTransformCache().get();
+        ceres::Problem problem(problem_options);
+
+        std::chrono::steady_clock::time_point start_time =
+            std::chrono::steady_clock::now();
+        optimizer.buildPoseGraphOptimization(optimization_scope,
+                                             setting.residual_params_,
+                                             setting_pose_graph,
+                                             &problem,
+                                             sweep_logger);
+        vtr::SolverSweepResult result;
+        result.success_ = optimizer.solveOptimization(&problem,
+                                                      setting.solver_params_,
+                                                      {},
+                                                      sweep_logger,
+                                                      nullptr,
+                                                      nullptr);
+        result.wall_time_ = std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - start_time)
+                                .count();
+        const vtr::CurrentOptimizationInfo &opt_info =
+            sweep_logger->getCurrentOptInfo();
+        result.ceres_time_ = opt_info.total_ceres_time_;
+        result.num_iterations_ = opt_info.num_ceres_iterations_;
+        result.initial_cost_ = opt_info.initial_cost_;
+        result.final_cost_ = opt_info.final_cost_;
+        return result;
+      };
+
+  LOG(INFO) << "Running " << settings.size() << " solver sweep settings";
+  std::vector<vtr::SolverSweepResult> results;
+  vtr::runSolverSweepInProcesses(settings,
+                                 std::max(FLAGS_solver_sweep_max_processes, 1),
+                                 setting_runner,
+                                 results);
+  vtr::writeSolverSweepResultsToFile(
+      FLAGS_solver_sweep_results_file, settings, results);
+  return true;
+}
 
 int main(int argc, char **argv) {
   google::InitGoogleLogging(argv[0]);
@@ -84,7 +284,8 @@ int main(int argc, char **argv) {
     node_prefix += "_";
   }
 
-  if (FLAGS_long_term_map_output.empty()) {
+  bool run_solver_sweep = !FLAGS_solver_sweep_results_file.empty();
+  if (FLAGS_long_term_map_output.empty() && !run_solver_sweep) {
     LOG(ERROR) << "No long-term map output file provided";
     exit(1);
   }
@@ -97,9 +298,6 @@ int main(int argc, char **argv) {
 
   LOG(INFO) << "Prefix: " << param_prefix;
 
-  ros::init(argc, argv, "a_" + node_prefix + "run_opt_from_state");
-  ros::NodeHandle node_handle;
-
   vtr::FullOVSLAMConfig config;
   LOG(INFO) << "Reading config " << FLAGS_params_config_file;
   vtr::readConfiguration(FLAGS_params_config_file, config);
@@ -176,6 +374,14 @@ int main(int argc, char **argv) {
       MainPg::createObjectAndReprojectionFeaturePoseGraphFromState(
           pose_graph_state, long_term_map_factor_provider);
 
+  if (run_solver_sweep) {
+    // Before starting ROS, since the sweep forks
+    return runSolverSweep(config, pose_graph, ltm_factor_creator) ? 0 : 1;
+  }
+
+  ros::init(argc, argv, "a_" + node_prefix + "run_opt_from_state");
+  ros::NodeHandle node_handle;
+
   vtr::FrameId last_frame_id = pose_graph->getMinMaxFrameId().second;
 
   std::function<void(const MainProbData &, MainPgPtr &)> pose_graph_creator =
@@ -6,6 +6,7 @@
 #include <file_io/camera_extrinsics_with_id_io.h>
 #include <file_io/cv_file_storage/output_problem_data_file_storage_io.h>
 #include <file_io/cv_file_storage/vslam_basic_types_file_storage_io.h>
+#include <file_io/debug_dump_io.h>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <refactoring/image_processing/debugging_image_utils.h>
@@ -21,7 +22,8 @@ namespace vtr = vslam_types_refactor;
 
 DEFINE_string(jacobian_residual_info_file,
               "",
-              "File containing jacobian parameter and residual info");
+              "File containing jacobian parameter and residual info (binary "
+              "if it has the .bin extension, JSON otherwise)");
 DEFINE_string(problem_feats_matlab_file,
               "",
               "File containing columns identified in matlab as very low value "
@@ -101,23 +103,14 @@ int main(int argc, char **argv) {
   std::vector<vtr::GenericFactorInfo> generic_factor_infos;
   std::vector<vtr::ParameterBlockInfo> parameter_block_infos;
 
-  vtr::SerializableVector<vtr::ParameterBlockInfo,
-                          vtr::SerializableParameterBlockInfo>
-      serializable_param_info;
-  vtr::SerializableVector<vtr::GenericFactorInfo,
-                          vtr::SerializableGenericFactorInfo>
-      serializable_factors;
-
   LOG(INFO) << "Reading jacobian param/residual info from "
             << FLAGS_jacobian_residual_info_file;
-  cv::FileStorage jacobian_info_fs(FLAGS_jacobian_residual_info_file,
-                                   cv::FileStorage::READ);
-  jacobian_info_fs["jacobian_param_block_info"] >> serializable_param_info;
-  jacobian_info_fs["jacobian_residual_info"] >> serializable_factors;
-  jacobian_info_fs.release();
-
-  generic_factor_infos = serializable_factors.getEntry();
-  parameter_block_infos = serializable_param_info.getEntry();
+  if (!vtr::readJacobianResidualInfoFromFile(FLAGS_jacobian_residual_info_file,
+                                             parameter_block_infos,
+                                             generic_factor_infos)) {
+    LOG(ERROR) << "Could not read jacobian param/residual info";
+    exit(1);
+  }
 
   std::vector<int> problem_columns;
 
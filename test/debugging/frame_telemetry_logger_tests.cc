@@ -0,0 +1,67 @@
+#include <debugging/frame_telemetry_logger.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace vslam_types_refactor;
+namespace fs = std::filesystem;
+
+namespace {
+std::vector<std::string> readLines(const std::string &file_name) {
+  std::vector<std::string> lines;
+  std::ifstream file(file_name);
+  std::string line;
+  while (std::getline(file, line)) {
+    lines.emplace_back(line);
+  }
+  return lines;
+}
+}  // namespace
+
+TEST(FrameTelemetryLogger, WritesOneRecordPerFrame) {
+  std::string file_name =
+      (fs::temp_directory_path() / "frame_telemetry_test.jsonl").string();
+  {
+    FrameTelemetryLogger telemetry(file_name);
+    // Not recorded, since no frame is in progress
+    telemetry.addStageTime(FrameTelemetryStage::SOLVE_OPTIMIZATION, 100);
+
+    telemetry.startFrame(3);
+    telemetry.addStageTime(FrameTelemetryStage::SOLVE_OPTIMIZATION, 0.5);
+    telemetry.addStageTime(FrameTelemetryStage::SOLVE_OPTIMIZATION, 0.25);
+    telemetry.addSolve(7);
+    telemetry.addSolve(2);
+    telemetry.setResidualCounts(
+        {{0, 40}, {2, 5}});
+    telemetry.finishFrame();
+
+    {
+      FrameTelemetryStageTimer timer(nullptr, FrameTelemetryStage::FRONT_END);
+    }
+    telemetry.startFrame(4);
+    {
+      FrameTelemetryStageTimer timer(&telemetry,
+                                     FrameTelemetryStage::FRONT_END);
+    }
+    telemetry.finishFrame();
+
+    // Buffered until flushed
+    EXPECT_TRUE(readLines(file_name).empty());
+  }
+
+  std::vector<std::string> lines = readLines(file_name);
+  ASSERT_EQ(2, lines.size());
+  EXPECT_EQ(0, lines[0].find("{\"frame_id\":3,"));
+  EXPECT_NE(std::string::npos, lines[0].find("\"solve\":0.75,"));
+  EXPECT_NE(std::string::npos, lines[0].find("\"num_solves\":2,"));
+  EXPECT_NE(std::string::npos, lines[0].find("\"num_ceres_iterations\":9,"));
+  EXPECT_NE(std::string::npos,
+            lines[0].find("\"num_residuals_by_factor_type\":"
+                          "{\"0\":40,\"2\":5}"));
+  EXPECT_EQ(std::string::npos, lines[0].find("\"rss_bytes\":0,"));
+  EXPECT_EQ(0, lines[1].find("{\"frame_id\":4,"));
+  EXPECT_NE(std::string::npos, lines[1].find("\"num_solves\":0,"));
+  EXPECT_EQ('}', lines[1].back());
+  fs::remove(file_name);
+}
@@ -0,0 +1,92 @@
+#include <evaluation/object_evaluation_utils.h>
+#include <evaluation/position_kd_tree.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace vslam_types_refactor;
+
+namespace {
+FullDOFEllipsoidState<double> createEllipsoid(const double &x,
+                                              const double &y) {
+  return FullDOFEllipsoidState<double>(
+      Pose3D<double>(Position3d<double>(x, y, 0.5),
+                     Orientation3D<double>(0, Eigen::Vector3d::UnitZ())),
+      ObjectDim<double>(1, 1, 1));
+}
+}  // namespace
+
+TEST(PositionKdTree, MatchesBruteForceQueries) {
+  std::vector<std::pair<ObjectId, Position3d<double>>> points;
+  for (ObjectId point_id = 0; point_id < 200; point_id++) {
+    // Deterministic, irregularly spaced points
+    points.emplace_back(std::make_pair(
+        point_id,
+        Position3d<double>((point_id * 37) % 101 * 0.1,
+                           (point_id * 53) % 89 * 0.1,
+                           (point_id * 11) % 7 * 0.1)));
+  }
+  PositionKdTree tree(points);
+  ASSERT_EQ(points.size(), tree.size());
+
+  std::vector<Position3d<double>> queries = {Position3d<double>(0.05, 0, 0),
+                                             Position3d<double>(5, 4, 0.3),
+                                             Position3d<double>(20, -3, 1)};
+  for (const Position3d<double> &query : queries) {
+    std::vector<ObjectId> brute_force_in_radius;
+    std::optional<std::pair<ObjectId, double>> brute_force_nearest;
+    for (const std::pair<ObjectId, Position3d<double>> &point : points) {
+      double dist = (point.second - query).norm();
+      if (dist <= 1.5) {
+        brute_force_in_radius.emplace_back(point.first);
+      }
+      if ((!brute_force_nearest.has_value()) ||
+          (dist < brute_force_nearest->second)) {
+        brute_force_nearest = std::make_pair(point.first, dist);
+      }
+    }
+
+    std::vector<std::pair<ObjectId, double>> ids_and_dists;
+    tree.radiusSearch(query, 1.5, ids_and_dists);
+    std::vector<ObjectId> in_radius;
+    for (const std::pair<ObjectId, double> &id_and_dist : ids_and_dists) {
+      in_radius.emplace_back(id_and_dist.first);
+    }
+    std::sort(in_radius.begin(), in_radius.end());
+    EXPECT_EQ(brute_force_in_radius, in_radius);
+
+    std::optional<std::pair<ObjectId, double>> nearest = tree.nearest(query);
+    ASSERT_TRUE(nearest.has_value());
+    EXPECT_EQ(brute_force_nearest->first, nearest->first);
+    EXPECT_DOUBLE_EQ(brute_force_nearest->second, nearest->second);
+    EXPECT_FALSE(
+        tree.nearest(query, brute_force_nearest->second * 0.5).has_value());
+  }
+}
+
+TEST(ObjectAssociation, OneToOneMinimizesTotalDistance) {
+  FullDOFEllipsoidResults gt_objects;
+  gt_objects[10] = std::make_pair("chair", createEllipsoid(0, 0));
+  gt_objects[11] = std::make_pair("chair", createEllipsoid(1, 0));
+  gt_objects[12] = std::make_pair("table", createEllipsoid(0.6, 0));
+
+  // Greedily taking the closest pair (1 -> 11) would leave object 2 too far
+  // from gt object 10
+  FullDOFEllipsoidResults est_objects;
+  est_objects[1] = std::make_pair("chair", createEllipsoid(0.6, 0));
+  est_objects[2] = std::make_pair("chair", createEllipsoid(1.5, 0));
+  est_objects[3] = std::make_pair("lamp", createEllipsoid(0, 0));
+
+  std::unordered_map<ObjectId, std::optional<ObjectId>> gt_objects_for_est;
+  associateObjects(est_objects, gt_objects, true, gt_objects_for_est, 1.0);
+  ASSERT_EQ(3u, gt_objects_for_est.size());
+  EXPECT_EQ(std::optional<ObjectId>(10), gt_objects_for_est.at(1));
+  EXPECT_EQ(std::optional<ObjectId>(11), gt_objects_for_est.at(2));
+  EXPECT_FALSE(gt_objects_for_est.at(3).has_value());
+
+  gt_objects_for_est.clear();
+  associateObjects(est_objects, gt_objects, false, gt_objects_for_est);
+  EXPECT_EQ(std::optional<ObjectId>(11), gt_objects_for_est.at(1));
+  EXPECT_EQ(std::optional<ObjectId>(11), gt_objects_for_est.at(2));
+  EXPECT_FALSE(gt_objects_for_est.at(3).has_value());
+}
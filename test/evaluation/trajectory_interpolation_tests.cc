@@ -0,0 +1,125 @@
+#include <evaluation/trajectory_interpolation_utils.h>
+#include <gtest/gtest.h>
+#include <refactoring/types/vslam_types_math_util.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+const size_t kNumOdomPoses = 21;
+
+/**
+ * Ground truth pose at (fractional) time t for a robot that drives 0.5 m/s
+ * while turning at 0.05 rad/s.
+ */
+pose::Pose2d getTruePose(const double &t) {
+  const double kSpeed = 0.5;
+  const double kTurnRate = 0.05;
+  double yaw = kTurnRate * t;
+  double radius = kSpeed / kTurnRate;
+  return std::make_pair(
+      Eigen::Vector2d(radius * sin(yaw), radius * (1 - cos(yaw))), yaw);
+}
+
+pose::Timestamp getTimestamp(const double &t) {
+  uint32_t sec = (uint32_t)t;
+  return std::make_pair(sec, (uint32_t)std::round((t - sec) * 1e9));
+}
+
+Pose3D<double> getTruePose3d(const double &t) {
+  pose::Pose2d pose_2d = getTruePose(t);
+  return Pose3D<double>(
+      Position3d<double>(pose_2d.first.x(), pose_2d.first.y(), 0),
+      Orientation3D<double>(pose_2d.second, Eigen::Vector3d::UnitZ()));
+}
+
+void interpolate(
+    const SegmentedInterpolationParams &params,
+    util::BoostHashMap<pose::Timestamp, Pose3D<double>> &interpolated_poses) {
+  std::vector<std::pair<pose::Timestamp, pose::Pose2d>> odom_poses;
+  for (size_t odom_idx = 0; odom_idx < kNumOdomPoses; odom_idx++) {
+    odom_poses.emplace_back(
+        std::make_pair(getTimestamp(odom_idx), getTruePose(odom_idx)));
+  }
+
+  // The middle coarse pose splits the problem into segments, and is offset
+  // from the odometry so the segments have to absorb a discrepancy
+  std::vector<std::pair<pose::Timestamp, Pose3D<double>>> coarse_fixed_poses;
+  coarse_fixed_poses.emplace_back(
+      std::make_pair(getTimestamp(0.5), getTruePose3d(0.5)));
+  Pose3D<double> offset_middle_pose = getTruePose3d(10.5);
+  offset_middle_pose.transl_ += Position3d<double>(0.03, 0.05, 0);
+  coarse_fixed_poses.emplace_back(
+      std::make_pair(getTimestamp(10.5), offset_middle_pose));
+  coarse_fixed_poses.emplace_back(
+      std::make_pair(getTimestamp(19.5), getTruePose3d(19.5)));
+
+  std::vector<pose::Timestamp> required_timestamps = {getTimestamp(3.25),
+                                                      getTimestamp(7.75),
+                                                      getTimestamp(12.5),
+                                                      getTimestamp(16.1)};
+
+  util::BoostHashMap<pose::Timestamp, Pose3D<double>> odom_poses_adjusted_3d;
+  interpolate3dPosesUsingOdom(
+      odom_poses,
+      coarse_fixed_poses,
+      required_timestamps,
+      [](const util::BoostHashMap<pose::Timestamp, Pose3D<double>> &,
+         const std::vector<RelativePoseFactorInfo> &) {},
+      interpolated_poses,
+      odom_poses_adjusted_3d,
+      params);
+}
+
+void expectPosesNear(
+    const util::BoostHashMap<pose::Timestamp, Pose3D<double>> &expected,
+    const util::BoostHashMap<pose::Timestamp, Pose3D<double>> &actual,
+    const double &transl_tolerance,
+    const double &rot_tolerance) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (const auto &expected_pose : expected) {
+    ASSERT_EQ(1u, actual.count(expected_pose.first));
+    Pose3D<double> diff = getPose2RelativeToPose1(
+        expected_pose.second, actual.at(expected_pose.first));
+    EXPECT_LE(diff.transl_.norm(), transl_tolerance)
+        << "Timestamp " << expected_pose.first.first << ", "
+        << expected_pose.first.second;
+    EXPECT_LE(abs(diff.orientation_.angle()), rot_tolerance)
+        << "Timestamp " << expected_pose.first.first << ", "
+        << expected_pose.first.second;
+  }
+}
+}  // namespace
+
+TEST(TrajectoryInterpolation, SegmentedMatchesSingleOptimization) {
+  SegmentedInterpolationParams monolithic_params;
+  util::BoostHashMap<pose::Timestamp, Pose3D<double>> monolithic_poses;
+  interpolate(monolithic_params, monolithic_poses);
+
+  // Odometry, coarse, and required poses
+  EXPECT_EQ(kNumOdomPoses + 3 + 4, monolithic_poses.size());
+  for (const double &fixed_time : {0.5, 19.5}) {
+    Pose3D<double> diff =
+        getPose2RelativeToPose1(getTruePose3d(fixed_time),
+                                monolithic_poses.at(getTimestamp(fixed_time)));
+    EXPECT_NEAR(0, diff.transl_.norm(), 1e-9);
+  }
+
+  // Segmenting drops the odometry factor that spans the middle coarse pose,
+  // so the results are only expected to match closely, not exactly
+  SegmentedInterpolationParams optimized_segment_params;
+  optimized_segment_params.solve_in_segments_ = true;
+  optimized_segment_params.num_threads_ = 2;
+  util::BoostHashMap<pose::Timestamp, Pose3D<double>> optimized_segment_poses;
+  interpolate(optimized_segment_params, optimized_segment_poses);
+  expectPosesNear(monolithic_poses, optimized_segment_poses, 0.005, 0.005);
+
+  // The closed form solution only spreads the discrepancy along the segment,
+  // while the optimization also absorbs part of it by rotating the poses
+  SegmentedInterpolationParams closed_form_params;
+  closed_form_params.solve_in_segments_ = true;
+  closed_form_params.num_threads_ = 2;
+  closed_form_params.use_closed_form_when_consistent_ = true;
+  util::BoostHashMap<pose::Timestamp, Pose3D<double>> closed_form_poses;
+  interpolate(closed_form_params, closed_form_poses);
+  expectPosesNear(monolithic_poses, closed_form_poses, 0.02, 0.025);
+}
@@ -0,0 +1,103 @@
+#include <file_io/bounding_box_by_timestamp_io.h>
+#include <file_io/csv_tokenizer.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+using namespace file_io;
+namespace fs = std::filesystem;
+
+namespace {
+struct IdAndValue {
+  uint64_t id_;
+  double value_;
+};
+
+void readIdAndValueLine(const std::vector<std::string_view> &entries,
+                        IdAndValue &id_and_value) {
+  parseCsvField(entries[0], id_and_value.id_);
+  parseCsvField(entries[1], id_and_value.value_);
+}
+}  // namespace
+
+TEST(CsvTokenizer, SplitLineMatchesGetlineSplitting) {
+  EXPECT_EQ(std::vector<std::string_view>({"a", " b", "", "c"}),
+            splitCsvLine("a, b,,c"));
+  EXPECT_EQ(std::vector<std::string_view>({"a", "b"}), splitCsvLine("a,b,"));
+  EXPECT_TRUE(splitCsvLine("").empty());
+  EXPECT_EQ(std::vector<std::string_view>({"1.5", "2"}),
+            splitCsvLine("1.5 2", ' '));
+}
+
+TEST(CsvTokenizer, ParseFields) {
+  EXPECT_DOUBLE_EQ(-1.25e-3, parseCsvField<double>(" -1.25e-3\r"));
+  EXPECT_DOUBLE_EQ(3.0, parseCsvField<double>("+3"));
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(),
+            parseCsvField<uint64_t>(" 18446744073709551615"));
+  EXPECT_EQ(-7, parseCsvField<int>("-7"));
+
+  double value;
+  EXPECT_FALSE(tryParseCsvField(" ", value));
+  EXPECT_FALSE(tryParseCsvField("abc", value));
+}
+
+TEST(CsvTokenizer, ChunkedParsingMatchesSerialParsing) {
+  std::string text;
+  for (int line_num = 0; line_num < 1000; line_num++) {
+    text += std::to_string(line_num) + ", " + std::to_string(line_num * 0.5) +
+            "\n";
+    if (line_num % 100 == 0) {
+      // Blank lines should be skipped
+      text += "\r\n";
+    }
+  }
+  // No newline at the end of the last line
+  text += "1000, 500.0";
+
+  CsvLineReader<IdAndValue> line_reader = readIdAndValueLine;
+  std::vector<IdAndValue> serial_objects;
+  parseCsvText(text, line_reader, 1, serial_objects);
+  ASSERT_EQ(1001, serial_objects.size());
+
+  for (size_t num_threads : {2, 3, 7, 64}) {
+    std::vector<IdAndValue> chunked_objects;
+    parseCsvText(text, line_reader, num_threads, chunked_objects);
+    ASSERT_EQ(serial_objects.size(), chunked_objects.size());
+    for (size_t obj_num = 0; obj_num < serial_objects.size(); obj_num++) {
+      EXPECT_EQ(obj_num, chunked_objects[obj_num].id_);
+      EXPECT_DOUBLE_EQ(obj_num * 0.5, chunked_objects[obj_num].value_);
+    }
+  }
+}
+
+TEST(CsvTokenizer, ReadWrittenBoundingBoxFile) {
+  std::vector<BoundingBoxWithTimestamp> bounding_boxes(2);
+  bounding_boxes[0] = {1.5, 2.5, 30.25, 40.75, "chair", 12, 345, 1, 0.9};
+  bounding_boxes[1] = {0, 0, 10, 20, "lamppost", 13, 0, 2, 0.5};
+
+  std::string file_name =
+      (fs::temp_directory_path() / "csv_tokenizer_bb_test.csv").string();
+  writeBoundingBoxWithTimestampsToFile(file_name, bounding_boxes);
+
+  std::vector<BoundingBoxWithTimestamp> read_bounding_boxes;
+  readBoundingBoxWithTimestampsFromFile(file_name, read_bounding_boxes);
+  ASSERT_EQ(bounding_boxes.size(), read_bounding_boxes.size());
+  for (size_t bb_num = 0; bb_num < bounding_boxes.size(); bb_num++) {
+    const BoundingBoxWithTimestamp &expected = bounding_boxes[bb_num];
+    const BoundingBoxWithTimestamp &read = read_bounding_boxes[bb_num];
+    EXPECT_DOUBLE_EQ(expected.min_pixel_x, read.min_pixel_x);
+    EXPECT_DOUBLE_EQ(expected.min_pixel_y, read.min_pixel_y);
+    EXPECT_DOUBLE_EQ(expected.max_pixel_x, read.max_pixel_x);
+    EXPECT_DOUBLE_EQ(expected.max_pixel_y, read.max_pixel_y);
+    EXPECT_EQ(expected.semantic_class, read.semantic_class);
+    EXPECT_EQ(expected.seconds, read.seconds);
+    EXPECT_EQ(expected.nano_seconds, read.nano_seconds);
+    EXPECT_EQ(expected.camera_id, read.camera_id);
+    EXPECT_DOUBLE_EQ(expected.detection_confidence,
+                     read.detection_confidence);
+  }
+  fs::remove(file_name);
+
+  MappedTextFile missing_file;
+  EXPECT_FALSE(missing_file.open(file_name));
+}
@@ -0,0 +1,107 @@
+#include <file_io/cv_file_storage/offline_runner_checkpoint_file_storage_io.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+using namespace vslam_types_refactor;
+namespace fs = std::filesystem;
+
+TEST(OfflineRunnerCheckpointState, ReadWriteOfflineRunnerCheckpointState) {
+  OfflineRunnerCheckpointState runner_checkpoint;
+  runner_checkpoint.last_frame_processed_ = 193;
+
+  VisualFeatureCachedInfo cached_info_1;
+  cached_info_1.is_cache_cleaned_ = false;
+  cached_info_1.frame_ids_and_reprojection_err_factors_ = {
+      {4,
+       {ReprojectionErrorFactor(4, 32, 1, PixelCoord<double>(1.2, 3.4), 4.2),
+        ReprojectionErrorFactor(
+            4, 32, 2, PixelCoord<double>(-38.4, 39.4), 1.3)}},
+      {9,
+       {ReprojectionErrorFactor(
+           9, 32, 1, PixelCoord<double>(94.2, 0.1), 4.2)}}};
+  cached_info_1.frame_ids_and_poses_ = {
+      {4,
+       Pose3D<double>(Position3d<double>(4.2, 0.4, -0.3),
+                      Orientation3D<double>(0.3,
+                                            Eigen::Vector3d(0.4, -19.3, 48.2)
+                                                .normalized()))},
+      {9, std::nullopt}};
+  VisualFeatureCachedInfo cached_info_2;
+  cached_info_2.is_cache_cleaned_ = true;
+
+  VisualFeatureFrontEndState &visual_front_end_state =
+      runner_checkpoint.visual_feature_front_end_state_;
+  visual_front_end_state.first_observed_frame_by_feature_ = {{32, 4},
+                                                             {48, 13}};
+  visual_front_end_state.added_feature_ids_ = {48, 94, 1038};
+  visual_front_end_state.pending_feature_factors_ = {{32, cached_info_1}};
+  visual_front_end_state.pending_feature_factors_for_initialized_features_ = {
+      {48, cached_info_2}};
+
+  FeatureBasedBoundingBoxFrontEndState bb_front_end_state;
+  bb_front_end_state.association_state_.object_appearance_info_[13]
+      .observed_feats_[4][1] = {32, 48};
+  bb_front_end_state.observed_corner_locations_[4][1][13] =
+      std::make_pair(std::make_pair(PixelCoord<double>(1.2, 3.4),
+                                    PixelCoord<double>(9.2, 8.3)),
+                     0.8);
+  bb_front_end_state.all_filtered_corner_locations_[4][1] = {
+      std::make_pair(std::make_pair(PixelCoord<double>(1.2, 3.4),
+                                    PixelCoord<double>(9.2, 8.3)),
+                     std::nullopt)};
+  bb_front_end_state.pending_objects_ = {std::make_pair("chair", std::nullopt)};
+  runner_checkpoint.bounding_box_front_end_state_ = bb_front_end_state;
+
+  std::FILE *tmp_file = std::tmpfile();
+  std::string tmp_file_name = fs::read_symlink(
+      fs::path("/proc/self/fd") / std::to_string(fileno(tmp_file)));
+  outputRunnerCheckpointToFile(runner_checkpoint, tmp_file_name);
+  OfflineRunnerCheckpointState read_checkpoint;
+  ASSERT_TRUE(readRunnerCheckpointFromFile(tmp_file_name, read_checkpoint));
+
+  ASSERT_EQ(runner_checkpoint.last_frame_processed_,
+            read_checkpoint.last_frame_processed_);
+
+  const VisualFeatureFrontEndState &read_visual_front_end_state =
+      read_checkpoint.visual_feature_front_end_state_;
+  ASSERT_EQ(visual_front_end_state.first_observed_frame_by_feature_,
+            read_visual_front_end_state.first_observed_frame_by_feature_);
+  ASSERT_EQ(visual_front_end_state.added_feature_ids_,
+            read_visual_front_end_state.added_feature_ids_);
+  ASSERT_EQ(1, read_visual_front_end_state.pending_feature_factors_.size());
+  const VisualFeatureCachedInfo &read_cached_info_1 =
+      read_visual_front_end_state.pending_feature_factors_.at(32);
+  ASSERT_EQ(cached_info_1.is_cache_cleaned_,
+            read_cached_info_1.is_cache_cleaned_);
+  ASSERT_EQ(cached_info_1.frame_ids_and_reprojection_err_factors_,
+            read_cached_info_1.frame_ids_and_reprojection_err_factors_);
+  ASSERT_EQ(cached_info_1.frame_ids_and_poses_,
+            read_cached_info_1.frame_ids_and_poses_);
+  ASSERT_TRUE(read_visual_front_end_state
+                  .pending_feature_factors_for_initialized_features_.at(48)
+                  .is_cache_cleaned_);
+
+  ASSERT_TRUE(read_checkpoint.bounding_box_front_end_state_.has_value());
+  const FeatureBasedBoundingBoxFrontEndState &read_bb_front_end_state =
+      read_checkpoint.bounding_box_front_end_state_.value();
+  ASSERT_EQ(bb_front_end_state.association_state_.object_appearance_info_
+                .at(13)
+                .observed_feats_,
+            read_bb_front_end_state.association_state_.object_appearance_info_
+                .at(13)
+                .observed_feats_);
+  ASSERT_EQ(bb_front_end_state.observed_corner_locations_,
+            read_bb_front_end_state.observed_corner_locations_);
+  ASSERT_EQ(bb_front_end_state.all_filtered_corner_locations_,
+            read_bb_front_end_state.all_filtered_corner_locations_);
+  ASSERT_EQ(1, read_bb_front_end_state.pending_objects_.size());
+  ASSERT_EQ("chair", read_bb_front_end_state.pending_objects_.front().first);
+  ASSERT_FALSE(
+      read_bb_front_end_state.pending_objects_.front().second.has_value());
+
+  runner_checkpoint.bounding_box_front_end_state_ = std::nullopt;
+  outputRunnerCheckpointToFile(runner_checkpoint, tmp_file_name);
+  ASSERT_TRUE(readRunnerCheckpointFromFile(tmp_file_name, read_checkpoint));
+  ASSERT_FALSE(read_checkpoint.bounding_box_front_end_state_.has_value());
+}
@@ -0,0 +1,100 @@
+#include <file_io/debug_dump_io.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+using namespace vslam_types_refactor;
+namespace fs = std::filesystem;
+
+TEST(DebugDumpIo, ReadWriteBinaryCrsMatrix) {
+  ceres::CRSMatrix crs_matrix;
+  crs_matrix.num_rows = 2;
+  crs_matrix.num_cols = 3;
+  crs_matrix.rows = {0, 2, 3};
+  crs_matrix.cols = {0, 2, 1};
+  crs_matrix.values = {1.5, -2.25, 1e-9};
+
+  std::string out_file =
+      (fs::temp_directory_path() / "debug_dump_io_crs_test.bin").string();
+  ASSERT_TRUE(writeCrsMatrixToBinaryFile(crs_matrix, out_file));
+
+  ceres::CRSMatrix read_matrix;
+  ASSERT_TRUE(readCrsMatrixFromBinaryFile(out_file, read_matrix));
+  ASSERT_EQ(crs_matrix.num_rows, read_matrix.num_rows);
+  ASSERT_EQ(crs_matrix.num_cols, read_matrix.num_cols);
+  ASSERT_EQ(crs_matrix.rows, read_matrix.rows);
+  ASSERT_EQ(crs_matrix.cols, read_matrix.cols);
+  ASSERT_EQ(crs_matrix.values, read_matrix.values);
+
+  // Content type is checked, so a matrix can't be read as residual info
+  std::vector<ParameterBlockInfo> param_infos;
+  std::vector<GenericFactorInfo> factor_infos;
+  ASSERT_FALSE(
+      readJacobianResidualInfoFromFile(out_file, param_infos, factor_infos));
+  fs::remove(out_file);
+}
+
+TEST(DebugDumpIo, ReadWriteBinaryJacobianResidualInfo) {
+  std::vector<ParameterBlockInfo> param_infos(2);
+  param_infos[0].frame_id_ = 4;
+  param_infos[1].obj_id_ = 13;
+
+  std::vector<GenericFactorInfo> factor_infos(2);
+  factor_infos[0].factor_type_ = 3;
+  factor_infos[0].frame_ids_ = std::unordered_set<FrameId>({4, 9});
+  factor_infos[0].feature_id_ = 48;
+  factor_infos[0].final_residual_val_ = 0.25;
+  factor_infos[1].factor_type_ = 1;
+  factor_infos[1].camera_id_ = 2;
+  factor_infos[1].obj_id_ = 13;
+
+  std::string out_file =
+      (fs::temp_directory_path() / "debug_dump_io_residual_test.bin")
+          .string();
+  writeJacobianResidualInfoToFile(param_infos, factor_infos, out_file);
+
+  std::vector<ParameterBlockInfo> read_param_infos;
+  std::vector<GenericFactorInfo> read_factor_infos;
+  ASSERT_TRUE(readJacobianResidualInfoFromFile(
+      out_file, read_param_infos, read_factor_infos));
+  ASSERT_EQ(param_infos.size(), read_param_infos.size());
+  for (size_t i = 0; i < param_infos.size(); i++) {
+    ASSERT_EQ(param_infos[i].frame_id_, read_param_infos[i].frame_id_);
+    ASSERT_EQ(param_infos[i].obj_id_, read_param_infos[i].obj_id_);
+    ASSERT_EQ(param_infos[i].feature_id_, read_param_infos[i].feature_id_);
+  }
+  ASSERT_EQ(factor_infos.size(), read_factor_infos.size());
+  for (size_t i = 0; i < factor_infos.size(); i++) {
+    ASSERT_EQ(factor_infos[i].factor_type_, read_factor_infos[i].factor_type_);
+    ASSERT_EQ(factor_infos[i].frame_ids_, read_factor_infos[i].frame_ids_);
+    ASSERT_EQ(factor_infos[i].camera_id_, read_factor_infos[i].camera_id_);
+    ASSERT_EQ(factor_infos[i].obj_id_, read_factor_infos[i].obj_id_);
+    ASSERT_EQ(factor_infos[i].feature_id_, read_factor_infos[i].feature_id_);
+    ASSERT_EQ(factor_infos[i].final_residual_val_,
+              read_factor_infos[i].final_residual_val_);
+  }
+  fs::remove(out_file);
+}
+
+TEST(DebugDumpIo, ReadWriteBinaryObjectDataAssociationResults) {
+  ObjectDataAssociationResults data_assoc_results;
+  data_assoc_results.associated_bounding_boxes_[4][1][13] =
+      std::make_pair(std::make_pair(PixelCoord<double>(1.2, 3.4),
+                                    PixelCoord<double>(9.2, 8.3)),
+                     0.8);
+  data_assoc_results.associated_bounding_boxes_[9][2][13] =
+      std::make_pair(std::make_pair(PixelCoord<double>(4.5, 6.7),
+                                    PixelCoord<double>(10.1, 12.3)),
+                     std::nullopt);
+
+  std::string out_file =
+      (fs::temp_directory_path() / "debug_dump_io_assoc_test.bin").string();
+  writeObjectDataAssociationResultsToFile(data_assoc_results, out_file);
+
+  ObjectDataAssociationResults read_results;
+  ASSERT_TRUE(readObjectDataAssociationResultsFromFile(out_file, read_results));
+  ASSERT_TRUE(read_results.ellipsoid_pose_results_.ellipsoids_.empty());
+  ASSERT_EQ(data_assoc_results.associated_bounding_boxes_,
+            read_results.associated_bounding_boxes_);
+  fs::remove(out_file);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <refactoring/bounding_box_frontend/optimal_assignment.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+void addEntry(const size_t &row,
+              const size_t &col,
+              const double &score,
+              SparseAssignmentProblem &problem) {
+  problem.entry_rows_.emplace_back(row);
+  problem.entry_cols_.emplace_back(col);
+  problem.entry_scores_.emplace_back(score);
+}
+}  // namespace
+
+TEST(OptimalAssignment, PrefersGlobalOptimumOverGreedy) {
+  SparseAssignmentProblem problem;
+  problem.num_rows_ = 2;
+  problem.num_cols_ = 2;
+  // Greedy would give column 0 to row 0 and leave row 1 unassigned
+  addEntry(0, 0, 0.9, problem);
+  addEntry(0, 1, 0.8, problem);
+  addEntry(1, 0, 0.85, problem);
+
+  std::vector<std::optional<size_t>> assignments =
+      solveSparseAssignment(problem);
+  ASSERT_EQ(2, assignments.size());
+  ASSERT_EQ(1, assignments[0]);
+  ASSERT_EQ(0, assignments[1]);
+}
+
+TEST(OptimalAssignment, MaximizesTotalScore) {
+  SparseAssignmentProblem problem;
+  problem.num_rows_ = 3;
+  problem.num_cols_ = 3;
+  addEntry(0, 0, 0.5, problem);
+  addEntry(0, 1, 0.6, problem);
+  addEntry(1, 1, 0.9, problem);
+  addEntry(1, 2, 0.1, problem);
+  addEntry(2, 2, 0.3, problem);
+  addEntry(2, 0, 0.4, problem);
+
+  std::vector<std::optional<size_t>> assignments =
+      solveSparseAssignment(problem);
+  ASSERT_EQ(0, assignments[0]);
+  ASSERT_EQ(1, assignments[1]);
+  ASSERT_EQ(2, assignments[2]);
+}
+
+TEST(OptimalAssignment, UnassignedRowsAndGating) {
+  SparseAssignmentProblem problem;
+  problem.num_rows_ = 4;
+  problem.num_cols_ = 3;
+  addEntry(0, 0, 0.7, problem);
+  addEntry(1, 0, 0.9, problem);
+  // Row 2 has no candidates
+  addEntry(3, 2, 0.2, problem);
+  addEntry(3, 1, -std::numeric_limits<double>::infinity(), problem);
+
+  std::vector<std::optional<size_t>> assignments =
+      solveSparseAssignment(problem);
+  ASSERT_FALSE(assignments[0].has_value());
+  ASSERT_EQ(0, assignments[1]);
+  ASSERT_FALSE(assignments[2].has_value());
+  ASSERT_EQ(2, assignments[3]);
+
+  assignments = solveSparseAssignment(problem, 0.5);
+  ASSERT_FALSE(assignments[3].has_value());
+  ASSERT_EQ(0, assignments[1]);
+}
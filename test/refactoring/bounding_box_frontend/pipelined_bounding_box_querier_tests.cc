@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <refactoring/bounding_box_frontend/pipelined_bounding_box_querier.h>
+
+#include <atomic>
+#include <filesystem>
+
+using namespace vslam_types_refactor;
+namespace fs = std::filesystem;
+
+namespace {
+sensor_msgs::Image::ConstPtr createImage(const uint8_t &fill_value) {
+  sensor_msgs::Image::Ptr image = boost::make_shared<sensor_msgs::Image>();
+  image->height = 4;
+  image->width = 6;
+  image->step = 6;
+  image->encoding = "mono8";
+  image->data = std::vector<uint8_t>(24, fill_value);
+  return image;
+}
+
+// Stands in for the detection service: returns one box whose x coordinate is
+// the image's fill value
+bool stubDetector(std::atomic<int> &num_calls,
+                  const sensor_msgs::Image::ConstPtr &image,
+                  std::vector<RawBoundingBox> &bounding_boxes) {
+  num_calls++;
+  RawBoundingBox bb;
+  bb.pixel_corner_locations_ =
+      std::make_pair(PixelCoord<double>(image->data.front(), 1),
+                     PixelCoord<double>(image->data.front() + 2, 3));
+  bb.semantic_class_ = "chair";
+  bb.detection_confidence_ = 0.75;
+  bounding_boxes.emplace_back(bb);
+  return true;
+}
+}  // namespace
+
+TEST(PipelinedBoundingBoxQuerier, PrefetchedAndCachedDetections) {
+  fs::path cache_dir = fs::temp_directory_path() / "bb_detection_cache_test";
+  fs::remove_all(cache_dir);
+
+  std::unordered_map<FrameId,
+                     std::unordered_map<CameraId, sensor_msgs::Image::ConstPtr>>
+      images;
+  for (FrameId frame_id = 0; frame_id < 5; frame_id++) {
+    images[frame_id] = {{1, createImage(10 * frame_id)},
+                        {2, createImage(10 * frame_id + 1)}};
+  }
+
+  std::atomic<int> num_calls(0);
+  PipelinedBoundingBoxQuerier::ImageDetector detector =
+      [&](const sensor_msgs::Image::ConstPtr &image,
+          std::vector<RawBoundingBox> &bounding_boxes) {
+        return stubDetector(num_calls, image, bounding_boxes);
+      };
+
+  {
+    PipelinedBoundingBoxQuerier querier(
+        detector,
+        2,
+        std::make_shared<BoundingBoxDetectionCache>(
+            cache_dir.string(), "/stub_detector", "stub_model"));
+    ASSERT_TRUE(querier.prefetchBoundingBoxes(1, images.at(1)));
+    ASSERT_TRUE(querier.prefetchBoundingBoxes(2, images.at(2)));
+    // In-flight window is full
+    ASSERT_FALSE(querier.prefetchBoundingBoxes(3, images.at(3)));
+
+    for (FrameId frame_id = 0; frame_id < 5; frame_id++) {
+      std::unordered_map<CameraId, std::vector<RawBoundingBox>> bbs;
+      ASSERT_TRUE(querier.retrieveBoundingBoxesFromCamIdsAndImages(
+          frame_id, images.at(frame_id), bbs));
+      ASSERT_EQ(2, bbs.size());
+      ASSERT_EQ(1, bbs.at(1).size());
+      ASSERT_DOUBLE_EQ(10 * frame_id,
+                       bbs.at(1).front().pixel_corner_locations_.first.x());
+      ASSERT_DOUBLE_EQ(10 * frame_id + 1,
+                       bbs.at(2).front().pixel_corner_locations_.first.x());
+      ASSERT_EQ("chair", bbs.at(2).front().semantic_class_);
+    }
+  }
+  ASSERT_EQ(10, num_calls);
+
+  // A second run with the same cache shouldn't need the detector
+  PipelinedBoundingBoxQuerier cached_querier(
+      detector,
+      0,
+      std::make_shared<BoundingBoxDetectionCache>(
+          cache_dir.string(), "/stub_detector", "stub_model"));
+  std::unordered_map<CameraId, std::vector<RawBoundingBox>> cached_bbs;
+  ASSERT_TRUE(cached_querier.retrieveBoundingBoxesFromCamIdsAndImages(
+      3, images.at(3), cached_bbs));
+  ASSERT_DOUBLE_EQ(30,
+                   cached_bbs.at(1).front().pixel_corner_locations_.first.x());
+  ASSERT_DOUBLE_EQ(0.75, cached_bbs.at(1).front().detection_confidence_);
+  ASSERT_EQ(10, num_calls);
+
+  // Detections from a different model aren't reused
+  BoundingBoxDetectionCache other_model_cache(
+      cache_dir.string(), "/stub_detector", "other_model");
+  std::vector<RawBoundingBox> other_model_bbs;
+  ASSERT_FALSE(other_model_cache.getCachedDetections(*(images.at(3).at(1)),
+                                                     other_model_bbs));
+
+  fs::remove_all(cache_dir);
+}
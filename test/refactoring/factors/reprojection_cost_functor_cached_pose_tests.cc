@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <refactoring/factors/reprojection_cost_functor.h>
+#include <refactoring/factors/reprojection_cost_functor_cached_pose.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+const double kResidualTolerance = 1e-9;
+const double kJacobianTolerance = 1e-7;
+
+CameraExtrinsics<double> createExtrinsics() {
+  CameraExtrinsics<double> extrinsics;
+  extrinsics.transl_ = Position3d<double>(0.1, -0.2, 0.3);
+  // Camera z axis along the robot's x axis
+  extrinsics.orientation_ = Orientation3D<double>(
+      Eigen::AngleAxisd(-M_PI_2, Eigen::Vector3d::UnitY()) *
+      Eigen::AngleAxisd(M_PI_2, Eigen::Vector3d::UnitZ()));
+  return extrinsics;
+}
+
+CameraIntrinsicsMat<double> createIntrinsics() {
+  CameraIntrinsicsMat<double> intrinsics;
+  intrinsics << 500, 0, 320, 0, 510, 240, 0, 0, 1;
+  return intrinsics;
+}
+
+/**
+ * Compare the residual and Jacobians of the cached pose cost function to the
+ * autodiff version for a point placed in front of the camera.
+ */
+void compareToAutodiff(const std::array<double, 6> &robot_pose,
+                       const std::shared_ptr<const RobotPoseTransform>
+                           &robot_pose_transform) {
+  CameraExtrinsics<double> extrinsics = createExtrinsics();
+  CameraIntrinsicsMat<double> intrinsics = createIntrinsics();
+  PixelCoord<double> feature_pixel(300, 250);
+
+  Eigen::Affine3d robot_pose_tf = PoseArrayToAffine(&(robot_pose[3]),
+                                                    &(robot_pose[0]));
+  Eigen::Affine3d cam_tf =
+      robot_pose_tf *
+      (Eigen::Translation3d(extrinsics.transl_) * extrinsics.orientation_);
+  Eigen::Vector3d point = cam_tf * Eigen::Vector3d(0.3, -0.2, 4);
+
+  std::unique_ptr<ceres::CostFunction> autodiff_cost_function(
+      ReprojectionCostFunctor::create(
+          intrinsics, extrinsics, feature_pixel, 2.0));
+  std::unique_ptr<ceres::CostFunction> cached_cost_function(
+      ReprojectionCostFunctorCachedPose::create(intrinsics,
+                                                extrinsics,
+                                                feature_pixel,
+                                                2.0,
+                                                robot_pose_transform));
+
+  const double *parameters[2] = {robot_pose.data(), point.data()};
+  double autodiff_residuals[2];
+  double autodiff_pose_jacobian[12];
+  double autodiff_point_jacobian[6];
+  double *autodiff_jacobians[2] = {autodiff_pose_jacobian,
+                                   autodiff_point_jacobian};
+  double cached_residuals[2];
+  double cached_pose_jacobian[12];
+  double cached_point_jacobian[6];
+  double *cached_jacobians[2] = {cached_pose_jacobian, cached_point_jacobian};
+  ASSERT_TRUE(autodiff_cost_function->Evaluate(
+      parameters, autodiff_residuals, autodiff_jacobians));
+  ASSERT_TRUE(cached_cost_function->Evaluate(
+      parameters, cached_residuals, cached_jacobians));
+
+  for (int i = 0; i < 2; i++) {
+    EXPECT_NEAR(autodiff_residuals[i], cached_residuals[i], kResidualTolerance);
+  }
+  for (int i = 0; i < 12; i++) {
+    EXPECT_NEAR(
+        autodiff_pose_jacobian[i], cached_pose_jacobian[i], kJacobianTolerance);
+  }
+  for (int i = 0; i < 6; i++) {
+    EXPECT_NEAR(autodiff_point_jacobian[i],
+                cached_point_jacobian[i],
+                kJacobianTolerance);
+  }
+}
+}  // namespace
+
+TEST(ReprojectionCostFunctorCachedPose, MatchesAutodiffWithCurrentCache) {
+  RobotPoseTransformCache cache;
+  for (const std::array<double, 6> &robot_pose :
+       std::vector<std::array<double, 6>>{{1, 2, 3, 0.1, -0.4, 0.7},
+                                          {-4, 0.5, 1, 2.5, 0.3, -1.2},
+                                          {0, 0, 0, 1e-5, 2e-5, -1e-5}}) {
+    compareToAutodiff(robot_pose, cache.getOrAddRobotPose(robot_pose.data()));
+  }
+}
+
+TEST(ReprojectionCostFunctorCachedPose, MatchesAutodiffWithStaleCache) {
+  RobotPoseTransformCache cache;
+  std::array<double, 6> robot_pose = {1, 2, 3, 0.1, -0.4, 0.7};
+  std::shared_ptr<const RobotPoseTransform> transform =
+      cache.getOrAddRobotPose(robot_pose.data());
+
+  // Cache hasn't been refreshed, so the residual has to compute it itself
+  robot_pose[3] += 0.05;
+  compareToAutodiff(robot_pose, transform);
+
+  cache.PrepareForEvaluation(true, true);
+  EXPECT_TRUE(transform->matches(robot_pose.data()));
+  compareToAutodiff(robot_pose, transform);
+}
+
+TEST(RobotPoseTransformCache, DropsUnreferencedTransforms) {
+  RobotPoseTransformCache cache;
+  std::array<double, 6> robot_pose_1 = {1, 2, 3, 0.1, -0.4, 0.7};
+  std::array<double, 6> robot_pose_2 = {-4, 0.5, 1, 2.5, 0.3, -1.2};
+  std::shared_ptr<const RobotPoseTransform> transform_1 =
+      cache.getOrAddRobotPose(robot_pose_1.data());
+  EXPECT_EQ(transform_1, cache.getOrAddRobotPose(robot_pose_1.data()));
+  cache.getOrAddRobotPose(robot_pose_2.data());
+  EXPECT_EQ(2u, cache.size());
+
+  cache.PrepareForEvaluation(false, true);
+  EXPECT_EQ(1u, cache.size());
+}
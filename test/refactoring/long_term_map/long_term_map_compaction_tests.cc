@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include <refactoring/long_term_map/long_term_map_compaction.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+typedef IndependentEllipsoidsLongTermObjectMap<util::EmptyStruct> TestLtm;
+
+EllipsoidState<double> createEllipsoid(const double &x, const double &y) {
+  EllipsoidState<double> ellipsoid;
+  ellipsoid.pose_.transl_ = Position3d<double>(x, y, 0.5);
+  ellipsoid.dimensions_ = ObjectDim<double>(1, 1, 1);
+  return ellipsoid;
+}
+
+/**
+ * Objects 1 and 2 are chairs 0.2 m apart, object 3 is a table next to them,
+ * and object 4 is a chair far away.
+ */
+TestLtm createLtm() {
+  EllipsoidResults ellipsoids;
+  ellipsoids.ellipsoids_[1] = std::make_pair("chair", createEllipsoid(0, 0));
+  ellipsoids.ellipsoids_[2] =
+      std::make_pair("chair", createEllipsoid(0.2, 0));
+  ellipsoids.ellipsoids_[3] =
+      std::make_pair("table", createEllipsoid(0.1, 0));
+  ellipsoids.ellipsoids_[4] = std::make_pair("chair", createEllipsoid(10, 0));
+
+  std::unordered_map<ObjectId,
+                     Covariance<double, kEllipsoidParamterizationSize>>
+      covariances;
+  for (ObjectId obj_id = 1; obj_id <= 4; obj_id++) {
+    covariances[obj_id] =
+        Covariance<double, kEllipsoidParamterizationSize>::Identity();
+  }
+  // Object 2 is 3x as certain as object 1
+  covariances[2] /= 3;
+
+  std::unordered_map<ObjectId, util::EmptyStruct> front_end_data;
+  for (ObjectId obj_id = 1; obj_id <= 4; obj_id++) {
+    front_end_data[obj_id] = util::EmptyStruct();
+  }
+
+  TestLtm ltm;
+  ltm.setLtmEllipsoidResults(ellipsoids);
+  ltm.setEllipsoidResults(ellipsoids);
+  ltm.setEllipsoidCovariances(covariances);
+  ltm.setFrontEndObjMapData(front_end_data);
+  return ltm;
+}
+}  // namespace
+
+TEST(LongTermMapCompaction, UpdateUnobservedSessionCounts) {
+  std::shared_ptr<TestLtm> prev_ltm = std::make_shared<TestLtm>(createLtm());
+  prev_ltm->setUnobservedSessionCounts({{3, 2}, {4, 5}});
+
+  // Object 5 is new this session
+  TestLtm ltm = createLtm();
+  EllipsoidResults ellipsoids;
+  ltm.getLtmEllipsoidResults(ellipsoids);
+  ellipsoids.ellipsoids_[5] = std::make_pair("lamp", createEllipsoid(5, 5));
+  ltm.setLtmEllipsoidResults(ellipsoids);
+
+  updateUnobservedSessionCounts(prev_ltm, {1, 4, 5}, ltm);
+  std::unordered_map<ObjectId, uint64_t> unobserved_session_counts;
+  ltm.getUnobservedSessionCounts(unobserved_session_counts);
+  EXPECT_EQ((std::unordered_map<ObjectId, uint64_t>({{2, 1}, {3, 3}})),
+            unobserved_session_counts);
+}
+
+TEST(LongTermMapCompaction, MergesDuplicatesOfSameClass) {
+  TestLtm ltm = createLtm();
+  LongTermMapCompactionParams params;
+  params.max_merge_distance_ = 0.5;
+  LongTermMapCompactionStats stats = LongTermMapCompactor(params).compact(ltm);
+  EXPECT_EQ(4u, stats.num_objects_before_);
+  EXPECT_EQ(3u, stats.num_objects_after_);
+  EXPECT_EQ(1u, stats.num_merged_);
+
+  EllipsoidResults ellipsoids;
+  ltm.getLtmEllipsoidResults(ellipsoids);
+  ASSERT_EQ(3u, ellipsoids.ellipsoids_.size());
+  ASSERT_EQ(1u, ellipsoids.ellipsoids_.count(1));
+  EXPECT_NEAR(
+      0.15, ellipsoids.ellipsoids_.at(1).second.pose_.transl_.x(), 1e-9);
+
+  std::unordered_map<ObjectId,
+                     Covariance<double, kEllipsoidParamterizationSize>>
+      covariances = ltm.getEllipsoidCovariances();
+  EXPECT_EQ(0u, covariances.count(2));
+  EXPECT_NEAR(0.25, covariances.at(1)(0, 0), 1e-9);
+  EXPECT_EQ(1.0, covariances.at(3)(0, 0));
+
+  EllipsoidResults prev_traj_ellipsoids;
+  ltm.getEllipsoidResults(prev_traj_ellipsoids);
+  EXPECT_EQ(0u, prev_traj_ellipsoids.ellipsoids_.count(2));
+  std::unordered_map<ObjectId, util::EmptyStruct> front_end_data;
+  ltm.getFrontEndObjMapData(front_end_data);
+  EXPECT_EQ(3u, front_end_data.size());
+}
+
+TEST(LongTermMapCompaction, RemovesLongUnobservedObjects) {
+  TestLtm ltm = createLtm();
+  ltm.setUnobservedSessionCounts({{3, 2}, {4, 3}});
+  LongTermMapCompactionParams params;
+  params.max_merge_distance_ = 0;
+  params.max_unobserved_sessions_ = 3;
+  LongTermMapCompactionStats stats = LongTermMapCompactor(params).compact(ltm);
+  EXPECT_EQ(1u, stats.num_removed_unobserved_);
+  EXPECT_EQ(3u, stats.num_objects_after_);
+
+  EllipsoidResults ellipsoids;
+  ltm.getLtmEllipsoidResults(ellipsoids);
+  EXPECT_EQ(0u, ellipsoids.ellipsoids_.count(4));
+  std::unordered_map<ObjectId, uint64_t> unobserved_session_counts;
+  ltm.getUnobservedSessionCounts(unobserved_session_counts);
+  EXPECT_EQ((std::unordered_map<ObjectId, uint64_t>({{3, 2}})),
+            unobserved_session_counts);
+}
+
+TEST(LongTermMapCompaction, MergesFrontEndMapData) {
+  typedef std::unordered_set<FrameId> ObservedFrames;
+  // Objects 1 and 2 merge in the first pass, and the merged object is then
+  // close enough to object 3 to merge with it in the second pass
+  EllipsoidResults ellipsoids;
+  ellipsoids.ellipsoids_[1] = std::make_pair("chair", createEllipsoid(0, 0));
+  ellipsoids.ellipsoids_[2] =
+      std::make_pair("chair", createEllipsoid(0.2, 0));
+  ellipsoids.ellipsoids_[3] =
+      std::make_pair("chair", createEllipsoid(0.45, 0));
+  std::unordered_map<ObjectId,
+                     Covariance<double, kEllipsoidParamterizationSize>>
+      covariances;
+  for (ObjectId obj_id = 1; obj_id <= 3; obj_id++) {
+    covariances[obj_id] =
+        Covariance<double, kEllipsoidParamterizationSize>::Identity();
+  }
+
+  // Object 1 has no front-end data, so it should take object 2's before
+  // object 3's is merged into it
+  IndependentEllipsoidsLongTermObjectMap<ObservedFrames> ltm;
+  ltm.setLtmEllipsoidResults(ellipsoids);
+  ltm.setEllipsoidResults(ellipsoids);
+  ltm.setEllipsoidCovariances(covariances);
+  ltm.setFrontEndObjMapData({{2, {20}}, {3, {30}}});
+
+  std::function<void(const ObservedFrames &, ObservedFrames &)> merger =
+      [](const ObservedFrames &data_to_merge_in,
+         ObservedFrames &data_to_update) {
+        data_to_update.insert(data_to_merge_in.begin(),
+                              data_to_merge_in.end());
+      };
+  LongTermMapCompactionParams params;
+  params.max_merge_distance_ = 0.5;
+  LongTermMapCompactionStats stats =
+      LongTermMapCompactor(params).compact(ltm, merger);
+  EXPECT_EQ(2u, stats.num_merged_);
+  EXPECT_EQ(1u, stats.num_objects_after_);
+
+  std::unordered_map<ObjectId, ObservedFrames> front_end_data;
+  ltm.getFrontEndObjMapData(front_end_data);
+  ASSERT_EQ(1u, front_end_data.size());
+  EXPECT_EQ(ObservedFrames({20, 30}), front_end_data.at(1));
+}
+
+#ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
+TEST(LongTermMapCompaction, FusesYawsOnOppositeSidesOfWrap) {
+  // Both yaws are near pi; averaging the raw values would give a yaw near 0
+  RawEllipsoid<double> first_est;
+  first_est << 0, 0, 0.5, M_PI - 0.1, 1, 1, 1;
+  RawEllipsoid<double> second_est;
+  second_est << 0.2, 0, 0.5, -M_PI + 0.3, 1, 1, 1;
+  Covariance<double, kEllipsoidParamterizationSize> cov =
+      Covariance<double, kEllipsoidParamterizationSize>::Identity();
+
+  RawEllipsoid<double> fused_est;
+  Covariance<double, kEllipsoidParamterizationSize> fused_cov;
+  ASSERT_TRUE(fuseEllipsoidEstimates(
+      first_est, cov, second_est, cov, fused_est, fused_cov));
+  EXPECT_NEAR(0.1, fused_est(0), 1e-9);
+  EXPECT_NEAR(-M_PI + 0.1, fused_est(3), 1e-9);
+  EXPECT_NEAR(0.5, fused_cov(3, 3), 1e-9);
+
+  EllipsoidResults ellipsoids;
+  ellipsoids.ellipsoids_[1] =
+      std::make_pair("chair", convertToEllipsoidState(first_est));
+  ellipsoids.ellipsoids_[2] =
+      std::make_pair("chair", convertToEllipsoidState(second_est));
+  TestLtm ltm;
+  ltm.setLtmEllipsoidResults(ellipsoids);
+  ltm.setEllipsoidResults(ellipsoids);
+  ltm.setEllipsoidCovariances({{1, cov}, {2, cov}});
+  LongTermMapCompactionParams params;
+  params.max_merge_distance_ = 0.5;
+  EXPECT_EQ(1u, LongTermMapCompactor(params).compact(ltm).num_merged_);
+
+  ltm.getLtmEllipsoidResults(ellipsoids);
+  ASSERT_EQ(1u, ellipsoids.ellipsoids_.size());
+  EXPECT_NEAR(
+      -M_PI + 0.1, ellipsoids.ellipsoids_.at(1).second.pose_.yaw_, 1e-9);
+}
+#endif
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <refactoring/long_term_map/long_term_map_tiles.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+/**
+ * Stand-in for the pose graph that records the long-term map objects in it.
+ */
+class FakeLtmPoseGraph {
+ public:
+  bool addLongTermMapObject(const ObjectId &object_id,
+                            const std::string &,
+                            const RawEllipsoid<double> &) {
+    return ltm_objects_.insert(object_id).second;
+  }
+
+  bool removeUnobservedLongTermMapObject(const ObjectId &object_id) {
+    if (observed_objects_.find(object_id) != observed_objects_.end()) {
+      return false;
+    }
+    return ltm_objects_.erase(object_id) > 0;
+  }
+
+  void getLongTermMapObjects(std::unordered_set<ObjectId> &ltm_object_ids) {
+    ltm_object_ids = ltm_objects_;
+  }
+
+  void reserveObjectIdsThrough(const ObjectId &max_reserved_object_id) {
+    max_reserved_object_id_ = max_reserved_object_id;
+  }
+
+  std::unordered_set<ObjectId> ltm_objects_;
+  std::unordered_set<ObjectId> observed_objects_;
+  ObjectId max_reserved_object_id_ = 0;
+};
+
+/**
+ * Objects 1-10 are spaced 10 m apart along the x axis, starting at x = 5.
+ */
+EllipsoidResults createMapObjects() {
+  EllipsoidResults map_objects;
+  for (ObjectId object_id = 1; object_id <= 10; object_id++) {
+    EllipsoidState<double> ellipsoid;
+    ellipsoid.pose_.transl_ =
+        Position3d<double>(10.0 * object_id - 5, 1.0, 0.5);
+    ellipsoid.dimensions_ = ObjectDim<double>(1, 1, 1);
+    map_objects.ellipsoids_[object_id] = std::make_pair("chair", ellipsoid);
+  }
+  return map_objects;
+}
+
+LongTermMapTilingParams createTilingParams() {
+  LongTermMapTilingParams params;
+  params.tile_size_ = 10;
+  params.load_radius_ = 12;
+  params.unload_radius_ = 22;
+  return params;
+}
+}  // namespace
+
+TEST(TiledLongTermMapObjects, GetObjectsInTilesNear) {
+  TiledLongTermMapObjects tiles(createMapObjects(), createTilingParams());
+  EXPECT_EQ(10u, tiles.getNumTiles());
+  EXPECT_EQ(10u, tiles.getMaxMapObjectId());
+
+  // Tiles [30, 40) to [60, 70) are within 12 m of x = 48
+  std::unordered_set<ObjectId> nearby_objects;
+  tiles.getObjectsInTilesNear(
+      Position3d<double>(48, 0, 0), 12, nearby_objects);
+  EXPECT_EQ(std::unordered_set<ObjectId>({4, 5, 6, 7}), nearby_objects);
+
+  // Only the y = 0 row of tiles has objects
+  nearby_objects.clear();
+  tiles.getObjectsInTilesNear(
+      Position3d<double>(48, 30, 0), 12, nearby_objects);
+  EXPECT_TRUE(nearby_objects.empty());
+}
+
+TEST(TiledLongTermMapObjects, UpdateWorkingSetLoadsAndUnloads) {
+  TiledLongTermMapObjects tiles(createMapObjects(), createTilingParams());
+  std::shared_ptr<FakeLtmPoseGraph> pose_graph =
+      std::make_shared<FakeLtmPoseGraph>();
+
+  tiles.updateWorkingSet(Position3d<double>(15, 0, 0), pose_graph);
+  EXPECT_EQ(10u, pose_graph->max_reserved_object_id_);
+  EXPECT_EQ(std::unordered_set<ObjectId>({1, 2, 3}), pose_graph->ltm_objects_);
+
+  // Object 2 was observed, so it stays even once it's far away. Object 3 is
+  // still within the unload radius.
+  pose_graph->observed_objects_.insert(2);
+  tiles.updateWorkingSet(Position3d<double>(45, 0, 0), pose_graph);
+  EXPECT_EQ(std::unordered_set<ObjectId>({2, 3, 4, 5, 6}),
+            pose_graph->ltm_objects_);
+
+  tiles.loadAllObjects(pose_graph);
+  EXPECT_EQ(10u, pose_graph->ltm_objects_.size());
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <refactoring/offline/keyframe_selection.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+/**
+ * Frames 0-9, moving 0.1 m along x per frame.
+ */
+std::unordered_map<FrameId, Pose3D<double>> createRobotPoses() {
+  std::unordered_map<FrameId, Pose3D<double>> robot_poses;
+  for (FrameId frame_id = 0; frame_id < 10; frame_id++) {
+    robot_poses[frame_id] =
+        Pose3D<double>(Position3d<double>(0.1 * frame_id, 0, 0),
+                       Orientation3D<double>(0, Eigen::Vector3d::UnitZ()));
+  }
+  return robot_poses;
+}
+
+StructuredVisionFeatureTrack createTrack(
+    const FeatureId &feature_id,
+    const std::vector<std::pair<FrameId, double>> &frames_and_pixel_x) {
+  VisionFeatureTrack track(feature_id);
+  for (const std::pair<FrameId, double> &frame_and_pixel_x :
+       frames_and_pixel_x) {
+    track.feature_observations_.emplace(
+        frame_and_pixel_x.first,
+        VisionFeature(frame_and_pixel_x.first,
+                      {{0, PixelCoord<double>(frame_and_pixel_x.second, 10)}},
+                      0));
+  }
+  return StructuredVisionFeatureTrack(Position3d<double>(1, 2, 3), track);
+}
+}  // namespace
+
+TEST(KeyframeSelection, SelectsByPoseChange) {
+  KeyframeSelectionParams params;
+  params.max_pose_inc_threshold_transl_ = 0.25;
+  KeyframeMapping mapping =
+      selectKeyframes(params, createRobotPoses(), {}, {});
+  // Every third frame is more than 0.25 m from the last keyframe, and the
+  // last frame is always kept
+  EXPECT_EQ(std::vector<FrameId>({0, 3, 6, 9}),
+            mapping.input_frame_for_keyframe_);
+  EXPECT_EQ(1u, mapping.keyframe_for_input_frame_.at(3));
+  EXPECT_EQ(0u, mapping.keyframe_for_input_frame_.count(4));
+}
+
+TEST(KeyframeSelection, NoKeyframesWithoutPoses) {
+  KeyframeMapping mapping =
+      selectKeyframes(KeyframeSelectionParams(), {}, {}, {});
+  EXPECT_TRUE(mapping.input_frame_for_keyframe_.empty());
+  EXPECT_TRUE(mapping.keyframe_for_input_frame_.empty());
+}
+
+TEST(KeyframeSelection, SelectsByParallaxAndNewDetections) {
+  KeyframeSelectionParams params;
+  params.max_pose_inc_threshold_transl_ = 10;
+  params.max_median_feature_parallax_ = 15;
+  params.keyframe_on_new_detections_ = true;
+
+  // Feature 0 moves 10 px per frame
+  std::unordered_map<FeatureId, StructuredVisionFeatureTrack> visual_features;
+  std::vector<std::pair<FrameId, double>> frames_and_pixel_x;
+  for (FrameId frame_id = 0; frame_id < 10; frame_id++) {
+    frames_and_pixel_x.emplace_back(std::make_pair(frame_id, 10.0 * frame_id));
+  }
+  visual_features[0] = createTrack(0, frames_and_pixel_x);
+
+  // A second chair appears in frame 5
+  std::unordered_map<FrameId,
+                     std::unordered_map<CameraId, std::vector<RawBoundingBox>>>
+      bounding_boxes;
+  RawBoundingBox chair;
+  chair.semantic_class_ = "chair";
+  for (FrameId frame_id = 0; frame_id < 10; frame_id++) {
+    bounding_boxes[frame_id][0] = {chair};
+    if (frame_id >= 5) {
+      bounding_boxes[frame_id][0].emplace_back(chair);
+    }
+  }
+
+  KeyframeMapping mapping = selectKeyframes(
+      params, createRobotPoses(), visual_features, bounding_boxes);
+  EXPECT_EQ(std::vector<FrameId>({0, 2, 4, 5, 7, 9}),
+            mapping.input_frame_for_keyframe_);
+}
+
+TEST(KeyframeSelection, RemapsToAndFromKeyframes) {
+  KeyframeMapping mapping;
+  mapping.input_frame_for_keyframe_ = {0, 3, 6};
+  mapping.keyframe_for_input_frame_ = {{0, 0}, {3, 1}, {6, 2}};
+
+  std::unordered_map<FrameId, Pose3D<double>> keyframe_poses =
+      remapToKeyframes(createRobotPoses(), mapping);
+  ASSERT_EQ(3u, keyframe_poses.size());
+  EXPECT_DOUBLE_EQ(0.6, keyframe_poses.at(2).transl_.x());
+  std::unordered_map<FrameId, Pose3D<double>> input_frame_poses =
+      remapToInputFrames(keyframe_poses, mapping);
+  ASSERT_EQ(1u, input_frame_poses.count(6));
+  EXPECT_DOUBLE_EQ(0.6, input_frame_poses.at(6).transl_.x());
+
+  std::unordered_map<FeatureId, StructuredVisionFeatureTrack> visual_features;
+  visual_features[0] = createTrack(0, {{2, 0}, {3, 0}, {4, 0}});
+  visual_features[1] = createTrack(1, {{4, 0}, {5, 0}});
+  std::unordered_map<FeatureId, StructuredVisionFeatureTrack>
+      keyframe_features = remapFeatureTracksToKeyframes(visual_features,
+                                                        mapping);
+  ASSERT_EQ(1u, keyframe_features.size());
+  const VisionFeatureTrack &track = keyframe_features.at(0).feature_track;
+  ASSERT_EQ(1u, track.feature_observations_.size());
+  EXPECT_EQ(1u, track.feature_observations_.at(1).frame_id_);
+}
@@ -0,0 +1,367 @@
+#include <benchmarks/synthetic_scene_generator.h>
+#include <file_io/cv_file_storage/offline_runner_checkpoint_file_storage_io.h>
+#include <gtest/gtest.h>
+#include <refactoring/offline/offline_problem_runner.h>
+#include <refactoring/optimization/residual_creator.h>
+
+#include <filesystem>
+#include <random>
+
+using namespace vslam_types_refactor;
+namespace fs = std::filesystem;
+
+namespace {
+typedef ObjectAndReprojectionFeaturePoseGraph SyntheticPg;
+typedef std::shared_ptr<SyntheticPg> SyntheticPgPtr;
+typedef std::pair<FactorType, FeatureFactorId> SyntheticFactorInfo;
+
+const FrameId kNumFrames = 12;
+const FrameId kCheckpointFrame = 6;
+const FrameId kLocalBaWindowSize = 4;
+
+/**
+ * Tolerance for estimates of the resumed run. The resumed run rebuilds the
+ * problem, so it only matches the uninterrupted run up to solver round-off.
+ */
+const double kEstimateTolerance = 1e-4;
+
+/**
+ * Input data for a synthetic run. The runner only needs the final frame; the
+ * frame data adder reads the observations directly from the run.
+ */
+struct SyntheticRunInput {
+  FrameId max_frame_id_;
+
+  FrameId getMaxFrameId() const { return max_frame_id_; }
+};
+
+typedef OfflineProblemRunner<SyntheticRunInput,
+                             ReprojectionErrorFactor,
+                             ObjectAndReprojectionFeaturePoseGraphState,
+                             util::EmptyStruct,
+                             SyntheticPg>
+    SyntheticRunner;
+
+/**
+ * Synthetic visual-feature-only scene with noisy odometry and noisy initial
+ * feature estimates, added to the pose graph one frame at a time.
+ */
+class SyntheticRun {
+ public:
+  SyntheticRun() {
+    SyntheticSceneParams scene_params;
+    scene_params.num_poses_ = kNumFrames;
+    scene_params.num_landmarks_ = 300;
+    scene_params.num_ellipsoids_ = 0;
+    scene_ = generateSyntheticScene(scene_params);
+
+    std::mt19937 rand_gen(42);
+    std::normal_distribution<double> unit_noise(0.0, 1.0);
+    auto noise_vec = [&](const double &std_dev) {
+      return Eigen::Vector3d(unit_noise(rand_gen),
+                             unit_noise(rand_gen),
+                             unit_noise(rand_gen)) *
+             std_dev;
+    };
+    for (FrameId frame_id = 1; frame_id < kNumFrames; frame_id++) {
+      Pose3D<double> odom = getPose2RelativeToPose1(
+          scene_.robot_poses_[frame_id - 1], scene_.robot_poses_[frame_id]);
+      odom.transl_ += noise_vec(0.05);
+      noisy_odometry_[frame_id] = odom;
+    }
+    for (const ReprojectionErrorFactor &factor :
+         scene_.feature_observations_) {
+      observations_by_frame_[factor.frame_id_].emplace_back(factor);
+      if (first_frame_by_feature_.find(factor.feature_id_) ==
+          first_frame_by_feature_.end()) {
+        first_frame_by_feature_[factor.feature_id_] = factor.frame_id_;
+        init_feature_positions_[factor.feature_id_] =
+            scene_.landmarks_[factor.feature_id_] + noise_vec(0.2);
+      }
+    }
+
+    ltm_factor_provider_ =
+        [](const std::unordered_set<ObjectId> &,
+           util::BoostHashMap<std::pair<FactorType, FeatureFactorId>,
+                              std::unordered_set<ObjectId>> &) {
+          return true;
+        };
+    cached_info_creator_ = [](const SyntheticFactorInfo &,
+                              const SyntheticPgPtr &,
+                              util::EmptyStruct &) { return true; };
+    ltm_residual_creator_ =
+        [](const SyntheticFactorInfo &,
+           const SyntheticPgPtr &,
+           const pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+               &,
+           const std::function<bool(const SyntheticFactorInfo &,
+                                    const SyntheticPgPtr &,
+                                    util::EmptyStruct &)> &,
+           ceres::Problem *,
+           ceres::ResidualBlockId &,
+           util::EmptyStruct &) { return false; };
+  }
+
+  /**
+   * Run the optimization.
+   *
+   * @param resume_checkpoint     Checkpoint to resume after. If not
+   *                              provided, the run starts at the first frame.
+   * @param checkpoint_frame      Frame after which to take a checkpoint.
+   * @param checkpoint[out]       Checkpoint taken after checkpoint_frame.
+   * @param final_state[out]      Pose graph state at the end of the run.
+   *
+   * @return True if the optimization succeeded.
+   */
+  bool run(const std::optional<OfflineRunnerCheckpointState> &resume_checkpoint,
+           const FrameId &checkpoint_frame,
+           OfflineRunnerCheckpointState &checkpoint,
+           ObjectAndReprojectionFeaturePoseGraphState &final_state) {
+    std::function<void(const SyntheticRunInput &, SyntheticPgPtr &)>
+        pose_graph_creator = [&](const SyntheticRunInput &,
+                                 SyntheticPgPtr &pose_graph) {
+          if (resume_checkpoint.has_value()) {
+            pose_graph = SyntheticPg::
+                createObjectAndReprojectionFeaturePoseGraphFromState(
+                    resume_checkpoint->pose_graph_state_,
+                    ltm_factor_provider_);
+          } else {
+            pose_graph = std::make_shared<SyntheticPg>(
+                scene_.shape_mean_and_cov_by_semantic_class_,
+                scene_.camera_extrinsics_by_camera_,
+                scene_.camera_intrinsics_by_camera_,
+                std::unordered_map<
+                    ObjectId,
+                    std::pair<std::string, RawEllipsoid<double>>>(),
+                ltm_factor_provider_);
+          }
+        };
+    std::function<void(const SyntheticRunInput &,
+                       const SyntheticPgPtr &,
+                       const FrameId &,
+                       const FrameId &)>
+        frame_data_adder = [&](const SyntheticRunInput &,
+                               const SyntheticPgPtr &pose_graph,
+                               const FrameId &,
+                               const FrameId &frame_id) {
+          addFrameData(pose_graph, frame_id);
+        };
+    std::function<bool(const SyntheticFactorInfo &,
+                       const pose_graph_optimization::
+                           ObjectVisualPoseGraphResidualParams &,
+                       const SyntheticPgPtr &,
+                       ceres::Problem *,
+                       ceres::ResidualBlockId &,
+                       util::EmptyStruct &)>
+        residual_creator =
+            [&](const SyntheticFactorInfo &factor_info,
+                const pose_graph_optimization::
+                    ObjectVisualPoseGraphResidualParams &residual_params,
+                const SyntheticPgPtr &pose_graph,
+                ceres::Problem *problem,
+                ceres::ResidualBlockId &residual_id,
+                util::EmptyStruct &cached_info) {
+              return createResidual(factor_info,
+                                    pose_graph,
+                                    residual_params,
+                                    cached_info_creator_,
+                                    ltm_residual_creator_,
+                                    problem,
+                                    residual_id,
+                                    cached_info,
+                                    std::nullopt);
+            };
+    std::function<void(
+        const SyntheticRunInput &,
+        const SyntheticPgPtr &,
+        const pose_graph_optimizer::OptimizationFactorsEnabledParams &,
+        ObjectAndReprojectionFeaturePoseGraphState &)>
+        output_data_extractor =
+            [](const SyntheticRunInput &,
+               const SyntheticPgPtr &pose_graph,
+               const pose_graph_optimizer::OptimizationFactorsEnabledParams &,
+               ObjectAndReprojectionFeaturePoseGraphState &output_state) {
+              pose_graph->getState(output_state);
+            };
+    std::function<void(
+        const SyntheticRunInput &, const SyntheticPgPtr &, const FrameId &)>
+        frame_completed_callback = [&](const SyntheticRunInput &,
+                                       const SyntheticPgPtr &pose_graph,
+                                       const FrameId &frame_id) {
+          if (frame_id != checkpoint_frame) {
+            return;
+          }
+          checkpoint.last_frame_processed_ = frame_id;
+          pose_graph->getState(checkpoint.pose_graph_state_);
+        };
+
+    pose_graph_optimization::OptimizationIterationParams iteration_params;
+    iteration_params.allow_reversion_after_detecting_jumps_ = false;
+    iteration_params.feature_outlier_percentage_ = 0;
+    // Multithreaded evaluation sums residuals in a nondeterministic order
+    iteration_params.phase_one_opt_params_.num_threads_ = 1;
+
+    SyntheticRunner runner(
+        pose_graph_optimization::ObjectVisualPoseGraphResidualParams(),
+        LimitTrajectoryEvaluationParams(),
+        pose_graph_optimization::PoseGraphPlusObjectsOptimizationParams(),
+        []() { return true; },
+        [](const FrameId &max_frame_to_opt) -> FrameId {
+          if ((max_frame_to_opt == kNumFrames - 1) ||
+              (max_frame_to_opt < kLocalBaWindowSize)) {
+            return 0;
+          }
+          return max_frame_to_opt - kLocalBaWindowSize;
+        },
+        [](const SyntheticFactorInfo &,
+           const SyntheticPgPtr &,
+           const util::EmptyStruct &) { return false; },
+        residual_creator,
+        pose_graph_creator,
+        frame_data_adder,
+        output_data_extractor,
+        [](const SyntheticRunInput &,
+           const SyntheticPgPtr &,
+           const FrameId &,
+           const FrameId &) {
+          return std::vector<std::shared_ptr<ceres::IterationCallback>>();
+        },
+        [](const SyntheticRunInput &,
+           const SyntheticPgPtr &,
+           const FrameId &,
+           const FrameId &,
+           const VisualizationTypeEnum &,
+           const int &) {},
+        [&](const FrameId &) { return iteration_params; },
+        [](const SyntheticPgPtr &, std::unordered_set<ObjectId> &) {
+          return false;
+        },
+        [](const FrameId &) { return false; },
+        frame_completed_callback);
+
+    pose_graph_optimizer::OptimizationFactorsEnabledParams factors_enabled;
+    factors_enabled.min_low_level_feature_observations_per_frame_ = 0;
+    factors_enabled.include_object_factors_ = false;
+    factors_enabled.include_visual_factors_ = true;
+    factors_enabled.fix_poses_ = false;
+    factors_enabled.fix_visual_features_ = false;
+
+    SyntheticRunInput input;
+    input.max_frame_id_ = kNumFrames - 1;
+    std::optional<OptimizationLogger> opt_logger;
+    FrameId start_at_frame = resume_checkpoint.has_value()
+                                 ? resume_checkpoint->last_frame_processed_ + 1
+                                 : 0;
+    return runner.runOptimization(
+        input, factors_enabled, opt_logger, final_state, start_at_frame);
+  }
+
+ private:
+  SyntheticScene scene_;
+  std::unordered_map<FrameId, Pose3D<double>> noisy_odometry_;
+  std::unordered_map<FrameId, std::vector<ReprojectionErrorFactor>>
+      observations_by_frame_;
+  std::unordered_map<FeatureId, FrameId> first_frame_by_feature_;
+  std::unordered_map<FeatureId, Position3d<double>> init_feature_positions_;
+
+  std::function<bool(
+      const std::unordered_set<ObjectId> &,
+      util::BoostHashMap<std::pair<FactorType, FeatureFactorId>,
+                         std::unordered_set<ObjectId>> &)>
+      ltm_factor_provider_;
+  std::function<bool(
+      const SyntheticFactorInfo &, const SyntheticPgPtr &, util::EmptyStruct &)>
+      cached_info_creator_;
+  std::function<bool(
+      const SyntheticFactorInfo &,
+      const SyntheticPgPtr &,
+      const pose_graph_optimization::ObjectVisualPoseGraphResidualParams &,
+      const std::function<bool(const SyntheticFactorInfo &,
+                               const SyntheticPgPtr &,
+                               util::EmptyStruct &)> &,
+      ceres::Problem *,
+      ceres::ResidualBlockId &,
+      util::EmptyStruct &)>
+      ltm_residual_creator_;
+
+  void addFrameData(const SyntheticPgPtr &pose_graph, const FrameId &frame_id) {
+    if (frame_id == 0) {
+      pose_graph->addFrame(frame_id, scene_.robot_poses_[0]);
+    } else {
+      // Initialize from the optimized previous pose, as the front end does
+      Pose3D<double> prev_pose =
+          convertToPose3D(pose_graph->getRobotPose(frame_id - 1).value());
+      pose_graph->addFrame(
+          frame_id, combinePoses(prev_pose, noisy_odometry_.at(frame_id)));
+    }
+    for (const ReprojectionErrorFactor &factor :
+         observations_by_frame_[frame_id]) {
+      if (first_frame_by_feature_.at(factor.feature_id_) == frame_id) {
+        pose_graph->addFeature(factor.feature_id_,
+                               init_feature_positions_.at(factor.feature_id_));
+      }
+      pose_graph->addVisualFactor(factor);
+    }
+  }
+};
+}  // namespace
+
+TEST(OfflineProblemRunner, ResumeFromCheckpointMatchesUninterruptedRun) {
+  SyntheticRun synthetic_run;
+
+  OfflineRunnerCheckpointState checkpoint;
+  ObjectAndReprojectionFeaturePoseGraphState uninterrupted_state;
+  ASSERT_TRUE(synthetic_run.run(
+      std::nullopt, kCheckpointFrame, checkpoint, uninterrupted_state));
+  ASSERT_EQ(kCheckpointFrame, checkpoint.last_frame_processed_);
+
+  // Resume from the checkpoint as written to and read from disk
+  fs::path checkpoint_file = fs::temp_directory_path() /
+                             (kRunnerCheckpointOutputFileBaseName +
+                              std::to_string(kCheckpointFrame) + ".json");
+  outputRunnerCheckpointToFile(checkpoint, checkpoint_file.string());
+  OfflineRunnerCheckpointState read_checkpoint;
+  ASSERT_TRUE(
+      readRunnerCheckpointFromFile(checkpoint_file.string(), read_checkpoint));
+  fs::remove(checkpoint_file);
+
+  OfflineRunnerCheckpointState unused_checkpoint;
+  ObjectAndReprojectionFeaturePoseGraphState resumed_state;
+  ASSERT_TRUE(synthetic_run.run(
+      read_checkpoint, kNumFrames, unused_checkpoint, resumed_state));
+
+  const ReprojectionLowLevelFeaturePoseGraphState &uninterrupted =
+      uninterrupted_state.reprojection_low_level_feature_pose_graph_state_;
+  const ReprojectionLowLevelFeaturePoseGraphState &resumed =
+      resumed_state.reprojection_low_level_feature_pose_graph_state_;
+
+  // Same graph structure
+  EXPECT_EQ(uninterrupted.low_level_pg_state_.factors_,
+            resumed.low_level_pg_state_.factors_);
+  EXPECT_EQ(uninterrupted.low_level_pg_state_.visual_factors_by_feature_,
+            resumed.low_level_pg_state_.visual_factors_by_feature_);
+
+  // Same estimates
+  ASSERT_EQ(kNumFrames, uninterrupted.low_level_pg_state_.robot_poses_.size());
+  ASSERT_EQ(kNumFrames, resumed.low_level_pg_state_.robot_poses_.size());
+  for (const auto &frame_and_pose :
+       uninterrupted.low_level_pg_state_.robot_poses_) {
+    const RawPose3d<double> &resumed_pose =
+        resumed.low_level_pg_state_.robot_poses_.at(frame_and_pose.first);
+    for (int idx = 0; idx < frame_and_pose.second.size(); idx++) {
+      EXPECT_NEAR(
+          frame_and_pose.second(idx), resumed_pose(idx), kEstimateTolerance)
+          << "Frame " << frame_and_pose.first;
+    }
+  }
+  ASSERT_EQ(uninterrupted.feature_positions_.size(),
+            resumed.feature_positions_.size());
+  for (const auto &feature_and_position : uninterrupted.feature_positions_) {
+    const Position3d<double> &resumed_position =
+        resumed.feature_positions_.at(feature_and_position.first);
+    EXPECT_NEAR(0,
+                (feature_and_position.second - resumed_position).norm(),
+                kEstimateTolerance)
+        << "Feature " << feature_and_position.first;
+  }
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <refactoring/offline/pipelined_frame_feature_loader.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+std::unordered_map<FeatureId, StructuredVisionFeatureTrack>
+createFeatureTracks() {
+  // Feature n is observed in frames n to n + 3 by camera 0 and in even frames
+  // by camera 1 as well
+  std::unordered_map<FeatureId, StructuredVisionFeatureTrack> visual_features;
+  for (FeatureId feature_id = 0; feature_id < 20; feature_id++) {
+    StructuredVisionFeatureTrack &track = visual_features[feature_id];
+    track.feature_track.feature_id_ = feature_id;
+    for (FrameId frame_id = feature_id; frame_id < feature_id + 4;
+         frame_id++) {
+      std::unordered_map<CameraId, PixelCoord<double>> pixel_by_camera_id;
+      pixel_by_camera_id[0] = PixelCoord<double>(feature_id, frame_id);
+      if (frame_id % 2 == 0) {
+        pixel_by_camera_id[1] = PixelCoord<double>(frame_id, feature_id);
+      }
+      track.feature_track.feature_observations_.emplace(
+          frame_id, VisionFeature(frame_id, pixel_by_camera_id, 0));
+    }
+  }
+  return visual_features;
+}
+}  // namespace
+
+TEST(PipelinedFrameFeatureLoader, MatchesObservationsInTracks) {
+  std::unordered_map<FeatureId, StructuredVisionFeatureTrack> visual_features =
+      createFeatureTracks();
+
+  for (size_t max_frames_in_flight : {0, 1, 4}) {
+    PipelinedFrameFeatureLoader loader(
+        visual_features, max_frames_in_flight, 3);
+    for (FrameId frame_id = 0; frame_id < 25; frame_id++) {
+      FrameFeatureObservations observations;
+      bool has_observations =
+          loader.getObservationsForFrame(frame_id, observations);
+      ASSERT_EQ(frame_id < 23, has_observations) << "Frame " << frame_id;
+      if (!has_observations) {
+        EXPECT_TRUE(observations.empty());
+        continue;
+      }
+
+      FeatureId min_feature_id = (frame_id < 3) ? 0 : (frame_id - 3);
+      FeatureId max_feature_id = std::min(frame_id, (FrameId)19);
+      size_t num_features = max_feature_id - min_feature_id + 1;
+      ASSERT_EQ(num_features, observations.at(0).size());
+      EXPECT_EQ((frame_id % 2 == 0) ? 2 : 1, observations.size());
+      for (FeatureId feature_id = min_feature_id; feature_id <= max_feature_id;
+           feature_id++) {
+        EXPECT_EQ(PixelCoord<double>(feature_id, frame_id),
+                  observations.at(0).at(feature_id));
+        if (frame_id % 2 == 0) {
+          EXPECT_EQ(PixelCoord<double>(frame_id, feature_id),
+                    observations.at(1).at(feature_id));
+        }
+      }
+    }
+  }
+}
+
+TEST(PipelinedFrameFeatureLoader, NoFeatureTracks) {
+  std::unordered_map<FeatureId, StructuredVisionFeatureTrack> visual_features;
+  PipelinedFrameFeatureLoader loader(visual_features, 2);
+  FrameFeatureObservations observations;
+  EXPECT_FALSE(loader.getObservationsForFrame(0, observations));
+  EXPECT_TRUE(observations.empty());
+}
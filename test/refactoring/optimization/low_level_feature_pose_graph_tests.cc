@@ -0,0 +1,107 @@
+#include <base_lib/basic_utils.h>
+#include <gtest/gtest.h>
+#include <refactoring/optimization/low_level_feature_pose_graph.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+const FrameId kNumFrames = 200;
+
+// Feature i is observed in frames i % kNumFrames through
+// (i % kNumFrames) + (i % 7)
+std::shared_ptr<ReprojectionLowLevelFeaturePoseGraph> createPoseGraph() {
+  std::shared_ptr<ReprojectionLowLevelFeaturePoseGraph> pose_graph =
+      std::make_shared<ReprojectionLowLevelFeaturePoseGraph>(
+          std::unordered_map<CameraId, CameraExtrinsics<double>>(),
+          std::unordered_map<CameraId, CameraIntrinsicsMat<double>>());
+  Pose3D<double> identity_pose(
+      Position3d<double>(0, 0, 0),
+      Orientation3D<double>(0, Eigen::Vector3d(0, 0, 1)));
+  for (FrameId frame_id = 0; frame_id < kNumFrames + 10; frame_id++) {
+    pose_graph->addFrame(frame_id, identity_pose);
+  }
+  for (FeatureId feature_id = 0; feature_id < 3 * kNumFrames; feature_id++) {
+    pose_graph->addFeature(feature_id, Position3d<double>(0, 0, 1));
+    FrameId first_frame = feature_id % kNumFrames;
+    FrameId last_frame = first_frame + feature_id % 7;
+    for (FrameId frame_id = first_frame; frame_id <= last_frame; frame_id++) {
+      pose_graph->addVisualFactor(ReprojectionErrorFactor(
+          frame_id, feature_id, 0, PixelCoord<double>(1, 1), 1));
+    }
+  }
+  return pose_graph;
+}
+}  // namespace
+
+TEST(LowLevelFeaturePoseGraph, WindowQueriesMatchObservationRanges) {
+  std::shared_ptr<ReprojectionLowLevelFeaturePoseGraph> pose_graph =
+      createPoseGraph();
+
+  for (const std::pair<FrameId, FrameId> &window :
+       std::vector<std::pair<FrameId, FrameId>>{
+           {0, 0}, {10, 30}, {150, kNumFrames + 20}, {40, 39}}) {
+    std::unordered_set<FeatureId> expected_features;
+    size_t expected_num_factors = 0;
+    for (FeatureId feature_id = 0; feature_id < 3 * kNumFrames; feature_id++) {
+      FrameId first_frame = feature_id % kNumFrames;
+      FrameId last_frame = first_frame + feature_id % 7;
+      if ((last_frame >= window.first) && (first_frame <= window.second)) {
+        expected_features.insert(feature_id);
+      }
+      for (FrameId frame_id = first_frame; frame_id <= last_frame; frame_id++) {
+        if ((frame_id >= window.first) && (frame_id <= window.second)) {
+          expected_num_factors++;
+        }
+      }
+    }
+
+    std::unordered_set<FeatureId> matching_features;
+    pose_graph->getFeaturesViewedBetweenFramesInclusive(
+        window.first, window.second, matching_features);
+    EXPECT_EQ(expected_features, matching_features);
+
+    util::BoostHashSet<std::pair<FactorType, FeatureFactorId>>
+        matching_factors;
+    pose_graph->getVisualFeatureFactorIdsBetweenFrameIdsInclusive(
+        window.first, window.second, matching_factors);
+    EXPECT_EQ(expected_num_factors, matching_factors.size());
+
+    std::unordered_set<FrameId> matching_frames;
+    pose_graph->getFrameIdsBetweenFrameIdsInclusive(
+        window.first, window.second, matching_frames);
+    EXPECT_EQ((window.first > window.second)
+                  ? 0
+                  : std::min(window.second, kNumFrames + 9) - window.first + 1,
+              matching_frames.size());
+  }
+}
+
+TEST(LowLevelFeaturePoseGraph, WindowQueriesAfterInitializeFromState) {
+  std::shared_ptr<ReprojectionLowLevelFeaturePoseGraph> pose_graph =
+      createPoseGraph();
+  ReprojectionLowLevelFeaturePoseGraphState state;
+  pose_graph->getState(state);
+
+  std::shared_ptr<ReprojectionLowLevelFeaturePoseGraph> restored_pose_graph =
+      std::make_shared<ReprojectionLowLevelFeaturePoseGraph>(
+          std::unordered_map<CameraId, CameraExtrinsics<double>>(),
+          std::unordered_map<CameraId, CameraIntrinsicsMat<double>>());
+  restored_pose_graph->initializeFromState(state);
+
+  std::unordered_set<FeatureId> features;
+  std::unordered_set<FeatureId> restored_features;
+  pose_graph->getFeaturesViewedBetweenFramesInclusive(50, 60, features);
+  restored_pose_graph->getFeaturesViewedBetweenFramesInclusive(
+      50, 60, restored_features);
+  EXPECT_EQ(features, restored_features);
+
+  util::BoostHashSet<std::pair<FactorType, FeatureFactorId>> factors;
+  util::BoostHashSet<std::pair<FactorType, FeatureFactorId>> restored_factors;
+  pose_graph->getVisualFeatureFactorIdsBetweenFrameIdsInclusive(
+      50, 60, factors);
+  restored_pose_graph->getVisualFeatureFactorIdsBetweenFrameIdsInclusive(
+      50, 60, restored_factors);
+  EXPECT_EQ(factors, restored_factors);
+
+  EXPECT_EQ(pose_graph->getFrameIds(), restored_pose_graph->getFrameIds());
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <refactoring/types/ellipsoid_projection_kernel.h>
+
+using namespace vslam_types_refactor;
+
+namespace {
+const double kFiniteDiffStep = 1e-6;
+const double kJacobianTolerance = 1e-5;
+
+Eigen::Affine3d createRobotToCamTf() {
+  // Camera looking along the robot's x axis, offset from the robot origin
+  Eigen::Matrix3d cam_rot_in_robot;
+  cam_rot_in_robot << 0, 0, 1, -1, 0, 0, 0, -1, 0;
+  Eigen::Affine3d cam_to_robot = Eigen::Translation3d(0.2, 0.05, 0.7) *
+                                 Eigen::Quaterniond(cam_rot_in_robot);
+  return cam_to_robot.inverse();
+}
+
+RawPose3d<double> createRobotPose() {
+  RawPose3d<double> robot_pose;
+  robot_pose << 1.0, -0.5, 0.1, 0.02, -0.03, 0.4;
+  return robot_pose;
+}
+
+RawEllipsoid<double> createEllipsoid() {
+  RawEllipsoid<double> ellipsoid;
+#ifdef CONSTRAIN_ELLIPSOID_ORIENTATION
+  ellipsoid << 6.0, 2.0, 0.6, 0.3, 0.8, 0.5, 1.2;
+#else
+  ellipsoid << 6.0, 2.0, 0.6, 0.1, -0.2, 0.3, 0.8, 0.5, 1.2;
+#endif
+  return ellipsoid;
+}
+}  // namespace
+
+TEST(EllipsoidProjectionKernel, MatchesTemplatedProjection) {
+  Eigen::Affine3d robot_to_cam_tf = createRobotToCamTf();
+  RawPose3d<double> robot_pose = createRobotPose();
+  RawEllipsoid<double> ellipsoid = createEllipsoid();
+
+  Eigen::Vector4d expected_corners;
+  ASSERT_TRUE(getCornerLocationsVectorRectified(
+      ellipsoid.data(), robot_pose.data(), robot_to_cam_tf, expected_corners));
+
+  Eigen::Vector4d corners;
+  ASSERT_TRUE(projectEllipsoidRectified(
+      createEllipsoidProjectionCameraFrame(robot_pose.data(), robot_to_cam_tf),
+      ellipsoid.data(),
+      corners));
+  for (int corner_num = 0; corner_num < 4; corner_num++) {
+    EXPECT_NEAR(expected_corners(corner_num), corners(corner_num), 1e-10);
+  }
+}
+
+TEST(EllipsoidProjectionKernel, JacobiansMatchFiniteDifferences) {
+  Eigen::Affine3d robot_to_cam_tf = createRobotToCamTf();
+  RawPose3d<double> robot_pose = createRobotPose();
+  RawEllipsoid<double> ellipsoid = createEllipsoid();
+
+  Eigen::Vector4d corners;
+  Eigen::Matrix<double, 4, kRobotPoseParameterizationSize, Eigen::RowMajor>
+      robot_pose_jacobian;
+  Eigen::Matrix<double, 4, kEllipsoidParamterizationSize, Eigen::RowMajor>
+      ellipsoid_jacobian;
+  ASSERT_TRUE(projectEllipsoidRectified(
+      createEllipsoidProjectionCameraFrame(robot_pose.data(), robot_to_cam_tf),
+      ellipsoid.data(),
+      corners,
+      robot_pose_jacobian.data(),
+      ellipsoid_jacobian.data()));
+
+  auto project = [&](const RawPose3d<double> &pose,
+                     const RawEllipsoid<double> &ellipsoid_params) {
+    Eigen::Vector4d perturbed_corners;
+    EXPECT_TRUE(projectEllipsoidRectified(
+        createEllipsoidProjectionCameraFrame(pose.data(), robot_to_cam_tf),
+        ellipsoid_params.data(),
+        perturbed_corners));
+    return perturbed_corners;
+  };
+
+  for (int param = 0; param < kRobotPoseParameterizationSize; param++) {
+    RawPose3d<double> plus = robot_pose;
+    RawPose3d<double> minus = robot_pose;
+    plus(param) += kFiniteDiffStep;
+    minus(param) -= kFiniteDiffStep;
+    Eigen::Vector4d numeric = (project(plus, ellipsoid) -
+                               project(minus, ellipsoid)) /
+                              (2 * kFiniteDiffStep);
+    for (int corner_num = 0; corner_num < 4; corner_num++) {
+      EXPECT_NEAR(numeric(corner_num),
+                  robot_pose_jacobian(corner_num, param),
+                  kJacobianTolerance)
+          << "Robot pose param " << param << ", corner " << corner_num;
+    }
+  }
+
+  for (int param = 0; param < kEllipsoidParamterizationSize; param++) {
+    RawEllipsoid<double> plus = ellipsoid;
+    RawEllipsoid<double> minus = ellipsoid;
+    plus(param) += kFiniteDiffStep;
+    minus(param) -= kFiniteDiffStep;
+    Eigen::Vector4d numeric = (project(robot_pose, plus) -
+                               project(robot_pose, minus)) /
+                              (2 * kFiniteDiffStep);
+    for (int corner_num = 0; corner_num < 4; corner_num++) {
+      EXPECT_NEAR(numeric(corner_num),
+                  ellipsoid_jacobian(corner_num, param),
+                  kJacobianTolerance)
+          << "Ellipsoid param " << param << ", corner " << corner_num;
+    }
+  }
+}
+
+TEST(EllipsoidProjectionKernel, BatchMatchesSingleProjection) {
+  Eigen::Affine3d robot_to_cam_tf = createRobotToCamTf();
+  RawPose3d<double> robot_pose = createRobotPose();
+  EllipsoidProjectionCameraFrame frame =
+      createEllipsoidProjectionCameraFrame(robot_pose.data(), robot_to_cam_tf);
+
+  std::vector<RawEllipsoid<double>> ellipsoids;
+  ellipsoids.emplace_back(createEllipsoid());
+  RawEllipsoid<double> behind_camera = createEllipsoid();
+  behind_camera(0) = -6.0;
+  ellipsoids.emplace_back(behind_camera);
+  RawEllipsoid<double> shifted = createEllipsoid();
+  shifted(1) = -1.0;
+  ellipsoids.emplace_back(shifted);
+
+  std::vector<std::optional<BbCorners<double>>> batch_corners;
+  projectEllipsoidsRectified(frame, ellipsoids, batch_corners);
+  ASSERT_EQ(ellipsoids.size(), batch_corners.size());
+  for (size_t ellipsoid_num = 0; ellipsoid_num < ellipsoids.size();
+       ellipsoid_num++) {
+    Eigen::Vector4d corners;
+    bool valid = projectEllipsoidRectified(
+        frame, ellipsoids[ellipsoid_num].data(), corners);
+    ASSERT_EQ(valid, batch_corners[ellipsoid_num].has_value());
+    if (valid) {
+      EXPECT_TRUE(corners.isApprox(batch_corners[ellipsoid_num].value()));
+    }
+  }
+}
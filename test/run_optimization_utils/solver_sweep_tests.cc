@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <run_optimization_utils/solver_sweep.h>
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <tuple>
+
+using namespace vslam_types_refactor;
+namespace fs = std::filesystem;
+
+TEST(SolverSweep, ParseSweepValues) {
+  std::vector<ceres::LinearSolverType> linear_solver_types;
+  EXPECT_TRUE(parseLinearSolverTypes("SPARSE_SCHUR, DENSE_SCHUR",
+                                     linear_solver_types));
+  EXPECT_EQ(std::vector<ceres::LinearSolverType>(
+                {ceres::SPARSE_SCHUR, ceres::DENSE_SCHUR}),
+            linear_solver_types);
+  EXPECT_FALSE(parseLinearSolverTypes("NOT_A_SOLVER", linear_solver_types));
+
+  std::vector<ceres::TrustRegionStrategyType> strategy_types;
+  EXPECT_TRUE(parseTrustRegionStrategyTypes("DOGLEG", strategy_types));
+  EXPECT_EQ(std::vector<ceres::TrustRegionStrategyType>({ceres::DOGLEG}),
+            strategy_types);
+
+  std::vector<double> huber_params;
+  EXPECT_TRUE(parseSweepValues("0.5,1,2e1", huber_params));
+  EXPECT_EQ(std::vector<double>({0.5, 1, 20}), huber_params);
+  EXPECT_FALSE(parseSweepValues("1,abc", huber_params));
+
+  std::vector<int> num_threads;
+  EXPECT_TRUE(parseSweepValues("", num_threads));
+  EXPECT_TRUE(num_threads.empty());
+}
+
+TEST(SolverSweep, CreateSettingsForEachCombination) {
+  pose_graph_optimization::OptimizationSolverParams base_solver_params;
+  base_solver_params.max_num_iterations_ = 17;
+  pose_graph_optimization::ObjectVisualPoseGraphResidualParams
+      base_residual_params;
+  base_residual_params.object_residual_params_
+      .object_observation_huber_loss_param_ = 3;
+
+  SolverSweepParams sweep_params;
+  EXPECT_EQ(1, createSolverSweepSettings(
+                   base_solver_params, base_residual_params, sweep_params)
+                   .size());
+
+  sweep_params.linear_solver_types_ = {ceres::SPARSE_SCHUR,
+                                       ceres::DENSE_SCHUR};
+  sweep_params.num_threads_ = {1, 2, 4};
+  sweep_params.reprojection_error_huber_loss_params_ = {0.5, 2};
+  std::vector<SolverSweepSetting> settings = createSolverSweepSettings(
+      base_solver_params, base_residual_params, sweep_params);
+  ASSERT_EQ(12, settings.size());
+
+  std::set<std::tuple<ceres::LinearSolverType, int, double>> combinations;
+  for (const SolverSweepSetting &setting : settings) {
+    EXPECT_EQ(17, setting.solver_params_.max_num_iterations_);
+    EXPECT_EQ(3,
+              setting.residual_params_.object_residual_params_
+                  .object_observation_huber_loss_param_);
+    combinations.insert(
+        std::make_tuple(setting.solver_params_.linear_solver_type_,
+                        setting.solver_params_.num_threads_,
+                        setting.residual_params_.visual_residual_params_
+                            .reprojection_error_huber_loss_param_));
+  }
+  EXPECT_EQ(12, combinations.size());
+}
+
+TEST(SolverSweep, RunSettingsInProcesses) {
+  std::vector<SolverSweepSetting> settings(5);
+  for (size_t setting_idx = 0; setting_idx < settings.size(); setting_idx++) {
+    settings[setting_idx].solver_params_.max_num_iterations_ = setting_idx;
+  }
+
+  // Should not be visible to the parent
+  int num_runs = 0;
+  std::function<SolverSweepResult(const SolverSweepSetting &)>
+      setting_runner = [&](const SolverSweepSetting &setting) {
+        num_runs++;
+        if (setting.solver_params_.max_num_iterations_ == 3) {
+          // Simulate a crash
+          _exit(2);
+        }
+        SolverSweepResult result;
+        result.success_ = true;
+        result.num_iterations_ =
+            setting.solver_params_.max_num_iterations_ * 10;
+        result.final_cost_ = num_runs;
+        return result;
+      };
+
+  std::vector<SolverSweepResult> results;
+  runSolverSweepInProcesses(settings, 2, setting_runner, results);
+  EXPECT_EQ(0, num_runs);
+  ASSERT_EQ(settings.size(), results.size());
+  for (size_t setting_idx = 0; setting_idx < settings.size(); setting_idx++) {
+    if (setting_idx == 3) {
+      EXPECT_FALSE(results[setting_idx].success_);
+      continue;
+    }
+    EXPECT_TRUE(results[setting_idx].success_);
+    EXPECT_EQ(setting_idx * 10, results[setting_idx].num_iterations_);
+    // Each child starts from the parent's state
+    EXPECT_EQ(1, results[setting_idx].final_cost_);
+  }
+
+  std::string file_name =
+      (fs::temp_directory_path() / "solver_sweep_test.csv").string();
+  writeSolverSweepResultsToFile(file_name, settings, results);
+  std::ifstream results_file(file_name);
+  size_t num_lines = 0;
+  std::string line;
+  while (std::getline(results_file, line)) {
+    num_lines++;
+  }
+  EXPECT_EQ(settings.size() + 1, num_lines);
+  fs::remove(file_name);
+}